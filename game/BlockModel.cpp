@@ -9,10 +9,12 @@
 using namespace std;
 
 #include "Trace.hpp"
+#include "Profiler.hpp"
 #include "Point.hpp"
 #include "GameState.hpp"
 #include "Tokenizer.hpp"
 #include "ResourceManager.hpp"
+#include "AssetCache.hpp"
 #include "Audio.hpp"
 #include "Quaternion.hpp"
 #include "ScoreKeeper.hpp"
@@ -25,8 +27,19 @@ using namespace std;
 
 #include <algorithm>
 #include <memory>
+#include <string.h>
 using namespace std;
 
+//resolved in init, played by id during the game
+static SampleId _achooSample = INVALID_SAMPLE;
+static SampleId _blblibSample = INVALID_SAMPLE;
+static SampleId _katoungSample = INVALID_SAMPLE;
+static SampleId _chirp2Sample = INVALID_SAMPLE;
+static SampleId _xdoubleplaySample = INVALID_SAMPLE;
+static SampleId _xtripleplaySample = INVALID_SAMPLE;
+static SampleId _xmonsterplaySample = INVALID_SAMPLE;
+static SampleId _xrediculousSample = INVALID_SAMPLE;
+
 /*
 
 Terminology used:
@@ -62,6 +75,7 @@ BlockModel::BlockModel(int w, int h, int d, int level, const std::string& blocks
     _practiceMode(false),
     _timeLimitReached(false),
     _elementCount(0),
+    _planesCleared(0),
     _hachooInProgress(false),
     _view(0) {}
 
@@ -161,6 +175,16 @@ bool BlockModel::init(void) {
     _tmpElementList = new ElementList;
     _lockedElementList = new ElementList;
 
+    Audio* audio = AudioS::instance();
+    _achooSample = audio->getSampleId("sounds/achoo");
+    _blblibSample = audio->getSampleId("sounds/blblib");
+    _katoungSample = audio->getSampleId("sounds/katoung");
+    _chirp2Sample = audio->getSampleId("sounds/chirp2");
+    _xdoubleplaySample = audio->getSampleId("sounds/xdoubleplay");
+    _xtripleplaySample = audio->getSampleId("sounds/xtripleplay");
+    _xmonsterplaySample = audio->getSampleId("sounds/xmonsterplay");
+    _xrediculousSample = audio->getSampleId("sounds/xrediculous");
+
     updateDropDelay();
     if (!loadBlocks()) {
         return false;
@@ -195,6 +219,7 @@ bool BlockModel::reset(int w, int h, int d, int level, const std::string& blocks
     _freefallZ = 0;
     _multiplier = 0;
     _elementCount = 0;
+    _planesCleared = 0;
     _nextBlock = -1;
     _timeLimitReached = false;
 
@@ -236,56 +261,81 @@ void BlockModel::addBlock(void) {
     }
 }
 
+//bump when the compiled blockset layout changes
+static const uint32_t BLOCKSET_CACHE_VERSION = 1;
+
 bool BlockModel::loadBlocks(void) {
     string filename = "blocksets/" + _blockset + ".txt";
 
-    std::unique_ptr<ziStream> infileP(ResourceManagerS::instance()->getInputStream(filename));
-    if (!infileP) {
+    std::unique_ptr<ResourceView> view(ResourceManagerS::instance()->getResourceView(filename));
+    if (!view) {
         LOG_ERROR << "Unable to open: [" << filename << "]" << endl;
         return false;
     }
-    ziStream& infile = *infileP;
 
-    LOG_INFO << "Loading block info from [" << filename << "]" << endl;
+    //the shaft size filter below depends on the level, so cache all blocks
+    vector<int> blocks;
+    AssetCacheKey key("blockset", BLOCKSET_CACHE_VERSION);
+    key.add(*view);
+    std::unique_ptr<ResourceView> cached(AssetCacheS::instance()->load(key));
+    if (cached && ((cached->size() % sizeof(int)) == 0)) {
+        LOG_INFO << "Loading block info from [" << filename << "] (cached)" << endl;
+        blocks.resize(cached->size() / sizeof(int));
+        memcpy(blocks.data(), cached->data(), cached->size());
+    } else {
+        ResourceViewStream infile(*view);
 
-    string line;
-    int linecount = 0;
-    while (!getline(infile, line).eof()) {
-        if (line.length() == 0) {
-            continue;
-        }
+        LOG_INFO << "Loading block info from [" << filename << "]" << endl;
 
-        linecount++;
-        //        LOG_INFO << "[" <<  line << "]" << endl;
-        if (line[0] == '#') {
-            continue;
-        }
+        string line;
+        int linecount = 0;
+        while (!getline(infile, line).eof()) {
+            if (line.length() == 0) {
+                continue;
+            }
 
-        Tokenizer t(line);
-        string token = t.next();
-        if (token == "Elements") {
-            int numElems = atoi(t.next().c_str());
-            if (!readBlock(infile, numElems, linecount)) {
-                LOG_ERROR << "Error reading blocks. Line: " << linecount << endl;
-                return false;
+            linecount++;
+            //        LOG_INFO << "[" <<  line << "]" << endl;
+            if (line[0] == '#') {
+                continue;
             }
+
+            Tokenizer t(line);
+            string token = t.next();
+            if (token == "Elements") {
+                int numElems = atoi(t.next().c_str());
+                if (!readBlock(infile, numElems, linecount, blocks)) {
+                    LOG_ERROR << "Error reading blocks. Line: " << linecount << endl;
+                    return false;
+                }
+            }
+        }
+        AssetCacheS::instance()->store(key, blocks.data(), blocks.size() * sizeof(int));
+    }
+
+    size_t pos = 0;
+    while ((pos + 2) <= blocks.size()) {
+        int line = blocks[pos];
+        int numElems = blocks[pos + 1];
+        pos += 2;
+        if ((numElems <= 0) || ((pos + numElems * 3) > blocks.size())) {
+            LOG_ERROR << "Bad compiled blockset: [" << filename << "]" << endl;
+            return false;
         }
+        addBlockInfo(&blocks[pos], numElems, line);
+        pos += numElems * 3;
     }
+
     return true;
 }
 
-bool BlockModel::readBlock(ziStream& infile, int numElems, int& linecount) {
-    ElementList* el = new ElementList;
-    bool blockOK = true;
-
-    Point3Di minPos;
-    Point3Di maxPos;
+bool BlockModel::readBlock(std::istream& infile, int numElems, int& linecount, vector<int>& blocks) {
+    vector<int> elems;
 
     string line;
     for (int i = 0; i < numElems; i++) {
         if (getline(infile, line).eof()) {
-            blockOK = false;
-            break;
+            return true;
         }
         linecount++;
 
@@ -297,10 +347,34 @@ bool BlockModel::readBlock(ziStream& infile, int numElems, int& linecount) {
         p.z = atoi(t.next().c_str());
 
         if (t.tokensReturned() != 3) {
-            blockOK = false;
-            break;
+            return true;
         }
 
+        elems.push_back(p.x);
+        elems.push_back(p.y);
+        elems.push_back(p.z);
+    }
+
+    if (elems.empty()) {
+        return true;
+    }
+
+    blocks.push_back(linecount);
+    blocks.push_back(numElems);
+    blocks.insert(blocks.end(), elems.begin(), elems.end());
+
+    return true;
+}
+
+void BlockModel::addBlockInfo(const int* elems, int numElems, int line) {
+    ElementList* el = new ElementList;
+
+    Point3Di minPos;
+    Point3Di maxPos;
+
+    for (int i = 0; i < numElems; i++) {
+        Point3Di p(elems[i * 3], elems[i * 3 + 1], elems[i * 3 + 2]);
+
         if (i == 0) {
             minPos = p;
             maxPos = p;
@@ -336,21 +410,16 @@ bool BlockModel::readBlock(ziStream& infile, int numElems, int& linecount) {
     int dy = (maxPos.y - minPos.y + 1);
     int dz = (maxPos.z - minPos.z + 1);
     if ((dx > maxSize) || (dy > maxSize) || (dz > maxSize)) {
-        LOG_INFO << "Excluding big block (line:" << linecount << ")" << endl;
-        blockOK = false;
-    }
-
-    if (blockOK) {
-        BlockInfo bi;
-        bi.elements = el;
-        bi.multiplier = dx * dy * dz;
-        bi.center = Point3D((maxPos.x + minPos.x) / 2.0f, (maxPos.y + minPos.y) / 2.0f, (maxPos.z + minPos.z) / 2.0f);
-        _blockList.push_back(bi);
-    } else {
+        LOG_INFO << "Excluding big block (line:" << line << ")" << endl;
         clearAndDeleteElementList(el);
+        return;
     }
 
-    return true;
+    BlockInfo bi;
+    bi.elements = el;
+    bi.multiplier = dx * dy * dz;
+    bi.center = Point3D((maxPos.x + minPos.x) / 2.0f, (maxPos.y + minPos.y) / 2.0f, (maxPos.z + minPos.z) / 2.0f);
+    _blockList.push_back(bi);
 }
 
 void BlockModel::updateDropDelay(void) {
@@ -566,10 +635,11 @@ float BlockModel::getScoreMultiplier(void) {
 }
 
 bool BlockModel::update(void) {
+    PROFILE_ZONE("BlockModel::update");
     if (_nextHachoo < GameState::stopwatch.getTime()) {
         if (!_hachooInProgress) {
             _nextHachooBonusEnd = _nextHachoo + HachooDuration();
-            AudioS::instance()->playSample("sounds/achoo");
+            AudioS::instance()->playSample(_achooSample);
         }
         _hachooInProgress = true;
         if ((_nextHachoo + 0.7) < GameState::stopwatch.getTime()) {
@@ -602,17 +672,13 @@ bool BlockModel::update(void) {
                     Point3Di a = *p + _offset;
                     if (!lockElement(a)) {
                         //failed to lock block, game over!
-
-                        //update time played
-                        ScoreKeeperS::instance()->addToCurrentScore(0, 0, (int)GameState::stopwatch.getTime());
-                        //push leader board scores to score board list
-                        ScoreKeeperS::instance()->updateScoreBoardWithLeaderBoard();
+                        endGame();
                         return false;
                     }
                     eCount++;
                     if ((_level < 9) && (_elementCount >= (_level * 150))) {
                         _level++;
-                        AudioS::instance()->playSample("sounds/blblib");
+                        AudioS::instance()->playSample(_blblibSample);
                         updateDropDelay();
                         LOG_INFO << "New level is " << _level << endl;
                     }
@@ -623,17 +689,14 @@ bool BlockModel::update(void) {
                 scoreToAdd *= getScoreMultiplier();
                 ScoreKeeperS::instance()->addToCurrentScore((int)scoreToAdd, eCount, (int)GameState::stopwatch.getTime());
 
-                AudioS::instance()->playSample("sounds/katoung");
+                AudioS::instance()->playSample(_katoungSample);
                 checkPlanes();
 
                 addBlock();
 
                 if (!verifyAndAdjust()) {
                     LOG_INFO << "Can't fit new block!" << endl;
-                    //update time played
-                    ScoreKeeperS::instance()->addToCurrentScore(0, 0, (int)GameState::stopwatch.getTime());
-                    //push leader board scores to score board list
-                    ScoreKeeperS::instance()->updateScoreBoardWithLeaderBoard();
+                    endGame();
                     return false;
                 }
             }
@@ -646,6 +709,14 @@ bool BlockModel::update(void) {
     return true;
 }
 
+void BlockModel::endGame(void) {
+    //update time played
+    ScoreKeeperS::instance()->addToCurrentScore(0, 0, (int)GameState::stopwatch.getTime());
+    //push leader board scores to score board list
+    ScoreKeeperS::instance()->updateScoreBoardWithLeaderBoard();
+    ScoreKeeperS::instance()->recordGame(_level, _planesCleared);
+}
+
 void BlockModel::checkPlanes(void) {
     int planeElems = _width * _height;
     int planeCount = 0;
@@ -688,26 +759,27 @@ void BlockModel::checkPlanes(void) {
         //we moved everything down, so do this depth again
         d--;
     }
+    _planesCleared += planeCount;
 
     switch (planeCount) {
         case 0:
             break;
 
         case 1:
-            AudioS::instance()->playSample("sounds/chirp2");
+            AudioS::instance()->playSample(_chirp2Sample);
             break;
         case 2:
-            AudioS::instance()->playSample("sounds/xdoubleplay");
+            AudioS::instance()->playSample(_xdoubleplaySample);
             break;
         case 3:
-            AudioS::instance()->playSample("sounds/xtripleplay");
+            AudioS::instance()->playSample(_xtripleplaySample);
             break;
         case 4:
-            AudioS::instance()->playSample("sounds/xmonsterplay");
+            AudioS::instance()->playSample(_xmonsterplaySample);
             break;
 
         default:
-            AudioS::instance()->playSample("sounds/xrediculous");
+            AudioS::instance()->playSample(_xrediculousSample);
             break;
     }
 
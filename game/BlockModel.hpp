@@ -8,6 +8,7 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <istream>
 
 #include "Point.hpp"
 #include "R250.hpp"
@@ -15,7 +16,6 @@
 typedef std::list<Point3Di*> ElementList;
 
 class BlockView;
-class ziStream;
 
 class BlockModel {
 public:
@@ -85,6 +85,8 @@ protected:
     bool verifyAndAdjust(void);
     bool canDrop(void);
     void checkPlanes(void);
+    //record the finished game with the score keeper
+    void endGame(void);
 
     void updateNextDrop(float delta, bool freeFall = false);
     void updateDropDelay(void);
@@ -109,7 +111,9 @@ private:
 
     void addBlock(void);
     bool loadBlocks(void);
-    bool readBlock(ziStream& infile, int numElems, int& linecount);
+    //Compiled blockset: per block line, numElems, then x,y,z for each element
+    bool readBlock(std::istream& infile, int numElems, int& linecount, std::vector<int>& blocks);
+    void addBlockInfo(const int* elems, int numElems, int line);
 
     int _width;
     int _height;
@@ -161,6 +165,7 @@ private:
     bool _timeLimitReached;
 
     int _elementCount;
+    int _planesCleared;
 
     BlockView* _view;
 
@@ -8,7 +8,9 @@
 #include "SDL.h"
 
 #include "Trace.hpp"
+#include "Profiler.hpp"
 #include "FPS.hpp"
+#include "Timer.hpp"
 #include "Config.hpp"
 #include "ResourceManager.hpp"
 #include "zrwops.hpp"
@@ -19,11 +21,14 @@
 #include "FontManager.hpp"
 #include "ModelManager.hpp"
 #include "BitmapManager.hpp"
+#include "TextureManager.hpp"
 
 #include "BlockModel.hpp"
 #include "Constants.hpp"
 #include "GameState.hpp"
+#include "Game.hpp"
 #include "ScoreKeeper.hpp"
+#include "Audio.hpp"
 
 #include "ParticleGroupManager.hpp"
 
@@ -31,6 +36,7 @@
 #include "gl3/Shader.hpp"
 #include "gl3/Buffer.hpp"
 #include "gl3/VertexArray.hpp"
+#include "gl3/FrameBuffer.hpp"
 #include "gl3/ProgramManager.hpp"
 #include "gl3/MatrixStack.hpp"
 
@@ -40,11 +46,21 @@
 const float BLOCKROTSPEED = 2.0f;
 const float DEFAULT_ROTATION_SPEED = 7.0f * GAME_STEP_SCALE;
 const int DEFAULT_MOVE_STEPS = 10;
+const float SHAFT_ZNEAR = 2.0f;
+const float SHAFT_ZFAR = 2000.0f;
+const float HINT_SIZE = 0.6f;
+const double PROGRESS_REDRAW_INTERVAL = 0.05;
 
 BlockView::BlockView(BlockModel& model) :
     _model(model),
-    _showNextBlock(false),
-    _showBlockIndicator(false),
+    _showNextBlock("showNextBlock", false),
+    _showBlockIndicator("showBlockIndicator", false),
+    _allowShaftTilting("allowShaftTilting", false),
+    _drawSolidShaftTiles("drawSolidShaftTiles", true),
+    _drawShaftTileFrame("drawShaftTileFrame", false),
+    _showFPS("showFPS", false),
+    _rotationSpeedSetting("rotationSpeed", 7.0f),
+    _moveSpeedSetting("moveSpeed", 5),
     _blockAngle(0.0),
     _blockFace(0),
     _rotationSpeed(DEFAULT_ROTATION_SPEED),
@@ -53,9 +69,30 @@ BlockView::BlockView(BlockModel& model) :
     _shaftVerts(0),
     _shaftNormals(0),
     _shaftVindices(0),
-    _shaftVao(0) {
+    _shaftLineIndices(0),
+    _shaftVao(0),
+    _shaftMeshWidth(0),
+    _shaftMeshHeight(0),
+    _shaftMeshDepth(0),
+    _shaftMeshSquareSize(0.0f),
+    _shaftTileIndexCount(0),
+    _shaftFrameIndexCount(0),
+    _frozenFrame(0),
+    _frozenFrameDirty(true),
+    _frozenContext(Context::eUnknown),
+    _frozenHighScore(0),
+    _lastProgressDraw(0.0) {
     XTRACE();
     resetRotations();
+
+    _rotationSpeedSetting.subscribe([this](const float& rotSpeed) { _rotationSpeed = 5.0f + rotSpeed * 1.5f; });
+    _moveSpeedSetting.subscribe([this](const int& moveSpeed) { _moveSteps = 20 - 2 * moveSpeed; });
+
+    //these change the shaft, the frozen menu background needs a redraw
+    ConfigValue<bool>::Callback shaftChanged = [this](const bool&) { _frozenFrameDirty = true; };
+    _allowShaftTilting.subscribe(shaftChanged);
+    _drawSolidShaftTiles.subscribe(shaftChanged);
+    _drawShaftTileFrame.subscribe(shaftChanged);
 }
 
 BlockView::~BlockView() {
@@ -64,17 +101,19 @@ BlockView::~BlockView() {
     delete _shaftVerts;
     delete _shaftNormals;
     delete _shaftVindices;
+    delete _shaftLineIndices;
     delete _shaftVao;
+    delete _frozenFrame;
     VideoBaseS::cleanup();
 }
 
-bool BlockView::init(void) {
-    if (!VideoBaseS::instance()->init()) {
-        return false;
-    }
-
+bool BlockView::init(AssetLoader& preloader) {
     initGL3Test();
 
+    //assets have been decoding since before the window was opened
+    preloader.finish(this);
+    TextureManagerS::instance()->dumpMemoryStats();
+
     //set title and icon name
     //SDL_WM_SetCaption( "Shaaft OpenGL", "Shaaft GL" ); -- SDL1
 
@@ -149,9 +188,14 @@ void BlockView::resolutionChanged(int /*w*/, int /*h*/) {
 #endif
     ProgramManagerS::instance()->reset();
     initGL3Test();
+
+    delete _frozenFrame;
+    _frozenFrame = 0;
+    _frozenFrameDirty = true;
 }
 
 void BlockView::update(void) {
+    PROFILE_ZONE("BlockView::update");
     if (GameState::isAlive) {
         _prevOffset = _currentOffset;
         _prev2Angle = _currentAngle;
@@ -180,21 +224,6 @@ void BlockView::update(void) {
     _blockAngle += BLOCKROTSPEED;
 }
 
-void BlockView::updateSettings(void) {
-    float rotSpeed = 7.0;
-    ConfigS::instance()->getFloat("rotationSpeed", rotSpeed);
-    _rotationSpeed = 5.0f + rotSpeed * 1.5f;
-
-    int moveSpeed = 5;
-    ConfigS::instance()->getInteger("moveSpeed", moveSpeed);
-    _moveSteps = 20 - 2 * moveSpeed;
-
-    ConfigS::instance()->getBoolean("showNextBlock", _showNextBlock);
-    ConfigS::instance()->getBoolean("showBlockIndicator", _showBlockIndicator);
-
-    VideoBaseS::instance()->updateSettings();
-}
-
 //--------------------------------------------------------------------------------------
 //Smoothing
 void BlockView::resetRotations(void) {
@@ -274,6 +303,51 @@ float BlockView::getInterpolatedAngle(void) {
     return _prev2Angle + (_currentAngle - _prev2Angle) * gf;
 }
 
+void BlockView::assetLoaded(const std::string& /*assetName*/, int loaded, int total) {
+    //each swap waits for vsync, redrawing for every asset would hold up startup
+    double now = Timer::getTime();
+    if ((loaded < total) && ((now - _lastProgressDraw) < PROGRESS_REDRAW_INTERVAL)) {
+        return;
+    }
+    _lastProgressDraw = now;
+
+    VideoBase& video = *VideoBaseS::instance();
+    glViewport(0, 0, video.getWidth(), video.getHeight());
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    MatrixStack::projection.push(glm::ortho(0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f));
+    MatrixStack::model.push(glm::mat4(1.0));
+
+    float barEnd = 0.2f + 0.6f * (float)loaded / (float)total;
+    vec4f frame[4] = {
+        vec4f(0.2f, 0.48f, 0, 1),
+        vec4f(0.2f, 0.52f, 0, 1),
+        vec4f(0.8f, 0.52f, 0, 1),
+        vec4f(0.8f, 0.48f, 0, 1),
+    };
+    vec4f bar[4] = {
+        vec4f(0.2f, 0.48f, 0, 1),
+        vec4f(0.2f, 0.52f, 0, 1),
+        vec4f(barEnd, 0.52f, 0, 1),
+        vec4f(barEnd, 0.48f, 0, 1),
+    };
+    GLVBO vbo;
+    vbo.setColor(1.0f, 1.0f, 1.0f, 0.2f);
+    vbo.DrawQuad(frame);
+    vbo.setColor(1.0f, 1.0f, 1.0f, 0.8f);
+    vbo.DrawQuad(bar);
+
+    MatrixStack::model.pop();
+    MatrixStack::projection.pop();
+
+    video.swap();
+}
+
 void BlockView::initGL3Test() {
     while (!MatrixStack::model.empty()) {
         MatrixStack::model.pop();
@@ -288,6 +362,13 @@ void BlockView::initGL3Test() {
     Program* progLight = ProgramManagerS::instance()->createProgram("lighting");
     progLight->use();
 
+    delete _shaftVerts;
+    delete _shaftNormals;
+    delete _shaftVindices;
+    delete _shaftLineIndices;
+    delete _shaftVao;
+    _shaftMeshWidth = 0;
+
     _shaftVao = new VertexArray();
     _shaftVao->bind();
 
@@ -303,6 +384,8 @@ void BlockView::initGL3Test() {
     _shaftNormals->bind(GL_ARRAY_BUFFER);
     glVertexAttribPointer(shaftNormLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
+    _shaftLineIndices = new Buffer();
+
     _shaftVindices = new Buffer();
     _shaftVindices->bind(GL_ELEMENT_ARRAY_BUFFER);
 
@@ -319,12 +402,44 @@ void BlockView::initGL3Test() {
 //--------------------------------------------------------------------------------------
 //Drawing
 void BlockView::draw(void) {
-    static double nextTime = Timer::getTime() + 0.5;
-    double thisTime = Timer::getTime();
-    if (thisTime > nextTime) {
-        updateSettings();
-        nextTime = thisTime + 0.5;
+    PROFILE_ZONE("BlockView::draw");
+    VideoBase& video = *VideoBaseS::instance();
+    video.update();
+
+    if (GameState::context == Context::eInGame) {
+        _frozenFrameDirty = true;
+        drawScene();
+    } else {
+        if (!_frozenFrame) {
+            _frozenFrame = new FrameBuffer(true);
+        }
+
+        //online score merges can change the high score while we sit in the menu
+        int highScore = ScoreKeeperS::instance()->getHighScore();
+        if ((_frozenContext != GameState::context) || (_frozenHighScore != highScore)) {
+            _frozenFrameDirty = true;
+        }
+
+        if (_frozenFrame->resize(video.getWidth(), video.getHeight())) {
+            if (_frozenFrameDirty) {
+                _frozenFrame->bind();
+                drawScene();
+                FrameBuffer::unbind();
+
+                _frozenContext = GameState::context;
+                _frozenHighScore = highScore;
+                _frozenFrameDirty = false;
+            }
+            _frozenFrame->blit();
+        } else {
+            drawScene();
+        }
     }
+
+    drawFPS();
+}
+
+void BlockView::drawScene(void) {
     VideoBase& video = *VideoBaseS::instance();
     float gf = GameState::frameFraction;
 
@@ -344,7 +459,7 @@ void BlockView::draw(void) {
     projection = glm::mat4(1.0);
 
     const float fov = 53.13f;
-    projection = glm::perspective(glm::radians(fov), 1.0f, 2.0f, 2000.0f);
+    projection = glm::perspective(glm::radians(fov), 1.0f, SHAFT_ZNEAR, SHAFT_ZFAR);
 #if 0
     projection = glm::frustum<float>(
         (3.0/3.0)*(-2.0*tan(fov * M_PI / 360.0)),   //xmin
@@ -406,10 +521,7 @@ void BlockView::draw(void) {
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0)));
     //glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(viewer) );
 
-    bool allowShaftTilting = false;
-    ConfigS::instance()->getBoolean("allowShaftTilting", allowShaftTilting);
-
-    if (allowShaftTilting) {
+    if (_allowShaftTilting) {
         float interpPitch = GameState::prevShaftPitch + (GameState::shaftPitch - GameState::prevShaftPitch) * gf;
         float interpYaw = GameState::prevShaftYaw + (GameState::shaftYaw - GameState::prevShaftYaw) * gf;
 
@@ -429,15 +541,11 @@ void BlockView::draw(void) {
     _bottom = -120.0f - ((float)d * _squaresize);
 
     // -- Draw the shaft
-    bool drawSolidShaftTiles = true;
-    ConfigS::instance()->getBoolean("drawSolidShaftTiles", drawSolidShaftTiles);
-    if (drawSolidShaftTiles) {
+    if (_drawSolidShaftTiles) {
         drawShaft(false);
     }
 
-    bool drawShaftTileFrame = false;
-    ConfigS::instance()->getBoolean("drawShaftTileFrame", drawShaftTileFrame);
-    if (drawShaftTileFrame) {
+    if (_drawShaftTileFrame) {
         drawShaft(true);
     }
 
@@ -491,6 +599,8 @@ void BlockView::draw(void) {
         }
     }
 
+    flushRenderQueue();
+
     //--- draw indicator and next block on score board
 
     int statsOffset = video.getWidth() - blockView / 3;
@@ -575,15 +685,6 @@ void BlockView::draw(void) {
     modelview = MatrixStack::model.top();
 
     float textWidth;
-    FPS::Update();
-    bool showFPS = false;
-    ConfigS::instance()->getBoolean("showFPS", showFPS);
-    if (showFPS) {
-        textWidth = _fineFont->GetWidth(FPS::GetFPSString(), 0.5);
-        _fineFont->setColor(1.0, 1.0, 1.0, 1.0);
-        _fineFont->DrawString(FPS::GetFPSString(), orthoWidth - textWidth - 5, orthoHeight - 30, 0.5, 0.5);
-    }
-
     char num[30];
 
     _font->setColor(1.0, 1.0, 1.0, 1.0);
@@ -729,12 +830,80 @@ void BlockView::draw(void) {
                 _font->setColor(1.0f, 0.852f, 0.0f, 1.0f);
                 _font->DrawString(toMenu.c_str(), boardOffset.x + 90.0f, boardOffset.y + 50.0f, 1.2f, 1.2f);
             }
+
+            //ranked once when the game ended, not per frame
+            const GameRank& gameRank = ScoreKeeperS::instance()->getLastGameRank();
+            if (gameRank.total > 0) {
+                char rankText[80];
+                sprintf(rankText, "Rank %u of %u games (top %d%%)", (unsigned int)gameRank.rank,
+                        (unsigned int)gameRank.total, gameRank.topPercent);
+                _font->setColor(1.0f, 1.0f, 1.0f, 1.0f);
+                _font->DrawString(rankText, boardOffset.x + 90.0f, boardOffset.y + 95.0f, 0.8f, 0.8f);
+            }
         } else {
             ParticleGroupManagerS::instance()->draw();
         }
     }
 }
 
+void BlockView::drawFPS(void) {
+    FPS::Update();
+
+    if (!_showFPS) {
+        return;
+    }
+
+    //drawn on top of the (possibly frozen) score board every frame
+    VideoBase& video = *VideoBaseS::instance();
+    int blockView = video.getHeight();
+    int statsOffset = video.getWidth() - blockView / 3;
+    glViewport(statsOffset, 0, blockView / 3, video.getHeight());
+    glDisable(GL_DEPTH_TEST);
+
+    float orthoHeight = 750.0;
+    float orthoWidth = 250.0;
+    glm::mat4 projection = glm::ortho(-0.5f, orthoWidth + 0.5f, -0.5f, orthoHeight + 0.5f, -1000.0f, 1000.0f);
+    {
+        Program* prog = ProgramManagerS::instance()->getProgram("texture");
+        prog->use();  //needed to set uniforms
+        GLint modelViewMatrixLoc = glGetUniformLocation(prog->id(), "modelViewMatrix");
+        glUniformMatrix4fv(modelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    }
+
+    float textWidth = _fineFont->GetWidth(FPS::GetFPSString(), 0.5);
+    _fineFont->setColor(1.0, 1.0, 1.0, 1.0);
+    _fineFont->DrawString(FPS::GetFPSString(), orthoWidth - textWidth - 5, orthoHeight - 30, 0.5, 0.5);
+
+    FrameLimiter& limiter = GameS::instance()->getFrameLimiter();
+    char frameTime[40];
+    sprintf(frameTime, "%.1fms +/-%.1f", limiter.getFrameTime(), limiter.getJitter());
+    textWidth = _fineFont->GetWidth(frameTime, 0.5);
+    _fineFont->DrawString(frameTime, orthoWidth - textWidth - 5, orthoHeight - 50, 0.5, 0.5);
+
+    VoiceStats voiceStats;
+    if (AudioS::instance()->getVoiceStats(voiceStats)) {
+        char voices[60];
+        sprintf(voices, "voices %d/%d peak %d %.0fms", voiceStats.active, voiceStats.channels, voiceStats.peakActive,
+                voiceStats.bufferMs);
+        textWidth = _fineFont->GetWidth(voices, 0.5);
+        _fineFont->DrawString(voices, orthoWidth - textWidth - 5, orthoHeight - 70, 0.5, 0.5);
+
+        sprintf(voices, "stolen %u dropped %u xrun %u", voiceStats.stolen, voiceStats.dropped, voiceStats.underruns);
+        textWidth = _fineFont->GetWidth(voices, 0.5);
+        _fineFont->DrawString(voices, orthoWidth - textWidth - 5, orthoHeight - 90, 0.5, 0.5);
+    }
+
+    TextureMemoryStats textureStats;
+    TextureManagerS::instance()->getMemoryStats(textureStats);
+    char textures[60];
+    sprintf(textures, "tex %d cpu %uK gpu %uK", textureStats.textures, (unsigned int)(textureStats.cpuBytes / 1024),
+            (unsigned int)(textureStats.gpuBytes / 1024));
+    textWidth = _fineFont->GetWidth(textures, 0.5);
+    _fineFont->DrawString(textures, orthoWidth - textWidth - 5, orthoHeight - 110, 0.5, 0.5);
+
+    glViewport(0, 0, video.getWidth(), video.getHeight());
+}
+
 void BlockView::drawIndicator(void) {
     MatrixStack::model.push(MatrixStack::model.top());
     glm::mat4& modelview = MatrixStack::model.top();
@@ -791,32 +960,167 @@ void BlockView::drawNextBlock(void) {
 }
 
 void BlockView::drawShaft(bool drawLines) {
+    MatrixStack::model.push(MatrixStack::model.top());
+    glm::mat4& modelview = MatrixStack::model.top();
+
+    modelview = glm::translate(modelview, glm::vec3(0, 0, _bottom));
+
+    //the walls enclose everything else, keep them at the far end of the transparent pass
+    vec4f tileColor(0.0, 1.0, 0.0, 0.5);
+    submit(RenderQueue::eTransparent, drawLines ? eDrawShaftFrame : eDrawShaftTiles, 0, tileColor);
+
+    MatrixStack::model.pop();
+}
+
+void BlockView::buildShaftMesh(void) {
     int w = _model.getWidth();
     int h = _model.getHeight();
     int d = _model.getDepth();
 
+    if ((w == _shaftMeshWidth) && (h == _shaftMeshHeight) && (d == _shaftMeshDepth) &&
+        (_squaresize == _shaftMeshSquareSize)) {
+        return;
+    }
+    _shaftMeshWidth = w;
+    _shaftMeshHeight = h;
+    _shaftMeshDepth = d;
+    _shaftMeshSquareSize = _squaresize;
+
     float tilesize = _squaresize * 0.80f;
     float halfgapsize = (_squaresize - tilesize) / 2.0f;
 
-    glDisable(GL_DEPTH_TEST);
+    vector<vec3f> verts;
+    vector<vec3f> normals;
 
-    MatrixStack::model.push(MatrixStack::model.top());
-    glm::mat4& modelview = MatrixStack::model.top();
+    //bottom
+    for (int x = 0; x < w; x++) {
+        float xp = x * _squaresize - _squaresize * w / 2.0f + halfgapsize;
+        for (int y = 0; y < h; y++) {
+            float yp = y * _squaresize - _squaresize * h / 2.0f + halfgapsize;
+            verts.push_back(vec3f(xp, yp, 0));
+            verts.push_back(vec3f(xp + tilesize, yp, 0));
+            verts.push_back(vec3f(xp + tilesize, yp + tilesize, 0));
+            verts.push_back(vec3f(xp, yp + tilesize, 0));
+            normals.insert(normals.end(), 4, vec3f(0, 0, 1));
+        }
+    }
 
-    modelview = glm::translate(modelview, glm::vec3(0, 0, _bottom));
+    //front and back walls
+    for (int x = 0; x < w; x++) {
+        float xp = x * _squaresize - _squaresize * w / 2.0f + halfgapsize;
+        float yp = _squaresize * h / 2.0f;
+        for (int z = 0; z < d; z++) {
+            float zp = z * _squaresize;
+
+            verts.push_back(vec3f(xp + tilesize, -yp, zp));
+            verts.push_back(vec3f(xp, -yp, zp));
+            verts.push_back(vec3f(xp, -yp, zp + tilesize));
+            verts.push_back(vec3f(xp + tilesize, -yp, zp + tilesize));
+            normals.insert(normals.end(), 4, vec3f(0, 1, 0));
+
+            verts.push_back(vec3f(xp + tilesize, yp, zp + tilesize));
+            verts.push_back(vec3f(xp, yp, zp + tilesize));
+            verts.push_back(vec3f(xp, yp, zp));
+            verts.push_back(vec3f(xp + tilesize, yp, zp));
+            normals.insert(normals.end(), 4, vec3f(0, -1, 0));
+        }
+    }
+
+    //left and right walls
+    for (int y = 0; y < h; y++) {
+        float xp = _squaresize * w / 2.0f;
+        float yp = y * _squaresize - _squaresize * h / 2.0f + halfgapsize;
+        for (int z = 0; z < d; z++) {
+            float zp = z * _squaresize;
+
+            verts.push_back(vec3f(-xp, yp, zp));
+            verts.push_back(vec3f(-xp, yp + tilesize, zp));
+            verts.push_back(vec3f(-xp, yp + tilesize, zp + tilesize));
+            verts.push_back(vec3f(-xp, yp, zp + tilesize));
+            normals.insert(normals.end(), 4, vec3f(1, 0, 0));
+
+            verts.push_back(vec3f(xp, yp, zp + tilesize));
+            verts.push_back(vec3f(xp, yp + tilesize, zp + tilesize));
+            verts.push_back(vec3f(xp, yp + tilesize, zp));
+            verts.push_back(vec3f(xp, yp, zp));
+            normals.insert(normals.end(), 4, vec3f(-1, 0, 0));
+        }
+    }
+
+    vector<GLuint> tileIndices;
+    vector<GLuint> frameIndices;
+    for (GLuint i = 0; i < (GLuint)verts.size(); i += 4) {
+        GLuint tri[6] = {i, i + 1, i + 2, i, i + 2, i + 3};
+        tileIndices.insert(tileIndices.end(), tri, tri + 6);
+
+        GLuint line[8] = {i, i + 1, i + 1, i + 2, i + 2, i + 3, i + 3, i};
+        frameIndices.insert(frameIndices.end(), line, line + 8);
+    }
+    _shaftTileIndexCount = (GLsizei)tileIndices.size();
+    _shaftFrameIndexCount = (GLsizei)frameIndices.size();
+
+    _shaftVao->bind();
+    _shaftVerts->bind(GL_ARRAY_BUFFER);
+    _shaftVerts->setData(GL_ARRAY_BUFFER, verts.size() * sizeof(vec3f), verts.data(), GL_STATIC_DRAW);
+    _shaftNormals->bind(GL_ARRAY_BUFFER);
+    _shaftNormals->setData(GL_ARRAY_BUFFER, normals.size() * sizeof(vec3f), normals.data(), GL_STATIC_DRAW);
+    _shaftLineIndices->bind(GL_ELEMENT_ARRAY_BUFFER);
+    _shaftLineIndices->setData(GL_ELEMENT_ARRAY_BUFFER, frameIndices.size() * sizeof(GLuint), frameIndices.data(),
+                               GL_STATIC_DRAW);
+    _shaftVindices->bind(GL_ELEMENT_ARRAY_BUFFER);
+    _shaftVindices->setData(GL_ELEMENT_ARRAY_BUFFER, tileIndices.size() * sizeof(GLuint), tileIndices.data(),
+                            GL_STATIC_DRAW);
+    _shaftVao->unbind();
+}
+
+void BlockView::drawShaftMesh(bool drawLines, const vec4f& color) {
+    buildShaftMesh();
 
     Program* prog = ProgramManagerS::instance()->getProgram("lighting");
     prog->use();  //needed to set uniforms
     GLint modelLoc = glGetUniformLocation(prog->id(), "model");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelview));
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(MatrixStack::model.top()));
+
+    GLint objectColorLoc = glGetUniformLocation(prog->id(), "objectColor");
+    glUniform4fv(objectColorLoc, 1, color.array);
 
-    int drawType;
     if (drawLines) {
-        drawType = GL_LINE_LOOP;
-        //glLineWidth(3.0);
+        _shaftVao->bindElementBuffer(_shaftLineIndices);
+        glDrawElements(GL_LINES, _shaftFrameIndexCount, GL_UNSIGNED_INT, NULL);
+        _shaftVao->bindElementBuffer(_shaftVindices);
     } else {
-        drawType = GL_TRIANGLE_FAN;
+        _shaftVao->bind();
+        glDrawElements(GL_TRIANGLES, _shaftTileIndexCount, GL_UNSIGNED_INT, NULL);
     }
+    _shaftVao->unbind();
+}
+
+void BlockView::submit(RenderQueue::Pass pass, DrawType type, Model* model, const vec4f& color) {
+    DrawItem item;
+    item.type = type;
+    item.model = model;
+    item.transform = MatrixStack::model.top();
+    item.color = color;
+
+    float depth = 1.0f;
+    if ((type != eDrawShaftTiles) && (type != eDrawShaftFrame)) {
+        glm::vec4 eye = item.transform * glm::vec4(0, 0, 0, 1);
+        depth = (-eye.z - SHAFT_ZNEAR) / (SHAFT_ZFAR - SHAFT_ZNEAR);
+    }
+
+    bool textured = (type == eDrawHint);
+    Program* prog = ProgramManagerS::instance()->getProgram(textured ? "texture" : "lighting");
+
+    uint64_t key = RenderQueue::makeKey(pass, prog->id(), textured ? 1 : 0, depth);
+    _renderQueue.add(key, (unsigned int)_drawItems.size());
+    _drawItems.push_back(item);
+}
+
+void BlockView::flushRenderQueue(void) {
+    _renderQueue.sort();
+
+    Program* prog = ProgramManagerS::instance()->getProgram("lighting");
+    prog->use();  //needed to set uniforms
 
     GLint lightPosLoc = glGetUniformLocation(prog->id(), "lightPos");
     vec3f lightPos(-600.0, 600.0, 400.0);
@@ -830,142 +1134,64 @@ void BlockView::drawShaft(bool drawLines) {
     vec3f lightColor(1.0, 1.0, 1.0);
     glUniform3fv(lightColorLoc, 1, lightColor.array);
 
-    GLint objectColorLoc = glGetUniformLocation(prog->id(), "objectColor");
-    vec4f tileColor(0.0, 1.0, 0.0, 0.5);
-    glUniform4fv(objectColorLoc, 1, tileColor.array);
-
-    _shaftVao->bind();
+    glEnable(GL_DEPTH_TEST);
 
-    for (int x = 0; x < w; x++) {
-        float xp = x * _squaresize - _squaresize * w / 2.0f + halfgapsize;
-        for (int y = 0; y < h; y++) {
-            float yp = y * _squaresize - _squaresize * h / 2.0f + halfgapsize;
-            vec3f v[4] = {
-                vec3f(  xp         , yp         , 0),
-                vec3f(  xp+tilesize, yp         , 0),
-                vec3f(  xp+tilesize, yp+tilesize, 0),
-                vec3f(  xp         , yp+tilesize, 0),
-            };
-            vec3f n[4] = {
-                vec3f(0, 0, 1),
-                vec3f(0, 0, 1),
-                vec3f(0, 0, 1),
-                vec3f(0, 0, 1),
-            };
-
-            _shaftVerts->bind(GL_ARRAY_BUFFER);
-            _shaftVerts->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), v, GL_STATIC_DRAW);
-
-            _shaftNormals->bind(GL_ARRAY_BUFFER);
-            _shaftNormals->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), n, GL_STATIC_DRAW);
-
-            glDrawArrays(drawType, 0, 4);
+    int currentPass = -1;
+    for (size_t i = 0; i < _renderQueue.size(); i++) {
+        RenderQueue::Pass pass = RenderQueue::getPass(_renderQueue.key(i));
+        if (pass != currentPass) {
+            currentPass = pass;
+            if (pass == RenderQueue::eOpaque) {
+                glDisable(GL_BLEND);
+                glDepthMask(GL_TRUE);
+            } else {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glDepthMask(GL_FALSE);
+            }
         }
-    }
 
-    for (int x = 0; x < w; x++) {
-        float xp = x * _squaresize - _squaresize * w / 2.0f + halfgapsize;
-        float yp = _squaresize * h / 2.0f;
-        for (int z = 0; z < d; z++) {
-            float zp = z * _squaresize;
+        DrawItem& item = _drawItems[_renderQueue.item(i)];
+        MatrixStack::model.push(item.transform);
 
-            vec3f v[4] = {
-                vec3f(  xp+tilesize,-yp, zp),
-                vec3f(  xp         ,-yp, zp),
-                vec3f(  xp         ,-yp, zp+tilesize),
-                vec3f(  xp+tilesize,-yp, zp+tilesize),
-            };
-            vec3f n[4] = {
-                vec3f(0, 1, 0),
-                vec3f(0, 1, 0),
-                vec3f(0, 1, 0),
-                vec3f(0, 1, 0),
-            };
-            _shaftVerts->bind(GL_ARRAY_BUFFER);
-            _shaftVerts->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), v, GL_STATIC_DRAW);
-
-            _shaftNormals->bind(GL_ARRAY_BUFFER);
-            _shaftNormals->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), n, GL_STATIC_DRAW);
-
-            glDrawArrays(drawType, 0, 4);
-
-            vec3f v2[4] = {
-                vec3f(  xp+tilesize, yp, zp+tilesize),
-                vec3f(  xp         , yp, zp+tilesize),
-                vec3f(  xp         , yp, zp),
-                vec3f(  xp+tilesize, yp, zp),
-            };
-            vec3f n2[4] = {
-                vec3f(0, -1, 0),
-                vec3f(0, -1, 0),
-                vec3f(0, -1, 0),
-                vec3f(0, -1, 0),
-            };
-
-            _shaftVerts->bind(GL_ARRAY_BUFFER);
-            _shaftVerts->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), v2, GL_STATIC_DRAW);
-
-            _shaftNormals->bind(GL_ARRAY_BUFFER);
-            _shaftNormals->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), n2, GL_STATIC_DRAW);
-
-            glDrawArrays(drawType, 0, 4);
-        }
-    }
+        switch (item.type) {
+            case eDrawShaftTiles:
+                drawShaftMesh(false, item.color);
+                break;
 
-    for (int y = 0; y < h; y++) {
-        float xp = _squaresize * w / 2.0f;
-        float yp = y * _squaresize - _squaresize * h / 2.0f + halfgapsize;
-        for (int z = 0; z < d; z++) {
-            float zp = z * _squaresize;
+            case eDrawShaftFrame:
+                drawShaftMesh(true, item.color);
+                break;
+
+            case eDrawModel:
+                item.model->setColor(item.color);
+                item.model->draw();
+                break;
+
+            case eDrawHint: {
+                GLBitmapCollection* scoreBoard = BitmapManagerS::instance()->getBitmap("bitmaps/scoreBoard");
+                scoreBoard->bind();
 
-            vec3f v[4] = {
-                vec3f(-xp, yp         , zp),
-                vec3f(-xp, yp+tilesize, zp),
-                vec3f(-xp, yp+tilesize, zp+tilesize),
-                vec3f(-xp, yp         , zp+tilesize),
-            };
-            vec3f n[4] = {
-                vec3f(1, 0, 0),
-                vec3f(1, 0, 0),
-                vec3f(1, 0, 0),
-                vec3f(1, 0, 0),
-            };
-
-            _shaftVerts->bind(GL_ARRAY_BUFFER);
-            _shaftVerts->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), v, GL_STATIC_DRAW);
-
-            _shaftNormals->bind(GL_ARRAY_BUFFER);
-            _shaftNormals->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), n, GL_STATIC_DRAW);
-
-            glDrawArrays(drawType, 0, 4);
-
-            vec3f v2[4] = {
-                vec3f( xp, yp         , zp+tilesize),
-                vec3f( xp, yp+tilesize, zp+tilesize),
-                vec3f( xp, yp+tilesize, zp),
-                vec3f( xp, yp         , zp),
-            };
-            vec3f n2[4] = {
-                vec3f(-1, 0, 0),
-                vec3f(-1, 0, 0),
-                vec3f(-1, 0, 0),
-                vec3f(-1, 0, 0),
-            };
-
-            _shaftVerts->bind(GL_ARRAY_BUFFER);
-            _shaftVerts->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), v2, GL_STATIC_DRAW);
-
-            _shaftNormals->bind(GL_ARRAY_BUFFER);
-            _shaftNormals->setData(GL_ARRAY_BUFFER, 4 * sizeof(vec3f), n2, GL_STATIC_DRAW);
-
-            glDrawArrays(drawType, 0, 4);
+                Program* prog = ProgramManagerS::instance()->getProgram("texture");
+                prog->use();  //needed to set uniforms
+                GLint modelViewMatrixLoc = glGetUniformLocation(prog->id(), "modelViewMatrix");
+                glUniformMatrix4fv(modelViewMatrixLoc, 1, GL_FALSE,
+                                   glm::value_ptr(MatrixStack::projection.top() * item.transform));
+
+                scoreBoard->setColor(item.color);
+                scoreBoard->Draw(_target, 0, 0, 0.18f * HINT_SIZE, 0.18f * HINT_SIZE);
+            } break;
         }
+
+        MatrixStack::model.pop();
     }
-    _shaftVao->unbind();
 
-    MatrixStack::model.pop();
+    glDepthMask(GL_TRUE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glEnable(GL_DEPTH_TEST);
+    _renderQueue.clear();
+    _drawItems.clear();
 }
 
 vec4f BlockView::getColor(int p) {
@@ -1041,8 +1267,7 @@ void BlockView::drawElement(Point3Di* p, BlockType blockType) {
         modelview = glm::translate(modelview, glm::vec3(xp, yp, zp));
         modelview = glm::scale(modelview, glm::vec3(_squaresize * 0.5f, _squaresize * 0.5f, _squaresize * 0.5f));
 
-        _indicator->setColor(getColor(p->z));
-        _indicator->draw();
+        submit(RenderQueue::eOpaque, eDrawModel, _indicator, getColor(p->z));
 
         MatrixStack::model.pop();
     }
@@ -1095,23 +1320,13 @@ void BlockView::drawElement(Point3Di* p, BlockType blockType) {
     }
 #endif
     else if (blockType == Hint) {
-        GLBitmapCollection* scoreBoard = BitmapManagerS::instance()->getBitmap("bitmaps/scoreBoard");
-        scoreBoard->bind();
-
-        float hintSize = 0.6f;
         MatrixStack::model.push(MatrixStack::model.top());
         glm::mat4& modelview = MatrixStack::model.top();
 
-        modelview = glm::translate(modelview, glm::vec3(xp - halftilesize * hintSize, yp - halftilesize * hintSize,
-                                                        zp - halftilesize * hintSize));
-
-        Program* prog = ProgramManagerS::instance()->getProgram("texture");
-        prog->use();  //needed to set uniforms
-        GLint modelViewMatrixLoc = glGetUniformLocation(prog->id(), "modelViewMatrix");
-        glUniformMatrix4fv(modelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(MatrixStack::projection.top() * modelview));
+        modelview = glm::translate(modelview, glm::vec3(xp - halftilesize * HINT_SIZE, yp - halftilesize * HINT_SIZE,
+                                                        zp - halftilesize * HINT_SIZE));
 
-        scoreBoard->setColor(1.0, 1.0, 1.0, 1.0f);
-        scoreBoard->Draw(_target, 0, 0, 0.18f * hintSize, 0.18f * hintSize);
+        submit(RenderQueue::eTransparent, eDrawHint, 0, vec4f(1.0f, 1.0f, 1.0f, 1.0f));
 
         MatrixStack::model.pop();
     } else {
@@ -1121,7 +1336,8 @@ void BlockView::drawElement(Point3Di* p, BlockType blockType) {
         modelview = glm::translate(modelview, glm::vec3(xp, yp, zp));
         modelview = glm::scale(modelview, glm::vec3(_squaresize * 0.6f, _squaresize * 0.6f, _squaresize * 0.6f));
 
-        _cube->draw();
+        //negative color: use the model's vertex colors
+        submit(RenderQueue::eOpaque, eDrawModel, _cube, vec4f(-1.0f, -1.0f, -1.0f, 1.0f));
 
         MatrixStack::model.pop();
     }
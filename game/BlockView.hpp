@@ -8,27 +8,39 @@
 #include "Quaternion.hpp"
 #include "GLBitmapFont.hpp"
 #include "Model.hpp"
+#include "AssetLoader.hpp"
 
 #include "BlockModel.hpp"
 #include "VideoBase.hpp"
 #include "TextInput.hpp"
+#include "Context.hpp"
+#include "Config.hpp"
+
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "gl3/RenderQueue.hpp"
 
 class Buffer;
 class VertexArray;
+class FrameBuffer;
 
-class BlockView : public ResolutionChangeObserverI {
+class BlockView : public ResolutionChangeObserverI, public AssetLoadObserverI {
 public:
     BlockView(BlockModel& model);
     virtual ~BlockView();
 
-    bool init(void);
+    //needs VideoBase initialized, uploads what preloader has decoded
+    bool init(AssetLoader& preloader);
     void draw(void);
 
     virtual void resolutionChanged(int w, int h);
 
+    //draw preload progress bar
+    virtual void assetLoaded(const std::string& assetName, int loaded, int total);
+
     // game step update
     void update(void);
-    void updateSettings(void);
 
     //The model will call these when a new block or a new
     //rotation was applied.
@@ -58,10 +70,33 @@ private:
         Lookahead,
     };
 
+    void drawScene(void);
+    void drawFPS(void);
+
     void drawElement(Point3Di* p, BlockType blockType);
     void drawLockedElements(void);
 
+    //Shaft view draws are queued and executed sorted once per frame
+    enum DrawType {
+        eDrawShaftTiles,
+        eDrawShaftFrame,
+        eDrawModel,
+        eDrawHint,
+    };
+
+    struct DrawItem {
+        DrawType type;
+        Model* model;
+        glm::mat4 transform;
+        vec4f color;
+    };
+
+    void submit(RenderQueue::Pass pass, DrawType type, Model* model, const vec4f& color);
+    void flushRenderQueue(void);
+
     void drawShaft(bool drawLines);
+    void buildShaftMesh(void);
+    void drawShaftMesh(bool drawLines, const vec4f& color);
     void drawIndicator(void);
     void drawNextBlock(void);
 
@@ -72,8 +107,14 @@ private:
     float _squaresize;
     float _bottom;
 
-    bool _showNextBlock;
-    bool _showBlockIndicator;
+    ConfigValue<bool> _showNextBlock;
+    ConfigValue<bool> _showBlockIndicator;
+    ConfigValue<bool> _allowShaftTilting;
+    ConfigValue<bool> _drawSolidShaftTiles;
+    ConfigValue<bool> _drawShaftTileFrame;
+    ConfigValue<bool> _showFPS;
+    ConfigValue<float> _rotationSpeedSetting;
+    ConfigValue<int> _moveSpeedSetting;
 
     float _blockAngle;
 
@@ -118,6 +159,27 @@ private:
     Buffer* _shaftVerts;
     Buffer* _shaftNormals;
     Buffer* _shaftVindices;
+    Buffer* _shaftLineIndices;
 
     VertexArray* _shaftVao;
+
+    //shaft tiles are uploaded once per shaft size
+    int _shaftMeshWidth;
+    int _shaftMeshHeight;
+    int _shaftMeshDepth;
+    float _shaftMeshSquareSize;
+    GLsizei _shaftTileIndexCount;
+    GLsizei _shaftFrameIndexCount;
+
+    RenderQueue _renderQueue;
+    std::vector<DrawItem> _drawItems;
+
+    //while paused or in the menu nothing moves, the scene is rendered once and reused
+    FrameBuffer* _frozenFrame;
+    bool _frozenFrameDirty;
+    Context::ContextEnum _frozenContext;
+    int _frozenHighScore;
+
+    //time of the last preload progress bar redraw
+    double _lastProgressDraw;
 };
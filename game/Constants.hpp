@@ -41,6 +41,8 @@ const int MAX_PARTICLES_PER_GROUP = 2048;
 const float GAME_STEP_SIZE = (1.0f / 30.0f);  //run logic 30 times per second
 const int MAX_GAME_STEPS = 20;                //max number of logic runs per frame
 
+const double IDLE_TIMEOUT = 5.0;  //seconds without input before menus drop to idleFPS
+
 // All updates in out logic are based on a game step size of 1/50.
 // In case we want to use a different GAME_STEP_SIZE in the future,
 // multiply all update values by GAME_STEP_SCALE.
@@ -0,0 +1,109 @@
+// Description:
+//   Frame rate limiter with vsync-aware sleeping and frame time stats.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "FrameLimiter.hpp"
+
+#include "SDL.h"
+#include <math.h>
+
+#include "Trace.hpp"
+#include "Profiler.hpp"
+#include "Config.hpp"
+#include "VideoBase.hpp"
+#include "Timer.hpp"
+
+//below this we spin instead of trusting the OS scheduler
+const double SPIN_MARGIN = 0.002;
+
+FrameLimiter::FrameLimiter(void) :
+    _maxFPS("maxFPS", 0),
+    _idleFPS("idleFPS", 20),
+    _throttleWhenIdle("throttleWhenIdle", true),
+    _nextDeadline(0.0),
+    _lastFrameEnd(0.0),
+    _frameIndex(0),
+    _frameCount(0),
+    _frameTimeAvg(0.0),
+    _jitter(0.0) {
+    XTRACE();
+    for (int i = 0; i < kFrameHistory; i++) {
+        _frameTimes[i] = 0.0;
+    }
+}
+
+//same clock as the game timers, so deadlines line up with game steps
+double FrameLimiter::getTime(void) {
+    return Timer::getTime();
+}
+
+void FrameLimiter::waitUntil(double deadline) {
+    double remaining = deadline - getTime();
+    if (remaining > SPIN_MARGIN) {
+        SDL_Delay((Uint32)((remaining - SPIN_MARGIN) * 1000.0));
+    }
+    while (getTime() < deadline) {
+        //spin for the last bit
+    }
+}
+
+void FrameLimiter::recordFrameTime(double frameTime) {
+    _frameTimes[_frameIndex] = frameTime;
+    _frameIndex = (_frameIndex + 1) % kFrameHistory;
+    if (_frameCount < kFrameHistory) {
+        _frameCount++;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < _frameCount; i++) {
+        sum += _frameTimes[i];
+    }
+    _frameTimeAvg = sum / _frameCount;
+
+    double variance = 0.0;
+    for (int i = 0; i < _frameCount; i++) {
+        double d = _frameTimes[i] - _frameTimeAvg;
+        variance += d * d;
+    }
+    _jitter = sqrt(variance / _frameCount);
+}
+
+void FrameLimiter::endFrame(bool idle) {
+    PROFILE_ZONE("FrameLimiter::endFrame");
+    double now = getTime();
+
+    int targetFPS = _maxFPS;
+    int idleFPS = _idleFPS;
+    if (idle && _throttleWhenIdle && (idleFPS > 0) && ((targetFPS <= 0) || (idleFPS < targetFPS))) {
+        targetFPS = idleFPS;
+    }
+
+    //with vsync on, swap already blocks at the refresh rate
+    VideoBase& video = *VideoBaseS::instance();
+    if (video.getSwapInterval() != 0 && (targetFPS >= video.getRefreshRate())) {
+        targetFPS = 0;
+    }
+
+#if !defined(EMSCRIPTEN)
+    //the browser paces requestAnimationFrame for us
+    if (targetFPS > 0) {
+        double period = 1.0 / targetFPS;
+        _nextDeadline += period;
+        if ((_nextDeadline < now) || (_nextDeadline > now + period)) {
+            //fell behind or rate changed, start over instead of trying to catch up
+            _nextDeadline = now + period;
+        }
+        waitUntil(_nextDeadline);
+    } else
+#endif
+    {
+        _nextDeadline = now;
+    }
+
+    double frameEnd = getTime();
+    if (_lastFrameEnd > 0.0) {
+        recordFrameTime(frameEnd - _lastFrameEnd);
+    }
+    _lastFrameEnd = frameEnd;
+}
@@ -0,0 +1,44 @@
+#pragma once
+// Description:
+//   Frame rate limiter with vsync-aware sleeping and frame time stats.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "Config.hpp"
+
+class FrameLimiter {
+public:
+    FrameLimiter(void);
+
+    //Called once per frame right after the buffer swap.
+    //Sleeps (and spins the last bit) until the next frame is due.
+    void endFrame(bool idle);
+
+    //Smoothed frame time and its standard deviation in milliseconds
+    double getFrameTime(void) { return _frameTimeAvg * 1000.0; }
+
+    double getJitter(void) { return _jitter * 1000.0; }
+
+private:
+    FrameLimiter(const FrameLimiter&);
+    FrameLimiter& operator=(const FrameLimiter&);
+
+    void waitUntil(double deadline);
+    void recordFrameTime(double frameTime);
+
+    static double getTime(void);
+
+    ConfigValue<int> _maxFPS;
+    ConfigValue<int> _idleFPS;
+    ConfigValue<bool> _throttleWhenIdle;
+
+    double _nextDeadline;
+    double _lastFrameEnd;
+
+    static const int kFrameHistory = 64;
+    double _frameTimes[kFrameHistory];
+    int _frameIndex;
+    int _frameCount;
+    double _frameTimeAvg;
+    double _jitter;
+};
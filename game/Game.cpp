@@ -8,6 +8,9 @@
 #include <time.h>
 
 #include "Trace.hpp"
+#include "Profiler.hpp"
+#include "Timer.hpp"
+#include "InitGraph.hpp"
 
 #include "GameState.hpp"
 #include "Constants.hpp"
@@ -19,7 +22,9 @@
 #include "BlockView.hpp"
 
 #include "ScoreKeeper.hpp"
+#include "OnlineScore.hpp"
 #include "MenuManager.hpp"
+#include "StartupTasks.hpp"
 
 #include <ParticleGroup.hpp>
 #include <ParticleGroupManager.hpp>
@@ -27,6 +32,11 @@
 
 #include "zStream.hpp"
 #include "ResourceManager.hpp"
+#include "AssetCache.hpp"
+
+#include "physfs.h"
+
+#include <sstream>
 
 #if defined(EMSCRIPTEN)
 #include <emscripten.h>
@@ -35,10 +45,38 @@
 
 using namespace std;
 
+//write the recorded zones to profile-<date>-<time>.json in the write directory
+static void dumpProfile(void) {
+    time_t now = time(0);
+    char fileName[64];
+    strftime(fileName, sizeof(fileName), "profile-%Y%m%d-%H%M%S.json", localtime(&now));
+
+    ostringstream trace;
+    Profiler::Dump(trace);
+    string data = trace.str();
+
+    PHYSFS_File* outfile = PHYSFS_openWrite(fileName);
+    if (!outfile) {
+        LOG_ERROR << "Unable to write profile " << fileName << endl;
+        return;
+    }
+    bool ok = (PHYSFS_writeBytes(outfile, data.data(), data.size()) == (PHYSFS_sint64)data.size());
+    PHYSFS_close(outfile);
+
+    if (ok) {
+        LOG_INFO << "Profile written to " << fileName << " (" << data.size() / 1024 << "KB)" << endl;
+    } else {
+        LOG_ERROR << "Unable to write profile " << fileName << endl;
+    }
+}
+
 Game::Game(void) :
     _model(0),
     _controller(0),
     _view(0),
+    _frameLimiter(),
+    _firstFrameDone(false),
+    _exitCode(0),
     _zo(0),
     _oStream(0),
     _zi(0),
@@ -51,6 +89,14 @@ Game::~Game() {
 
     LOG_INFO << "Shutting down..." << endl;
 
+    if (Profiler::IsRecording()) {
+        dumpProfile();
+        Profiler::Stop();
+    }
+
+    // stop score requests before SDL goes away
+    OnlineScore::Shutdown();
+
     delete _model;
     delete _controller;
 
@@ -73,6 +119,7 @@ Game::~Game() {
     ScoreKeeperS::instance()->save();
     ScoreKeeperS::cleanup();
     InputS::cleanup();
+    AssetCacheS::cleanup();
 
     // Note: this shuts down PHYSFS
     LOG_INFO << "ResourceManager cleanup..." << endl;
@@ -83,12 +130,16 @@ bool Game::init(void) {
     XTRACE();
     bool result = true;
 
-    ScoreKeeperS::instance()->load();
-
-    AudioS::instance()->setDefaultSoundtrack("music/shaaft.ogg");
-    if (!AudioS::instance()->init()) {
-        return false;
+    Profiler::SetThreadName("main");
+    bool profile = false;
+    ConfigS::instance()->getBoolean("profile", profile);
+    if (profile) {
+        //keeps the last few seconds of zones, Ctrl-T or exit writes them out
+        Profiler::Start();
+        LOG_INFO << "Profiling, Ctrl-T writes a trace" << endl;
     }
+
+    OnlineScore::Init();
 #if 0
     EventInjector *ei = 0;
     string play;
@@ -144,42 +195,89 @@ bool Game::init(void) {
     GameState::r250.reset(tv.tv_sec);
 #endif
 
-    setupModel(ModelCreate);
+    //Singleton<T>::instance is not thread safe, create the ones the
+    //startup tasks share up front
+    ScoreKeeperS::instance();
+    AudioS::instance();
+    VideoBaseS::instance();
 
-    if (!_model->init()) {
-        return false;
-    }
+    //before the blockset and image loaders look anything up
+    AssetCacheS::instance()->sweep();
 
-    _view = new BlockView(*_model);
-    _model->registerView(_view);
-    if (!_view->init()) {
+    AudioS::instance()->setDefaultSoundtrack("music/shaaft.ogg");
+    if (!AudioS::instance()->init()) {
         return false;
     }
 
-    // input init also initializes Keys which requires that SDL video has ben initialized
-    if (!InputS::instance()->init()) {
-        return false;
+    setupModel(ModelCreate);
+
+    //decode images while the window and GL context are being created
+    AssetLoader preloader;
+    if (preloader.loadManifest("system/preload.txt")) {
+        preloader.start();
     }
 
-    _controller = new BlockController(*_model);
+    //Anything that doesn't need GL runs on workers while the main thread
+    //sets up video. Task times and the critical path are logged below.
+    TiXmlDocument* menu = 0;
+    StartupTasks tasks;
+    tasks.scores = [this]() {
+        ScoreKeeperS::instance()->load();
+        setupScoreBoard();
+        return true;
+    };
+    tasks.audio = []() { return AudioS::instance()->open(); };
+    tasks.blockset = [this]() { return _model->init(); };
+    tasks.menuXml = [&menu]() {
+        menu = MenuManager::loadMenu();
+        return menu != 0;
+    };
+    tasks.video = []() { return VideoBaseS::instance()->init(); };
+    tasks.view = [this, &preloader]() {
+        _view = new BlockView(*_model);
+        return _view->init(preloader);
+    };
+    tasks.input = []() { return InputS::instance()->init(); };
+    tasks.controller = [this]() {
+        _model->registerView(_view);
+        _controller = new BlockController(*_model);
 #if 0
-    if( ew) _controller->setEventWatcher( ew);
-    if( ei) _controller->setEventInjector( ei);
+        if( ew) _controller->setEventWatcher( ew);
+        if( ei) _controller->setEventInjector( ei);
 #endif
-
-    if (!MenuManagerS::instance()->init()) {
+        return true;
+    };
+    tasks.menu = [&menu]() {
+        TiXmlDocument* menuDoc = menu;
+        menu = 0;
+        return MenuManagerS::instance()->init(menuDoc);
+    };
+    tasks.particles = []() {
+        ParticleGroupManager* pgm = ParticleGroupManagerS::instance();
+        if (!pgm->init()) {
+            return false;
+        }
+        //there are 3 effect groups to give very simple control over the order
+        //of drawing which is important for alpha blending.
+        pgm->addGroup(EFFECTS_GROUP1, 1000);
+        pgm->addGroup(EFFECTS_GROUP2, 1000);
+        pgm->addGroup(EFFECTS_GROUP3, 1000);
+        return true;
+    };
+
+    //the dependencies are in StartupTasks.cpp, shared with tools/initcheck
+    InitGraph startup;
+    if (!addStartupTasks(startup, tasks)) {
         return false;
     }
 
-    ParticleGroupManager* pgm = ParticleGroupManagerS::instance();
-    if (!pgm->init()) {
+    bool started = startup.run();
+    startup.log("Startup");
+    //parsed but not handed to the menu
+    delete menu;
+    if (!started) {
         return false;
     }
-    //there are 3 effect groups to give very simple control over the order
-    //of drawing which is important for alpha blending.
-    pgm->addGroup(EFFECTS_GROUP1, 1000);
-    pgm->addGroup(EFFECTS_GROUP2, 1000);
-    pgm->addGroup(EFFECTS_GROUP3, 1000);
 
     //reset our stopwatch
     GameState::stopwatch.reset();
@@ -193,6 +291,9 @@ bool Game::init(void) {
     GameState::startOfStep = GameState::mainTimer.getTime();
     GameState::startOfGameStep = GameState::stopwatch.getTime();
 
+    //samples have been decoding in the background since Audio::open
+    AudioS::instance()->finishPreload();
+
     LOG_INFO << "Initialization complete OK." << endl;
     return result;
 }
@@ -210,6 +311,7 @@ void Game::reset(void) {
     GameState::secondsPlayed = 0.0;
 
     setupModel(ModelReset);
+    setupScoreBoard();
 }
 
 void Game::setupModel(SetupModelEnum setupType) {
@@ -234,13 +336,36 @@ void Game::setupModel(SetupModelEnum setupType) {
     ConfigS::instance()->getBoolean("practiceMode", practiceMode);
     _model->setPracticeMode(practiceMode);
 
-    ostringstream ostr;
-    ostr << dimx << "x" << dimy << "x" << dimz << ":" << blockset;
+}
 
-    LOG_INFO << "Setting active score board to [" << ostr.str() << "]" << endl;
-    ScoreKeeperS::instance()->setLeaderBoard(ostr.str());
+//point the score keeper at the board for the model's shaft and blockset
+void Game::setupScoreBoard(void) {
+    ScoreBoardKey boardKey(_model->getWidth(), _model->getHeight(), _model->getDepth(), _model->getBlockset());
+
+    LOG_INFO << "Setting active score board to [" << boardKey.toName() << "]" << endl;
+    ScoreKeeperS::instance()->setLeaderBoard(boardKey);
     ScoreKeeperS::instance()->resetCurrentScore();
-    ScoreKeeperS::instance()->setPracticeMode(practiceMode);
+    ScoreKeeperS::instance()->setPracticeMode(_model->isPracticeMode());
+}
+
+//GameState's timers start the clock during static initialization, so this
+//is the time from process start to the first frame on screen
+void Game::firstFrameDone(void) {
+    _firstFrameDone = true;
+    double startupTime = Timer::getTime() * 1000.0;
+    LOG_INFO << "First frame after " << (int)startupTime << "ms" << endl;
+
+    //manual startup check, e.g. "shaaft -startupBudget 1500": exit after
+    //the first frame, with an error if it came too late. Needs a display,
+    //so no CI job runs it.
+    int budget = 0;
+    if (ConfigS::instance()->getInteger("startupBudget", budget) && (budget > 0)) {
+        if (startupTime > budget) {
+            LOG_ERROR << "Startup took " << (int)startupTime << "ms, budget is " << budget << "ms" << endl;
+            _exitCode = 1;
+        }
+        GameState::requestExit = true;
+    }
 }
 
 void Game::startNewGame(void) {
@@ -294,6 +419,7 @@ void Game::updateOtherLogic(void) {
 }
 
 void Game::updateInGameLogic(void) {
+    PROFILE_ZONE("Game::updateInGameLogic");
     int stepCount = 0;
     double currentGameTime = GameState::stopwatch.getTime();
     while ((currentGameTime - GameState::startOfGameStep) > GAME_STEP_SIZE) {
@@ -339,6 +465,7 @@ void Game::updateInGameLogic(void) {
 }
 
 void Game::gameLoop() {
+    PROFILE_ZONE("Game::gameLoop");
     Game& game = *GameS::instance();
     Audio& audio = *AudioS::instance();
 
@@ -355,6 +482,7 @@ void Game::gameLoop() {
     //stuff that should run all the time
     game.updateOtherLogic();
 
+    OnlineScore::Update();
     ScoreKeeperS::instance()->mergeOnlineScores();
 
     audio.update();
@@ -362,12 +490,26 @@ void Game::gameLoop() {
     game._view->draw();
     MenuManagerS::instance()->draw();
     VideoBaseS::instance()->swap();
+    if (!game._firstFrameDone) {
+        game.firstFrameDone();
+    }
 
     GLenum err;
     while ((err = glGetError()) != GL_NO_ERROR) {
         LOG_ERROR << "GL ERROR: " << std::hex << err << "\n";
     }
 
+    //nobody is watching or touching the menu - no need to run at full speed
+    Input& input = *InputS::instance();
+    bool idle = !input.hasFocus() ||
+                ((GameState::context != Context::eInGame) && (input.getIdleTime() > IDLE_TIMEOUT));
+    game._frameLimiter.endFrame(idle);
+
+    if (GameState::requestProfileDump) {
+        GameState::requestProfileDump = false;
+        dumpProfile();
+    }
+
 #if defined(EMSCRIPTEN)
     if (GameState::requestExit) {
         GameS::cleanup();
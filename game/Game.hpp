@@ -12,6 +12,7 @@
 #include "BlockModel.hpp"
 #include "BlockController.hpp"
 #include "BlockView.hpp"
+#include "FrameLimiter.hpp"
 
 class Game {
     friend class Singleton<Game>;
@@ -24,6 +25,11 @@ public:
 
     static void gameLoop(void);
 
+    FrameLimiter& getFrameLimiter(void) { return _frameLimiter; }
+
+    //non zero if the startup budget was exceeded
+    int getExitCode(void) { return _exitCode; }
+
 private:
     ~Game();
     Game(void);
@@ -39,10 +45,15 @@ private:
     };
 
     void setupModel(SetupModelEnum setupType);
+    void setupScoreBoard(void);
+    void firstFrameDone(void);
 
     BlockModel* _model;
     BlockController* _controller;
     BlockView* _view;
+    FrameLimiter _frameLimiter;
+    bool _firstFrameDone;
+    int _exitCode;
 
     std::ostream* _zo;
     std::ofstream* _oStream;
@@ -12,6 +12,7 @@ int GameState::licLength = 0;
 bool GameState::isDeveloper = false;
 bool GameState::isAlive = true;
 bool GameState::requestExit = false;
+bool GameState::requestProfileDump = false;
 
 bool GameState::showFPS = false;
 
@@ -18,6 +18,7 @@ struct GameState {
     static bool isDeveloper;
     static bool isAlive;
     static bool requestExit;
+    static bool requestProfileDump;
 
     static bool showFPS;
 
@@ -9,6 +9,7 @@
 #include "SDL.h"
 
 #include "Trace.hpp"
+#include "Profiler.hpp"
 #include "Config.hpp"
 #include "Callback.hpp"
 #include "GameState.hpp"
@@ -45,8 +46,11 @@ Input::Input(void) :
     _mousePos(0, 0),
     _mouseDelta(0, 0),
     _mouseSensitivity(1.0f),
+    _mouseSensitivitySetting("mouseSensitivity", 1.0f),
     _interceptor(0),
-    _touchCount(0) {
+    _touchCount(0),
+    _hasFocus(true),
+    _lastActivity(Timer::getTime()) {
     XTRACE();
 }
 
@@ -96,7 +100,10 @@ bool Input::init(void) {
         }
     }
 
-    updateMouseSettings();
+    _mouseSensitivitySetting.subscribe([this](const float& sensitivity) {
+        _mouseSensitivity = sensitivity;
+        Clampf(_mouseSensitivity, 0.1f, 3.0f);
+    });
 
     //SDL_EnableKeyRepeat( 300,200); -- SDL1
 
@@ -106,11 +113,6 @@ bool Input::init(void) {
     return true;
 }
 
-void Input::updateMouseSettings(void) {
-    ConfigS::instance()->getFloat( "mouseSensitivity", _mouseSensitivity);
-    Clampf(_mouseSensitivity, 0.1f, 3.0f);
-}
-
 std::vector<TouchInfo*> Input::getActiveTouches() {
     std::vector<TouchInfo*> results;
 
@@ -398,6 +400,10 @@ bool Input::tryGetTrigger(Trigger& trigger, bool& isDown) {
         return false;
     }
 
+    if (event.type != SDL_WINDOWEVENT) {
+        _lastActivity = Timer::getTime();
+    }
+
     switch (event.type) {
 #ifdef IPHONE
         case SDL_TOUCH:
@@ -469,6 +475,10 @@ bool Input::tryGetTrigger(Trigger& trigger, bool& isDown) {
                 GameState::shaftPitch = 0.0;
                 GameState::shaftYaw = 0.0;
             }
+            if ((event.key.keysym.sym == SDLK_t) && (event.key.keysym.mod & MAIN_MODIFIER) &&
+                Profiler::IsRecording()) {
+                GameState::requestProfileDump = true;
+            }
             if ((event.key.keysym.sym == SDLK_f) && (event.key.keysym.mod & MAIN_MODIFIER)) {
                 bool fullscreen = false;
                 ConfigS::instance()->getBoolean("fullscreen", fullscreen);
@@ -537,6 +547,16 @@ bool Input::tryGetTrigger(Trigger& trigger, bool& isDown) {
             trigger.data2 = event.edit.length;
             break;
 
+        case SDL_WINDOWEVENT:
+            if (event.window.event == SDL_WINDOWEVENT_FOCUS_GAINED) {
+                _hasFocus = true;
+                _lastActivity = Timer::getTime();
+            } else if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
+                _hasFocus = false;
+            }
+            trigger.type = eUnknownTrigger;
+            break;
+
         case SDL_QUIT:
             GameState::requestExit = true;
             break;
@@ -554,13 +574,6 @@ bool Input::update(void) {
     bool isDown;
     Trigger trigger;
 
-    static double nextTime = Timer::getTime() + 0.5;
-    double thisTime = Timer::getTime();
-    if (thisTime > nextTime) {
-        updateMouseSettings();
-        nextTime = thisTime + 0.5;
-    }
-
     _mouseDelta = vec2f(0, 0);
 
     while (tryGetTrigger(trigger, isDown)) {
@@ -9,9 +9,11 @@
 #include "Trace.hpp"
 #include "hashMap.hpp"
 #include "Singleton.hpp"
+#include "Timer.hpp"
 #include "Trigger.hpp"
 #include "Keys.hpp"
 #include "ConfigHandler.hpp"
+#include "Config.hpp"
 #include "CallbackManager.hpp"
 #include "InterceptorI.hpp"
 
@@ -90,6 +92,11 @@ public:
 
     std::vector<TouchInfo*> getActiveTouches();
 
+    bool hasFocus(void) { return _hasFocus; }
+
+    //seconds since the last key, mouse or touch event
+    double getIdleTime(void) { return Timer::getTime() - _lastActivity; }
+
 private:
     virtual ~Input();
     Input(void);
@@ -98,7 +105,6 @@ private:
 
     void bind(Trigger& t, Callback* action);
     bool tryGetTrigger(Trigger& trigger, bool& isDown);
-    void updateMouseSettings(void);
 
 #ifdef IPHONE
     void handleTouch(SDL_TouchEvent& touch);
@@ -118,6 +124,7 @@ private:
     vec2f _mousePos;
     vec2f _mouseDelta;
     float _mouseSensitivity;
+    ConfigValue<float> _mouseSensitivitySetting;
 
     //intercept raw input
     InterceptorI* _interceptor;
@@ -126,6 +133,9 @@ private:
     int _touchCount;
     std::vector<TouchInfo> _touches;
 
+    bool _hasFocus;
+    double _lastActivity;
+
 #ifdef IPHONE
     int addTouch(void* t, const vec2i& p);
     void removeTouch(int button);
@@ -8,6 +8,7 @@
 #include "SDL.h"  //key syms
 
 #include "Trace.hpp"
+#include "Profiler.hpp"
 #include "XMLHelper.hpp"
 #include "GameState.hpp"
 #include "Audio.hpp"
@@ -23,6 +24,9 @@
 #include "glm/ext.hpp"
 #include "gl3/ProgramManager.hpp"
 #include "gl3/Program.hpp"
+#include "gl3/FrameBuffer.hpp"
+#include "gl3/MatrixStack.hpp"
+#include "GLVertexBufferObject.hpp"
 
 #include "Input.hpp"
 #include "VideoBase.hpp"
@@ -41,11 +45,17 @@ MenuManager::MenuManager() :
     _prevContext(Context::eUnknown),
     _delayedExit(false),
     _newLevelLoaded(false),
-    _showCursorAnim(true),
-    _cursorAnim("CursorAnim", 1000) {
+    _showCursorAnim("showCursorAnimation", true),
+    _cursorAnim("CursorAnim", 1000),
+    _dirty(true),
+    _menuFrame(0) {
     XTRACE();
 
-    updateSettings();
+    //make sure the option shows up in the config file
+    bool showCursorAnim;
+    if (!ConfigS::instance()->getBoolean("showCursorAnimation", showCursorAnim)) {
+        _showCursorAnim.set(_showCursorAnim);
+    }
 
     int w = VideoBaseS::instance()->getWidth();
     int h = VideoBaseS::instance()->getHeight();
@@ -60,15 +70,17 @@ MenuManager::~MenuManager() {
 
     SelectableFactory::cleanup();
 
+    delete _menuFrame;
+    _menuFrame = 0;
+
     delete _menu;
     _menu = 0;
 }
 
-bool MenuManager::init(void) {
+bool MenuManager::init(TiXmlDocument* menu) {
     XTRACE();
-    _menu = XMLHelper::load("system/Menu.xml");
+    _menu = menu ? menu : loadMenu();
     if (!_menu) {
-        _menu = 0;
         return false;
     }
 
@@ -93,14 +105,14 @@ bool MenuManager::init(void) {
 
     _cursorAnim.init();
 
+    VideoBaseS::instance()->registerResolutionObserver(this);
+
     return true;
 }
 
-void MenuManager::updateSettings(void) {
-    if (!ConfigS::instance()->getBoolean("showCursorAnimation", _showCursorAnim)) {
-        Value* v = new Value(_showCursorAnim);
-        ConfigS::instance()->updateKeyword("showCursorAnimation", v);
-    }
+TiXmlDocument* MenuManager::loadMenu(void) {
+    PROFILE_ZONE("MenuManager::loadMenu");
+    return XMLHelper::load("system/Menu.xml");
 }
 
 void MenuManager::clearActiveSelectables(void) {
@@ -115,6 +127,7 @@ void MenuManager::clearActiveSelectables(void) {
 
 void MenuManager::loadMenuLevel(void) {
     _newLevelLoaded = true;
+    _dirty = true;
     clearActiveSelectables();
 
     TiXmlNode* node = _currentMenu->FirstChild();
@@ -154,13 +167,6 @@ void MenuManager::makeMenu(TiXmlNode* _node) {
 }
 
 bool MenuManager::update(void) {
-    static double nextTime = Timer::getTime() + 0.5;
-    double thisTime = Timer::getTime();
-    if (thisTime > nextTime) {
-        updateSettings();
-        nextTime = thisTime + 0.5;
-    }
-
     if (_delayedExit) {
         if (!Exit()) {
             turnMenuOff();
@@ -201,6 +207,7 @@ bool MenuManager::update(void) {
 }
 
 bool MenuManager::draw(void) {
+    PROFILE_ZONE("MenuManager::draw");
     if (GameState::context != Context::eMenu) {
         return true;
     }
@@ -241,6 +248,53 @@ bool MenuManager::draw(void) {
 
     glActiveTexture(GL_TEXTURE0);
 
+    bool dirty = _dirty;
+    list<Selectable*>::iterator i;
+    for (i = _activeSelectables.begin(); i != _activeSelectables.end(); i++) {
+        if ((*i)->isDirty()) {
+            dirty = true;
+        }
+    }
+
+    if (!_menuFrame) {
+        _menuFrame = new FrameBuffer();
+    }
+
+    if (_menuFrame->resize(video.getWidth(), video.getHeight())) {
+        if (dirty) {
+            _menuFrame->bind();
+            glClearColor(0.0, 0.0, 0.0, 0.0);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            //accumulate premultiplied alpha so the cached layer blends like direct drawing
+            glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            drawStatic(orthoWidth, orthoHeight);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+            FrameBuffer::unbind();
+            _dirty = false;
+        }
+        drawCached();
+
+        prog->use();
+        glUniformMatrix4fv(modelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(modelViewMatrix));
+    } else {
+        drawStatic(orthoWidth, orthoHeight);
+    }
+
+    if (_showCursorAnim) {
+        _cursorAnim.draw();
+    }
+
+    GLBitmapCollection* icons = BitmapManagerS::instance()->getBitmap("bitmaps/menuIcons");
+    icons->bind();
+    icons->setColor(1.0, 1.0, 1.0, 1.0);
+    icons->Draw(_pointer, _mouseX, _mouseY, 0.5, 0.5);
+
+    return true;
+}
+
+void MenuManager::drawStatic(float orthoWidth, float orthoHeight) {
     GLBitmapCollection* menuBoard = BitmapManagerS::instance()->getBitmap("bitmaps/menuBoard");
     menuBoard->bind();
 
@@ -270,19 +324,37 @@ bool MenuManager::draw(void) {
 
     list<Selectable*>::iterator i;
     for (i = _activeSelectables.begin(); i != _activeSelectables.end(); i++) {
+        (*i)->clearDirty();
         (*i)->draw(_boardOffset);
     }
+}
 
-    if (_showCursorAnim) {
-        _cursorAnim.draw();
-    }
-
-    GLBitmapCollection* icons = BitmapManagerS::instance()->getBitmap("bitmaps/menuIcons");
-    icons->bind();
-    icons->setColor(1.0, 1.0, 1.0, 1.0);
-    icons->Draw(_pointer, _mouseX, _mouseY, 0.5, 0.5);
+void MenuManager::drawCached(void) {
+    MatrixStack::projection.push(glm::ortho(0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f));
+    MatrixStack::model.push(glm::mat4(1.0f));
+
+    vec4f v[4] = {
+        vec4f(0.0f, 0.0f, 0.0f, 1.0f),
+        vec4f(1.0f, 0.0f, 0.0f, 1.0f),
+        vec4f(1.0f, 1.0f, 0.0f, 1.0f),
+        vec4f(0.0f, 1.0f, 0.0f, 1.0f),
+    };
+    vec2f t[4] = {
+        vec2f(0.0f, 0.0f),
+        vec2f(1.0f, 0.0f),
+        vec2f(1.0f, 1.0f),
+        vec2f(0.0f, 1.0f),
+    };
+
+    _menuFrame->bindTexture();
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLVBO vbo;
+    vbo.setColor(1.0f, 1.0f, 1.0f, 1.0f);
+    vbo.DrawTexQuad(v, t);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    return true;
+    MatrixStack::model.pop();
+    MatrixStack::projection.pop();
 }
 
 void MenuManager::reload(void) {
@@ -290,18 +362,29 @@ void MenuManager::reload(void) {
     int h = VideoBaseS::instance()->getHeight();
     _mouseX = w / 2;
     _mouseY = h / 2;
+
+    //GL objects do not survive a video mode change
+    delete _menuFrame;
+    _menuFrame = 0;
+    _dirty = true;
+}
+
+void MenuManager::resolutionChanged(int /*w*/, int /*h*/) {
+    reload();
 }
 
 void MenuManager::turnMenuOn(void) {
     SDL_SetRelativeMouseMode(SDL_FALSE);
 
-    AudioS::instance()->playSample("sounds/beep");
+    static SampleId sndBeep = AudioS::instance()->getSampleId("sounds/beep");
+    AudioS::instance()->playSample(sndBeep);
     _prevContext = GameState::context;
     GameState::context = Context::eMenu;
 
     //ask input system to forward all input to us
     InputS::instance()->enableInterceptor(this);
     GameState::stopwatch.pause();
+    _dirty = true;
 
 #ifdef IPHONE
     _currentSelectable = _activeSelectables.end();
@@ -317,7 +400,8 @@ void MenuManager::turnMenuOff(void) {
 
     SDL_SetRelativeMouseMode(SDL_TRUE);
 
-    AudioS::instance()->playSample("sounds/beep");
+    static SampleId sndBeep = AudioS::instance()->getSampleId("sounds/beep");
+    AudioS::instance()->playSample(sndBeep);
     GameState::context = _prevContext;
 
     //don't want anymore input
@@ -430,6 +514,11 @@ void MenuManager::input(const Trigger& trigger, const bool& isDown) {
     if (_currentSelectable != _activeSelectables.end()) {
         (*_currentSelectable)->input(t, isDown, _boardOffset);
     }
+
+    //mouse motion only moves the pointer, selectables flag their own changes
+    if (trigger.type != eMotionTrigger) {
+        _dirty = true;
+    }
 }
 
 void MenuManager::activateSelectableUnderMouse(const bool& useFallback) {
@@ -512,7 +601,8 @@ bool MenuManager::Exit(bool delayed) {
     if (_currentMenu != _topMenu) {
         _currentMenu = _currentMenu->Parent();
         loadMenuLevel();
-        AudioS::instance()->playSample("sounds/beep");
+        static SampleId sndBeep = AudioS::instance()->getSampleId("sounds/beep");
+        AudioS::instance()->playSample(sndBeep);
         return true;
     }
 
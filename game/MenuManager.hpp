@@ -13,15 +13,22 @@
 #include "Context.hpp"
 #include "Point.hpp"
 #include "ParticleGroup.hpp"
+#include "VideoBase.hpp"
+#include "Config.hpp"
 
 struct Trigger;
 class Selectable;
+class FrameBuffer;
 
-class MenuManager : public InterceptorI {
+class MenuManager : public InterceptorI, public ResolutionChangeObserverI {
     friend class Singleton<MenuManager>;
 
 public:
-    bool init(void);
+    //Parsing the menu only needs the resource files, so it can be done on
+    //another thread with loadMenu. init takes ownership of menu and loads
+    //it itself if there is none.
+    static TiXmlDocument* loadMenu(void);
+    bool init(TiXmlDocument* menu = 0);
     bool update(void);
     bool draw(void);
 
@@ -40,6 +47,8 @@ public:
 
     void reload(void);
 
+    virtual void resolutionChanged(int w, int h);
+
 private:
     virtual ~MenuManager();
     MenuManager(void);
@@ -48,9 +57,10 @@ private:
 
     void loadMenuLevel(void);
     void clearActiveSelectables(void);
-    void updateSettings(void);
     void activateSelectableUnderMouse(const bool& useFallback = false);
     void updateMousePosition(const Trigger& trigger);
+    void drawStatic(float orthoWidth, float orthoHeight);
+    void drawCached(void);
 
     TiXmlDocument* _menu;
 
@@ -77,8 +87,12 @@ private:
     float _angle;
     float _prevAngle;
 
-    bool _showCursorAnim;
+    ConfigValue<bool> _showCursorAnim;
     ParticleGroup _cursorAnim;
+
+    //board, title and selectables are only re-rendered when something changed
+    bool _dirty;
+    FrameBuffer* _menuFrame;
 };
 
 typedef Singleton<MenuManager> MenuManagerS;
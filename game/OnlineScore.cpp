@@ -1,356 +1,606 @@
 #include "OnlineScore.hpp"
 
 #include "Trace.hpp"
+#include "Profiler.hpp"
 #include "Tea.hpp"
+#include "Hex.hpp"
 #include "Tokenizer.hpp"
 
-#include "hashMap.hpp"
-#include "HashString.hpp"
-
-#include <iomanip>
+#include <algorithm>
 #include <string>
+#include <deque>
 #include <list>
+#include <random>
 #include <sstream>
+#include <stdlib.h>
 using namespace std;
 
-#if 0  //def __APPLE__
-#import <Foundation/Foundation.h>
+#include "SDL_mutex.h"
+#include "SDL_atomic.h"
+#include "SDL_thread.h"
+#include "SDL.h"
 
-@interface OnlineScoreTransfer : NSObject
-{
-    NSURL  *_url;
-    NSString *_boardName;
-}
-@end
-
-@implementation OnlineScoreTransfer
--(id)initWithURL:(NSURL*)url
-{
-    if( self = [super init])
-    {
-        _url = url;
-        [_url retain];
-        _boardName = nil;
-    }
-    return self;
-}
+#include "Config.hpp"
+#include "ResourceManager.hpp"
+#include "zStream.hpp"
+#include "HttpClient.hpp"
+#include "OSName.hpp"
+#include "physfs.h"
 
--(id)initWithURL:(NSURL*)url andBoardName:(NSString *)boardName
-{
-    if( self = [super init])
-    {
-        _url = url;
-        [_url retain];
-        _boardName = boardName;
-        [_boardName retain];
-    }
-    return self;
-}
+//TODO: add connectivity / reachability check
+//"onlineScoreURL" in the config overrides this
+#ifdef DUMMYSCORES
+//stand-in server: scripts/server.py
+static string onlineScoreURL = "http://localhost:8080/scores";
+#else
+static string onlineScoreURL = "";
+#endif
 
--(void)dealloc
-{
-    LOG_INFO << "OnlineScoreTransfer::dealloc\n";
-    [_url release];
-    [_boardName release];
-    [super dealloc];
-}
+//completion of a batched score submission, called from the worker
+static void AddSubmitResult(unsigned int lastSeq, bool ok, const string& reply);
 
--(NSData *)sendRequest
-{
-    NSError *error = nil;
-    NSURLResponse *response = nil;
-    NSURLRequest *request = [NSURLRequest requestWithURL:_url
-                                             cachePolicy:NSURLRequestReloadIgnoringCacheData
-                                         timeoutInterval:5];
-    NSData *data = [NSURLConnection sendSynchronousRequest:request
-                                         returningResponse:&response
-                                                     error:&error];
-    return data;
-}
+//requests beyond this are dropped instead of piling up behind a dead network
+const size_t MAX_PENDING_REQUESTS = 32;
 
+struct ScoreRequest {
+    ScoreRequest(const string& u, const string& b, unsigned int seq = 0) :
+        url(u),
+        boardName(b),
+        lastSeq(seq) {}
 
--(void)sendScore
-{
-    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+    string url;
+    string boardName;
+    //non zero for score submissions: last sequence number in the batch
+    unsigned int lastSeq;
+    string result;
+};
+
+//One long lived worker fed by a bounded queue. The locks are created by
+//OnlineScore::Init on the main thread before any request can be made.
+static SDL_mutex* requestLock = 0;
+static SDL_cond* requestCond = 0;
+static deque<ScoreRequest> scoreRequests;
+static bool quitWorker = false;
+static SDL_Thread* workerThread = 0;
+
+//give up on a request after this long, also bounds how long shutdown waits
+const int REQUEST_TIMEOUT = 5000;  //ms
+const size_t MAX_RESPONSE_SIZE = 64 * 1024;
+
+//Only used by the worker. The connection is kept open between requests.
+static HttpClient* httpClient = 0;
+
+static bool PerformRequest(ScoreRequest& scoreRequest) {
+#ifdef EMSCRIPTEN
+    //no plain sockets in the browser, submissions stay in the outbox
+    return false;
+#else
+    LOG_INFO << "Score Request: " << scoreRequest.url << endl;
 
-    NSData *data = [self sendRequest];
-    if( data)
-    {
-        NSString *result = [NSString stringWithCString:(const char *)[data bytes] length:[data length]];
-        LOG_INFO << "OnlineScoreTransfer::sendScore " << [result UTF8String] << "\n";
+    HttpResponse response;
+    if (!httpClient->get(scoreRequest.url, response)) {
+        LOG_INFO << "Score Request Failed: " << httpClient->getError() << "\n";
+        return false;
     }
-    else
-    {
-        LOG_INFO << "OnlineScoreTransfer::sendScore unable to get data\n";
+    if (response.status != 200) {
+        LOG_INFO << "Score Request Failed: HTTP " << response.status << "\n";
+        return false;
     }
 
-    [pool release];
+    LOG_INFO << "Score Request OK\n";
+    scoreRequest.result = response.body;
+    return true;
+#endif
 }
 
--(void)getScores
-{
-    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+static void CompleteRequest(ScoreRequest& scoreRequest, bool ok) {
+    if (scoreRequest.lastSeq) {
+        //failures are reported too, so the outbox can schedule a retry
+        AddSubmitResult(scoreRequest.lastSeq, ok, scoreRequest.result);
+    } else if (ok && (scoreRequest.boardName != "")) {
+        LOG_INFO << "Score for " << scoreRequest.boardName << ": " << scoreRequest.result << "\n";
 
-    NSData *data = [self sendRequest];
-    if( data)
-    {
-        NSString *result = [NSString stringWithCString:(const char *)[data bytes] length:[data length]];
-
-        std::string topN = [result UTF8String];
-        LOG_INFO << "OnlineScoreTransfer::getScores " << [_boardName UTF8String] << "\n" << topN << "\n";
-
-        if( topN != "Error")
-        {
-            OnlineScore::AddScoreBoardData( [_boardName UTF8String], topN);
+        if (scoreRequest.result != "Error") {
+            OnlineScore::AddScoreBoardData(scoreRequest.boardName, scoreRequest.result);
         }
     }
-    else
-    {
-        LOG_INFO << "OnlineScoreTransfer::getScores unable to get data\n";
+}
+
+static int ScoreRequestThread(void*) {
+    Profiler::SetThreadName("online-score");
+    for (;;) {
+        SDL_LockMutex(requestLock);
+        while (scoreRequests.empty() && !quitWorker) {
+            SDL_CondWait(requestCond, requestLock);
+        }
+        if (quitWorker) {
+            SDL_UnlockMutex(requestLock);
+            break;
+        }
+        ScoreRequest scoreRequest = scoreRequests.front();
+        scoreRequests.pop_front();
+        SDL_UnlockMutex(requestLock);
+
+        PROFILE_ZONE("OnlineScore::request");
+        bool ok = PerformRequest(scoreRequest);
+        CompleteRequest(scoreRequest, ok);
     }
+    return 0;
+}
 
-    [pool release];
+static bool StartWorker(void) {
+    stringstream userAgent;
+    userAgent << PACKAGE << " " << VERSION << " " << OSNAME();
+    httpClient = new HttpClient(userAgent.str(), REQUEST_TIMEOUT, MAX_RESPONSE_SIZE);
+
+    requestLock = SDL_CreateMutex();
+    requestCond = SDL_CreateCond();
+    quitWorker = false;
+#ifndef EMSCRIPTEN
+    workerThread = SDL_CreateThread(ScoreRequestThread, "online-score", 0);
+    if (!workerThread) {
+        LOG_WARNING << "Unable to create online score thread: " << SDL_GetError() << endl;
+    }
+#endif
+    return (requestLock != 0) && (requestCond != 0);
 }
-@end
 
+static void StopWorker(void) {
+    if (!requestLock) {
+        return;
+    }
 
-NSLock  *theLock = [NSLock new];
-void GetLock()
-{
-    [theLock lock];
-}
+    SDL_LockMutex(requestLock);
+    quitWorker = true;
+    SDL_CondBroadcast(requestCond);
+    SDL_UnlockMutex(requestLock);
+
+    //a request in flight finishes (or times out) first
+    if (workerThread) {
+        SDL_WaitThread(workerThread, 0);
+        workerThread = 0;
+    }
+
+    if (!scoreRequests.empty()) {
+        LOG_INFO << "Dropping " << scoreRequests.size() << " pending score requests\n";
+        scoreRequests.clear();
+    }
+
+    SDL_DestroyCond(requestCond);
+    requestCond = 0;
+    SDL_DestroyMutex(requestLock);
+    requestLock = 0;
 
-void ReleaseLock()
-{
-    [theLock unlock];
+    delete httpClient;
+    httpClient = 0;
 }
-void SendScore( const std::string &url )
-{
-    NSURL *nsURL = [NSURL URLWithString:[NSString stringWithCString:url.c_str()
-                                                           encoding:NSUTF8StringEncoding]];
-    OnlineScoreTransfer *transfer = [[OnlineScoreTransfer alloc] initWithURL:nsURL];
-    [transfer performSelectorInBackground:@selector(sendScore) withObject:nil];
-    [transfer release];
+
+static bool QueueRequest(const ScoreRequest& scoreRequest) {
+    if (!requestLock) {
+        LOG_WARNING << "OnlineScore not initialized, dropping request\n";
+        return false;
+    }
+
+    if (!workerThread) {
+        //no threads (e.g. single threaded web build). A request done in place
+        //could block a frame for the whole timeout, scores stay in the outbox.
+        return false;
+    }
+
+    SDL_LockMutex(requestLock);
+    bool queued = !quitWorker && (scoreRequests.size() < MAX_PENDING_REQUESTS);
+    if (queued) {
+        scoreRequests.push_back(scoreRequest);
+        SDL_CondSignal(requestCond);
+    }
+    SDL_UnlockMutex(requestLock);
+
+    if (!queued) {
+        LOG_WARNING << "Score request queue full, dropping " << scoreRequest.url << "\n";
+    }
+    return queued;
 }
 
-void GetScores( const std::string &url, const std::string &boardName )
-{
-    NSURL *nsURL = [NSURL URLWithString:[NSString stringWithCString:url.c_str()
-                                                           encoding:NSUTF8StringEncoding]];
-    NSString *nsBoardName = [NSString stringWithCString:boardName.c_str()
-                                               encoding:NSUTF8StringEncoding];
-    OnlineScoreTransfer *transfer = [[OnlineScoreTransfer alloc] initWithURL:nsURL andBoardName:nsBoardName];
-    [transfer performSelectorInBackground:@selector(getScores) withObject:nil];
-    [transfer release];
+static bool SubmitScores(const string& url, unsigned int lastSeq) {
+    return QueueRequest(ScoreRequest(url, "", lastSeq));
 }
-#else
-#include "SDL_thread.h"
-#if 0
-#include <curl/curl.h>
-#endif
 
-SDL_mutex* sdlLock = 0;
+void GetScores(const string& url, const string& boardName) {
+    QueueRequest(ScoreRequest(url, boardName));
+}
 
-struct ScoreRequest {
-    ScoreRequest(const string& u, const string& b) :
-        url(u),
-        boardName(b) {}
+struct ScoreBoardData {
+    ScoreBoardData(const string& b, const string& d) :
+        boardName(b),
+        data(d) {}
 
-    string url;
     string boardName;
-    string result;
+    string data;
+};
+
+//Completion queue. Workers append under the lock, the main thread only
+//takes the lock when the counter says something arrived.
+static SDL_mutex* completionLock = 0;
+static SDL_atomic_t numCompleted;
+static list<ScoreBoardData> completedData;
+//main thread only
+static list<ScoreBoardData> drainedData;
+
+struct SubmitResult {
+    SubmitResult(unsigned int s, bool o, const string& r) :
+        lastSeq(s),
+        ok(o),
+        reply(r) {}
+
+    unsigned int lastSeq;
+    bool ok;
+    string reply;
 };
 
-static list<ScoreRequest> scoreRequests;
+static list<SubmitResult> submitResults;
 
-void GetLock() {
-    if (!sdlLock) {
-        sdlLock = SDL_CreateMutex();
+static void AddSubmitResult(unsigned int lastSeq, bool ok, const string& reply) {
+    if (!completionLock) {
+        return;
     }
-    SDL_LockMutex(sdlLock);
+
+    SDL_LockMutex(completionLock);
+    submitResults.push_back(SubmitResult(lastSeq, ok, reply));
+    SDL_AtomicAdd(&numCompleted, 1);
+    SDL_UnlockMutex(completionLock);
 }
 
-void ReleaseLock() {
-    if (sdlLock) {
-        SDL_UnlockMutex(sdlLock);
+//Durable outbox of score submissions (main thread only). Every score gets a
+//sequence number and is written to the write directory before anything is
+//sent. Pending scores go out in one batch with the install's random client
+//id; the server replies "OK <seq>" once everything up to seq is stored and
+//drops (client id, seq) pairs it has already seen, so resending after a
+//lost reply is harmless.
+//The file is a log: new scores and acks are appended, and it is rewritten
+//without the acknowledged scores when it is loaded.
+struct PendingScore {
+    unsigned int seq;
+    int score;
+    string hash;
+};
+
+static const string OUTBOX_FILE = "scoreoutbox";
+const int OUTBOX_VERSION = 1;
+const size_t MAX_SUBMIT_BATCH = 16;
+const Uint32 MIN_SUBMIT_BACKOFF = 5000;  //ms
+const Uint32 MAX_SUBMIT_BACKOFF = 10 * 60 * 1000;
+
+static list<PendingScore> outbox;
+static string clientId;
+static unsigned int nextSeq = 1;
+static bool submitInFlight = false;
+static Uint32 nextSubmitTime = 0;
+static Uint32 submitBackoff = 0;
+
+//sequence numbers start at 1 for every install, the id tells them apart
+static string NewClientId(void) {
+    random_device random;
+    unsigned char id[8];
+    for (size_t i = 0; i < sizeof(id); i++) {
+        id[i] = (unsigned char)random();
     }
+    string hex(sizeof(id) * 2, 0);
+    Hex::encode(id, sizeof(id), &hex[0]);
+    return hex;
 }
 
-int ScoreRequestThread(void* data);
+static string OutboxHeader(void) {
+    ostringstream header;
+    header << "# pending online score submissions\n";
+    header << "Version " << OUTBOX_VERSION << "\n";
+    header << "Client " << clientId << "\n";
+    return header.str();
+}
+
+static bool WriteOutbox(const string& fileName, const string& data, bool append) {
+    PHYSFS_File* outfile = append ? PHYSFS_openAppend(fileName.c_str()) : PHYSFS_openWrite(fileName.c_str());
+    if (!outfile) {
+        LOG_ERROR << "Unable to write " << fileName << "\n";
+        return false;
+    }
 
-void SendScore(const string& url) {
-    GetLock();
-    ScoreRequest scoreRequest(url, "");
-    scoreRequests.push_back(scoreRequest);
-    ReleaseLock();
+    bool ok = (PHYSFS_writeBytes(outfile, data.data(), data.size()) == (PHYSFS_sint64)data.size());
+    PHYSFS_close(outfile);
 
-    SDL_Thread* thread = SDL_CreateThread(ScoreRequestThread, "send-score", 0);
+    if (!ok) {
+        LOG_ERROR << "Unable to write " << fileName << "\n";
+    }
+    return ok;
 }
 
-void GetScores(const string& url, const string& boardName) {
-    GetLock();
-    ScoreRequest scoreRequest(url, boardName);
-    scoreRequests.push_back(scoreRequest);
-    ReleaseLock();
+//one Score or Ack record, the header goes first in a new file
+static void AppendOutbox(const string& record) {
+    if (!ResourceManagerS::instance()->hasResource(OUTBOX_FILE)) {
+        WriteOutbox(OUTBOX_FILE, OutboxHeader() + record, false);
+    } else {
+        WriteOutbox(OUTBOX_FILE, record, true);
+    }
+}
 
-    SDL_Thread* thread = SDL_CreateThread(ScoreRequestThread, "get-scores", 0);
+//Drop the acknowledged records, replacing the file keeps the old one
+//intact until the new one is complete
+static void CompactOutbox(void) {
+    ostringstream data;
+    data << OutboxHeader();
+    data << "NextSeq " << nextSeq << "\n";
+    list<PendingScore>::const_iterator i;
+    for (i = outbox.begin(); i != outbox.end(); i++) {
+        data << "Score " << i->seq << " " << i->score << " " << i->hash << "\n";
+    }
+    //on failure the old file is still complete, compact again next time
+    ResourceManagerS::instance()->replaceFile(OUTBOX_FILE, data.str());
 }
 
-size_t receiveData(void* buffer, size_t size, size_t nmemb, void* data) {
-    char* tmpBuf = new char[size * nmemb + 1];
-    memcpy(tmpBuf, buffer, size * nmemb);
-    tmpBuf[size * nmemb] = '\0';
+//returns true if the file holds acknowledged or torn records, or no client id
+static bool ReadOutbox(void) {
+    outbox.clear();
+    clientId = "";
+    nextSeq = 1;
+    if (!ResourceManagerS::instance()->hasResource(OUTBOX_FILE)) {
+        return false;
+    }
 
-    ScoreRequest* scoreRequest = (ScoreRequest*)data;
-    scoreRequest->result += tmpBuf;
-    //    LOG_INFO << tmpBuf << endl;
+    ziStream infile(OUTBOX_FILE);
+    if (!infile.isOK()) {
+        return false;
+    }
 
-    delete[] tmpBuf;
+    bool compact = false;
+    string line;
+    while (!getline(infile, line).eof()) {
+        if (line.empty() || (line[0] == '#')) {
+            continue;
+        }
 
-    return size * nmemb;
+        Tokenizer t(line, false, " \t\n\r");
+        string token = t.next();
+        if (token == "Version") {
+            if (atoi(t.next().c_str()) != OUTBOX_VERSION) {
+                LOG_ERROR << "Wrong version in " << OUTBOX_FILE << ", ignoring it\n";
+                outbox.clear();
+                return false;
+            }
+        } else if (token == "Client") {
+            clientId = t.next();
+        } else if (token == "NextSeq") {
+            nextSeq = (unsigned int)strtoul(t.next().c_str(), 0, 10);
+        } else if (token == "Score") {
+            PendingScore pending;
+            pending.seq = (unsigned int)strtoul(t.next().c_str(), 0, 10);
+            pending.score = atoi(t.next().c_str());
+            pending.hash = t.next();
+            //a torn write leaves a short last line behind
+            if (pending.seq && (pending.hash != "")) {
+                outbox.push_back(pending);
+                //never hand out a sequence number twice
+                nextSeq = std::max(nextSeq, pending.seq + 1);
+            }
+        } else if (token == "Ack") {
+            unsigned int acked = (unsigned int)strtoul(t.next().c_str(), 0, 10);
+            while (!outbox.empty() && (outbox.front().seq <= acked)) {
+                outbox.pop_front();
+            }
+            nextSeq = std::max(nextSeq, acked + 1);
+            compact = true;
+        }
+    }
+
+    //a torn last record would run into the next one appended
+    return compact || !line.empty() || clientId.empty();
 }
 
-// #include "OSName.hpp"
-int ScoreRequestThread(void* data) {
-    GetLock();
-    ScoreRequest scoreRequest = scoreRequests.front();
-    scoreRequests.pop_front();
-    ReleaseLock();
-
-#if 0
-    CURL *handle = curl_easy_init();
-    if( handle)
-    {
-	stringstream useragent;
-	useragent << PACKAGE << " " << VERSION << " " << OSNAME() << " (" << __DATE__ << " " << __TIME__ << ")" << ends;
-	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, ::receiveData);
-	curl_easy_setopt(handle, CURLOPT_WRITEDATA, &scoreRequest);
-	curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1);
-	curl_easy_setopt(handle, CURLOPT_TIMEOUT, 30);
-	curl_easy_setopt(handle, CURLOPT_USERAGENT, useragent.str().c_str());
-	curl_easy_setopt(handle, CURLOPT_URL, scoreRequest.url.c_str());
-	//      curl_easy_setopt(handle, CURLOPT_REFERER, "None");
-
-	LOG_INFO << "Score Request: " << scoreRequest.url << endl;
-
-	CURLcode success = curl_easy_perform(handle);
-	if( success == CURLE_OK)
-	{
-	    LOG_INFO << "Score Request OK\n";
-	    if( scoreRequest.boardName == "" )
-	    {
-		//send score
-	    }
-	    else
-	    {
-		//get score
-		LOG_INFO << "Score for " << scoreRequest.boardName << ": " << scoreRequest.result << "\n";
-
-		if( scoreRequest.result != "Error")
-		{
-		    OnlineScore::AddScoreBoardData( scoreRequest.boardName, scoreRequest.result);
-		}
-	    }
-	}
-	else
-	{
-	    LOG_INFO << "Score Request Failed\n";
-	}
-
-	curl_easy_cleanup(handle);
+static void LoadOutbox(void) {
+    //after the read, the file can't be replaced while it is open
+    bool compact = ReadOutbox();
+    if (clientId.empty()) {
+        clientId = NewClientId();
+    }
+    if (compact && ResourceManagerS::instance()->hasResource(OUTBOX_FILE)) {
+        CompactOutbox();
+    }
+    if (!outbox.empty()) {
+        LOG_INFO << outbox.size() << " score submissions pending\n";
     }
-#endif
-    return 0;
 }
 
-#endif
+static void SubmitFailed(void) {
+    submitBackoff = submitBackoff ? std::min(submitBackoff * 2, MAX_SUBMIT_BACKOFF) : MIN_SUBMIT_BACKOFF;
+    nextSubmitTime = SDL_GetTicks() + submitBackoff;
+    LOG_INFO << "Score submission failed, retrying in " << submitBackoff / 1000 << "s\n";
+}
 
-static hash_map<const std::string, std::string, hash<const std::string>, equal_to<const std::string>>
-    pendindScoreBoardData;
+static void HandleSubmitResult(const SubmitResult& result) {
+    submitInFlight = false;
 
-bool OnlineScore::GetNextScoreBoardData(std::string& boardName, std::string& scoreData) {
-    bool hasNext = false;
-    GetLock();
-    if (pendindScoreBoardData.begin() != pendindScoreBoardData.end()) {
-        boardName = pendindScoreBoardData.begin()->first;
-        scoreData = pendindScoreBoardData.begin()->second;
+    unsigned int acked = 0;
+    if (result.ok) {
+        Tokenizer t(result.reply, false, " \t\n\r");
+        if (t.next() == "OK") {
+            acked = (unsigned int)strtoul(t.next().c_str(), 0, 10);
+        }
+    }
+    if (!acked) {
+        SubmitFailed();
+        return;
+    }
+
+    size_t removed = 0;
+    while (!outbox.empty() && (outbox.front().seq <= acked)) {
+        outbox.pop_front();
+        removed++;
+    }
+    LOG_INFO << "Score submission acknowledged up to " << acked << ", " << outbox.size() << " pending\n";
+
+    submitBackoff = 0;
+    nextSubmitTime = 0;
+    if (removed) {
+        ostringstream record;
+        record << "Ack " << acked << "\n";
+        AppendOutbox(record.str());
+    }
+}
+
+static bool SendingEnabled(void) {
+    bool onlineScores = false;
+    ConfigS::instance()->getBoolean("onlineScores", onlineScores);
+    return onlineScores && !onlineScoreURL.empty();
+}
+
+static void SendPendingScores(void) {
+    if (submitInFlight || outbox.empty() || ((Sint32)(SDL_GetTicks() - nextSubmitTime) < 0)) {
+        return;
+    }
+    if (!SendingEnabled()) {
+        return;
+    }
 
-        pendindScoreBoardData.erase(pendindScoreBoardData.begin());
+    stringstream url;
+    url << onlineScoreURL << "?Client=" << clientId << "&Batch=";
+    unsigned int lastSeq = 0;
+    size_t count = 0;
+    list<PendingScore>::const_iterator i;
+    for (i = outbox.begin(); (i != outbox.end()) && (count < MAX_SUBMIT_BATCH); i++, count++) {
+        if (count) {
+            url << ",";
+        }
+        url << i->seq << ":" << i->score << ":" << i->hash;
+        lastSeq = i->seq;
+    }
 
-        hasNext = true;
+    submitInFlight = true;
+    if (!SubmitScores(url.str(), lastSeq)) {
+        submitInFlight = false;
+        SubmitFailed();
     }
-    ReleaseLock();
-    return hasNext;
 }
 
-void OnlineScore::AddScoreBoardData(const std::string& boardName, const std::string& data) {
-    GetLock();
-    pendindScoreBoardData[boardName] = data;
-    ReleaseLock();
+bool OnlineScore::Init(void) {
+    if (completionLock) {
+        return true;
+    }
+    completionLock = SDL_CreateMutex();
+    SDL_AtomicSet(&numCompleted, 0);
+
+    ConfigS::instance()->getString("onlineScoreURL", onlineScoreURL);
+    LoadOutbox();
+
+    return (completionLock != 0) && StartWorker();
 }
 
-static inline std::string stringToHex(const std::string& data) {
-    std::stringstream ss;
+void OnlineScore::Shutdown(void) {
+    StopWorker();
 
-    for (size_t i = 0; i < data.length(); i++) {
-        unsigned char val = (unsigned char)data[i];
-        ss << std::setw(2) << std::setfill('0') << hex;
-        ss << (unsigned int)val;
+    if (completionLock) {
+        SDL_DestroyMutex(completionLock);
+        completionLock = 0;
     }
-    return ss.str();
+    completedData.clear();
+    drainedData.clear();
+    submitResults.clear();
+
+    //anything unacknowledged is still in the outbox file for next time
+    outbox.clear();
+    submitInFlight = false;
 }
 
-static inline std::string hexToString(const std::string& strRep) {
-    std::stringstream ss;
-    std::string result;
+//Take everything the worker completed. Only locks when the counter says
+//something arrived.
+static void DrainCompleted(void) {
+    if (!completionLock || (SDL_AtomicGet(&numCompleted) == 0)) {
+        return;
+    }
+
+    list<SubmitResult> results;
 
-    for (size_t i = 0; i < strRep.length(); i += 2) {
-        ss.clear();
-        ss << hex << strRep.substr(i, 2);
-        unsigned int c;
-        ss >> c;
-        result += (unsigned char)c;
+    SDL_LockMutex(completionLock);
+    drainedData.splice(drainedData.end(), completedData);
+    results.swap(submitResults);
+    SDL_AtomicSet(&numCompleted, 0);
+    SDL_UnlockMutex(completionLock);
+
+    list<SubmitResult>::const_iterator i;
+    for (i = results.begin(); i != results.end(); i++) {
+        HandleSubmitResult(*i);
     }
-    return result;
 }
 
-//TODO: add connectivity / reachability check
-#ifdef DUMMYSCORES
-const string onlineScoreURL = "";
-#else
-const string onlineScoreURL = "";
-#endif
+void OnlineScore::Update(void) {
+    DrainCompleted();
+    SendPendingScores();
+}
 
-void OnlineScore::SendScore(int score, const std::string& scoreMsg) {
-    string message = scoreMsg;
-    int pad = message.size() % 4;
-    if (pad != 0) {
-        message += string(4 - pad, ' ');
+bool OnlineScore::GetNextScoreBoardData(std::string& boardName, std::string& scoreData) {
+    if (drainedData.empty()) {
+        DrainCompleted();
+    }
+
+    if (drainedData.empty()) {
+        return false;
     }
 
-    string cipher = Tea::encode(message);
+    boardName = drainedData.front().boardName;
+    scoreData = drainedData.front().data;
+    drainedData.pop_front();
 
-    string hash = stringToHex(cipher);
-    stringstream url;
+    return true;
+}
 
-    url << onlineScoreURL << "?Score=" << score << "&Hash=" << hash;
+void OnlineScore::AddScoreBoardData(const std::string& boardName, const std::string& data) {
+    if (!completionLock) {
+        return;
+    }
 
-    ::SendScore(url.str());
+    SDL_LockMutex(completionLock);
+    completedData.push_back(ScoreBoardData(boardName, data));
+    SDL_AtomicAdd(&numCompleted, 1);
+    SDL_UnlockMutex(completionLock);
 }
 
-void OnlineScore::RequestTopScores(const std::string& boardName, const std::string& scoreMsg) {
+//Encrypt a message and return it as hex. The message is space padded to
+//whole Tea words.
+static string EncodeMessage(const string& scoreMsg) {
     string message = scoreMsg;
-    int pad = message.size() % 4;
-    if (pad != 0) {
-        message += string(4 - pad, ' ');
+    size_t padded = std::max((message.size() + 3) & ~(size_t)3, (size_t)8);
+    message.resize(padded, ' ');
+
+    Tea::encode((unsigned char*)&message[0], message.size());
+
+    string hash(message.size() * 2, 0);
+    Hex::encode((const unsigned char*)message.data(), message.size(), &hash[0]);
+    return hash;
+}
+
+void OnlineScore::SendScore(int score, const std::string& scoreMsg) {
+    //nothing would ever drain the outbox
+    if (!SendingEnabled()) {
+        return;
     }
 
-    string cipher = Tea::encode(message);
+    PendingScore pending;
+    pending.seq = nextSeq++;
+    pending.score = score;
+    pending.hash = EncodeMessage(scoreMsg);
+    outbox.push_back(pending);
+
+    //on disk before it goes anywhere near the network
+    ostringstream record;
+    record << "Score " << pending.seq << " " << pending.score << " " << pending.hash << "\n";
+    AppendOutbox(record.str());
+    SendPendingScores();
+}
+
+void OnlineScore::RequestTopScores(const std::string& boardName, const std::string& scoreMsg) {
+    if (onlineScoreURL.empty()) {
+        return;
+    }
 
-    string hash = stringToHex(cipher);
     stringstream url;
-
-    url << onlineScoreURL << "?Board=" << boardName << "&Hash=" << hash;
+    url << onlineScoreURL << "?Board=" << boardName << "&Hash=" << EncodeMessage(scoreMsg);
 
     LOG_INFO << url.str() << "\n";
 
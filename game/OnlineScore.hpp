@@ -5,6 +5,16 @@
 
 class OnlineScore {
 public:
+    //Start the request worker. Call once from the main thread before any request.
+    static bool Init(void);
+    //Stop and join the worker. Requests not yet sent are dropped.
+    static void Shutdown(void);
+
+    //Pump the score outbox and collect finished requests. Call once per frame.
+    static void Update(void);
+
+    //Queue a score in the persistent outbox, it is sent (and resent) from
+    //Update. Does nothing while online scores are off.
     static void SendScore(int score, const std::string& scoreMsg);
     static void RequestTopScores(const std::string& boardName, const std::string& scoreMsg);
 
@@ -6,6 +6,7 @@
 #include "ParticleGroupManager.hpp"
 
 #include <Trace.hpp>
+#include <Profiler.hpp>
 
 #include <ParticleGroup.hpp>
 #include <FindHash.hpp>
@@ -52,6 +53,7 @@ void ParticleGroupManager::reset(void) {
 
 void ParticleGroupManager::draw(void) {
     XTRACE();
+    PROFILE_ZONE("ParticleGroupManager::draw");
 
     list<ParticleGroup*>::iterator i;
     for (i = _particleGroupList.begin(); i != _particleGroupList.end(); i++) {
@@ -61,6 +63,7 @@ void ParticleGroupManager::draw(void) {
 
 bool ParticleGroupManager::update(void) {
     XTRACE();
+    PROFILE_ZONE("ParticleGroupManager::update");
 
     list<ParticleGroup*>::iterator i;
     for (i = _particleGroupList.begin(); i != _particleGroupList.end(); i++) {
@@ -0,0 +1,105 @@
+#pragma once
+// Description:
+//   Little endian record encoding shared by the score files.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include <algorithm>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+inline void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out += (char)((v >> (i * 8)) & 0xff);
+    }
+}
+
+inline void putU64(std::string& out, uint64_t v) {
+    putU32(out, (uint32_t)v);
+    putU32(out, (uint32_t)(v >> 32));
+}
+
+inline void putString(std::string& out, const std::string& s) {
+    size_t length = std::min(s.size(), (size_t)0xffff);
+    out += (char)(length & 0xff);
+    out += (char)(length >> 8);
+    out.append(s, 0, length);
+}
+
+class RecordReader {
+public:
+    RecordReader(const char* data, size_t size) :
+        _data((const unsigned char*)data),
+        _size(size),
+        _pos(0) {}
+
+    bool getU32(uint32_t& v) {
+        if (!has(4)) {
+            return false;
+        }
+        v = 0;
+        for (int i = 0; i < 4; i++) {
+            v |= (uint32_t)_data[_pos++] << (i * 8);
+        }
+        return true;
+    }
+
+    bool getI32(int& v) {
+        uint32_t u;
+        if (!getU32(u)) {
+            return false;
+        }
+        v = (int)(int32_t)u;
+        return true;
+    }
+
+    bool getU64(uint64_t& v) {
+        uint32_t lo, hi;
+        if (!getU32(lo) || !getU32(hi)) {
+            return false;
+        }
+        v = ((uint64_t)hi << 32) | lo;
+        return true;
+    }
+
+    bool getU8(uint8_t& v) {
+        if (!has(1)) {
+            return false;
+        }
+        v = _data[_pos++];
+        return true;
+    }
+
+    bool getString(std::string& s) {
+        if (!has(2)) {
+            return false;
+        }
+        size_t length = _data[_pos] | (_data[_pos + 1] << 8);
+        _pos += 2;
+        if (!has(length)) {
+            return false;
+        }
+        s.assign((const char*)_data + _pos, length);
+        _pos += length;
+        return true;
+    }
+
+    bool getBytes(const char*& bytes, size_t length) {
+        if (!has(length)) {
+            return false;
+        }
+        bytes = (const char*)_data + _pos;
+        _pos += length;
+        return true;
+    }
+
+    bool atEnd(void) { return _pos == _size; }
+
+private:
+    bool has(size_t bytes) { return (_size - _pos) >= bytes; }
+
+    const unsigned char* _data;
+    size_t _size;
+    size_t _pos;
+};
@@ -0,0 +1,285 @@
+// Description:
+//   Every finished game, kept in an append-only file, with per board rank
+//   indices for rank and percentile queries.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "ScoreHistory.hpp"
+
+#include "Trace.hpp"
+#include "ResourceManager.hpp"
+#include "RecordIO.hpp"
+
+#include "physfs.h"
+
+#include <algorithm>
+#include <memory>
+#include <string.h>
+#include <zlib.h>
+using namespace std;
+
+//History file (scorehistory.bin), little endian, append-only:
+//  char[4] magic, uint32_t version
+//  per game: uint32_t size, uint32_t crc32, unsigned char[size] record
+//  record: int32_t width, height, depth, string blockset,
+//          int32_t score, level, planesCleared, secondsPlayed, int64_t time
+//  string: uint16_t length, char[length]
+//A game cut short by a crash fails its size or checksum; it and anything
+//after it are dropped and the file is replaced on the next load.
+static const char HISTORY_MAGIC[4] = {'S', 'H', 'S', 'T'};
+static const uint32_t HISTORY_VERSION = 1;
+const size_t HISTORY_HEADER_SIZE = 8;
+const size_t MAX_RECORD_SIZE = 64 * 1024;
+
+//blocks split when they reach twice this
+const size_t RANK_BLOCK_SIZE = 512;
+
+RankIndex::RankIndex(void) :
+    _blocks(),
+    _counts(),
+    _size(0) {}
+
+void RankIndex::build(vector<int>& scores) {
+    sort(scores.begin(), scores.end());
+
+    _blocks.clear();
+    for (size_t i = 0; i < scores.size(); i += RANK_BLOCK_SIZE) {
+        size_t end = std::min(i + RANK_BLOCK_SIZE, scores.size());
+        _blocks.push_back(vector<int>(scores.begin() + i, scores.begin() + end));
+    }
+    _size = scores.size();
+    rebuildCounts();
+}
+
+//first block whose largest score is greater than score, or the last block
+size_t RankIndex::findBlock(int score) const {
+    size_t lo = 0;
+    size_t hi = _blocks.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (_blocks[mid].back() > score) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+void RankIndex::insert(int score) {
+    if (_blocks.empty()) {
+        _blocks.push_back(vector<int>(1, score));
+        _size = 1;
+        rebuildCounts();
+        return;
+    }
+
+    size_t b = std::min(findBlock(score), _blocks.size() - 1);
+    vector<int>& block = _blocks[b];
+    block.insert(upper_bound(block.begin(), block.end(), score), score);
+    _size++;
+
+    if (block.size() >= 2 * RANK_BLOCK_SIZE) {
+        vector<int> upper(block.begin() + RANK_BLOCK_SIZE, block.end());
+        block.resize(RANK_BLOCK_SIZE);
+        _blocks.insert(_blocks.begin() + b + 1, upper);
+        rebuildCounts();
+    } else {
+        addCount(b, 1);
+    }
+}
+
+size_t RankIndex::countAbove(int score) const {
+    if (_blocks.empty()) {
+        return 0;
+    }
+
+    //blocks before b only hold scores <= score
+    size_t b = findBlock(score);
+    size_t atMost = countBefore(b);
+    if (b < _blocks.size()) {
+        const vector<int>& block = _blocks[b];
+        atMost += upper_bound(block.begin(), block.end(), score) - block.begin();
+    }
+    return _size - atMost;
+}
+
+//total size of blocks [0, block)
+size_t RankIndex::countBefore(size_t block) const {
+    size_t sum = 0;
+    for (size_t i = block; i > 0; i -= i & (~i + 1)) {
+        sum += _counts[i - 1];
+    }
+    return sum;
+}
+
+void RankIndex::addCount(size_t block, int delta) {
+    for (size_t i = block + 1; i <= _counts.size(); i += i & (~i + 1)) {
+        _counts[i - 1] += delta;
+    }
+}
+
+void RankIndex::rebuildCounts(void) {
+    _counts.assign(_blocks.size(), 0);
+    for (size_t b = 0; b < _blocks.size(); b++) {
+        addCount(b, (int)_blocks[b].size());
+    }
+}
+
+ScoreHistory::ScoreHistory(void) :
+    _fileName(),
+    _numGames(0),
+    _boards() {}
+
+string ScoreHistory::encode(const GameRecord& game) {
+    string record;
+    putU32(record, (uint32_t)game.board.width);
+    putU32(record, (uint32_t)game.board.height);
+    putU32(record, (uint32_t)game.board.depth);
+    putString(record, game.board.blockset);
+    putU32(record, (uint32_t)game.score);
+    putU32(record, (uint32_t)game.level);
+    putU32(record, (uint32_t)game.planesCleared);
+    putU32(record, (uint32_t)game.secondsPlayed);
+    putU64(record, (uint64_t)game.time);
+
+    string data;
+    putU32(data, (uint32_t)record.size());
+    putU32(data, (uint32_t)crc32(0, (const Bytef*)record.data(), (uInt)record.size()));
+    return data + record;
+}
+
+static bool decode(const char* data, size_t size, GameRecord& game) {
+    RecordReader reader(data, size);
+    uint64_t time;
+    if (!reader.getI32(game.board.width) || !reader.getI32(game.board.height) ||
+        !reader.getI32(game.board.depth) || !reader.getString(game.board.blockset) ||
+        !reader.getI32(game.score) || !reader.getI32(game.level) || !reader.getI32(game.planesCleared) ||
+        !reader.getI32(game.secondsPlayed) || !reader.getU64(time)) {
+        return false;
+    }
+    game.time = (time_t)time;
+    return reader.atEnd();
+}
+
+bool ScoreHistory::load(const string& fileName) {
+    XTRACE();
+    _fileName = fileName;
+    _numGames = 0;
+    _boards.clear();
+
+    if (!ResourceManagerS::instance()->hasResource(fileName)) {
+        return true;
+    }
+
+    std::unique_ptr<ResourceView> view(ResourceManagerS::instance()->getResourceView(fileName));
+    if (!view || (view->size() < HISTORY_HEADER_SIZE) ||
+        (memcmp(view->data(), HISTORY_MAGIC, sizeof(HISTORY_MAGIC)) != 0)) {
+        //leave it alone and don't record into it
+        LOG_ERROR << "Score history " << fileName << " is not a history file, not recording games\n";
+        _fileName = "";
+        return false;
+    }
+
+    RecordReader reader((const char*)view->data(), view->size());
+    const char* magic;
+    uint32_t version;
+    reader.getBytes(magic, sizeof(HISTORY_MAGIC));
+    reader.getU32(version);
+    if (version != HISTORY_VERSION) {
+        LOG_ERROR << "Score history " << fileName << " has unknown version " << version << ", not recording games\n";
+        _fileName = "";
+        return false;
+    }
+
+    //collect scores per board and build each index once
+    map<ScoreBoardKey, vector<int>> scores;
+    size_t validSize = HISTORY_HEADER_SIZE;
+    while (!reader.atEnd()) {
+        uint32_t size;
+        uint32_t crc;
+        const char* record;
+        if (!reader.getU32(size) || !reader.getU32(crc) || (size > MAX_RECORD_SIZE) ||
+            !reader.getBytes(record, size)) {
+            break;
+        }
+
+        GameRecord game;
+        if ((crc32(0, (const Bytef*)record, (uInt)size) != crc) || !decode(record, size, game)) {
+            break;
+        }
+
+        scores[game.board].push_back(game.score);
+        _numGames++;
+        validSize += 8 + size;
+    }
+
+    map<ScoreBoardKey, vector<int>>::iterator i;
+    for (i = scores.begin(); i != scores.end(); i++) {
+        _boards[i->first].build(i->second);
+    }
+
+    if (validSize != view->size()) {
+        LOG_WARNING << "Score history " << fileName << " damaged, keeping " << _numGames << " games\n";
+        string kept((const char*)view->data(), validSize);
+        //unmapped before the file is replaced
+        view.reset();
+        ResourceManagerS::instance()->replaceFile(fileName, kept);
+    }
+
+    LOG_INFO << "Score history: " << _numGames << " games on " << _boards.size() << " boards\n";
+    return true;
+}
+
+bool ScoreHistory::write(const string& data, bool append) {
+    PHYSFS_File* outfile =
+        append ? PHYSFS_openAppend(_fileName.c_str()) : PHYSFS_openWrite(_fileName.c_str());
+    if (!outfile) {
+        LOG_ERROR << "Unable to write score history " << _fileName << "\n";
+        return false;
+    }
+
+    bool ok = (PHYSFS_writeBytes(outfile, data.data(), data.size()) == (PHYSFS_sint64)data.size());
+    PHYSFS_close(outfile);
+
+    if (!ok) {
+        LOG_ERROR << "Unable to write score history " << _fileName << "\n";
+    }
+    return ok;
+}
+
+bool ScoreHistory::add(const GameRecord& game) {
+    if (_fileName.empty()) {
+        return false;
+    }
+
+    _boards[game.board].insert(game.score);
+    _numGames++;
+
+    string data = encode(game);
+    if (!ResourceManagerS::instance()->hasResource(_fileName)) {
+        string header(HISTORY_MAGIC, sizeof(HISTORY_MAGIC));
+        putU32(header, HISTORY_VERSION);
+        return write(header + data, false);
+    }
+    return write(data, true);
+}
+
+GameRank ScoreHistory::getRank(const ScoreBoardKey& board, int score) const {
+    GameRank result;
+    result.rank = 0;
+    result.total = 0;
+    result.topPercent = 0;
+
+    map<ScoreBoardKey, RankIndex>::const_iterator i = _boards.find(board);
+    if ((i == _boards.end()) || (i->second.size() == 0)) {
+        return result;
+    }
+
+    const RankIndex& index = i->second;
+    result.rank = index.countAbove(score) + 1;
+    result.total = index.size();
+    result.topPercent = (int)((result.rank * 100 + result.total - 1) / result.total);
+
+    return result;
+}
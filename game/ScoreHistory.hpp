@@ -0,0 +1,71 @@
+#pragma once
+// Description:
+//   Every finished game, kept in an append-only file, with per board rank
+//   indices for rank and percentile queries.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include <map>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "ScoreKeeper.hpp"
+
+struct GameRecord {
+    ScoreBoardKey board;
+    int score;
+    int level;
+    int planesCleared;
+    int secondsPlayed;
+    time_t time;
+};
+
+//Multiset of scores kept as sorted blocks, with a Fenwick tree over the
+//block sizes. Rank queries and inserts are O(log n) apart from moving
+//elements within one block.
+class RankIndex {
+public:
+    RankIndex(void);
+
+    //replace contents, scores need not be sorted
+    void build(std::vector<int>& scores);
+    void insert(int score);
+
+    size_t size(void) const { return _size; }
+    //number of scores strictly greater than score
+    size_t countAbove(int score) const;
+
+private:
+    size_t findBlock(int score) const;
+    size_t countBefore(size_t block) const;
+    void addCount(size_t block, int delta);
+    void rebuildCounts(void);
+
+    std::vector<std::vector<int>> _blocks;
+    std::vector<size_t> _counts;
+    size_t _size;
+};
+
+class ScoreHistory {
+public:
+    ScoreHistory(void);
+
+    //read all games, rewrites the file if its tail was damaged
+    bool load(const std::string& fileName);
+    //append to the file and the index
+    bool add(const GameRecord& game);
+
+    GameRank getRank(const ScoreBoardKey& board, int score) const;
+
+    size_t numGames(void) const { return _numGames; }
+
+private:
+    bool write(const std::string& data, bool append);
+    static std::string encode(const GameRecord& game);
+
+    std::string _fileName;
+    size_t _numGames;
+    std::map<ScoreBoardKey, RankIndex> _boards;
+};
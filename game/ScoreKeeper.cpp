@@ -10,6 +10,7 @@
 #include "Value.hpp"
 #include "Tokenizer.hpp"
 #include "zStream.hpp"
+#include "ResourceManager.hpp"
 #include <RandomKnuth.hpp>
 
 #include "GLBitmapFont.hpp"
@@ -29,6 +30,8 @@
 #include "GameState.hpp"
 #include "FindHash.hpp"
 #include "StringUtils.hpp"
+#include "RecordIO.hpp"
+#include "ScoreHistory.hpp"
 
 #ifdef min
 #undef min
@@ -36,10 +39,13 @@
 
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <string>
 #include <algorithm>
 #include <sstream>
-#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
 using namespace std;
 
 const int LEADERBOARD_SIZE = 11;  //top-10 plus current score
@@ -52,6 +58,12 @@ void ScoreKeeper::mergeOnlineScores() {
     while (OnlineScore::GetNextScoreBoardData(boardName, scoreData)) {
         //LOG_INFO << "Merging online score data for " << boardName << "\n";
 
+        ScoreBoardKey key;
+        if (!ScoreBoardKey::fromName(boardName, key)) {
+            LOG_WARNING << "Ignoring online scores for unknown board [" << boardName << "]\n";
+            continue;
+        }
+
         Tokenizer t(scoreData, false, "\n\r");
         string line;
         LeaderBoard onlineBoard;
@@ -64,6 +76,7 @@ void ScoreKeeper::mergeOnlineScores() {
                 stringstream(csv[2]) >> sd.cubes;
                 stringstream(csv[3]) >> sd.secondsPlayed;
                 stringstream(csv[4]) >> sd.time;
+                sd.sent = true;
                 sd.online = true;
 
                 onlineBoard.push_back(sd);
@@ -74,7 +87,7 @@ void ScoreKeeper::mergeOnlineScores() {
             return;
         }
 
-        if (_leaderBoardName == boardName) {
+        if (key == _leaderBoardKey) {
             LOG_INFO << "Updating actice leaderboard\n";
 
             ScoreData currentScore = _leaderBoard[_currentIndex];
@@ -82,9 +95,6 @@ void ScoreKeeper::mergeOnlineScores() {
             //merge onlineBoard into _leaderBoard
             mergeLeaderBoard(_leaderBoard, onlineBoard);
 
-            sort(_leaderBoard.begin(), _leaderBoard.end());
-            _leaderBoard.resize(LEADERBOARD_SIZE);
-
             _currentIndex = LEADERBOARD_SIZE;
             for (size_t i = 0; i < _leaderBoard.size(); i++) {
                 if (currentScore.score == _leaderBoard[i].score && currentScore.cubes == _leaderBoard[i].cubes &&
@@ -101,56 +111,56 @@ void ScoreKeeper::mergeOnlineScores() {
                 sortLeaderBoard();
             }
 
-            if (boardName == _currentScoreboard->name) {
-                _currentScoreboardAsLeaderBoard = _leaderBoard;
-            }
+            updateScoreBoardWithLeaderBoard();
         } else {
             LOG_INFO << "Updating dormant leaderboard\n";
 
-            ScoreBoards::iterator i;
-            for (i = _scoreBoards.begin(); i < _scoreBoards.end(); i++) {
-                if (i->name == boardName) {
-                    break;
-                }
-            }
-
+            ScoreBoards::iterator i = _scoreBoards.find(key);
             if (i != _scoreBoards.end()) {
-                LeaderBoard lb;
-                stringToLeaderBoard(i->data, lb);
-
-                mergeLeaderBoard(lb, onlineBoard);
-
-                sort(lb.begin(), lb.end());
-                lb.resize(LEADERBOARD_SIZE);
-
-                i->data = leaderBoardToString(lb, boardName);
+                mergeLeaderBoard(i->second, onlineBoard);
             }
+        }
 
-            if (boardName == _currentScoreboard->name) {
-                stringToLeaderBoard(_currentScoreboard->data, _currentScoreboardAsLeaderBoard);
-            }
+        if ((_currentScoreboard != _scoreBoards.end()) && (_currentScoreboard->first == key)) {
+            _revision++;
         }
     }
 }
 
-void ScoreKeeper::mergeLeaderBoard(LeaderBoard& leaderBoard, const LeaderBoard& onlineBoard) {
+//Both boards are kept sorted, so this is a bounded merge of two sorted lists.
+//Online entries matching a local one only mark it as online.
+void ScoreKeeper::mergeLeaderBoard(LeaderBoard& leaderBoard, LeaderBoard onlineBoard) {
+    stable_sort(onlineBoard.begin(), onlineBoard.end());
+
+    LeaderBoard fresh;
+    fresh.reserve(onlineBoard.size());
     LeaderBoard::const_iterator oi;
     for (oi = onlineBoard.begin(); oi != onlineBoard.end(); oi++) {
         const ScoreData& sd = *oi;
 
+        //duplicates have the same score, so only look at that range
         bool isDuplicate = false;
-        LeaderBoard::iterator i;
-        for (i = leaderBoard.begin(); i != leaderBoard.end(); i++) {
-            if (sd.score == i->score && sd.cubes == i->cubes && sd.secondsPlayed == i->secondsPlayed &&
-                sd.time == i->time) {
+        pair<LeaderBoard::iterator, LeaderBoard::iterator> range =
+            equal_range(leaderBoard.begin(), leaderBoard.end(), sd);
+        for (LeaderBoard::iterator i = range.first; i != range.second; i++) {
+            if (sd.cubes == i->cubes && sd.secondsPlayed == i->secondsPlayed && sd.time == i->time) {
                 isDuplicate = true;
                 i->online = true;
             }
         }
         if (!isDuplicate) {
-            leaderBoard.push_back(sd);
+            fresh.push_back(sd);
         }
     }
+
+    if (fresh.empty()) {
+        return;
+    }
+
+    LeaderBoard merged(leaderBoard.size() + fresh.size());
+    merge(leaderBoard.begin(), leaderBoard.end(), fresh.begin(), fresh.end(), merged.begin());
+    merged.resize(LEADERBOARD_SIZE);
+    leaderBoard.swap(merged);
 }
 
 void ScoreKeeper::sendOnlineUpdateRequest(const std::string& boardName) {
@@ -180,16 +190,24 @@ void ScoreKeeper::sendOnlineUpdateRequest(const std::string& boardName) {
 ScoreKeeper::ScoreKeeper(void) :
     _currentIndex(LEADERBOARD_SIZE - 1),
     _infoIndex(0),
+    _leaderBoardKey(),
     _leaderBoard(LEADERBOARD_SIZE),
-    _practiceMode(true) {
+    _scoreBoards(),
+    _currentScoreboard(_scoreBoards.end()),
+    _practiceMode(true),
+    _revision(0),
+    _history(new ScoreHistory()) {
     XTRACE();
     resetLeaderBoard(_leaderBoard);
-    _currentScoreboard = _scoreBoards.end();
+    _lastGameRank.rank = 0;
+    _lastGameRank.total = 0;
+    _lastGameRank.topPercent = 0;
 }
 
 ScoreKeeper::~ScoreKeeper(void) {
     XTRACE();
     _scoreBoards.clear();
+    delete _history;
 }
 
 void ScoreKeeper::resetCurrentScore(void) {
@@ -201,6 +219,10 @@ void ScoreKeeper::resetCurrentScore(void) {
     _leaderBoard[_currentIndex].secondsPlayed = 0;
     _leaderBoard[_currentIndex].sent = false;
     _leaderBoard[_currentIndex].online = false;
+
+    _lastGameRank.rank = 0;
+    _lastGameRank.total = 0;
+    _lastGameRank.topPercent = 0;
 }
 
 int ScoreKeeper::addToCurrentScore(int score, int cubes, int secs) {
@@ -267,29 +289,40 @@ bool ScoreKeeper::currentIsTopTen(void) {
     return _currentIndex < (LEADERBOARD_SIZE - 1);
 }
 
+void ScoreKeeper::recordGame(int level, int planesCleared) {
+    if (_practiceMode) {
+        return;
+    }
+
+    const ScoreData& current = _leaderBoard[_currentIndex];
+
+    GameRecord game;
+    game.board = _leaderBoardKey;
+    game.score = current.score;
+    game.level = level;
+    game.planesCleared = planesCleared;
+    game.secondsPlayed = current.secondsPlayed;
+    game.time = current.time;
+    _history->add(game);
+
+    _lastGameRank = _history->getRank(_leaderBoardKey, current.score);
+    LOG_INFO << "Game ranks " << _lastGameRank.rank << " of " << _lastGameRank.total << " on "
+             << _leaderBoardKey.toName() << "\n";
+}
+
 void ScoreKeeper::setNameForCurrent(const std::string& name) {
     _leaderBoard[_currentIndex].name = name;
 }
 
-void ScoreKeeper::setLeaderBoard(const std::string& scoreboardName) {
-    ScoreBoards::iterator i;
-    for (i = _scoreBoards.begin(); i < _scoreBoards.end(); i++) {
-        if (i->name == scoreboardName) {
-            break;
-        }
-    }
-
-    if (i != _scoreBoards.end()) {
-        stringToLeaderBoard(i->data, _leaderBoard);
-    } else {
-        resetLeaderBoard(_leaderBoard);
-        string data = leaderBoardToString(_leaderBoard, scoreboardName);
-        addScoreBoard(scoreboardName, data);
+void ScoreKeeper::setLeaderBoard(const ScoreBoardKey& key) {
+    ScoreBoards::iterator i = _scoreBoards.find(key);
+    if (i == _scoreBoards.end()) {
+        i = addScoreBoard(key);
     }
+    _leaderBoard = i->second;
+    _leaderBoardKey = key;
 
-    _leaderBoardName = scoreboardName;
-
-    sendOnlineUpdateRequest(scoreboardName);
+    sendOnlineUpdateRequest(key.toName());
 }
 
 int ScoreKeeper::getScore(unsigned int index) {
@@ -317,6 +350,7 @@ void ScoreKeeper::resetLeaderBoard(LeaderBoard& lb) {
         time(&lb[i].time);
         lb[i].cubes = 0;
         lb[i].secondsPlayed = 0;
+        lb[i].sent = false;
         lb[i].online = false;
     }
 
@@ -342,113 +376,32 @@ void ScoreKeeper::sortLeaderBoard(void) {
     //dumpLeaderBoard( _leaderBoard);
 }
 
-string ScoreKeeper::leaderBoardToString(LeaderBoard& lb, const string& leaderBoardName) {
-    ostringstream ostr;
-    ostr << leaderBoardName << "\001";
-
-    for (unsigned int i = 0; i < lb.size(); i++) {
-        if (lb[i].name == "") {
-            lb[i].name = "Anonymous";
-        }
-        ostr << lb[i].name << "\002" << lb[i].score << "\002" << (long)lb[i].time << "\002" << lb[i].cubes << "\002"
-             << lb[i].secondsPlayed << "\002" << lb[i].online << "\002";
-    }
-
-    LOG_INFO << "leaderBoardToString [" << ostr.str() << "]\n";
-
-    return ostr.str();
-}
-
-void ScoreKeeper::stringToLeaderBoard(const string& lbString, LeaderBoard& lb) {
-    Tokenizer t(lbString, false, "\001\002");
-
-    string scoreboardName = t.next();
-    if (scoreboardName != "") {
-        lb.clear();
-
-        bool done = false;
-        while (!done) {
-            ScoreData sData;
-            sData.name = t.next();
-            if (sData.name != "") {
-                sData.score = atoi(t.next().c_str());
-                sData.time = (time_t)atoi(t.next().c_str());
-
-                string num = t.next();
-                sData.cubes = 0;
-                if (num.length()) {
-                    sData.cubes = atoi(num.c_str());
-                }
-
-                num = t.next();
-                sData.secondsPlayed = 0;
-                if (num.length()) {
-                    sData.secondsPlayed = atoi(num.c_str());
-                }
-
-                sData.online = false;
-                num = t.next();
-                if (num.length()) {
-                    sData.online = atoi(num.c_str());
-                }
-
-                lb.push_back(sData);
-            } else {
-                done = true;
-            }
-        }
-    }
-    if (lb.size() < LEADERBOARD_SIZE) {
-        lb.resize(LEADERBOARD_SIZE);
-        resetLeaderBoard(lb);
-    }
-
-    //should already be sorted, but better be safe...
-    sort(lb.begin(), lb.end());
-
-    dumpLeaderBoard(lb);
-}
-
 void ScoreKeeper::dumpLeaderBoard(const LeaderBoard& lb) {
     LOG_INFO << "------LeaderBoard-----" << endl;
     for (unsigned int i = 0; i < lb.size(); i++) {
-        LOG_INFO.width(30);
-        LOG_VOID.fill('.');
-        LOG_VOID.unsetf(ios::right);
-        LOG_VOID.setf(ios::left);
-        LOG_VOID << lb[i].name.c_str();
-
-        LOG_VOID.width(10);
-        LOG_VOID.unsetf(ios::left);
-        LOG_VOID.setf(ios::right);
-        LOG_VOID << lb[i].score;
-
-        LOG_VOID.width(10);
-        LOG_VOID.unsetf(ios::left);
-        LOG_VOID.setf(ios::right);
-        LOG_VOID << lb[i].cubes;
-
-        LOG_VOID.width(10);
-        LOG_VOID.unsetf(ios::left);
-        LOG_VOID.setf(ios::right);
-        LOG_VOID << lb[i].secondsPlayed;
-
         char buf[128];
         strftime(buf, 127, "%a %d-%b-%Y %H:%M", localtime(&lb[i].time));
-        LOG_VOID << " : " << buf << endl;
+
+        LOG_INFO << setfill('.') << left << setw(30) << lb[i].name.c_str() << setfill(' ') << right
+                 << setw(10) << lb[i].score << setw(10) << lb[i].cubes << setw(10) << lb[i].secondsPlayed
+                 << " : " << buf << endl;
     }
 }
 
 const string ScoreKeeper::getInfoText(unsigned int index) {
     string info = "";
-    _infoIndex = index;
+    if (_infoIndex != index) {
+        _infoIndex = index;
+        _revision++;
+    }
 
-    if (index < _currentScoreboardAsLeaderBoard.size()) {
-        info = _currentScoreboardAsLeaderBoard[index].name;
+    if ((_currentScoreboard != _scoreBoards.end()) && (index < _currentScoreboard->second.size())) {
+        const ScoreData& sd = _currentScoreboard->second[index];
+        info = sd.name;
         info += " played on ";
 
         char buf[128];
-        strftime(buf, 127, "%a %d-%b-%Y %H:%M", localtime(&_currentScoreboardAsLeaderBoard[index].time));
+        strftime(buf, 127, "%a %d-%b-%Y %H:%M", localtime(&sd.time));
 
         info += buf;
     }
@@ -457,152 +410,338 @@ const string ScoreKeeper::getInfoText(unsigned int index) {
 }
 
 void ScoreKeeper::updateScoreBoardWithLeaderBoard(void) {
-    ScoreBoards::iterator i;
-    for (i = _scoreBoards.begin(); i < _scoreBoards.end(); i++) {
-        if (i->name == _leaderBoardName) {
-            i->data = leaderBoardToString(_leaderBoard, _leaderBoardName);
-            break;
-        }
+    ScoreBoards::iterator i = _scoreBoards.find(_leaderBoardKey);
+    if (i != _scoreBoards.end()) {
+        i->second = _leaderBoard;
     }
 }
 
-static inline Point3Di nameToDimension(string name) {
-    Tokenizer t(name, "x:");
-    Point3Di dim;
-    dim.x = atoi(t.next().c_str());
-    dim.y = atoi(t.next().c_str());
-    dim.z = atoi(t.next().c_str());
-    return dim;
+string ScoreBoardKey::toName(void) const {
+    ostringstream ostr;
+    ostr << width << "x" << height << "x" << depth << ":" << blockset;
+    return ostr.str();
 }
 
-void ScoreKeeper::addScoreBoard(const string& scoreboardName, const string& data) {
-    ScoreBoard newBoard;
-    newBoard.name = scoreboardName;
-    newBoard.dimension = ::nameToDimension(scoreboardName);
-    newBoard.data = data;
-    _scoreBoards.push_back(newBoard);
+bool ScoreBoardKey::fromName(const string& name, ScoreBoardKey& key) {
+    size_t colon = name.find(':');
+    if (colon == string::npos) {
+        return false;
+    }
+    if (sscanf(name.c_str(), "%dx%dx%d:", &key.width, &key.height, &key.depth) != 3) {
+        return false;
+    }
+    key.blockset = name.substr(colon + 1);
+    return true;
+}
 
-    sort(_scoreBoards.begin(), _scoreBoards.end());
+ScoreKeeper::ScoreBoards::iterator ScoreKeeper::addScoreBoard(const ScoreBoardKey& key) {
+    LeaderBoard lb(LEADERBOARD_SIZE);
+    resetLeaderBoard(lb);
+    ScoreBoards::iterator i = _scoreBoards.insert(make_pair(key, lb)).first;
+    if (_currentScoreboard == _scoreBoards.end()) {
+        _currentScoreboard = i;
+    }
+    return i;
+}
 
-    for (ScoreBoards::iterator i = _scoreBoards.begin(); i < _scoreBoards.end(); i++) {
-        if (i->name == scoreboardName) {
-            _currentScoreboard = i;
-            break;
-        }
+void ScoreKeeper::setCurrentScoreboard(ScoreBoards::iterator board) {
+    _currentScoreboard = board;
+    if (_currentScoreboard != _scoreBoards.end()) {
+        sendOnlineUpdateRequest(_currentScoreboard->first.toName());
     }
+    _revision++;
 }
 
 void ScoreKeeper::setActive(string scoreboardName) {
     updateScoreBoardWithLeaderBoard();
 
-    if (scoreboardName == "") {
-        scoreboardName = _leaderBoardName;
-    }
-    if (_currentScoreboard->name != scoreboardName) {
-        _currentScoreboard = _scoreBoards.end();
-        for (ScoreBoards::iterator i = _scoreBoards.begin(); i < _scoreBoards.end(); i++) {
-            if (i->name == scoreboardName) {
-                _currentScoreboard = i;
-                break;
-            }
-        }
+    ScoreBoardKey key = _leaderBoardKey;
+    if ((scoreboardName != "") && !ScoreBoardKey::fromName(scoreboardName, key)) {
+        LOG_WARNING << "Invalid board name [" << scoreboardName << "]\n";
+        return;
     }
 
-    if (_currentScoreboard != _scoreBoards.end()) {
-        stringToLeaderBoard(_currentScoreboard->data, _currentScoreboardAsLeaderBoard);
-    } else {
-        LOG_WARNING << "Board [" << scoreboardName << "] does not exist! Creating...\n";
-        resetLeaderBoard(_currentScoreboardAsLeaderBoard);
-        string data = leaderBoardToString(_currentScoreboardAsLeaderBoard, scoreboardName);
-        addScoreBoard(scoreboardName, data);
+    ScoreBoards::iterator i = _scoreBoards.find(key);
+    if (i == _scoreBoards.end()) {
+        LOG_WARNING << "Board [" << key.toName() << "] does not exist! Creating...\n";
+        i = addScoreBoard(key);
     }
-
-    sendOnlineUpdateRequest(scoreboardName);
+    setCurrentScoreboard(i);
 }
 
 void ScoreKeeper::nextBoard(void) {
     updateScoreBoardWithLeaderBoard();
-
-    _currentScoreboard++;
-    if (_currentScoreboard == _scoreBoards.end()) {
-        _currentScoreboard = _scoreBoards.begin();
+    if (_scoreBoards.empty()) {
+        return;
     }
-    if (_currentScoreboard != _scoreBoards.end()) {
-        stringToLeaderBoard(_currentScoreboard->data, _currentScoreboardAsLeaderBoard);
-        sendOnlineUpdateRequest(_currentScoreboard->name);
+
+    ScoreBoards::iterator i = _currentScoreboard;
+    if ((i == _scoreBoards.end()) || (++i == _scoreBoards.end())) {
+        i = _scoreBoards.begin();
     }
+    setCurrentScoreboard(i);
 }
 
 void ScoreKeeper::prevBoard(void) {
     updateScoreBoardWithLeaderBoard();
+    if (_scoreBoards.empty()) {
+        return;
+    }
 
-    if (_currentScoreboard == _scoreBoards.begin()) {
-        _currentScoreboard = _scoreBoards.end();
+    ScoreBoards::iterator i = _currentScoreboard;
+    if (i == _scoreBoards.begin()) {
+        i = _scoreBoards.end();
     }
-    _currentScoreboard--;
-    if (_currentScoreboard != _scoreBoards.end()) {
-        stringToLeaderBoard(_currentScoreboard->data, _currentScoreboardAsLeaderBoard);
-        sendOnlineUpdateRequest(_currentScoreboard->name);
+    i--;
+    setCurrentScoreboard(i);
+}
+
+//Leaderboard file (leaderboard.bin, gzip compressed), little endian:
+//  char[4] magic, uint32_t version, uint32_t numBoards
+//  per board: uint32_t size, uint32_t crc32, unsigned char[size] record
+//  record: int32_t width, height, depth, string blockset, uint32_t numEntries
+//          per entry: string name, int32_t score, int64_t time,
+//                     int32_t cubes, int32_t secondsPlayed, uint8_t flags
+//  string: uint16_t length, char[length]
+//Boards failing their checksum are dropped, the rest still loads.
+static const char LEADERBOARD_MAGIC[4] = {'S', 'L', 'B', 'D'};
+static const uint32_t LEADERBOARD_VERSION = 1;
+static const string LEADERBOARD_FILE = "leaderboard.bin";
+//text format used up to version 1.0, read once for migration
+static const string LEGACY_LEADERBOARD_FILE = "leaderboard";
+//every finished game, see ScoreHistory.cpp
+static const string HISTORY_FILE = "scorehistory.bin";
+
+enum ScoreFlags {
+    eScoreSent = 1,
+    eScoreOnline = 2,
+};
+
+static bool readBoardRecord(const char* data, size_t size, ScoreBoardKey& key, vector<ScoreData>& lb) {
+    RecordReader reader(data, size);
+    uint32_t numEntries;
+    if (!reader.getI32(key.width) || !reader.getI32(key.height) || !reader.getI32(key.depth) ||
+        !reader.getString(key.blockset) || !reader.getU32(numEntries) || (numEntries > LEADERBOARD_SIZE)) {
+        return false;
+    }
+
+    lb.resize(numEntries);
+    for (uint32_t i = 0; i < numEntries; i++) {
+        ScoreData& sd = lb[i];
+        uint64_t time;
+        uint8_t flags;
+        if (!reader.getString(sd.name) || !reader.getI32(sd.score) || !reader.getU64(time) ||
+            !reader.getI32(sd.cubes) || !reader.getI32(sd.secondsPlayed) || !reader.getU8(flags)) {
+            return false;
+        }
+        sd.time = (time_t)time;
+        sd.sent = (flags & eScoreSent) != 0;
+        sd.online = (flags & eScoreOnline) != 0;
     }
+
+    return reader.atEnd();
 }
 
-void ScoreKeeper::load(void) {
-    XTRACE();
-    string scoreFilename = "leaderboard";
-    LOG_INFO << "Loading hi-scores from " << scoreFilename << endl;
+bool ScoreKeeper::loadBinary(const string& fileName) {
+    ziStream infile(fileName);
+    if (!infile.isOK()) {
+        return false;
+    }
+    const string data = infile.readAll();
+
+    RecordReader reader(data.data(), data.size());
+    const char* magic;
+    uint32_t version;
+    uint32_t numBoards;
+    if (!reader.getBytes(magic, sizeof(LEADERBOARD_MAGIC)) ||
+        (memcmp(magic, LEADERBOARD_MAGIC, sizeof(LEADERBOARD_MAGIC)) != 0) || !reader.getU32(version) ||
+        !reader.getU32(numBoards)) {
+        LOG_ERROR << "Leaderboard " << fileName << " is not a leaderboard file" << endl;
+        return false;
+    }
+    if (version != LEADERBOARD_VERSION) {
+        LOG_ERROR << "Wrong version in score file!" << endl;
+        return false;
+    }
 
-    int version = 1;
-    ziStream infile(scoreFilename.c_str());
-    if (infile.isOK())  //infile.good())
-    {
-        string line;
-        while (!getline(infile, line).eof()) {
-            LOG_INFO << "[" << line << "]" << endl;
-            //explicitly skip comments
-            if (line[0] == '#') {
-                continue;
+    for (uint32_t b = 0; b < numBoards; b++) {
+        uint32_t size;
+        uint32_t crc;
+        const char* record;
+        if (!reader.getU32(size) || !reader.getU32(crc) || !reader.getBytes(record, size)) {
+            LOG_ERROR << "Leaderboard " << fileName << " truncated after " << b << " boards" << endl;
+            break;
+        }
+
+        ScoreBoardKey key;
+        LeaderBoard lb;
+        if ((crc32(0, (const Bytef*)record, size) != crc) || !readBoardRecord(record, size, key, lb)) {
+            LOG_WARNING << "Dropping damaged leaderboard #" << b << endl;
+            continue;
+        }
+
+        if (lb.size() < LEADERBOARD_SIZE) {
+            lb.resize(LEADERBOARD_SIZE);
+            resetLeaderBoard(lb);
+        }
+        //should already be sorted, but better be safe...
+        sort(lb.begin(), lb.end());
+        _scoreBoards[key] = lb;
+    }
+
+    return true;
+}
+
+bool ScoreKeeper::parseLegacyBoard(const string& line, ScoreBoardKey& key, LeaderBoard& lb) {
+    Tokenizer t(line, false, "\001\002");
+
+    string scoreboardName = t.next();
+    if ((scoreboardName == "") || !ScoreBoardKey::fromName(scoreboardName, key)) {
+        return false;
+    }
+
+    lb.clear();
+    bool done = false;
+    while (!done) {
+        ScoreData sData;
+        sData.name = t.next();
+        if (sData.name != "") {
+            sData.score = atoi(t.next().c_str());
+            sData.time = (time_t)atoi(t.next().c_str());
+
+            string num = t.next();
+            sData.cubes = 0;
+            if (num.length()) {
+                sData.cubes = atoi(num.c_str());
             }
 
-            Tokenizer tv(line, false, " \t\n\r");
-            string token = tv.next();
-            if (token == "Version") {
-                string versionString = tv.next();
-                version = atoi(versionString.c_str());
+            num = t.next();
+            sData.secondsPlayed = 0;
+            if (num.length()) {
+                sData.secondsPlayed = atoi(num.c_str());
+            }
 
-                if (version != 1) {
-                    LOG_ERROR << "Wrong version in score file!" << endl;
-                }
-            } else {
-                Tokenizer t(line, false, "\001\002");
-                string scoreboardName = t.next();
+            sData.sent = false;
+            sData.online = false;
+            num = t.next();
+            if (num.length()) {
+                sData.online = atoi(num.c_str());
+            }
 
-                if (scoreboardName != "") {
-                    addScoreBoard(scoreboardName, line);
-                }
+            lb.push_back(sData);
+        } else {
+            done = true;
+        }
+    }
+    if (lb.size() < LEADERBOARD_SIZE) {
+        lb.resize(LEADERBOARD_SIZE);
+        resetLeaderBoard(lb);
+    }
+    sort(lb.begin(), lb.end());
+    lb.resize(LEADERBOARD_SIZE);
+
+    return true;
+}
+
+bool ScoreKeeper::loadLegacy(const string& fileName) {
+    ziStream infile(fileName);
+    if (!infile.isOK()) {
+        return false;
+    }
+
+    LOG_INFO << "Migrating hi-scores from " << fileName << endl;
+    string line;
+    while (!getline(infile, line).eof()) {
+        //explicitly skip comments
+        if (line.empty() || (line[0] == '#')) {
+            continue;
+        }
+
+        Tokenizer tv(line, false, " \t\n\r");
+        string token = tv.next();
+        if (token == "Version") {
+            int version = atoi(tv.next().c_str());
+            if (version != 1) {
+                LOG_ERROR << "Wrong version in score file!" << endl;
+            }
+        } else {
+            ScoreBoardKey key;
+            LeaderBoard lb;
+            if (parseLegacyBoard(line, key, lb)) {
+                _scoreBoards[key] = lb;
             }
         }
     }
+
+    return true;
 }
 
-void ScoreKeeper::save(void) {
+void ScoreKeeper::load(void) {
     XTRACE();
-    string scoreFilename = "leaderboard";
-    LOG_INFO << "Saving hi-scores to " << scoreFilename << endl;
+    LOG_INFO << "Loading hi-scores from " << LEADERBOARD_FILE << endl;
 
-    //Save scores in a compressed file to make it a bit tougher to cheat...
-    zoStream outfile(scoreFilename.c_str());
-    if (outfile.good()) {
-        outfile << "#------LeaderBoard-----#" << endl;
-        outfile << "Version 1" << endl;
+    _scoreBoards.clear();
+    if (!ResourceManagerS::instance()->hasResource(LEADERBOARD_FILE) || !loadBinary(LEADERBOARD_FILE)) {
+        //the old text file is left alone, the next save writes the new format
+        if (ResourceManagerS::instance()->hasResource(LEGACY_LEADERBOARD_FILE)) {
+            loadLegacy(LEGACY_LEADERBOARD_FILE);
+        }
+    }
+    _currentScoreboard = _scoreBoards.begin();
 
-        updateScoreBoardWithLeaderBoard();
+    LOG_INFO << "Loaded " << _scoreBoards.size() << " hi-score boards" << endl;
 
-        ScoreBoards::const_iterator ci;
-        for (ci = _scoreBoards.begin(); ci != _scoreBoards.end(); ci++) {
-            LOG_INFO << "[" << ci->data << "]" << endl;
-            outfile << ci->data << endl;
+    _history->load(HISTORY_FILE);
+}
+
+bool ScoreKeeper::save(void) {
+    XTRACE();
+    LOG_INFO << "Saving hi-scores to " << LEADERBOARD_FILE << endl;
+
+    updateScoreBoardWithLeaderBoard();
+
+    string data(LEADERBOARD_MAGIC, sizeof(LEADERBOARD_MAGIC));
+    putU32(data, LEADERBOARD_VERSION);
+    putU32(data, (uint32_t)_scoreBoards.size());
+
+    ScoreBoards::const_iterator ci;
+    for (ci = _scoreBoards.begin(); ci != _scoreBoards.end(); ci++) {
+        const ScoreBoardKey& key = ci->first;
+        const LeaderBoard& lb = ci->second;
+
+        string record;
+        putU32(record, (uint32_t)key.width);
+        putU32(record, (uint32_t)key.height);
+        putU32(record, (uint32_t)key.depth);
+        putString(record, key.blockset);
+        putU32(record, (uint32_t)lb.size());
+        for (size_t i = 0; i < lb.size(); i++) {
+            const ScoreData& sd = lb[i];
+            putString(record, (sd.name == "") ? string("Anonymous") : sd.name);
+            putU32(record, (uint32_t)sd.score);
+            putU64(record, (uint64_t)sd.time);
+            putU32(record, (uint32_t)sd.cubes);
+            putU32(record, (uint32_t)sd.secondsPlayed);
+            record += (char)((sd.sent ? eScoreSent : 0) | (sd.online ? eScoreOnline : 0));
         }
+
+        putU32(data, (uint32_t)record.size());
+        putU32(data, (uint32_t)crc32(0, (const Bytef*)record.data(), (uInt)record.size()));
+        data += record;
+    }
+
+    //Save scores in a compressed file to make it a bit tougher to cheat...
+    zoStream outfile(LEADERBOARD_FILE, true);
+    if (!outfile.isOK()) {
+        LOG_ERROR << "Unable to save hi-scores to " << LEADERBOARD_FILE << endl;
+        return false;
     }
+    outfile.write(data.data(), data.size());
+    if (!outfile.close()) {
+        LOG_ERROR << "Unable to write hi-scores to " << LEADERBOARD_FILE << endl;
+        return false;
+    }
+    return true;
 }
 
 void ScoreKeeper::draw(const Point2Di& offset) {
@@ -611,7 +750,13 @@ void ScoreKeeper::draw(const Point2Di& offset) {
 
     static GLBitmapCollection* icons = BitmapManagerS::instance()->getBitmap("bitmaps/menuIcons");
 
-    string scoreBoardHeader = _currentScoreboard->name + ":";
+    if (_currentScoreboard == _scoreBoards.end()) {
+        return;
+    }
+    const LeaderBoard& board = _currentScoreboard->second;
+    bool isActive = (_currentScoreboard->first == _leaderBoardKey);
+
+    string scoreBoardHeader = _currentScoreboard->first.toName() + ":";
     fontShadow->setColor(1.0, 1.0, 1.0, 1.0);
     fontShadow->DrawString(scoreBoardHeader.c_str(), 90.0f + offset.x + 9.0f, 480.0f + offset.y - 9.0f, 1.0f, 1.0f);
     fontWhite->DrawString(scoreBoardHeader.c_str(), 90.0f + offset.x, 480.0f + offset.y, 1.0f, 1.0f);
@@ -625,10 +770,10 @@ void ScoreKeeper::draw(const Point2Di& offset) {
 
     float scale = 1.0;
     float spacing = 39;
-    size_t maxIndex = std::min((size_t)(LEADERBOARD_SIZE - 1), _currentScoreboardAsLeaderBoard.size());
+    size_t maxIndex = std::min((size_t)(LEADERBOARD_SIZE - 1), board.size());
     for (unsigned int i = 0; i < maxIndex; i++) {
         char score[128];
-        sprintf(score, "%d", _currentScoreboardAsLeaderBoard[i].score);
+        sprintf(score, "%d", board[i].score);
         float scoreWidth = fontWhite->GetWidth(score, scale);
 
         char place[10];
@@ -638,23 +783,23 @@ void ScoreKeeper::draw(const Point2Di& offset) {
         fontShadow->setColor(1.0, 1.0, 1.0, 1.0);
         fontShadow->DrawString(place, 80 + offset.x - placeWidth + 7, 420 + offset.y - (float)i * spacing - 7, scale,
                                scale);
-        fontShadow->DrawString(_currentScoreboardAsLeaderBoard[i].name.c_str(), 90 + offset.x + 7.0f,
+        fontShadow->DrawString(board[i].name.c_str(), 90 + offset.x + 7.0f,
                                420 + offset.y - (float)i * spacing - 7, scale, scale);
         fontShadow->DrawString(score, 560 + offset.x - scoreWidth + 7, 420 + offset.y - (float)i * spacing - 7, scale,
                                scale);
 
         if (i == _infoIndex) {
             fontWhite->setColor(1.0, 0.1f, 0.1f, 1.0);
-        } else if (_leaderBoardName == _currentScoreboard->name && i == _currentIndex) {
+        } else if (isActive && i == _currentIndex) {
             fontWhite->setColor(1.0, 0.852f, 0.0, 1.0);
-        } else if (_currentScoreboardAsLeaderBoard[i].online) {
+        } else if (board[i].online) {
             fontWhite->setColor(1.0, 1.0, 1.0, 1.0);
         } else {
             fontWhite->setColor(1.0, 0.95f, 0.7f, 1.0);
         }
 
         fontWhite->DrawString(place, 80 + offset.x - placeWidth, 420 + offset.y - (float)i * spacing, scale, scale);
-        fontWhite->DrawString(_currentScoreboardAsLeaderBoard[i].name.c_str(), 90.0f + offset.x,
+        fontWhite->DrawString(board[i].name.c_str(), 90.0f + offset.x,
                               420 + offset.y - (float)i * spacing, scale, scale);
         fontWhite->DrawString(score, 560 + offset.x - scoreWidth, 420 + offset.y - (float)i * spacing, scale, scale);
     }
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 #include <time.h>
 
@@ -18,6 +19,8 @@
 
 using namespace std;
 
+class ScoreHistory;
+
 struct ScoreData {
     int score;
     std::string name;
@@ -28,37 +31,65 @@ struct ScoreData {
     bool online;
 };
 
+//where a finished game ranks among all games played on its board
+struct GameRank {
+    //1 is the best game on the board, 0 if nothing was recorded
+    size_t rank;
+    size_t total;
+    //share of games on the board scoring at least as well, 1-100
+    int topPercent;
+};
+
 inline bool operator<(const ScoreData& s1, const ScoreData& s2) {
     // ">" since we want highscore first
     return s1.score > s2.score;
 }
 
-struct ScoreBoard {
-    Point3Di dimension;
-    std::string name;  // dimension as string "XxYxZ:blockset"
-    std::string data;  // top-10 as string data
+//Leader boards are kept per shaft size and blockset. Practice games don't
+//record scores, so practice mode isn't part of the key.
+struct ScoreBoardKey {
+    ScoreBoardKey(void) :
+        width(0),
+        height(0),
+        depth(0),
+        blockset() {}
+
+    ScoreBoardKey(int w, int h, int d, const std::string& bset) :
+        width(w),
+        height(h),
+        depth(d),
+        blockset(bset) {}
+
+    //"WxHxD:blockset", as used by the online score server
+    std::string toName(void) const;
+    static bool fromName(const std::string& name, ScoreBoardKey& key);
+
+    int width;
+    int height;
+    int depth;
+    std::string blockset;
 };
 
-inline bool operator<(const ScoreBoard& s1, const ScoreBoard& s2) {
-    const Point3Di& dim1 = s1.dimension;
-    const Point3Di& dim2 = s2.dimension;
-
-    int area1 = (dim1.x * dim1.y);
-    int area2 = (dim2.x * dim2.y);
-
-    if (area1 == area2) {
-        if (dim1.z == dim2.z) {
-            if (dim1.x == dim2.x) {
-                return s1.name < s2.name;
-            }
+inline bool operator==(const ScoreBoardKey& k1, const ScoreBoardKey& k2) {
+    return (k1.width == k2.width) && (k1.height == k2.height) && (k1.depth == k2.depth) &&
+           (k1.blockset == k2.blockset);
+}
 
-            return dim1.x < dim2.x;
-        }
+//order in which boards are browsed: by shaft area, depth, width, blockset
+inline bool operator<(const ScoreBoardKey& k1, const ScoreBoardKey& k2) {
+    int area1 = (k1.width * k1.height);
+    int area2 = (k2.width * k2.height);
 
-        return dim1.z < dim2.z;
+    if (area1 != area2) {
+        return area1 < area2;
     }
-
-    return area1 < area2;
+    if (k1.depth != k2.depth) {
+        return k1.depth < k2.depth;
+    }
+    if (k1.width != k2.width) {
+        return k1.width < k2.width;
+    }
+    return k1.blockset < k2.blockset;
 }
 
 class ScoreKeeper {
@@ -74,10 +105,14 @@ public:
     int getCurrentScore(void);
     bool currentIsTopTen(void);
     void setNameForCurrent(const std::string& name);
-    void setLeaderBoard(const std::string& scoreboardName);
+    void setLeaderBoard(const ScoreBoardKey& key);
     void updateScoreBoardWithLeaderBoard(void);
 
-    std::string getCurrentScoreBoardName() { return _leaderBoardName; }
+    //add the finished game to the history and rank it
+    void recordGame(int level, int planesCleared);
+    const GameRank& getLastGameRank(void) { return _lastGameRank; }
+
+    std::string getCurrentScoreBoardName() { return _leaderBoardKey.toName(); }
 
     ScoreData& getCurrentScoreData() { return _leaderBoard[_currentIndex]; }
 
@@ -88,7 +123,8 @@ public:
 
     // load/save all score boards
     void load(void);
-    void save(void);
+    //false if the leaderboard couldn't be written (logged)
+    bool save(void);
 
     // draw current score board
     void draw(const Point2Di& offset);
@@ -107,33 +143,43 @@ public:
 
     void setPracticeMode(bool practiceMode) { _practiceMode = practiceMode; }
 
+    //bumped whenever the displayed score board changes
+    unsigned int getRevision(void) { return _revision; }
+
 private:
+    //sorted by score, LEADERBOARD_SIZE entries (top-10 plus current score)
     typedef std::vector<ScoreData> LeaderBoard;
-    typedef std::vector<ScoreBoard> ScoreBoards;
+    typedef std::map<ScoreBoardKey, LeaderBoard> ScoreBoards;
 
     ScoreKeeper(const ScoreKeeper&);
     ScoreKeeper& operator=(const ScoreKeeper&);
 
     void resetLeaderBoard(LeaderBoard& lb);
     void sortLeaderBoard(void);
-    string leaderBoardToString(LeaderBoard& lb, const string& leaderBoardName);
-    void stringToLeaderBoard(const std::string& lbString, LeaderBoard& lb);
     void dumpLeaderBoard(const LeaderBoard& lb);
 
-    void addScoreBoard(const string& scoreboardName, const string& data);
+    ScoreBoards::iterator addScoreBoard(const ScoreBoardKey& key);
+    void setCurrentScoreboard(ScoreBoards::iterator board);
 
-    void mergeLeaderBoard(LeaderBoard& leaderBoard, const LeaderBoard& onlineBoard);
+    void mergeLeaderBoard(LeaderBoard& leaderBoard, LeaderBoard onlineBoard);
     void sendOnlineUpdateRequest(const std::string& boardName);
 
+    bool loadBinary(const std::string& fileName);
+    bool loadLegacy(const std::string& fileName);
+    bool parseLegacyBoard(const std::string& line, ScoreBoardKey& key, LeaderBoard& lb);
+
     unsigned int _currentIndex;
     unsigned int _infoIndex;
-    std::string _leaderBoardName;
+    ScoreBoardKey _leaderBoardKey;
     LeaderBoard _leaderBoard;
 
-    ScoreBoards::iterator _currentScoreboard;
-    LeaderBoard _currentScoreboardAsLeaderBoard;
     ScoreBoards _scoreBoards;
+    ScoreBoards::iterator _currentScoreboard;
     bool _practiceMode;
+    unsigned int _revision;
+
+    ScoreHistory* _history;
+    GameRank _lastGameRank;
 
     hash_map<const std::string, time_t, hash<const std::string>, equal_to<const std::string>> _lastOnlineRequestTime;
 };
@@ -29,6 +29,7 @@ using namespace std;
 Selectable* Selectable::_active = 0;
 
 Selectable::Selectable(bool enabled, const BoundingBox& r, const string& info) :
+    _dirty(true),
     _enabled(enabled),
     _inputBox(r),
     _boundingBox(r),
@@ -63,20 +64,24 @@ void Selectable::updateActive(UserFeedback feedback) {
     if ((_active != this)) {
         if (_active) {
             _active->deactivate();
+            _active->markDirty();
         }
         _active = this;
+        markDirty();
         MenuManagerS::instance()->Goto(this);
 
         switch (feedback) {
-            case eBeep:
+            case eBeep: {
 #ifndef IPHONE
-                AudioS::instance()->playSample("sounds/beep");
+                static SampleId sndBeep = AudioS::instance()->getSampleId("sounds/beep");
+                AudioS::instance()->playSample(sndBeep);
 #endif
-                break;
+            } break;
 
-            case eTick:
-                AudioS::instance()->playSample("sounds/click1");
-                break;
+            case eTick: {
+                static SampleId sndClick1 = AudioS::instance()->getSampleId("sounds/click1");
+                AudioS::instance()->playSample(sndClick1);
+            } break;
 
             case eNoFeedback:
             default:
@@ -363,7 +368,9 @@ void FloatSelectable::incBy(float delta) {
 
     Value* v = new Value(curVal);
     ConfigS::instance()->updateKeyword(_variable, v);
-    AudioS::instance()->playSample("sounds/tick1");
+    static SampleId sndTick1 = AudioS::instance()->getSampleId("sounds/tick1");
+    AudioS::instance()->playSample(sndTick1);
+    markDirty();
 }
 
 void FloatSelectable::input(const Trigger& trigger, const bool& isDown, const Point2Di& offset) {
@@ -420,6 +427,7 @@ void FloatSelectable::input(const Trigger& trigger, const bool& isDown, const Po
 
                 _xPos += dx;
                 Clamp(_xPos, 0.0, 140.0);
+                markDirty();
             }
 
             if ((mouseX >= (_boundingBox.min.x + offset.x)) && (mouseX <= (_boundingBox.max.x + offset.x)) &&
@@ -511,7 +519,9 @@ void EnumSelectable::nextEnum(void) {
 
     Value* v = new Value(*_activeEnum);
     ConfigS::instance()->updateKeyword(_variable, v);
-    AudioS::instance()->playSample("sounds/click1");
+    static SampleId sndClick1 = AudioS::instance()->getSampleId("sounds/click1");
+    AudioS::instance()->playSample(sndClick1);
+    markDirty();
 }
 
 void EnumSelectable::prevEnum(void) {
@@ -522,7 +532,9 @@ void EnumSelectable::prevEnum(void) {
 
     Value* v = new Value(*_activeEnum);
     ConfigS::instance()->updateKeyword(_variable, v);
-    AudioS::instance()->playSample("sounds/click1");
+    static SampleId sndClick1 = AudioS::instance()->getSampleId("sounds/click1");
+    AudioS::instance()->playSample(sndClick1);
+    markDirty();
 }
 
 void EnumSelectable::input(const Trigger& trigger, const bool& isDown, const Point2Di& /*offset*/) {
@@ -635,7 +647,9 @@ void BoolSelectable::toggle(void) {
     //             << " is " << v->getString() << endl;
 
     ConfigS::instance()->updateKeyword(_variable, v);
-    AudioS::instance()->playSample("sounds/click1");
+    static SampleId sndClick1 = AudioS::instance()->getSampleId("sounds/click1");
+    AudioS::instance()->playSample(sndClick1);
+    markDirty();
 }
 
 void BoolSelectable::input(const Trigger& trigger, const bool& isDown, const Point2Di& /*offset*/) {
@@ -703,7 +717,8 @@ LeaderBoardSelectable::LeaderBoardSelectable(bool enabled, const BoundingBox& r,
 
     Selectable(enabled, r, info),
     _text(text),
-    _size(1.0f) {
+    _size(1.0f),
+    _scoreRevision(0) {
     _fontShadow = FontManagerS::instance()->getFont("bitmaps/menuShadow");
 
     float width = _fontWhite->GetWidth(_text.c_str(), _size);
@@ -805,6 +820,7 @@ void LeaderBoardSelectable::input(const Trigger& trigger, const bool& isDown, co
                 idx = 9;
             }
             _info = ScoreKeeperS::instance()->getInfoText(9 - idx);
+            markDirty();
             //                LOG_INFO << "spot = " << idx << endl;
         }
             this->activate();
@@ -816,10 +832,12 @@ void LeaderBoardSelectable::input(const Trigger& trigger, const bool& isDown, co
 
     if (goPrevBoard) {
         ScoreKeeperS::instance()->nextBoard();
-        AudioS::instance()->playSample("sounds/click1");
+        static SampleId sndClick1 = AudioS::instance()->getSampleId("sounds/click1");
+        AudioS::instance()->playSample(sndClick1);
     } else if (goNextBoard) {
         ScoreKeeperS::instance()->nextBoard();
-        AudioS::instance()->playSample("sounds/click1");
+        static SampleId sndClick1 = AudioS::instance()->getSampleId("sounds/click1");
+        AudioS::instance()->playSample(sndClick1);
     }
 }
 
@@ -827,6 +845,15 @@ void LeaderBoardSelectable::activate(bool /*beQuiet*/) {
     updateActive(eNoFeedback);
 }
 
+void LeaderBoardSelectable::update(void) {
+    //online scores may get merged while the board is showing
+    unsigned int revision = ScoreKeeperS::instance()->getRevision();
+    if (revision != _scoreRevision) {
+        _scoreRevision = revision;
+        markDirty();
+    }
+}
+
 void LeaderBoardSelectable::draw(const Point2Di& offset) {
     Selectable::draw(offset);
 #if 0
@@ -949,7 +976,8 @@ void ResolutionSelectable::applyResolution(void) {
     ConfigS::instance()->updateKeyword("width", w);
     Value* h = new Value(height);
     ConfigS::instance()->updateKeyword("height", h);
-    AudioS::instance()->playSample("sounds/click1");
+    static SampleId sndClick1 = AudioS::instance()->getSampleId("sounds/click1");
+    AudioS::instance()->playSample(sndClick1);
 }
 
 void ResolutionSelectable::addFullscreenResolutions(void) {
@@ -989,7 +1017,9 @@ void ResolutionSelectable::prevResolution(void) {
         _activeResolution = _resolutionList.end();
     }
     _activeResolution--;
-    AudioS::instance()->playSample("sounds/tick1");
+    static SampleId sndTick1 = AudioS::instance()->getSampleId("sounds/tick1");
+    AudioS::instance()->playSample(sndTick1);
+    markDirty();
 }
 
 void ResolutionSelectable::nextResolution(void) {
@@ -997,7 +1027,9 @@ void ResolutionSelectable::nextResolution(void) {
     if (_activeResolution == _resolutionList.end()) {
         _activeResolution = _resolutionList.begin();
     }
-    AudioS::instance()->playSample("sounds/tick1");
+    static SampleId sndTick1 = AudioS::instance()->getSampleId("sounds/tick1");
+    AudioS::instance()->playSample(sndTick1);
+    markDirty();
 }
 
 void ResolutionSelectable::input(const Trigger& trigger, const bool& isDown, const Point2Di& offset) {
@@ -1115,6 +1147,7 @@ TextSelectable::TextSelectable(bool enabled, const BoundingBox& rect, const stri
     TextOnlySelectable(enabled, rect, text, info),
     _ds(0.0) {
     _prevSize = _size;
+    _drawnSize = _size;
 }
 
 void TextSelectable::input(const Trigger& trigger, const bool& isDown, const Point2Di& /*offset*/) {
@@ -1162,6 +1195,10 @@ void TextSelectable::update(void) {
     _size += _ds;
     Clamp(_size, 1.0f, 1.8f);  //any bigger and we'll have overlapping activation areas
 #endif
+    //keep redrawing until the last interpolated frame has reached the target size
+    if ((_size != _prevSize) || (_drawnSize != _size)) {
+        markDirty();
+    }
 
     //adjust the input box according to the scaled text
     float dx = (float)(_boundingBox.max.x - _boundingBox.min.x) * (_size - 1.0f) / 2.0f;
@@ -1182,6 +1219,11 @@ void TextSelectable::draw(const Point2Di& offset) {
     float iSize = _prevSize + (_size - _prevSize) * GameState::frameFractionOther;
     Clamp(iSize, 1.0, 2.0);
 #endif
+    _drawnSize = iSize;
+    if (_size != _prevSize) {
+        //still scaling, next frame interpolates further
+        markDirty();
+    }
 
     float halfWidth = _fontWhite->GetWidth(_text.c_str(), iSize - 1.0f) / 2.0f;
     float halfHeight = _fontWhite->GetHeight(iSize - 1.0f) / 2.0f;
@@ -1217,7 +1259,8 @@ void ActionSelectable::select(void) {
     } else if (_action == "Quit") {
         GameState::requestExit = true;
     }
-    AudioS::instance()->playSample("sounds/confirm");
+    static SampleId sndConfirm = AudioS::instance()->getSampleId("sounds/confirm");
+    AudioS::instance()->playSample(sndConfirm);
 }
 
 //------------------------------------------------------------------------------
@@ -1230,7 +1273,8 @@ MenuSelectable::MenuSelectable(TiXmlNode* node, bool enabled, const BoundingBox&
 
 void MenuSelectable::select(void) {
     MenuManagerS::instance()->makeMenu(_node);
-    AudioS::instance()->playSample("sounds/confirm");
+    static SampleId sndConfirm = AudioS::instance()->getSampleId("sounds/confirm");
+    AudioS::instance()->playSample(sndConfirm);
 }
 
 //------------------------------------------------------------------------------
@@ -1290,6 +1334,13 @@ void BindKeySelectable::activate(bool beQuiet) {
     updateActive(beQuiet ? eNoFeedback : eBeep);
 }
 
+void BindKeySelectable::update(void) {
+    //picks up the new binding once Input has grabbed the next trigger
+    if (InputS::instance()->getTriggerName(_action) != _text) {
+        markDirty();
+    }
+}
+
 void BindKeySelectable::draw(const Point2Di& offset) {
     _text = InputS::instance()->getTriggerName(_action);
     //TextOnlySelectable::draw(offset);
@@ -41,13 +41,21 @@ public:
 
     const BoundingBox& getInputBox(void) { return _inputBox; }
 
+    //true if draw() would produce different output than last time
+    bool isDirty(void) { return _dirty; }
+
+    void clearDirty(void) { _dirty = false; }
+
     static void reset(void) { _active = 0; }
 
     void updateActive(UserFeedback feedback);
 
 protected:
+    void markDirty(void) { _dirty = true; }
+
     static Selectable* _active;
 
+    bool _dirty;
     bool _enabled;
     BoundingBox _inputBox;
     BoundingBox _boundingBox;
@@ -86,12 +94,14 @@ public:
 
     virtual void input(const Trigger& trigger, const bool& /*isDown*/, const Point2Di& offset);
     virtual void activate(bool beQuiet = false);
+    virtual void update(void);
     virtual void draw(const Point2Di& offset);
 
 protected:
     std::string _text;
     GLBitmapFont* _fontShadow;
     float _size;
+    unsigned int _scoreRevision;
 
 private:
     LeaderBoardSelectable(const LeaderBoardSelectable&);
@@ -299,6 +309,7 @@ public:
 protected:
     float _ds;
     float _prevSize;
+    float _drawnSize;
 
 private:
     TextSelectable(const TextSelectable&);
@@ -343,6 +354,7 @@ public:
     virtual void input(const Trigger& trigger, const bool& isDown, const Point2Di& offset);
     virtual void activate(bool beQuiet = false);
     virtual void select(void);
+    virtual void update(void);
     virtual void draw(const Point2Di& offset);
 
 protected:
@@ -0,0 +1,29 @@
+// Description:
+//   The startup tasks of Game::init, where they run and what they wait for.
+//   The game passes the real work, tools/initcheck stand-ins with costs.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "StartupTasks.hpp"
+
+bool addStartupTasks(InitGraph& graph, const StartupTasks& tasks) {
+    bool ok = true;
+    ok &= graph.add("scores", InitGraph::eAnyThread, tasks.scores);
+    //opening the SDL audio device off the main thread is deliberate, SDL
+    //allows it on every platform we ship (the mixer runs on its own thread)
+    ok &= graph.add("audio", InitGraph::eAnyThread, tasks.audio);
+    //the model looks up its sample ids
+    ok &= graph.add("blockset", InitGraph::eAnyThread, tasks.blockset, {"audio"});
+    ok &= graph.add("menu-xml", InitGraph::eAnyThread, tasks.menuXml);
+    ok &= graph.add("video", InitGraph::eMainThread, tasks.video);
+    ok &= graph.add("view", InitGraph::eMainThread, tasks.view, {"video"});
+    // input init also initializes Keys which requires that SDL video has ben initialized
+    ok &= graph.add("input", InitGraph::eMainThread, tasks.input, {"video"});
+    ok &= graph.add("controller", InitGraph::eMainThread, tasks.controller, {"view", "blockset", "input"});
+    //menu items show scores and key bindings of the controller's actions.
+    //Audio::open writes ConfigValues and Config::notify calls the menu's
+    //subscribers, so the menu subscribes only once audio is done.
+    ok &= graph.add("menu", InitGraph::eMainThread, tasks.menu, {"menu-xml", "scores", "controller", "audio"});
+    ok &= graph.add("particles", InitGraph::eMainThread, tasks.particles, {"view"});
+    return ok;
+}
@@ -0,0 +1,24 @@
+#pragma once
+// Description:
+//   The startup tasks of Game::init, where they run and what they wait for.
+//   The game passes the real work, tools/initcheck stand-ins with costs.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "InitGraph.hpp"
+
+struct StartupTasks {
+    InitGraph::Task scores;
+    InitGraph::Task audio;
+    InitGraph::Task blockset;
+    InitGraph::Task menuXml;
+    InitGraph::Task video;
+    InitGraph::Task view;
+    InitGraph::Task input;
+    InitGraph::Task controller;
+    InitGraph::Task menu;
+    InitGraph::Task particles;
+};
+
+//returns false if the graph rejected a task
+bool addStartupTasks(InitGraph& graph, const StartupTasks& tasks);
@@ -8,6 +8,7 @@
 #include <math.h>
 
 #include "Trace.hpp"
+#include "Profiler.hpp"
 #include "Config.hpp"
 #include "Value.hpp"
 #include "Timer.hpp"
@@ -46,12 +47,32 @@ VideoBase::VideoBase() :
     _height(VIDEO_DEFAULT_HEIGHT),
     _prevWidth(VIDEO_DEFAULT_WIDTH),
     _prevHeight(VIDEO_DEFAULT_HEIGHT),
+    _vsync("vsync", 1),
+    _fullscreenSetting("fullscreen", true),
+    _widthSetting("width", 0),
+    _heightSetting("height", 0),
+    _videoModeDirty(false),
+    _swapInterval(0),
+    _refreshRate(60),
     _windowHandle(0),
     _glContext(0) {
 #ifdef IPHONE
     _width = gGameState->width;
     _height = gGameState->height;
 #endif
+    _vsync.subscribe([this](const int& vsync) {
+        if (_glContext) {
+            setSwapInterval(vsync);
+        }
+    });
+
+    //settings are changed from input handlers, the mode switch waits for update()
+    ConfigValue<bool>::Callback fullscreenChanged = [this](const bool&) { _videoModeDirty = true; };
+    ConfigValue<int>::Callback sizeChanged = [this](const int&) { _videoModeDirty = true; };
+    _fullscreenSetting.subscribe(fullscreenChanged);
+    _widthSetting.subscribe(sizeChanged);
+    _heightSetting.subscribe(sizeChanged);
+    _videoModeDirty = false;
 }
 
 VideoBase::~VideoBase() {
@@ -237,8 +258,13 @@ bool VideoBase::setVideoMode(void) {
 
     SDL_DisplayMode currentMode;
     SDL_GetCurrentDisplayMode(0, &currentMode);
-    LOG_INFO << "Video Mode: OK (" << _width << "x" << _height << "x" << SDL_BITSPERPIXEL(currentMode.format) << ")"
-             << endl;
+    LOG_INFO << "Video Mode: OK (" << _width << "x" << _height << "x" << SDL_BITSPERPIXEL(currentMode.format) << " "
+             << currentMode.refresh_rate << "Hz)" << endl;
+    if (currentMode.refresh_rate > 0) {
+        _refreshRate = currentMode.refresh_rate;
+    }
+
+    setSwapInterval(_vsync);
 
     glewInit();
 
@@ -264,13 +290,27 @@ bool VideoBase::setVideoMode(void) {
     return true;
 }
 
+void VideoBase::setSwapInterval(int vsync) {
+    _swapInterval = vsync;
+    if (SDL_GL_SetSwapInterval(vsync) != 0) {
+        if (vsync == -1) {
+            LOG_WARNING << "Adaptive vsync not supported, using regular vsync." << endl;
+            _swapInterval = 1;
+            if (SDL_GL_SetSwapInterval(1) == 0) {
+                return;
+            }
+        }
+        LOG_WARNING << "Unable to set swap interval: " << SDL_GetError() << endl;
+        _swapInterval = SDL_GL_GetSwapInterval();
+    }
+}
+
 bool VideoBase::updateSettings(void) {
-    bool fullscreen = true;
-    ConfigS::instance()->getBoolean("fullscreen", fullscreen);
-    int width = 0;
-    ConfigS::instance()->getInteger("width", width);
-    int height = 0;
-    ConfigS::instance()->getInteger("height", height);
+    _videoModeDirty = false;
+
+    bool fullscreen = _fullscreenSetting;
+    int width = _widthSetting;
+    int height = _heightSetting;
 
     if ((fullscreen != _isFullscreen) || (width != _prevWidth) || (height != _prevHeight)) {
         LOG_INFO << "current:" << (_isFullscreen ? "fs " : "win") << " " << _prevWidth << "x" << _prevHeight << "\n";
@@ -326,10 +366,7 @@ void VideoBase::setResolutionConfig(int width, int height, bool fullscreen) {
 }
 
 bool VideoBase::update(void) {
-    static double nextTime = Timer::getTime() + 0.5;
-    double thisTime = Timer::getTime();
-    if (thisTime > nextTime) {
-        nextTime = thisTime + 0.5;
+    if (_videoModeDirty) {
         return updateSettings();
     }
     return true;
@@ -403,5 +440,6 @@ void VideoBase::takeSnapshot(void) {
 }
 
 void VideoBase::swap(void) {
+    PROFILE_ZONE("VideoBase::swap");
     SDL_GL_SwapWindow(_windowHandle);
 }
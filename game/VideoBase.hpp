@@ -6,6 +6,7 @@
 //
 #include "SDL.h"
 #include "Singleton.hpp"
+#include "Config.hpp"
 
 #include <list>
 
@@ -33,6 +34,11 @@ public:
 
     bool isFullscreen(void) { return _isFullscreen; }
 
+    //0: off, 1: on, -1: adaptive (late swaps tear instead of waiting)
+    int getSwapInterval(void) { return _swapInterval; }
+
+    int getRefreshRate(void) { return _refreshRate; }
+
     void takeSnapshot(void);
     void setResolutionConfig(int w, int h, bool fs);
 
@@ -40,6 +46,7 @@ public:
     //The actual values are retrieved from config (width, height, fullscreen)
     bool updateSettings(void);
 
+    //Applies pending mode changes. Call once per frame outside of event handling.
     bool update(void);
 
     void registerResolutionObserver(ResolutionChangeObserverI* i);
@@ -50,6 +57,7 @@ private:
 
     void reload(void);
     bool setVideoMode(void);
+    void setSwapInterval(int vsync);
 
     bool _isFullscreen;
 
@@ -60,6 +68,15 @@ private:
     int _prevWidth;
     int _prevHeight;
 
+    ConfigValue<int> _vsync;
+    ConfigValue<bool> _fullscreenSetting;
+    ConfigValue<int> _widthSetting;
+    ConfigValue<int> _heightSetting;
+    bool _videoModeDirty;
+
+    int _swapInterval;
+    int _refreshRate;
+
     SDL_Window* _windowHandle;
     SDL_GLContext _glContext;
 
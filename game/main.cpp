@@ -15,6 +15,7 @@
 #include "Endian.hpp"
 #include "ResourceManager.hpp"
 #include "GetDataPath.hpp"
+#include "physfs.h"
 #ifndef IPHONE
 #include "PreLaunch.hpp"
 #include "PostLaunch.hpp"
@@ -29,6 +30,8 @@ protected:
     virtual int_type overflow(int_type c) { return c; }
 };
 
+static int exitCode = 0;
+
 void checkEndian(void) {
     if (::isLittleEndian()) {
         LOG_INFO << "Setting up for little endian." << endl;
@@ -86,6 +89,11 @@ void init(int argc, char* argv[]) {
 #warning Logging off
     Trace::SetStreamBuffer(new NoopStreamBuf());
 #endif
+#ifdef WIN32
+    Trace::SetLogFile(getWritableDataPath(PACKAGE) + "log.txt");
+#endif
+    //from here on logging doesn't block on console/file output
+    Trace::StartLogThread();
 
 #ifndef IPHONE
     showInfo();
@@ -101,7 +109,10 @@ void init(int argc, char* argv[]) {
 #endif
     ResourceManagerS::instance()->setWriteDirectory(writeSubdir);  // TODO: handle windows
 
-    if (!ResourceManagerS::instance()->addResourceBundle(getDataPath() + resourceFilePath, "/")) {
+    //the build copies the packed resources next to the executable
+    ResourceManager* rm = ResourceManagerS::instance();
+    if (!rm->addResourceBundle(string(PHYSFS_getBaseDir()) + resourceFilePath, "/") &&
+        !rm->addResourceBundle(getDataPath() + resourceFilePath, "/")) {
         LOG_WARNING << "resource.dat not found. Trying data directory." << endl;
 #ifdef VCPP
         ResourceManagerS::instance()->addResourceDirectory("../../data");
@@ -123,6 +134,17 @@ void init(int argc, char* argv[]) {
     // process command line arguments...
     cfg->updateFromCommandLine(argc, argv);
 
+    string logLevel;
+    if (cfg->getString("logLevel", logLevel)) {
+        Trace::SetLevel(logLevel);
+    }
+#ifndef WIN32
+    bool logFile = false;
+    if (cfg->getBoolean("logFile", logFile) && logFile) {
+        Trace::SetLogFile(getWritableDataPath(writeSubdir) + "log.txt");
+    }
+#endif
+
     // to dump or not to dump...
     cfg->getBoolean("developer", GameState::isDeveloper);
     if (GameState::isDeveloper) {
@@ -193,6 +215,9 @@ int main(int argc, char* argv[])
     if (GameS::instance()->init()) {
         // let's go!
         GameS::instance()->run();
+        exitCode = GameS::instance()->getExitCode();
+    } else {
+        exitCode = 1;
     }
 #endif
 
@@ -217,7 +242,8 @@ int shutdownGame(void) {
 #ifndef IPHONE
     showInfo();
 #endif
+    Trace::StopLogThread();
 
     // See ya!
-    return 0;
+    return exitCode;
 }
@@ -0,0 +1,86 @@
+// Description:
+//   Table driven hex encoding and decoding.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include "Hex.hpp"
+
+#include <string.h>
+
+//both digits of every byte value, so encoding is one lookup and a 2 byte copy
+static const char HEX_PAIRS[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+//digit value, or 0xff for anything that isn't a hex digit
+static const unsigned char X = 0xff;
+static const unsigned char HEX_VALUES[256] = {
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, X, X, X, X, X, X,  //0-9
+    X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X,  //A-F
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X,  //a-f
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,  //
+};
+
+void Hex::encode(const unsigned char* data, size_t size, char* out) {
+    for (size_t i = 0; i < size; i++) {
+        memcpy(out + i * 2, HEX_PAIRS + data[i] * 2, 2);
+    }
+}
+
+bool Hex::decode(const char* hex, size_t size, unsigned char* out) {
+    //no early exit, so the loop stays branch free; check once at the end
+    unsigned char bad = 0;
+    for (size_t i = 0; i < size; i++) {
+        unsigned char hi = HEX_VALUES[(unsigned char)hex[i * 2]];
+        unsigned char lo = HEX_VALUES[(unsigned char)hex[i * 2 + 1]];
+        bad |= (hi | lo) & 0xf0;
+        out[i] = (unsigned char)((hi << 4) | (lo & 0x0f));
+    }
+    return bad == 0;
+}
+
+std::string Hex::encode(const std::string& data) {
+    std::string result(data.size() * 2, 0);
+    if (!data.empty()) {
+        encode((const unsigned char*)data.data(), data.size(), &result[0]);
+    }
+    return result;
+}
+
+bool Hex::decode(const std::string& hex, std::string& data) {
+    if (hex.size() % 2) {
+        return false;
+    }
+    data.resize(hex.size() / 2);
+    if (data.empty()) {
+        return true;
+    }
+    return decode(hex.data(), data.size(), (unsigned char*)&data[0]);
+}
@@ -0,0 +1,29 @@
+#pragma once
+// Description:
+//   Table driven hex encoding and decoding.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include <string>
+#include <stddef.h>
+
+class Hex {
+public:
+    //Write 2 * size lowercase hex digits to out. No allocations.
+    static void encode(const unsigned char* data, size_t size, char* out);
+    //Read 2 * size hex digits (either case) into out. Returns false on a bad digit.
+    static bool decode(const char* hex, size_t size, unsigned char* out);
+
+    static std::string encode(const std::string& data);
+    //Returns false for odd length or bad digits.
+    static bool decode(const std::string& hex, std::string& data);
+};
@@ -0,0 +1,527 @@
+// Description:
+//   Minimal blocking-call HTTP/1.1 client. One keep-alive connection per
+//   client, non-blocking sockets underneath so every step has a deadline.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include "HttpClient.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define poll WSAPoll
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+const size_t MAX_HEADER_SIZE = 8 * 1024;
+const size_t RECEIVE_SIZE = 16 * 1024;
+
+#if defined(WIN32)
+static const HttpClient::Socket NO_SOCKET = (HttpClient::Socket)INVALID_SOCKET;
+
+static void closeSocket(HttpClient::Socket s) {
+    closesocket((SOCKET)s);
+}
+
+static bool wouldBlock(void) {
+    int error = WSAGetLastError();
+    return (error == WSAEWOULDBLOCK) || (error == WSAEINPROGRESS);
+}
+
+static bool setNonBlocking(HttpClient::Socket s) {
+    u_long on = 1;
+    return ioctlsocket((SOCKET)s, FIONBIO, &on) == 0;
+}
+#else
+static const HttpClient::Socket NO_SOCKET = -1;
+
+static void closeSocket(HttpClient::Socket s) {
+    ::close(s);
+}
+
+static bool wouldBlock(void) {
+    return (errno == EWOULDBLOCK) || (errno == EAGAIN) || (errno == EINPROGRESS) || (errno == EINTR);
+}
+
+static bool setNonBlocking(HttpClient::Socket s) {
+    int flags = fcntl(s, F_GETFL, 0);
+    return (flags != -1) && (fcntl(s, F_SETFL, flags | O_NONBLOCK) != -1);
+}
+#endif
+
+static long long nowMs(void) {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+HttpClient::HttpClient(const string& userAgent, int timeoutMs, size_t maxResponseSize) :
+    _userAgent(userAgent),
+    _timeoutMs(timeoutMs),
+    _maxResponseSize(maxResponseSize),
+    _socket(NO_SOCKET),
+    _host(),
+    _port(0),
+    _connects(0),
+    _stale(false),
+    _addresses(0),
+    _resolvedHost(),
+    _resolvedPort(0),
+    _buffer(),
+    _error() {
+#if defined(WIN32)
+    static bool wsaStarted = false;
+    if (!wsaStarted) {
+        WSADATA wsaData;
+        wsaStarted = (WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+    }
+#endif
+}
+
+HttpClient::~HttpClient() {
+    close();
+    forget();
+}
+
+void HttpClient::close(void) {
+    if (_socket != NO_SOCKET) {
+        closeSocket(_socket);
+        _socket = NO_SOCKET;
+    }
+    _host = "";
+    _port = 0;
+    _buffer.clear();
+}
+
+void HttpClient::forget(void) {
+    if (_addresses) {
+        freeaddrinfo(_addresses);
+        _addresses = 0;
+    }
+    _resolvedHost = "";
+    _resolvedPort = 0;
+}
+
+//getaddrinfo has no timeout, so only the first lookup of a host is done
+//(and can block past the deadline). Later connects reuse the addresses.
+bool HttpClient::resolve(const string& host, int port) {
+    if (_addresses && (host == _resolvedHost) && (port == _resolvedPort)) {
+        return true;
+    }
+    forget();
+
+    stringstream portName;
+    portName << port;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(host.c_str(), portName.str().c_str(), &hints, &_addresses) != 0) {
+        _addresses = 0;
+        return fail("Unable to resolve " + host);
+    }
+    _resolvedHost = host;
+    _resolvedPort = port;
+    return true;
+}
+
+bool HttpClient::fail(const string& error) {
+    _error = error;
+    return false;
+}
+
+bool HttpClient::parseURL(const string& url, string& host, int& port, string& path) {
+    const string scheme = "http://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return false;
+    }
+
+    size_t hostStart = scheme.size();
+    size_t pathStart = url.find('/', hostStart);
+    if (pathStart == string::npos) {
+        pathStart = url.find('?', hostStart);
+    }
+    string hostPort = url.substr(hostStart, pathStart - hostStart);
+    path = (pathStart == string::npos) ? "/" : url.substr(pathStart);
+    if (path[0] == '?') {
+        path = "/" + path;
+    }
+
+    port = 80;
+    size_t colon = hostPort.find(':');
+    if (colon != string::npos) {
+        port = atoi(hostPort.c_str() + colon + 1);
+        hostPort.resize(colon);
+    }
+    host = hostPort;
+
+    return !host.empty() && (port > 0) && (port < 65536);
+}
+
+bool HttpClient::get(const string& url, HttpResponse& response) {
+    string host;
+    int port;
+    string path;
+    _error = "";
+    if (!parseURL(url, host, port, path)) {
+        return fail("Bad URL: " + url);
+    }
+
+    if ((_socket != NO_SOCKET) && ((host != _host) || (port != _port))) {
+        close();
+    }
+
+    if (request(host, port, path, response)) {
+        return true;
+    }
+
+    //the server may have dropped an idle keep-alive connection, try once more on a fresh one
+    if (_stale) {
+        close();
+        return request(host, port, path, response);
+    }
+    return false;
+}
+
+bool HttpClient::request(const string& host, int port, const string& path, HttpResponse& response) {
+    long long deadline = nowMs() + _timeoutMs;
+    _stale = false;
+
+    bool reused = (_socket != NO_SOCKET);
+    if (!reused && !connect(host, port, deadline)) {
+        return false;
+    }
+
+    stringstream req;
+    req << "GET " << path << " HTTP/1.1\r\n";
+    req << "Host: " << host;
+    if (port != 80) {
+        req << ":" << port;
+    }
+    req << "\r\n";
+    req << "User-Agent: " << _userAgent << "\r\n";
+    req << "Accept: */*\r\n";
+    req << "Connection: keep-alive\r\n";
+    req << "\r\n";
+
+    _buffer.clear();
+    if (!sendAll(req.str(), deadline)) {
+        _stale = reused;
+        close();
+        return false;
+    }
+
+    bool keepAlive = false;
+    response.status = 0;
+    response.body.clear();
+    if (!readResponse(response, keepAlive, deadline)) {
+        _stale = reused && _buffer.empty() && (response.status == 0) && (_error != "Timeout");
+        close();
+        return false;
+    }
+
+    if (!keepAlive) {
+        close();
+    }
+    return true;
+}
+
+bool HttpClient::connect(const string& host, int port, long long deadline) {
+    if (!resolve(host, port)) {
+        return false;
+    }
+
+    _error = "Unable to connect to " + host;
+    for (struct addrinfo* ai = _addresses; ai; ai = ai->ai_next) {
+        Socket s = (Socket)socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (s == NO_SOCKET) {
+            continue;
+        }
+        if (!setNonBlocking(s)) {
+            closeSocket(s);
+            continue;
+        }
+
+        //requests are small and we wait for each reply, don't let Nagle hold them back
+        int on = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+#ifdef SO_NOSIGPIPE
+        setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&on, sizeof(on));
+#endif
+
+        bool connected = (::connect(s, ai->ai_addr, (int)ai->ai_addrlen) == 0);
+        if (!connected && wouldBlock()) {
+            _socket = s;
+            if (wait(true, deadline)) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&error, &length);
+                connected = (error == 0);
+            }
+            _socket = NO_SOCKET;
+        }
+
+        if (connected) {
+            _socket = s;
+            break;
+        }
+        closeSocket(s);
+
+        if (nowMs() >= deadline) {
+            break;
+        }
+    }
+
+    if (_socket == NO_SOCKET) {
+        //the host may have moved, look it up again next time
+        forget();
+        return false;
+    }
+
+    _host = host;
+    _port = port;
+    _connects++;
+    return true;
+}
+
+bool HttpClient::wait(bool forWrite, long long deadline) {
+    for (;;) {
+        long long remaining = deadline - nowMs();
+        if (remaining <= 0) {
+            return fail("Timeout");
+        }
+
+        struct pollfd pfd;
+        pfd.fd = _socket;
+        pfd.events = forWrite ? POLLOUT : POLLIN;
+        pfd.revents = 0;
+
+        int result = poll(&pfd, 1, (int)remaining);
+        if (result > 0) {
+            return true;
+        }
+        if ((result < 0) && !wouldBlock()) {
+            return fail("Socket error");
+        }
+    }
+}
+
+bool HttpClient::sendAll(const string& data, long long deadline) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int result = (int)send(_socket, data.data() + sent, (int)(data.size() - sent), MSG_NOSIGNAL);
+        if (result > 0) {
+            sent += result;
+        } else if ((result < 0) && wouldBlock()) {
+            if (!wait(true, deadline)) {
+                return false;
+            }
+        } else {
+            return fail("Send failed");
+        }
+    }
+    return true;
+}
+
+int HttpClient::receive(long long deadline) {
+    char data[RECEIVE_SIZE];
+    for (;;) {
+        int result = (int)recv(_socket, data, sizeof(data), 0);
+        if (result > 0) {
+            _buffer.append(data, result);
+            return result;
+        }
+        if (result == 0) {
+            fail("Connection closed");
+            return 0;
+        }
+        if (!wouldBlock()) {
+            fail("Receive failed");
+            return -1;
+        }
+        if (!wait(false, deadline)) {
+            return -1;
+        }
+    }
+}
+
+bool HttpClient::fill(size_t size, long long deadline) {
+    while (_buffer.size() < size) {
+        if (receive(deadline) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HttpClient::readLine(string& line, long long deadline) {
+    size_t eol;
+    while ((eol = _buffer.find("\r\n")) == string::npos) {
+        if (_buffer.size() > MAX_HEADER_SIZE) {
+            return fail("Header too large");
+        }
+        if (receive(deadline) <= 0) {
+            return false;
+        }
+    }
+    line = _buffer.substr(0, eol);
+    _buffer.erase(0, eol + 2);
+    return true;
+}
+
+bool HttpClient::readResponse(HttpResponse& response, bool& keepAlive, long long deadline) {
+    string line;
+    if (!readLine(line, deadline)) {
+        return false;
+    }
+
+    //"HTTP/1.1 200 OK"
+    if ((line.compare(0, 7, "HTTP/1.") != 0) || (line.size() < 12)) {
+        return fail("Bad status line");
+    }
+    bool http11 = (line[7] == '1');
+    int status = atoi(line.c_str() + 9);
+
+    bool chunked = false;
+    bool hasLength = false;
+    size_t contentLength = 0;
+    bool connectionClose = !http11;
+    size_t headerSize = line.size();
+    for (;;) {
+        if (!readLine(line, deadline)) {
+            return false;
+        }
+        if (line.empty()) {
+            break;
+        }
+        headerSize += line.size();
+        if (headerSize > MAX_HEADER_SIZE) {
+            return fail("Header too large");
+        }
+
+        size_t colon = line.find(':');
+        if (colon == string::npos) {
+            continue;
+        }
+        string name = line.substr(0, colon);
+        string value = line.substr(colon + 1);
+        for (size_t i = 0; i < name.size(); i++) {
+            name[i] = (char)tolower((unsigned char)name[i]);
+        }
+        for (size_t i = 0; i < value.size(); i++) {
+            value[i] = (char)tolower((unsigned char)value[i]);
+        }
+
+        if (name == "content-length") {
+            hasLength = true;
+            contentLength = (size_t)strtoul(value.c_str(), 0, 10);
+        } else if (name == "transfer-encoding") {
+            chunked = (value.find("chunked") != string::npos);
+        } else if (name == "connection") {
+            if (value.find("close") != string::npos) {
+                connectionClose = true;
+            } else if (value.find("keep-alive") != string::npos) {
+                connectionClose = false;
+            }
+        }
+    }
+
+    //interim responses are not expected for a plain GET, but skip them anyway
+    if ((status >= 100) && (status < 200)) {
+        return readResponse(response, keepAlive, deadline);
+    }
+    response.status = status;
+
+    if ((status == 204) || (status == 304)) {
+        //no body
+    } else if (chunked) {
+        if (!readChunked(response.body, deadline)) {
+            return false;
+        }
+    } else if (hasLength) {
+        if (contentLength > _maxResponseSize) {
+            return fail("Response too large");
+        }
+        if (!fill(contentLength, deadline)) {
+            return false;
+        }
+        response.body = _buffer.substr(0, contentLength);
+        _buffer.erase(0, contentLength);
+    } else {
+        //body ends when the server closes the connection
+        connectionClose = true;
+        int result;
+        while ((result = receive(deadline)) > 0) {
+            if (_buffer.size() > _maxResponseSize) {
+                return fail("Response too large");
+            }
+        }
+        if (result < 0) {
+            return false;
+        }
+        response.body.swap(_buffer);
+    }
+
+    keepAlive = !connectionClose;
+    return true;
+}
+
+bool HttpClient::readChunked(string& body, long long deadline) {
+    string line;
+    for (;;) {
+        if (!readLine(line, deadline)) {
+            return false;
+        }
+        size_t chunkSize = (size_t)strtoul(line.c_str(), 0, 16);
+        if (chunkSize == 0) {
+            break;
+        }
+        if ((body.size() + chunkSize) > _maxResponseSize) {
+            return fail("Response too large");
+        }
+        if (!fill(chunkSize + 2, deadline)) {
+            return false;
+        }
+        body.append(_buffer, 0, chunkSize);
+        _buffer.erase(0, chunkSize + 2);
+    }
+
+    //skip trailers up to the final empty line
+    do {
+        if (!readLine(line, deadline)) {
+            return false;
+        }
+    } while (!line.empty());
+
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+// Description:
+//   Minimal blocking-call HTTP/1.1 client. One keep-alive connection per
+//   client, non-blocking sockets underneath so every step has a deadline.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include <string>
+#include <stdint.h>
+
+struct addrinfo;
+
+struct HttpResponse {
+    int status;
+    std::string body;
+};
+
+//Plain http only. Not thread safe, use one client per thread. Host names
+//are resolved once per client, that first lookup ignores the timeout.
+class HttpClient {
+public:
+#if defined(WIN32)
+    typedef uintptr_t Socket;  //SOCKET
+#else
+    typedef int Socket;
+#endif
+
+    HttpClient(const std::string& userAgent, int timeoutMs = 10000, size_t maxResponseSize = 64 * 1024);
+    ~HttpClient();
+
+    //GET "http://host[:port]/path?query". The connection is kept open and
+    //reused while requests go to the same host and port. Returns false on
+    //network errors, timeouts and oversized responses, see getError.
+    bool get(const std::string& url, HttpResponse& response);
+
+    void close(void);
+
+    const std::string& getError(void) { return _error; }
+    //number of TCP connections opened so far
+    unsigned int getConnectCount(void) { return _connects; }
+
+    static bool parseURL(const std::string& url, std::string& host, int& port, std::string& path);
+
+private:
+    HttpClient(const HttpClient&);
+    HttpClient& operator=(const HttpClient&);
+
+    //look up host unless the cached addresses are for it
+    bool resolve(const std::string& host, int port);
+    void forget(void);
+    bool connect(const std::string& host, int port, long long deadline);
+    bool request(const std::string& host, int port, const std::string& path, HttpResponse& response);
+    bool sendAll(const std::string& data, long long deadline);
+    //append to _buffer. Returns bytes read, 0 when the peer closed, -1 on error or timeout
+    int receive(long long deadline);
+    //receive until _buffer holds at least size bytes
+    bool fill(size_t size, long long deadline);
+    bool readLine(std::string& line, long long deadline);
+    bool readResponse(HttpResponse& response, bool& keepAlive, long long deadline);
+    bool readChunked(std::string& body, long long deadline);
+    bool wait(bool forWrite, long long deadline);
+    bool fail(const std::string& error);
+
+    std::string _userAgent;
+    int _timeoutMs;
+    size_t _maxResponseSize;
+
+    Socket _socket;
+    std::string _host;
+    int _port;
+    unsigned int _connects;
+    //the request failed on a reused connection before any reply arrived
+    bool _stale;
+    //addresses of the last host looked up
+    struct addrinfo* _addresses;
+    std::string _resolvedHost;
+    int _resolvedPort;
+
+    //received but not yet consumed
+    std::string _buffer;
+    std::string _error;
+};
@@ -0,0 +1,315 @@
+// Description:
+//   Startup tasks with dependencies. Independent tasks run concurrently on
+//   a few worker threads, tasks that need the main thread (window, GL) run
+//   on the caller. Every task is timed.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include "InitGraph.hpp"
+
+#include <algorithm>
+#include <system_error>
+#include <thread>
+#include <stdio.h>
+#include <string.h>
+
+#include "Trace.hpp"
+#include "Timer.hpp"
+#include "Profiler.hpp"
+using namespace std;
+
+static const size_t NO_TASK = (size_t)-1;
+
+static double ms(uint64_t ns) {
+    return (double)ns / 1e6;
+}
+
+InitGraph::InitGraph(void) :
+    _nodes(),
+    _valid(true),
+    _start(0),
+    _elapsed(0),
+    _readyMain(),
+    _readyAny(),
+    _finished(0),
+    _hasWorkers(false) {
+    XTRACE();
+}
+
+size_t InitGraph::find(const char* name) const {
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        if (strcmp(_nodes[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return _nodes.size();
+}
+
+bool InitGraph::add(const char* name, Affinity affinity, const Task& task, const vector<const char*>& dependencies) {
+    if (find(name) != _nodes.size()) {
+        LOG_ERROR << "Init task [" << name << "] added twice" << endl;
+        _valid = false;
+        return false;
+    }
+
+    Node node;
+    node.name = name;
+    node.affinity = affinity;
+    node.task = task;
+    for (size_t i = 0; i < dependencies.size(); i++) {
+        size_t dependency = find(dependencies[i]);
+        if (dependency == _nodes.size()) {
+            LOG_ERROR << "Init task [" << name << "] depends on unknown task [" << dependencies[i] << "]" << endl;
+            _valid = false;
+            return false;
+        }
+        node.dependencies.push_back(dependency);
+    }
+    node.pending = 0;
+    node.dependencyFailed = false;
+    node.state = eWaiting;
+    node.onMainThread = false;
+    node.previous = NO_TASK;
+    node.begin = 0;
+    node.end = 0;
+
+    for (size_t i = 0; i < node.dependencies.size(); i++) {
+        _nodes[node.dependencies[i]].dependents.push_back(_nodes.size());
+    }
+    _nodes.push_back(node);
+    return true;
+}
+
+void InitGraph::workerThread(InitGraph* graph) {
+    Profiler::SetThreadName("init-worker");
+    graph->work();
+}
+
+void InitGraph::work(void) {
+    unique_lock<mutex> lock(_lock);
+    size_t previous = NO_TASK;
+    while (_finished < _nodes.size()) {
+        if (_readyAny.empty()) {
+            _changed.wait(lock);
+            continue;
+        }
+        size_t next = _readyAny.front();
+        _readyAny.pop_front();
+
+        lock.unlock();
+        bool ok = execute(next, false, previous);
+        lock.lock();
+        finish(next, ok);
+        previous = next;
+    }
+}
+
+bool InitGraph::execute(size_t index, bool onMainThread, size_t previous) {
+    //only this thread touches the node until it is finished
+    Node& node = _nodes[index];
+    node.onMainThread = onMainThread;
+    node.previous = previous;
+    node.begin = Timer::getNanoseconds() - _start;
+
+    bool ok = false;
+    if (!node.dependencyFailed) {
+        PROFILE_ZONE(node.name);
+        ok = node.task();
+        if (!ok) {
+            LOG_ERROR << "Init task [" << node.name << "] failed" << endl;
+        }
+    }
+
+    node.end = Timer::getNanoseconds() - _start;
+    return ok;
+}
+
+void InitGraph::finish(size_t index, bool ok) {
+    Node& node = _nodes[index];
+    if (node.dependencyFailed) {
+        node.state = eSkipped;
+    } else {
+        node.state = ok ? eDone : eFailed;
+    }
+    _finished++;
+
+    for (size_t i = 0; i < node.dependents.size(); i++) {
+        Node& dependent = _nodes[node.dependents[i]];
+        if (node.state != eDone) {
+            dependent.dependencyFailed = true;
+        }
+        if (--dependent.pending == 0) {
+            schedule(node.dependents[i]);
+        }
+    }
+    _changed.notify_all();
+}
+
+void InitGraph::schedule(size_t index) {
+    Node& node = _nodes[index];
+    node.state = eReady;
+    if (node.affinity == eMainThread) {
+        _readyMain.push_back(index);
+    } else {
+        _readyAny.push_back(index);
+    }
+}
+
+bool InitGraph::run(int maxWorkers) {
+    XTRACE();
+    if (!_valid) {
+        LOG_ERROR << "Init graph has errors, not running it" << endl;
+        return false;
+    }
+
+    _start = Timer::getNanoseconds();
+    _readyMain.clear();
+    _readyAny.clear();
+    _finished = 0;
+
+    int numAny = 0;
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        Node& node = _nodes[i];
+        node.pending = node.dependencies.size();
+        node.dependencyFailed = false;
+        node.state = eWaiting;
+        node.previous = NO_TASK;
+        node.begin = 0;
+        node.end = 0;
+        if (node.affinity == eAnyThread) {
+            numAny++;
+        }
+    }
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        if (_nodes[i].pending == 0) {
+            schedule(i);
+        }
+    }
+
+    vector<thread*> workers;
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+    maxWorkers = 0;
+#endif
+    int numWorkers = std::min(maxWorkers, numAny);
+    for (int i = 0; i < numWorkers; i++) {
+        try {
+            workers.push_back(new thread(workerThread, this));
+        } catch (const system_error& e) {
+            LOG_WARNING << "Unable to start init worker: " << e.what() << endl;
+            break;
+        }
+    }
+
+    {
+        unique_lock<mutex> lock(_lock);
+        //without workers the main thread runs everything
+        _hasWorkers = !workers.empty();
+        size_t previous = NO_TASK;
+        while (_finished < _nodes.size()) {
+            size_t next;
+            if (!_readyMain.empty()) {
+                next = _readyMain.front();
+                _readyMain.pop_front();
+            } else if (!_hasWorkers && !_readyAny.empty()) {
+                next = _readyAny.front();
+                _readyAny.pop_front();
+            } else {
+                _changed.wait(lock);
+                continue;
+            }
+
+            lock.unlock();
+            bool ok = execute(next, true, previous);
+            lock.lock();
+            finish(next, ok);
+            previous = next;
+        }
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->join();
+        delete workers[i];
+    }
+    _elapsed = Timer::getNanoseconds() - _start;
+
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        if (_nodes[i].state != eDone) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t InitGraph::getWork(void) const {
+    uint64_t work = 0;
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        work += _nodes[i].end - _nodes[i].begin;
+    }
+    return work;
+}
+
+//walk back from the task that finished last through whatever it waited for
+//last: a dependency, or the task before it on the same thread (main thread
+//tasks queue up behind each other)
+vector<size_t> InitGraph::criticalPath(void) const {
+    vector<size_t> path;
+    size_t last = _nodes.size();
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        if ((last == _nodes.size()) || (_nodes[i].end > _nodes[last].end)) {
+            last = i;
+        }
+    }
+
+    while (last != _nodes.size()) {
+        path.push_back(last);
+        const Node& node = _nodes[last];
+        last = _nodes.size();
+        for (size_t i = 0; i < node.dependencies.size(); i++) {
+            size_t dependency = node.dependencies[i];
+            if ((last == _nodes.size()) || (_nodes[dependency].end > _nodes[last].end)) {
+                last = dependency;
+            }
+        }
+        if ((node.previous != NO_TASK) &&
+            ((last == _nodes.size()) || (_nodes[node.previous].end > _nodes[last].end))) {
+            last = node.previous;
+        }
+    }
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+void InitGraph::log(const string& title) const {
+    char line[128];
+    snprintf(line, sizeof(line), "%s: %.1fms, %.1fms of work", title.c_str(), ms(_elapsed), ms(getWork()));
+    LOG_INFO << line << endl;
+
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        const Node& node = _nodes[i];
+        const char* status = "";
+        if (node.state == eFailed) {
+            status = " FAILED";
+        } else if (node.state == eSkipped) {
+            status = " skipped";
+        }
+        snprintf(line, sizeof(line), "  %-12s at %7.1fms took %7.1fms on %s%s", node.name, ms(node.begin),
+                 ms(node.end - node.begin), node.onMainThread ? "main" : "worker", status);
+        LOG_INFO << line << endl;
+    }
+
+    vector<size_t> path = criticalPath();
+    string names;
+    for (size_t i = 0; i < path.size(); i++) {
+        names += (i ? " > " : "") + string(_nodes[path[i]].name);
+    }
+    LOG_INFO << "  critical path: " << names << endl;
+}
@@ -0,0 +1,103 @@
+#pragma once
+// Description:
+//   Startup tasks with dependencies. Independent tasks run concurrently on
+//   a few worker threads, tasks that need the main thread (window, GL) run
+//   on the caller. Every task is timed.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class InitGraph {
+public:
+    typedef std::function<bool(void)> Task;
+
+    enum Affinity {
+        eMainThread,
+        eAnyThread,
+    };
+
+    InitGraph(void);
+
+    //Names must be string literals (they are used as profiler zones) and
+    //dependencies must have been added before. Returns false otherwise.
+    bool add(const char* name, Affinity affinity, const Task& task,
+             const std::vector<const char*>& dependencies = std::vector<const char*>());
+
+    //Run every task once its dependencies are done. Tasks that depend on a
+    //failed task are skipped. With 0 workers (or no threads available) all
+    //tasks run on the caller. Returns false if any task failed.
+    bool run(int maxWorkers = 4);
+
+    //wall time of the last run and the sum of the task times, in ns
+    uint64_t getElapsed(void) const { return _elapsed; }
+    uint64_t getWork(void) const;
+
+    //per task start and duration, and the chain of tasks that took longest
+    void log(const std::string& title) const;
+
+private:
+    InitGraph(const InitGraph&);
+    InitGraph& operator=(const InitGraph&);
+
+    enum State {
+        eWaiting,
+        eReady,
+        eDone,
+        eFailed,
+        eSkipped,
+    };
+
+    struct Node {
+        const char* name;
+        Affinity affinity;
+        Task task;
+        std::vector<size_t> dependencies;
+        std::vector<size_t> dependents;
+        size_t pending;
+        bool dependencyFailed;
+        State state;
+        bool onMainThread;
+        //task that ran before this one on the same thread, if any
+        size_t previous;
+        uint64_t begin;  //relative to the start of run
+        uint64_t end;
+    };
+
+    size_t find(const char* name) const;
+    static void workerThread(InitGraph* graph);
+    void work(void);
+    bool execute(size_t index, bool onMainThread, size_t previous);
+    //call with _lock held
+    void finish(size_t index, bool ok);
+    void schedule(size_t index);
+    std::vector<size_t> criticalPath(void) const;
+
+    std::vector<Node> _nodes;
+    bool _valid;
+    uint64_t _start;
+    uint64_t _elapsed;
+
+    //guards the queues and node states while running
+    std::mutex _lock;
+    std::condition_variable _changed;
+    std::deque<size_t> _readyMain;
+    std::deque<size_t> _readyAny;
+    size_t _finished;
+    bool _hasWorkers;
+};
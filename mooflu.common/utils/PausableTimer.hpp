@@ -15,44 +15,46 @@
 //
 #include "Timer.hpp"
 
+//Times are kept in nanoseconds so pausing doesn't accumulate rounding.
 class PausableTimer {
 public:
     PausableTimer(void) :
         _isPaused(false),
-        _adjust(0.0),
-        _pausedAt(0.0) {
+        _adjust(0),
+        _pausedAt(0) {
         reset();
     }
 
     void reset(void) {
         _isPaused = false;
-        _adjust = Timer::getTime();
+        _adjust = Timer::getNanoseconds();
     }
 
     void pause(void) {
         if (!_isPaused) {
             _isPaused = true;
-            _pausedAt = Timer::getTime() - _adjust;
+            _pausedAt = Timer::getNanoseconds() - _adjust;
         }
     }
 
     void start(void) {
         if (_isPaused) {
             _isPaused = false;
-            _adjust = Timer::getTime() - _pausedAt;
+            _adjust = Timer::getNanoseconds() - _pausedAt;
         }
     }
 
+    //seconds
     double getTime(void) {
         if (_isPaused) {
-            return (_pausedAt);
+            return (double)_pausedAt / 1e9;
         } else {
-            return (Timer::getTime() - _adjust);
+            return (double)(Timer::getNanoseconds() - _adjust) / 1e9;
         }
     }
 
 private:
     bool _isPaused;
-    double _adjust;
-    double _pausedAt;
+    uint64_t _adjust;
+    uint64_t _pausedAt;
 };
@@ -0,0 +1,201 @@
+// Description:
+//   Scoped zone profiler. Zones are timed like XTRACE scopes and kept per
+//   thread; Dump writes them as Chrome trace JSON (chrome://tracing or
+//   ui.perfetto.dev).
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include "Profiler.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+using namespace std;
+
+//per thread ring of recent zones, power of 2
+const size_t MAX_EVENTS = 32768;
+//threads beyond this aren't recorded
+const size_t MAX_THREADS = 64;
+
+struct ZoneEvent {
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+    char detail[PROFILE_DETAIL_SIZE];
+};
+
+//Only the owning thread writes; it publishes each event by bumping count.
+//Buffers are never freed so zones of finished threads can still be dumped.
+struct ThreadZones {
+    ThreadZones(int threadId) : id(threadId), name(0), count(0), events(new ZoneEvent[MAX_EVENTS]) {}
+
+    int id;
+    atomic<const char*> name;
+    atomic<size_t> count;
+    ZoneEvent* events;
+};
+
+struct ZoneRegistry {
+    mutex lock;
+    vector<ThreadZones*> threads;
+};
+
+atomic<bool> Profiler::recording_(false);
+
+static ZoneRegistry& registry(void) {
+    static ZoneRegistry* zoneRegistry = new ZoneRegistry();
+    return *zoneRegistry;
+}
+
+static thread_local ThreadZones* threadZones = 0;
+static thread_local bool threadIgnored = false;
+
+static ThreadZones* zones(void) {
+    if (!threadZones && !threadIgnored) {
+        ZoneRegistry& reg = registry();
+        lock_guard<mutex> lock(reg.lock);
+        if (reg.threads.size() < MAX_THREADS) {
+            threadZones = new ThreadZones((int)reg.threads.size() + 1);
+            reg.threads.push_back(threadZones);
+        } else {
+            threadIgnored = true;
+        }
+    }
+    return threadZones;
+}
+
+void Profiler::Start(void) {
+    recording_.store(true);
+}
+
+void Profiler::Stop(void) {
+    recording_.store(false);
+}
+
+void Profiler::SetThreadName(const char* name) {
+    ThreadZones* z = zones();
+    if (z) {
+        z->name.store(name);
+    }
+}
+
+uint64_t Profiler::Now(void) {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void Profiler::Record(const char* name, const char* detail, uint64_t begin, uint64_t end) {
+    ThreadZones* z = zones();
+    if (!z) {
+        return;
+    }
+
+    size_t n = z->count.load(memory_order_relaxed);
+    ZoneEvent& event = z->events[n & (MAX_EVENTS - 1)];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    if (detail) {
+        strncpy(event.detail, detail, PROFILE_DETAIL_SIZE - 1);
+        event.detail[PROFILE_DETAIL_SIZE - 1] = '\0';
+    } else {
+        event.detail[0] = '\0';
+    }
+    z->count.store(n + 1, memory_order_release);
+}
+
+static void writeJSONString(ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; c++) {
+        if ((*c == '"') || (*c == '\\')) {
+            out << '\\' << *c;
+        } else if ((unsigned char)*c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned int)(unsigned char)*c);
+            out << escaped;
+        } else {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+//copy the events the owning thread can't be overwriting while we read
+static void copyEvents(const ThreadZones& z, vector<ZoneEvent>& events) {
+    size_t count = z.count.load(memory_order_acquire);
+    //the slot after the newest one may be in the middle of a write
+    size_t first = (count >= MAX_EVENTS) ? count - MAX_EVENTS + 1 : 0;
+    for (size_t i = first; i < count; i++) {
+        events.push_back(z.events[i & (MAX_EVENTS - 1)]);
+    }
+
+    //drop whatever was overwritten during the copy
+    size_t newCount = z.count.load(memory_order_acquire);
+    size_t overwritten = (newCount >= MAX_EVENTS) ? newCount - MAX_EVENTS + 1 : 0;
+    if (overwritten > first) {
+        events.erase(events.begin(), events.begin() + std::min(overwritten - first, events.size()));
+    }
+}
+
+void Profiler::Dump(ostream& out) {
+    vector<ThreadZones*> threads;
+    {
+        ZoneRegistry& reg = registry();
+        lock_guard<mutex> lock(reg.lock);
+        threads = reg.threads;
+    }
+
+    vector<vector<ZoneEvent> > events(threads.size());
+    uint64_t start = 0;
+    for (size_t t = 0; t < threads.size(); t++) {
+        copyEvents(*threads[t], events[t]);
+        for (size_t i = 0; i < events[t].size(); i++) {
+            if (!start || (events[t][i].begin < start)) {
+                start = events[t][i].begin;
+            }
+        }
+    }
+
+    char number[64];
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (size_t t = 0; t < threads.size(); t++) {
+        const char* name = threads[t]->name.load();
+        if (name) {
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threads[t]->id
+                << ",\"args\":{\"name\":";
+            writeJSONString(out, name);
+            out << "}}";
+            first = false;
+        }
+
+        for (size_t i = 0; i < events[t].size(); i++) {
+            const ZoneEvent& event = events[t][i];
+            out << (first ? "" : ",\n") << "{\"name\":";
+            writeJSONString(out, event.name);
+            //microseconds with ns precision
+            snprintf(number, sizeof(number), "%.3f,\"dur\":%.3f", (event.begin - start) / 1000.0,
+                     (event.end - event.begin) / 1000.0);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << threads[t]->id << ",\"ts\":" << number;
+            if (event.detail[0]) {
+                out << ",\"args\":{\"detail\":";
+                writeJSONString(out, event.detail);
+                out << "}";
+            }
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
@@ -0,0 +1,82 @@
+#pragma once
+// Description:
+//   Scoped zone profiler. Zones are timed like XTRACE scopes and kept per
+//   thread; Dump writes them as Chrome trace JSON (chrome://tracing or
+//   ui.perfetto.dev).
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <stdint.h>
+
+//Zone names must be string literals. The detail (e.g. a file name) is
+//copied, truncated to PROFILE_DETAIL_SIZE - 1 characters.
+#ifdef NO_PROFILE
+#define PROFILE_ZONE(_name_)
+#define PROFILE_ZONE_DETAIL(_name_, _detail_)
+#else
+#define PROFILE_CONCAT_(_a_, _b_) _a_##_b_
+#define PROFILE_CONCAT(_a_, _b_) PROFILE_CONCAT_(_a_, _b_)
+#define PROFILE_ZONE(_name_) ProfileZone PROFILE_CONCAT(__PROFILE_zOnE_, __LINE__)((_name_))
+#define PROFILE_ZONE_DETAIL(_name_, _detail_) \
+    ProfileZone PROFILE_CONCAT(__PROFILE_zOnE_, __LINE__)((_name_), (_detail_))
+#endif
+
+const size_t PROFILE_DETAIL_SIZE = 40;
+
+class Profiler {
+public:
+    //Zones are only recorded between Start and Stop. Each thread keeps its
+    //most recent MAX_EVENTS zones, so a dump shows the last few seconds.
+    static void Start(void);
+    static void Stop(void);
+    static bool IsRecording(void) { return recording_.load(std::memory_order_relaxed); }
+
+    //name shown for the calling thread, must be a string literal
+    static void SetThreadName(const char* name);
+
+    //all threads' zones as Chrome trace JSON
+    static void Dump(std::ostream& out);
+
+    //monotonic, in nanoseconds
+    static uint64_t Now(void);
+    static void Record(const char* name, const char* detail, uint64_t begin, uint64_t end);
+
+    static std::atomic<bool> recording_;
+};
+
+class ProfileZone {
+public:
+    ProfileZone(const char* name, const char* detail = 0) :
+        _name(name),
+        _detail(detail),
+        _begin(Profiler::IsRecording() ? Profiler::Now() : 0) {}
+    ProfileZone(const char* name, const std::string& detail) :
+        _name(name),
+        _detail(detail.c_str()),
+        _begin(Profiler::IsRecording() ? Profiler::Now() : 0) {}
+    ~ProfileZone() {
+        if (_begin) {
+            Profiler::Record(_name, _detail, _begin, Profiler::Now());
+        }
+    }
+
+private:
+    ProfileZone(const ProfileZone&);
+    ProfileZone& operator=(const ProfileZone&);
+
+    const char* _name;
+    const char* _detail;
+    uint64_t _begin;
+};
@@ -37,6 +37,28 @@ public:
         return resource;
     }
 
+    bool isCached(const std::string& resourceName) {
+        return findHash<const std::string>(resourceName, _resourceMap) != 0;
+    }
+
+    //Read and parse resource without touching GL (safe on a worker thread)
+    virtual ResourceT* decode(const std::string& resourceName) = 0;
+
+    //Finish a decoded resource on the GL thread and cache it. Takes ownership.
+    bool addDecoded(const std::string& resourceName, ResourceT* resource) {
+        if (isCached(resourceName)) {
+            delete resource;
+            return true;
+        }
+        if (!upload(resource)) {
+            LOG_ERROR << "Unable to upload " << resourceName << "\n";
+            delete resource;
+            return false;
+        }
+        _resourceMap[resourceName] = resource;
+        return true;
+    }
+
     virtual void reload(void) {
 #if 0
         hash_map< std::string, ResourceT*, hash<std::string>, std::equal_to<std::string> >::const_iterator ci;
@@ -61,7 +83,18 @@ protected:
         _resourceMap.clear();
     }
 
-    virtual ResourceT* load(const std::string& resource) = 0;
+    ResourceT* load(const std::string& resourceName) {
+        ResourceT* resource = decode(resourceName);
+        if (resource && !upload(resource)) {
+            delete resource;
+            resource = 0;
+        }
+        return resource;
+    }
+
+    //Create GL objects for a decoded resource
+    virtual bool upload(ResourceT* resource) = 0;
+
     hash_map<const std::string, ResourceT*, hash<const std::string>, std::equal_to<const std::string>> _resourceMap;
 
 private:
@@ -8,7 +8,7 @@
 
 #include <Tea.hpp>
 
-#define MX ((z >> 5 ^ y << 2) + (y >> 3 ^ z << 4)) ^ ((sum ^ y) + (k[(p & 3) ^ e] ^ z));
+#define MX (((z >> 5 ^ y << 2) + (y >> 3 ^ z << 4)) ^ ((sum ^ y) + (k[(p & 3) ^ e] ^ z)))
 
 uint32_t Tea::k[4] = {
     0x7ef6a7c3,
@@ -17,94 +17,96 @@ uint32_t Tea::k[4] = {
     0xcae63b12,
 };
 
-void Tea::msgToData(const std::string& msg, std::vector<uint32_t>& v) {
-    size_t n = (msg.size() + 3) / 4;
-    size_t len = msg.size();
-    size_t pos = 0;
-    for (size_t i = 0; i < n; i++) {
-        uint32_t result = (unsigned char)msg[pos++];
-        if (pos < len) {
-            result += (unsigned char)msg[pos++] << (1 * 8);
-        }
-        if (pos < len) {
-            result += (unsigned char)msg[pos++] << (2 * 8);
-        }
-        if (pos < len) {
-            result += (unsigned char)msg[pos++] << (3 * 8);
-        }
-
-        v.push_back(result);
-    }
+static inline uint32_t load32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
 }
 
-std::string Tea::dataToMsg(const std::vector<uint32_t>& v) {
-    std::string result(v.size() * 4, 0);
-
-    unsigned int pos = 0;
-    for (unsigned int i = 0; i < v.size(); i++) {
-        uint32_t value = v[i];
-        result[pos++] = value & 0xff;
-        result[pos++] = (value >> (1 * 8)) & 0xff;
-        result[pos++] = (value >> (2 * 8)) & 0xff;
-        result[pos++] = (value >> (3 * 8)) & 0xff;
-    }
-
-    return result;
+static inline void store32(unsigned char* p, uint32_t value) {
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+    p[2] = (value >> 16) & 0xff;
+    p[3] = (value >> 24) & 0xff;
 }
 
-std::string Tea::encode(const std::string& msg) {
-    std::vector<uint32_t> v;
-    msgToData(msg, v);
-    unsigned int n = (unsigned int)v.size();
+void Tea::encodeWords(unsigned char* data, size_t size) {
+    unsigned int n = (unsigned int)(size / 4);
 
     unsigned p, e;
     unsigned int rounds = 6 + 52 / n;
     uint32_t sum = 0;
     uint32_t y;
-    uint32_t z = v[n - 1];
+    uint32_t z = load32(data + (n - 1) * 4);
 
     do {
         sum += DELTA;
         e = (sum >> 2) & 3;
         for (p = 0; p < n - 1; p++) {
-            y = v[p + 1];
-            v[p] += MX;
-            z = v[p];
+            y = load32(data + (p + 1) * 4);
+            z = load32(data + p * 4) + MX;
+            store32(data + p * 4, z);
         }
-        y = v[0];
-        v[n - 1] += MX;
-        z = v[n - 1];
+        y = load32(data);
+        z = load32(data + p * 4) + MX;
+        store32(data + p * 4, z);
 
     } while (--rounds);
-
-    return dataToMsg(v);
 }
 
-std::string Tea::decode(const std::string& msg) {
-    std::vector<uint32_t> v;
-    msgToData(msg, v);
-    unsigned int n = (unsigned int)v.size();
+void Tea::decodeWords(unsigned char* data, size_t size) {
+    unsigned int n = (unsigned int)(size / 4);
 
     unsigned p, e;
     unsigned int rounds = 6 + 52 / n;
     uint32_t sum = rounds * DELTA;
-    uint32_t y = v[0];
+    uint32_t y = load32(data);
     uint32_t z;
 
     do {
         e = (sum >> 2) & 3;
         for (p = n - 1; p > 0; p--) {
-            z = v[p - 1];
-            v[p] -= MX;
-            y = v[p];
+            z = load32(data + (p - 1) * 4);
+            y = load32(data + p * 4) - MX;
+            store32(data + p * 4, y);
         }
-        z = v[n - 1];
-        v[0] -= MX;
-        y = v[0];
+        z = load32(data + (n - 1) * 4);
+        y = load32(data) - MX;
+        store32(data, y);
 
     } while ((sum -= DELTA) != 0);
+}
 
-    return dataToMsg(v);
+bool Tea::encode(unsigned char* data, size_t size) {
+    if ((size < 8) || (size % 4)) {
+        return false;
+    }
+    encodeWords(data, size);
+    return true;
+}
+
+bool Tea::decode(unsigned char* data, size_t size) {
+    if ((size < 8) || (size % 4)) {
+        return false;
+    }
+    decodeWords(data, size);
+    return true;
+}
+
+std::string Tea::encode(const std::string& msg) {
+    std::string result(msg);
+    result.resize(((msg.size() + 3) / 4) * 4, 0);
+    if (!result.empty()) {
+        encodeWords((unsigned char*)&result[0], result.size());
+    }
+    return result;
+}
+
+std::string Tea::decode(const std::string& msg) {
+    std::string result(msg);
+    result.resize(((msg.size() + 3) / 4) * 4, 0);
+    if (!result.empty()) {
+        decodeWords((unsigned char*)&result[0], result.size());
+    }
+    return result;
 }
 
 #if 0
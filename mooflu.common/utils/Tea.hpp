@@ -6,9 +6,9 @@
 
 #include <string>
 #include <vector>
+#include <stddef.h>
 
-//The input msg must be >4 chars.
-//The block size is variable but should be at least 2 32-bit words (>4 chars).
+//The block size is variable, at least 2 32-bit words (8 chars).
 #ifndef uint32_t
 typedef unsigned int uint32_t;
 #endif
@@ -16,11 +16,20 @@ typedef unsigned int uint32_t;
 class Tea {
 private:
     static const uint32_t DELTA = 0x9e3779b9;
-    static void msgToData(const std::string& msg, std::vector<uint32_t>& v);
-    static std::string dataToMsg(const std::vector<uint32_t>& v);
+    static void encodeWords(unsigned char* data, size_t size);
+    static void decodeWords(unsigned char* data, size_t size);
 
 public:
     static uint32_t k[4];
+
+    //In place over little endian 32-bit words, no allocations.
+    //size must be a multiple of 4 and at least 8: shorter buffers are
+    //rejected (false, data untouched), pad them with the string API.
+    static bool encode(unsigned char* data, size_t size);
+    static bool decode(unsigned char* data, size_t size);
+
+    //The message is zero padded to a multiple of 4 chars. Up to 4 chars
+    //end up in a single word, which XXTea hardly mixes.
     static std::string encode(const std::string& msg);
     static std::string decode(const std::string& msg);
 };
@@ -0,0 +1,91 @@
+// Description:
+//   Monotonic high resolution time.
+//
+// Copyright (C) 2001 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include "Timer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+using namespace std;
+
+//Reads of the default clock take no lock, they are on hot paths (frame
+//limiter spin, init workers). steady_clock can't step back, only sources
+//set by setClockSource (tests) go through the locked clamp below.
+static atomic<Timer::ClockSource> clockSource(Timer::steadyClock);
+
+static atomic<uint64_t>& steadyOrigin(void) {
+    static atomic<uint64_t> origin(Timer::steadyClock());
+    return origin;
+}
+
+struct TimerState {
+    TimerState(void) : last(0), elapsed(0), started(false) {}
+
+    mutex lock;
+    uint64_t last;     //last raw reading
+    uint64_t elapsed;  //at last
+    bool started;
+};
+
+static TimerState& timerState(void) {
+    static TimerState* state = new TimerState();
+    return *state;
+}
+
+uint64_t Timer::steadyClock(void) {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+uint64_t Timer::getNanoseconds(void) {
+    ClockSource source = clockSource.load(memory_order_acquire);
+    if (source == steadyClock) {
+        //origin first, a clock read before it could be older
+        uint64_t origin = steadyOrigin().load(memory_order_relaxed);
+        return steadyClock() - origin;
+    }
+
+    TimerState& t = timerState();
+    lock_guard<mutex> lock(t.lock);
+
+    uint64_t now = source();
+    if (!t.started) {
+        t.last = now;
+        t.elapsed = 0;
+        t.started = true;
+    }
+
+    //a source that steps back counts as no time passing, never run backwards
+    if (now > t.last) {
+        t.elapsed += now - t.last;
+    }
+    t.last = now;
+
+    return t.elapsed;
+}
+
+double Timer::getTime(void) {
+    return (double)getNanoseconds() / 1e9;
+}
+
+void Timer::setClockSource(ClockSource source) {
+    TimerState& t = timerState();
+    lock_guard<mutex> lock(t.lock);
+    t.started = false;
+    if (!source || (source == steadyClock)) {
+        steadyOrigin().store(steadyClock(), memory_order_relaxed);
+        source = steadyClock;
+    }
+    clockSource.store(source, memory_order_release);
+}
@@ -1,6 +1,6 @@
 #pragma once
 // Description:
-//   Helpers to get time.
+//   Monotonic high resolution time.
 //
 // Copyright (C) 2001 Frank Becker
 //
@@ -14,24 +14,21 @@
 // FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
 //
 
-#include "gettimeofday.hpp"
+#include <stdint.h>
 
+//Monotonic clock, unaffected by changes to the wall clock.
 class Timer {
 public:
-    static double getTime(void) {
-        struct timeval tv;
-        static bool initialized = false;
-        static long startSeconds = 0;
-        static long startUSeconds = 0;
+    //nanoseconds from any fixed origin
+    typedef uint64_t (*ClockSource)(void);
 
-        gettimeofday(&tv, 0);
+    //seconds since the first call
+    static double getTime(void);
+    static uint64_t getNanoseconds(void);
 
-        if (!initialized) {
-            startSeconds = tv.tv_sec;
-            startUSeconds = tv.tv_usec;
-            initialized = true;
-        }
-        long msecs = (tv.tv_sec - startSeconds) * 1000 + (tv.tv_usec - startUSeconds) / 1000;
-        return ((double)msecs / 1000.0);
-    }
+    //default source, std::chrono::steady_clock
+    static uint64_t steadyClock(void);
+    //Replace the clock (e.g. to simulate clock jumps), time restarts at 0.
+    //For tests: reads of a replaced clock are serialized by a lock.
+    static void setClockSource(ClockSource source);
 };
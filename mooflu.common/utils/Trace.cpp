@@ -15,8 +15,22 @@
 #include "Trace.hpp"
 #define TRACE
 
-#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 using namespace std;
 
 #ifdef HAVE_CONFIG_H
@@ -24,6 +38,7 @@ using namespace std;
 #endif
 
 int Trace::indent_ = 0;
+int Trace::level_ = Trace::eDEBUG;
 
 #ifdef WIN32
 static inline ofstream& tcout(void) {
@@ -61,55 +76,423 @@ Trace::~Trace() {
             << "}" << endl;
 }
 
-#ifdef TRACE
-#ifdef WIN32
-#include "../utilsfs/GetDataPath.hpp"
-ofstream mcout((getWritableDataPath(PACKAGE) + "/log.txt").c_str());
-//#define mcout cout
-#else
-#define mcout cout
-#endif
+//Log lines go through a bounded ring of fixed size slots. Any thread may
+//produce; a slot is claimed with a CAS on enqueuePos and published by
+//bumping its sequence (bounded MPMC queue after D. Vyukov). The log thread
+//is the only consumer. Lines longer than a slot take several slots.
+const size_t LOG_SLOTS = 1024;  //power of 2
+const size_t LOG_TEXT_SIZE = 232;
+//the log thread wakes up at least this often
+const int LOG_IDLE_MS = 20;
+
+struct LogSlot {
+    atomic<size_t> sequence;
+    int64_t timeMs;
+    unsigned char severity;
+    unsigned char indent;
+    bool prefix;  //first part of a line
+    unsigned short length;
+    char text[LOG_TEXT_SIZE];
+};
 
-void Trace::SetStreamBuffer(streambuf* newBuffer) {
-#ifndef WIN32
-    /*streambuf *old =*/mcout.rdbuf(newBuffer);
-    //delete old; //This breaks on iPhone with a 'pointer being freed was not allocated'
-#endif
-}
+struct LogState {
+    LogState(void) : enqueuePos(0), dequeuePos(0), running(false), writer(0), console(&cout),
+                     consoleEnabled(true), file(0), fileSize(0), maxFileSize(0) {
+        for (size_t i = 0; i < LOG_SLOTS; i++) {
+            slots[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
 
-ostream& Trace::Log(int severity) {
-    const char* type;
+    LogSlot slots[LOG_SLOTS];
+    atomic<size_t> enqueuePos;
+    atomic<size_t> dequeuePos;
+    atomic<bool> running;
+    thread* writer;
+
+    mutex wakeLock;
+    condition_variable wake;
+
+    //guards everything below
+    mutex sinkLock;
+    ostream* console;
+    bool consoleEnabled;
+    ofstream* file;
+    string fileName;
+    size_t fileSize;
+    size_t maxFileSize;
+};
+
+//never deleted, static destructors may still log
+static LogState& logState(void) {
+    static LogState* state = new LogState();
+    return *state;
+}
 
+static const char* severityName(int severity) {
     switch (severity) {
         case Trace::eDEBUG:
-            type = "DEBUG";
-            break;
+            return "DEBUG";
         case Trace::eINFO:
-            type = "INFO";
-            break;
+            return "INFO";
         case Trace::eWARNING:
-            type = "WARNING";
-            break;
+            return "WARNING";
         case Trace::eERROR:
-            type = "*ERROR*";
-            break;
+            return "*ERROR*";
         case Trace::eFATAL:
-            type = "FATAL";
-            break;
+            return "FATAL";
+        default:
+            return "TRACE";
+    }
+}
 
-        case Trace::eVOID:
-            return mcout;
+static void openLogFile(LogState& log, bool keepPrevious) {
+    delete log.file;
+    if (keepPrevious) {
+        string previous = log.fileName + ".1";
+        remove(previous.c_str());
+        rename(log.fileName.c_str(), previous.c_str());
+    }
+    log.file = new ofstream(log.fileName.c_str(), ios::out | ios::trunc);
+    log.fileSize = 0;
+    if (!log.file->good()) {
+        delete log.file;
+        log.file = 0;
+    }
+}
 
-        default:
-            type = "TRACE";
+//sinkLock held
+static void writeText(LogState& log, const char* text, size_t length) {
+    if (log.consoleEnabled) {
+        log.console->write(text, length);
+    }
+    if (log.file) {
+        log.file->write(text, length);
+        log.fileSize += length;
+        if ((log.fileSize > log.maxFileSize) && (length > 0) && (text[length - 1] == '\n')) {
+            openLogFile(log, true);
+        }
+    }
+}
+
+//sinkLock held
+static void writeLine(LogState& log, const LogSlot& line) {
+    if (line.prefix) {
+        time_t seconds = (time_t)(line.timeMs / 1000);
+        struct tm local;
+#ifdef WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        char prefix[64];
+        int length = snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%03d %*s%s: ", local.tm_hour, local.tm_min,
+                              local.tm_sec, (int)(line.timeMs % 1000), (int)line.indent, "",
+                              severityName(line.severity));
+        writeText(log, prefix, (size_t)length);
+    }
+    writeText(log, line.text, line.length);
+}
+
+//sinkLock held
+static void flushSinks(LogState& log) {
+    if (log.consoleEnabled) {
+        log.console->flush();
+    }
+    if (log.file) {
+        log.file->flush();
+    }
+}
+
+//single consumer, returns false if there was nothing to write
+static bool drainQueue(LogState& log) {
+    lock_guard<mutex> lock(log.sinkLock);
+
+    bool wrote = false;
+    for (;;) {
+        size_t pos = log.dequeuePos.load(memory_order_relaxed);
+        LogSlot& slot = log.slots[pos & (LOG_SLOTS - 1)];
+        if (slot.sequence.load(memory_order_acquire) != pos + 1) {
             break;
+        }
+        writeLine(log, slot);
+        slot.sequence.store(pos + LOG_SLOTS, memory_order_release);
+        log.dequeuePos.store(pos + 1, memory_order_release);
+        wrote = true;
     }
 
-    mcout << setw(indent_) << "" << type << ": ";
+    if (wrote) {
+        flushSinks(log);
+    }
+    return wrote;
+}
+
+static void logThread(LogState* log) {
+    while (log->running.load()) {
+        if (!drainQueue(*log)) {
+            unique_lock<mutex> lock(log->wakeLock);
+            log->wake.wait_for(lock, chrono::milliseconds(LOG_IDLE_MS));
+        }
+    }
+    drainQueue(*log);
+}
+
+static void pushLine(const LogSlot& line) {
+    LogState& log = logState();
+
+    if (!log.running.load(memory_order_acquire)) {
+        lock_guard<mutex> lock(log.sinkLock);
+        writeLine(log, line);
+        flushSinks(log);
+        return;
+    }
+
+    LogSlot* slot;
+    size_t pos = log.enqueuePos.load(memory_order_relaxed);
+    for (;;) {
+        slot = &log.slots[pos & (LOG_SLOTS - 1)];
+        size_t sequence = slot->sequence.load(memory_order_acquire);
+        if (sequence == pos) {
+            if (log.enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                break;
+            }
+        } else if ((ptrdiff_t)(sequence - pos) < 0) {
+            //full, only happens when flooding the log; wait rather than lose lines
+            log.wake.notify_one();
+            this_thread::yield();
+            pos = log.enqueuePos.load(memory_order_relaxed);
+        } else {
+            pos = log.enqueuePos.load(memory_order_relaxed);
+        }
+    }
+
+    slot->timeMs = line.timeMs;
+    slot->severity = line.severity;
+    slot->indent = line.indent;
+    slot->prefix = line.prefix;
+    slot->length = line.length;
+    memcpy(slot->text, line.text, line.length);
+    slot->sequence.store(pos + 1, memory_order_release);
+
+    //otherwise the log thread catches up on its own
+    if ((pos - log.dequeuePos.load(memory_order_relaxed) >= LOG_SLOTS / 2) || (line.severity >= Trace::eFATAL)) {
+        log.wake.notify_one();
+    }
+}
+
+//Formats log output for one thread. Text is cut into lines (or slot sized
+//pieces of long lines) and queued; nothing is written on the caller's thread.
+class LogBuffer : public streambuf {
+public:
+    LogBuffer(void) : _stream(this) {
+        _line.length = 0;
+        _line.prefix = false;
+    }
+    ~LogBuffer() { commit(); }
+
+    ostream& begin(int severity) {
+        commit();
+
+        _line.severity = (unsigned char)severity;
+        _line.indent = (unsigned char)std::min(std::max(Trace::indent_, 0), 255);
+        _line.prefix = true;
+        _line.timeMs =
+            chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+
+        //every line starts with default formatting
+        _stream.flags(ios::dec | ios::skipws);
+        _stream.fill(' ');
+        _stream.precision(6);
+        _stream.width(0);
+        return _stream;
+    }
+
+    ostream& stream(void) { return _stream; }
+
+    void commit(void) {
+        if (_line.length == 0) {
+            return;
+        }
+        pushLine(_line);
+        _line.length = 0;
+        _line.prefix = false;
+    }
+
+protected:
+    virtual int_type overflow(int_type c) {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            char ch = traits_type::to_char_type(c);
+            append(&ch, 1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    virtual streamsize xsputn(const char* s, streamsize n) {
+        append(s, (size_t)n);
+        return n;
+    }
+
+    virtual int sync(void) {
+        commit();
+        return 0;
+    }
+
+private:
+    void append(const char* s, size_t n) {
+        while (n > 0) {
+            size_t count = std::min(n, LOG_TEXT_SIZE - _line.length);
+            const char* newline = (const char*)memchr(s, '\n', count);
+            if (newline) {
+                count = newline - s + 1;
+            }
+            memcpy(_line.text + _line.length, s, count);
+            _line.length += (unsigned short)count;
+            s += count;
+            n -= count;
+
+            if (newline || (_line.length == LOG_TEXT_SIZE)) {
+                commit();
+            }
+        }
+    }
+
+    LogSlot _line;
+    ostream _stream;
+};
+
+//The buffer itself is not thread_local so static destructors that log
+//after the thread's locals are gone still get a (new, leaked) buffer.
+static thread_local LogBuffer* threadBuffer = 0;
+
+struct LogBufferOwner {
+    ~LogBufferOwner() {
+        delete threadBuffer;
+        threadBuffer = 0;
+    }
+};
+
+static LogBuffer& logBuffer(void) {
+    static thread_local LogBufferOwner owner;
+    if (!threadBuffer) {
+        threadBuffer = new LogBuffer();
+    }
+    return *threadBuffer;
+}
+
+void Trace::SetStreamBuffer(streambuf* newBuffer) {
+    LogState& log = logState();
+    lock_guard<mutex> lock(log.sinkLock);
+    /*streambuf *old =*/log.console->rdbuf(newBuffer);
+    //delete old; //This breaks on iPhone with a 'pointer being freed was not allocated'
+}
+
+ostream& Trace::Log(int severity) {
+    if (severity == Trace::eVOID) {
+        return logBuffer().stream();
+    }
+    return logBuffer().begin(severity);
+}
+
+void Trace::SetLevel(int severity) {
+    level_ = severity;
+}
+
+bool Trace::SetLevel(const string& name) {
+    static const char* LEVEL_NAMES[] = {"debug", "info", "warning", "error", "fatal"};
+
+    string level = name;
+    for (size_t i = 0; i < level.length(); i++) {
+        level[i] = (char)tolower((unsigned char)level[i]);
+    }
+    for (int severity = eDEBUG; severity <= eFATAL; severity++) {
+        if (level == LEVEL_NAMES[severity]) {
+            SetLevel(severity);
+            return true;
+        }
+    }
+    LOG_WARNING << "Unknown log level " << name << endl;
+    return false;
+}
+
+void Trace::SetConsole(bool enabled) {
+    LogState& log = logState();
+    lock_guard<mutex> lock(log.sinkLock);
+    log.consoleEnabled = enabled;
+}
+
+bool Trace::SetLogFile(const string& fileName, size_t maxSize) {
+    LogState& log = logState();
+    {
+        lock_guard<mutex> lock(log.sinkLock);
+        log.fileName = fileName;
+        log.maxFileSize = maxSize;
+        //the previous run's log becomes fileName.1
+        openLogFile(log, true);
+        if (log.file) {
+            return true;
+        }
+    }
+    LOG_ERROR << "Unable to open log file " << fileName << endl;
+    return false;
+}
+
+bool Trace::StartLogThread(void) {
+    LogState& log = logState();
+    if (log.running.load()) {
+        return true;
+    }
+
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+    return false;
 #else
-ostream& Trace::Log(int) {
+    log.running.store(true);
+    try {
+        log.writer = new thread(logThread, &log);
+    } catch (const system_error& e) {
+        log.running.store(false);
+        LOG_WARNING << "Unable to start log thread: " << e.what() << endl;
+        return false;
+    }
+
+    //make sure queued lines are written on exit
+    static bool registered = false;
+    if (!registered) {
+        atexit(StopLogThread);
+        registered = true;
+    }
+    return true;
 #endif
-    return mcout;
+}
+
+void Trace::Flush(void) {
+    LogState& log = logState();
+    logBuffer().commit();
+
+    if (!log.running.load()) {
+        return;
+    }
+
+    size_t target = log.enqueuePos.load();
+    while (log.running.load() && (log.dequeuePos.load() < target)) {
+        log.wake.notify_one();
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+void Trace::StopLogThread(void) {
+    LogState& log = logState();
+    if (!log.running.load()) {
+        return;
+    }
+    logBuffer().commit();
+
+    log.running.store(false);
+    log.wake.notify_one();
+    log.writer->join();
+    delete log.writer;
+    log.writer = 0;
+
+    //anything queued while the thread was stopping
+    drainQueue(log);
 }
 
 #ifdef DEBUG_TRACE
@@ -157,26 +540,6 @@ int main(int, char*[]) {
     Trace trace("CLASS::METHOD(PARAMS)");
     Trace trace("CLASS", "METHOD", "PARAMS");
 
-    //timestamping
-    Trace::EnableTimestamp();
-    Trace::DisableTimestamp();
-
-    //logging with severity
-    Trace::Debug(...)
-	Trace::Info(...)
-	Trace::Warning(...)
-	Trace::Error(...)
-	Trace::Fatal(...)
-	Trace::Log( severity, ...);
-
-    //enables debug for given severities
-    Trace::EnableSeverity(DEBUG | INFO | ALL_SEVERITIES);
-    Trace::DisableSeverity(DEBUG);
-
-    //sends output to file
-    Trace::AddOutput(file);
-    Trace::DelOutput(file);
-
     //config options
     Trace::ProcessCommandline(argc, argv);
 
@@ -14,8 +14,22 @@
 // FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
 //
 #include <iostream>
+#include <string>
 
 //#define TRACE
+
+//Severities below this are compiled out, e.g. -DLOG_COMPILE_LEVEL=2 keeps
+//warnings and up. Trace::SetLevel filters further at run time.
+#ifndef LOG_COMPILE_LEVEL
+#ifdef TRACE
+#define LOG_COMPILE_LEVEL 0
+#else
+#define LOG_COMPILE_LEVEL 1
+#endif
+#endif
+
+#define LOG_ENABLED(_severity_) (((_severity_) >= LOG_COMPILE_LEVEL) && ((_severity_) >= Trace::level_))
+
 #ifdef TRACE
 
 #define XTRACE() Trace __TRACE_pretty_Function__((__PRETTY_FUNCTION__))
@@ -29,16 +43,6 @@
 //String trace
 #define STRACE(_string_) Trace __TRACE_StRiNg__((_string_))
 
-#define LOG(_severity_) Trace::Log(_severity_)
-#define LOG_DEBUG       Trace::Log(Trace::eDEBUG)
-#define LOG_INFO        Trace::Log(Trace::eINFO)
-#define LOG_WARNING     Trace::Log(Trace::eWARNING)
-#define LOG_ERROR       Trace::Log(Trace::eERROR)
-#define LOG_FATAL       Trace::Log(Trace::eFATAL)
-#define LOG_VOID        Trace::Log(Trace::eVOID)
-
-#define LOG_FILELINE (Trace::Log(Trace::eWARNING) << __FILE__ << ":" << __LINE__ << " ")
-
 #else
 
 #define XTRACE()
@@ -46,26 +50,22 @@
 #define FTRACE(_funct_, _params_)
 #define STRACE(_string_)
 
-#define LOG(_severity) if(1);else Trace::Log(_severity_)
-#define LOG_DEBUG      if(1);else Trace::Log(Trace::eDEBUG)
+#endif
 
-#define LOG_INFO       Trace::Log(Trace::eINFO)
-#define LOG_WARNING    Trace::Log(Trace::eWARNING)
-#define LOG_ERROR      Trace::Log(Trace::eERROR)
-#define LOG_FATAL      Trace::Log(Trace::eFATAL)
-#define LOG_VOID       Trace::Log(Trace::eVOID)
+#define LOG(_severity_) if (!LOG_ENABLED(_severity_)); else Trace::Log(_severity_)
+#define LOG_DEBUG       LOG(Trace::eDEBUG)
+#define LOG_INFO        LOG(Trace::eINFO)
+#define LOG_WARNING     LOG(Trace::eWARNING)
+#define LOG_ERROR       LOG(Trace::eERROR)
+#define LOG_FATAL       LOG(Trace::eFATAL)
+//continues the current line without a prefix
+#define LOG_VOID        Trace::Log(Trace::eVOID)
 
 #define LOG_FILELINE (Trace::Log(Trace::eWARNING) << __FILE__ << ":" << __LINE__ << " ")
 
-#if 0
-#define LOG_INFO       if(1);else Trace::Log(Trace::eINFO)
-#define LOG_WARNING    if(1);else Trace::Log(Trace::eWARNING)
-#define LOG_ERROR      if(1);else Trace::Log(Trace::eERROR)
-#define LOG_FATAL      if(1);else Trace::Log(Trace::eFATAL)
-#endif
-
-#endif
-
+//Log lines are formatted into a per thread buffer and queued; a background
+//thread (see StartLogThread) adds timestamps and writes them to the console
+//and/or a log file. Without the thread, lines are written immediately.
 class Trace {
 public:
     enum {
@@ -86,5 +86,19 @@ public:
 
     static std::ostream& Log(int severity);
 
+    //lowest severity to log, names are debug, info, warning, error, fatal
+    static void SetLevel(int severity);
+    static bool SetLevel(const std::string& name);
+
+    static void SetConsole(bool enabled);
+    //log to fileName as well, moving it to fileName.1 when it grows past maxSize
+    static bool SetLogFile(const std::string& fileName, size_t maxSize = 1024 * 1024);
+
+    static bool StartLogThread(void);
+    //write out everything queued so far
+    static void Flush(void);
+    static void StopLogThread(void);
+
     static int indent_;
+    static int level_;
 };
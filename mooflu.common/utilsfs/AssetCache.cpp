@@ -0,0 +1,223 @@
+// Description:
+//   Cache of preprocessed assets in the write directory, addressed by the
+//   content of their source files.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "AssetCache.hpp"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <vector>
+#include <string.h>
+
+#include <physfs.h>
+#include <zlib.h>
+
+#include "Trace.hpp"
+#include "ResourceManager.hpp"
+
+using namespace std;
+
+//Cache entry layout:
+//  AssetCacheHeader
+//  unsigned char[payloadSize] payload
+static const char ASSET_CACHE_MAGIC[4] = {'A', 'C', 'H', 'E'};
+static const uint32_t ASSET_CACHE_VERSION = 1;
+static const string ASSET_CACHE_DIR = "assetcache";
+
+struct AssetCacheHeader {
+    char magic[4];
+    uint32_t version;
+    unsigned char key[SHA256_DIGEST_SIZE];
+    uint32_t payloadSize;
+    uint32_t crc;
+};
+
+AssetCacheKey::AssetCacheKey(const string& kind, uint32_t formatVersion) :
+    _kind(kind),
+    _final(false) {
+    sha256_init(&_ctx);
+    sha256_update(&_ctx, (const unsigned char*)kind.c_str(), (unsigned int)kind.size() + 1);
+    add(&formatVersion, sizeof(formatVersion));
+}
+
+void AssetCacheKey::add(const void* data, size_t size) {
+    if (_final) {
+        LOG_ERROR << "AssetCacheKey: add after the key was used\n";
+        return;
+    }
+    //prefix the size so different splits of the same bytes don't collide
+    uint64_t length = size;
+    sha256_update(&_ctx, (const unsigned char*)&length, sizeof(length));
+    sha256_update(&_ctx, (const unsigned char*)data, (unsigned int)size);
+}
+
+void AssetCacheKey::add(const ResourceView& source) {
+    add(source.data(), source.size());
+}
+
+const unsigned char* AssetCacheKey::getDigest(void) {
+    if (!_final) {
+        sha256_final(&_ctx, _digest);
+        _final = true;
+    }
+    return _digest;
+}
+
+string AssetCacheKey::getFileName(void) {
+    static const char hexDigits[] = "0123456789abcdef";
+    const unsigned char* digest = getDigest();
+
+    string hex;
+    hex.reserve(SHA256_DIGEST_SIZE * 2);
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        hex += hexDigits[digest[i] >> 4];
+        hex += hexDigits[digest[i] & 0xf];
+    }
+    return ASSET_CACHE_DIR + "/" + _kind + "/" + hex + ".bin";
+}
+
+//--------------------------------------------------------------------------
+
+AssetCache::AssetCache(void) {
+    XTRACE();
+}
+
+AssetCache::~AssetCache() {
+    XTRACE();
+}
+
+ResourceView* AssetCache::load(AssetCacheKey& key) {
+    const string fileName = key.getFileName();
+    if (!ResourceManagerS::instance()->hasResource(fileName)) {
+        return 0;
+    }
+
+    std::unique_ptr<ResourceView> view(ResourceManagerS::instance()->getResourceView(fileName));
+    if (!view || (view->size() < sizeof(AssetCacheHeader))) {
+        LOG_WARNING << "Asset cache " << fileName << " truncated\n";
+        return 0;
+    }
+
+    AssetCacheHeader header;
+    memcpy(&header, view->data(), sizeof(header));
+    if ((memcmp(header.magic, ASSET_CACHE_MAGIC, sizeof(header.magic)) != 0) ||
+        (header.version != ASSET_CACHE_VERSION) ||
+        (memcmp(header.key, key.getDigest(), sizeof(header.key)) != 0) ||
+        (header.payloadSize != view->size() - sizeof(header))) {
+        LOG_WARNING << "Asset cache " << fileName << " invalid\n";
+        return 0;
+    }
+
+    view->skip(sizeof(header));
+    if (crc32(0, (const Bytef*)view->data(), (uInt)view->size()) != header.crc) {
+        LOG_WARNING << "Asset cache " << fileName << " damaged\n";
+        return 0;
+    }
+
+    LOG_DEBUG << "Asset cache hit " << fileName << "\n";
+    return view.release();
+}
+
+bool AssetCache::store(AssetCacheKey& key, const void* payload, size_t payloadSize) {
+    const string fileName = key.getFileName();
+    if (!ResourceManagerS::instance()->makeDirectory(ASSET_CACHE_DIR + "/" + key.getKind())) {
+        return false;
+    }
+
+    AssetCacheHeader header;
+    memcpy(header.magic, ASSET_CACHE_MAGIC, sizeof(header.magic));
+    header.version = ASSET_CACHE_VERSION;
+    memcpy(header.key, key.getDigest(), sizeof(header.key));
+    header.payloadSize = (uint32_t)payloadSize;
+    header.crc = (uint32_t)crc32(0, (const Bytef*)payload, (uInt)payloadSize);
+
+    string data;
+    data.reserve(sizeof(header) + payloadSize);
+    data.append((const char*)&header, sizeof(header));
+    data.append((const char*)payload, payloadSize);
+
+    //temp file and rename: loaders on other threads (or a second instance)
+    //see the old entry or the complete new one, never a partial write
+    if (!ResourceManagerS::instance()->replaceFile(fileName, data)) {
+        LOG_WARNING << "Unable to write asset cache " << fileName << "\n";
+        return false;
+    }
+
+    LOG_DEBUG << "Asset cache stored " << fileName << "\n";
+    return true;
+}
+
+//entry header is readable and has the current layout version
+static bool isCurrent(const string& fileName) {
+    PHYSFS_File* infile = PHYSFS_openRead(fileName.c_str());
+    if (!infile) {
+        return false;
+    }
+    AssetCacheHeader header;
+    bool ok = (PHYSFS_readBytes(infile, &header, sizeof(header)) == (PHYSFS_sint64)sizeof(header)) &&
+              (memcmp(header.magic, ASSET_CACHE_MAGIC, sizeof(header.magic)) == 0) &&
+              (header.version == ASSET_CACHE_VERSION);
+    PHYSFS_close(infile);
+    return ok;
+}
+
+void AssetCache::sweep(uint64_t maxSize) {
+    XTRACE();
+    struct Entry {
+        string fileName;
+        PHYSFS_sint64 size;
+        PHYSFS_sint64 modtime;
+    };
+    vector<Entry> entries;
+    uint64_t total = 0;
+    int removed = 0;
+
+    list<string> kinds;
+    ResourceManagerS::instance()->getFiles(ASSET_CACHE_DIR, kinds);
+    for (list<string>::iterator kind = kinds.begin(); kind != kinds.end(); kind++) {
+        const string dirName = ASSET_CACHE_DIR + "/" + *kind;
+        list<string> files;
+        ResourceManagerS::instance()->getFiles(dirName, files);
+        for (list<string>::iterator file = files.begin(); file != files.end(); file++) {
+            Entry entry;
+            entry.fileName = dirName + "/" + *file;
+            PHYSFS_Stat statInfo;
+            if (!PHYSFS_stat(entry.fileName.c_str(), &statInfo) || (statInfo.filetype != PHYSFS_FILETYPE_REGULAR)) {
+                continue;
+            }
+
+            //leftover temp files and entries from an older cache layout
+            const string& name = *file;
+            bool temp = (name.size() > 4) && (name.compare(name.size() - 4, 4, ".tmp") == 0);
+            if (temp || !isCurrent(entry.fileName)) {
+                if (PHYSFS_delete(entry.fileName.c_str())) {
+                    removed++;
+                }
+                continue;
+            }
+
+            entry.size = statInfo.filesize;
+            entry.modtime = statInfo.modtime;
+            entries.push_back(entry);
+            total += (uint64_t)entry.size;
+        }
+    }
+
+    //entries are only written on a miss, so the oldest ones are most
+    //likely for sources or format versions that are gone
+    sort(entries.begin(), entries.end(),
+         [](const Entry& a, const Entry& b) { return a.modtime < b.modtime; });
+    for (size_t i = 0; (i < entries.size()) && (total > maxSize); i++) {
+        if (PHYSFS_delete(entries[i].fileName.c_str())) {
+            total -= (uint64_t)entries[i].size;
+            removed++;
+        }
+    }
+
+    if (removed) {
+        LOG_INFO << "Asset cache: removed " << removed << " entries, " << (total / 1024) << "KB left\n";
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+// Description:
+//   Cache of preprocessed assets in the write directory, addressed by the
+//   content of their source files.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include <stdint.h>
+#include <string>
+
+#include "Singleton.hpp"
+#include "sha2.h"
+
+class ResourceView;
+
+//SHA-256 over the kind of asset, its format version and all source bytes
+class AssetCacheKey {
+public:
+    AssetCacheKey(const std::string& kind, uint32_t formatVersion);
+
+    //hash source bytes (or loader settings that change the result)
+    void add(const void* data, size_t size);
+    void add(const ResourceView& source);
+
+    const std::string& getKind(void) const { return _kind; }
+
+    //finishes the hash, nothing can be added afterwards
+    const unsigned char* getDigest(void);
+    std::string getFileName(void);
+
+private:
+    std::string _kind;
+    sha256_ctx _ctx;
+    bool _final;
+    unsigned char _digest[SHA256_DIGEST_SIZE];
+};
+
+//Entries live in assetcache/KIND/DIGEST.bin. Loaders hash their sources and
+//look up the key before parsing anything; a changed source or format version
+//simply produces a different key. Keys that are no longer used are left
+//behind, sweep() removes them once the cache grows past its limit.
+class AssetCache {
+    friend class Singleton<AssetCache>;
+
+public:
+    //Cached payload for key, 0 if there is none or it is damaged.
+    ResourceView* load(AssetCacheKey& key);
+    bool store(AssetCacheKey& key, const void* payload, size_t payloadSize);
+
+    //Removes damaged or outdated entries and temp files, then the oldest
+    //entries until the cache fits in maxSize bytes. Run it at startup,
+    //before any loader uses the cache.
+    void sweep(uint64_t maxSize = DEFAULT_MAX_SIZE);
+
+    static const uint64_t DEFAULT_MAX_SIZE = 64 * 1024 * 1024;
+
+private:
+    AssetCache(void);
+    ~AssetCache();
+    AssetCache(const AssetCache&);
+    AssetCache& operator=(const AssetCache&);
+};
+
+typedef Singleton<AssetCache> AssetCacheS;
@@ -45,7 +45,58 @@ Config::~Config() {
     XTRACE();
 }
 
+ConfigValueBase::ConfigValueBase(const string& keyword) :
+    _keyword(keyword) {
+    ConfigS::instance()->addHandle(this);
+}
+
+ConfigValueBase::~ConfigValueBase() {
+    ConfigS::instance()->removeHandle(this);
+}
+
+void Config::addHandle(ConfigValueBase* handle) {
+    lock_guard<recursive_mutex> lock(_lock);
+    _handles[handle->getKeyword()].push_back(handle);
+}
+
+void Config::removeHandle(ConfigValueBase* handle) {
+    lock_guard<recursive_mutex> lock(_lock);
+    hash_map<string, list<ConfigValueBase*>, hash<string>>::iterator i = _handles.find(handle->getKeyword());
+    if (i == _handles.end()) {
+        return;
+    }
+    i->second.remove(handle);
+    if (i->second.empty()) {
+        _handles.erase(i);
+    }
+}
+
+void Config::notify(const string& keyword) {
+    lock_guard<recursive_mutex> lock(_lock);
+    hash_map<string, list<ConfigValueBase*>, hash<string>>::iterator i = _handles.find(keyword);
+    if (i == _handles.end()) {
+        return;
+    }
+    //subscribers may update other keywords, but must not create or destroy handles
+    list<ConfigValueBase*>& handles = i->second;
+    for (list<ConfigValueBase*>::iterator h = handles.begin(); h != handles.end(); h++) {
+        (*h)->refresh();
+    }
+}
+
+void Config::notifyAll(void) {
+    lock_guard<recursive_mutex> lock(_lock);
+    hash_map<string, list<ConfigValueBase*>, hash<string>>::iterator i;
+    for (i = _handles.begin(); i != _handles.end(); i++) {
+        list<ConfigValueBase*>& handles = i->second;
+        for (list<ConfigValueBase*>::iterator h = handles.begin(); h != handles.end(); h++) {
+            (*h)->refresh();
+        }
+    }
+}
+
 void Config::getConfigItemList(list<ConfigItem>& ciList) {
+    lock_guard<recursive_mutex> lock(_lock);
     Yaml::Node& config = _yaml[DEFAULT_SECTION];
 
     for (auto itS = config.Begin(); itS != config.End(); itS++) {
@@ -57,6 +108,7 @@ void Config::getConfigItemList(list<ConfigItem>& ciList) {
 }
 
 const string& Config::getConfigFileName(void) {
+    lock_guard<recursive_mutex> lock(_lock);
     if (_configFileName != "") {
         return _configFileName;
     }
@@ -97,6 +149,7 @@ void Config::updateFromCommandLine(int argc, char* argv[]) {
 
 void Config::updateFromFile(void) {
     XTRACE();
+    lock_guard<recursive_mutex> lock(_lock);
 
     string configFile = getConfigFileName();
     LOG_INFO << "Updating Configuration from : " << configFile << endl;
@@ -111,48 +164,74 @@ void Config::updateFromFile(void) {
     std::unique_ptr<ziStream> infilePtr(ResourceManagerS::instance()->getInputStream(configFile));
     ziStream& infile = *infilePtr;
     Yaml::Parse(_yaml, infile);
+
+    notifyAll();
 }
 
 void Config::updateTransitoryKeyword(const string& keyword, const string& value) {
     XTRACE();
-    removeTrans(keyword);
+    lock_guard<recursive_mutex> lock(_lock);
+    eraseTrans(keyword);
     _yamlTrans[DEFAULT_SECTION][keyword] = value;
+    notify(keyword);
 }
 
 void Config::updateKeyword(const string& keyword, const string& value, const string& section) {
     XTRACE();
-    remove(keyword);
-    removeTrans(keyword);  //also remove trans setting if it exists
+    lock_guard<recursive_mutex> lock(_lock);
+    erase(keyword);
+    eraseTrans(keyword);  //also remove trans setting if it exists
     _yaml[section][keyword] = value;
+    notify(keyword);
 }
 
 void Config::updateTransitoryKeyword(const string& keyword, Value* value) {
     XTRACE();
-    removeTrans(keyword);
+    lock_guard<recursive_mutex> lock(_lock);
+    eraseTrans(keyword);
     _yamlTrans[DEFAULT_SECTION][keyword] = value->getString();
+    notify(keyword);
 }
 
 void Config::updateKeyword(const string& keyword, Value* value, const string& section) {
     XTRACE();
-    remove(keyword);
-    removeTrans(keyword);  //also remove trans setting if it exists
+    lock_guard<recursive_mutex> lock(_lock);
+    erase(keyword);
+    eraseTrans(keyword);  //also remove trans setting if it exists
     _yaml[section][keyword] = value->getString();
+    notify(keyword);
 }
 
 void Config::remove(const string& keyword) {
-    _yaml[DEFAULT_SECTION].Erase(keyword);
+    lock_guard<recursive_mutex> lock(_lock);
+    erase(keyword);
+    notify(keyword);
 }
 
 void Config::removeTrans(const string& keyword) {
+    lock_guard<recursive_mutex> lock(_lock);
+    eraseTrans(keyword);
+    notify(keyword);
+}
+
+void Config::erase(const string& keyword) {
+    lock_guard<recursive_mutex> lock(_lock);
+    _yaml[DEFAULT_SECTION].Erase(keyword);
+}
+
+void Config::eraseTrans(const string& keyword) {
+    lock_guard<recursive_mutex> lock(_lock);
     _yamlTrans[DEFAULT_SECTION].Erase(keyword);
 }
 
 void Config::saveToFile(void) {
     XTRACE();
+    lock_guard<recursive_mutex> lock(_lock);
 
     const string configFile = getConfigFileName();
     LOG_INFO << "Saving Configuration to : " << configFile << endl;
 
+    //deliberately not compressed (unlike the leaderboard): users edit it
     zoStream outfile(configFile.c_str());
 
     outfile << "# This is a generated file. Edit carefully!" << endl;
@@ -160,20 +239,6 @@ void Config::saveToFile(void) {
     Yaml::Serialize(_yaml, outfile);
 }
 
-template <typename T>
-bool Config::get(const string& keyword, T& value) {
-    XTRACE();
-    Yaml::Node& node = _yamlTrans[DEFAULT_SECTION][keyword];
-    if (node.IsNone()) {
-        node = _yaml[DEFAULT_SECTION][keyword];
-    }
-    if (node.IsNone()) {
-        return false;
-    }
-    value = node.As<T>();
-    return true;
-}
-
 bool Config::getString(const string& keyword, string& value) {
     XTRACE();
     return get<string>(keyword, value);
@@ -196,6 +261,7 @@ bool Config::getFloat(const string& keyword, float& value) {
 
 void Config::dump(void) {
     XTRACE();
+    lock_guard<recursive_mutex> lock(_lock);
     Yaml::Node& config = _yaml[DEFAULT_SECTION];
 
     if (config.IsNone()) {
@@ -212,6 +278,7 @@ void Config::dump(void) {
 }
 
 bool Config::getList(const std::string& section, std::vector<ConfigItem>& items) {
+    lock_guard<recursive_mutex> lock(_lock);
     Yaml::Node& sectionNode = _yaml[section];
 
     if (sectionNode.IsNone()) {
@@ -14,6 +14,7 @@
 // FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
 //
 #include <list>
+#include <mutex>
 #include <string>
 #include <functional>
 #include <vector>
@@ -22,14 +23,70 @@
 #include <hashMap.hpp>
 #include <HashString.hpp>
 
+#include <Trace.hpp>
 #include <Yaml.hpp>
+#include <Value.hpp>
 
 const std::string CONFIGFILE = "ConfigFile";
 const string DEFAULT_SECTION = "config";
 
-class Value;
 class ConfigHandler;
 
+//Registers itself with Config and gets refreshed whenever its keyword changes.
+class ConfigValueBase {
+    friend class Config;
+
+public:
+    const std::string& getKeyword(void) const { return _keyword; }
+
+protected:
+    ConfigValueBase(const std::string& keyword);
+    virtual ~ConfigValueBase();
+
+    //re-read the value from Config and notify subscribers if it changed
+    virtual void refresh(void) = 0;
+
+    std::string _keyword;
+
+private:
+    ConfigValueBase(const ConfigValueBase&);
+    ConfigValueBase& operator=(const ConfigValueBase&);
+};
+
+//Typed handle to a config value. The value is parsed once and cached,
+//subscribers are called when Config changes it. Reads return a copy, so
+//handles can be read from any thread; subscribers run under the Config lock.
+template <typename T>
+class ConfigValue : public ConfigValueBase {
+public:
+    typedef std::function<void(const T&)> Callback;
+
+    ConfigValue(const std::string& keyword, const T& defaultValue);
+
+    T get(void) const {
+        std::lock_guard<std::mutex> lock(_valueLock);
+        return _value;
+    }
+    operator T(void) const { return get(); }
+
+    //persistent update, same as Config::updateKeyword
+    void set(const T& value);
+
+    //callback is invoked right away with the current value
+    void subscribe(const Callback& callback);
+
+private:
+    void refresh(void);
+
+    T _defaultValue;
+    //_value is written under the Config lock, _valueLock covers readers
+    mutable std::mutex _valueLock;
+    T _value;
+    std::vector<Callback> _subscribers;
+};
+
+//Safe to use from several threads (e.g. startup tasks). Handles are
+//notified on the thread that changed the value, one change at a time.
 class Config {
     friend class Singleton<Config>;
 
@@ -53,6 +110,13 @@ public:
     void updateTransitoryKeyword(const std::string& keyword, Value* value);
     void removeTrans(const std::string& keyword);
 
+    //Same as updateKeyword, notifies ConfigValue handles of the change.
+    template <typename T>
+    void set(const std::string& keyword, const T& value) {
+        Value v(value);
+        updateKeyword(keyword, &v);
+    }
+
     bool getString(const std::string& keyword, std::string& value);
     bool getInteger(const std::string& keyword, int& value);
     bool getFloat(const std::string& keyword, float& value);
@@ -73,6 +137,10 @@ public:
     std::string getConfigDirectory(void) { return _configDirectory; }
 
 private:
+    friend class ConfigValueBase;
+    template <typename T>
+    friend class ConfigValue;
+
     ~Config();
     Config(void);
     Config(const Config&);
@@ -81,14 +149,84 @@ private:
     template <typename T>
     bool get(const std::string& keyword, T& value);
 
+    void erase(const std::string& keyword);
+    void eraseTrans(const std::string& keyword);
+
+    void addHandle(ConfigValueBase* handle);
+    void removeHandle(ConfigValueBase* handle);
+    void notify(const std::string& keyword);
+    void notifyAll(void);
+
     std::string _configFileName;
 
     std::string _defaultConfigFileName;
     std::string _subdir;
     std::string _configDirectory;
 
+    //Yaml lookups insert missing nodes, so reads need the lock too.
+    //Recursive since handles read (and may set) values while notified.
+    std::recursive_mutex _lock;
+
     Yaml::Node _yaml;
     Yaml::Node _yamlTrans;
+
+    hash_map<std::string, std::list<ConfigValueBase*>, hash<std::string>> _handles;
 };
 
 typedef Singleton<Config> ConfigS;
+
+template <typename T>
+bool Config::get(const std::string& keyword, T& value) {
+    XTRACE();
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    //transitory values override persistent ones
+    Yaml::Node* node = &_yamlTrans[DEFAULT_SECTION][keyword];
+    if (node->IsNone()) {
+        node = &_yaml[DEFAULT_SECTION][keyword];
+    }
+    if (node->IsNone()) {
+        return false;
+    }
+    value = node->As<T>();
+    return true;
+}
+
+template <typename T>
+ConfigValue<T>::ConfigValue(const std::string& keyword, const T& defaultValue) :
+    ConfigValueBase(keyword),
+    _defaultValue(defaultValue),
+    _valueLock(),
+    _value(defaultValue),
+    _subscribers() {
+    ConfigS::instance()->get<T>(_keyword, _value);
+}
+
+template <typename T>
+void ConfigValue<T>::set(const T& value) {
+    ConfigS::instance()->set<T>(_keyword, value);
+}
+
+template <typename T>
+void ConfigValue<T>::subscribe(const Callback& callback) {
+    //same lock as notify, so a change can't slip in between
+    std::lock_guard<std::recursive_mutex> lock(ConfigS::instance()->_lock);
+    _subscribers.push_back(callback);
+    callback(get());
+}
+
+template <typename T>
+void ConfigValue<T>::refresh(void) {
+    //called by Config::notify with the Config lock held
+    T value = _defaultValue;
+    ConfigS::instance()->get<T>(_keyword, value);
+    {
+        std::lock_guard<std::mutex> lock(_valueLock);
+        if (value == _value) {
+            return;
+        }
+        _value = value;
+    }
+    for (size_t i = 0; i < _subscribers.size(); i++) {
+        _subscribers[i](value);
+    }
+}
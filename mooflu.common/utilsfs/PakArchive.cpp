@@ -0,0 +1,464 @@
+// Description:
+//   Reader for packed resource files (see PakFormat.hpp). The file is mapped
+//   once and entries are found through a hash of their path.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "PakArchive.hpp"
+#include "Trace.hpp"
+
+#include <physfs.h>
+#include <zlib.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+using namespace std;
+
+static hash_map<string, PakArchive*, hash<string>>& openArchives(void) {
+    static hash_map<string, PakArchive*, hash<string>> archives;
+    return archives;
+}
+
+PakArchive::PakArchive(const string& fileName, ResourceView* file) :
+    _fileName(fileName),
+    _refCount(1),
+    _file(file),
+    _header((const PakHeader*)file->data()),
+    _entries(0),
+    _names(0),
+    _lookup(),
+    _directories() {}
+
+PakArchive::~PakArchive() {
+    delete _file;
+}
+
+PakArchive* PakArchive::acquire(const string& fileName) {
+    hash_map<string, PakArchive*, hash<string>>::iterator i = openArchives().find(fileName);
+    if (i != openArchives().end()) {
+        i->second->_refCount++;
+        return i->second;
+    }
+
+    //check the magic before mapping, resource.dat may still be a zip
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file) {
+        return 0;
+    }
+    PakHeader header;
+    size_t headerSize = fread(&header, 1, sizeof(header), file);
+    fclose(file);
+    if (!isPakHeader(&header, headerSize)) {
+        return 0;
+    }
+
+    ResourceView* view = ResourceView::fromFile(fileName);
+    if (!view) {
+        LOG_ERROR << "Unable to read " << fileName << endl;
+        return 0;
+    }
+
+    PakArchive* pak = new PakArchive(fileName, view);
+    if (!pak->readIndex()) {
+        LOG_ERROR << "Corrupt pak file " << fileName << endl;
+        delete pak;
+        return 0;
+    }
+
+    LOG_INFO << "Pak " << fileName << ": " << pak->getNumEntries() << " entries"
+             << (view->isMapped() ? " (mapped)" : "") << endl;
+    openArchives()[fileName] = pak;
+    return pak;
+}
+
+void PakArchive::release(void) {
+    if (--_refCount > 0) {
+        return;
+    }
+    openArchives().erase(_fileName);
+    delete this;
+}
+
+bool PakArchive::readIndex(void) {
+    uint64_t fileSize = _file->size();
+    if ((_header->version != PAK_VERSION) || (_header->indexOffset > fileSize) ||
+        ((fileSize - _header->indexOffset) / sizeof(PakEntry) < _header->numEntries) ||
+        (_header->namesOffset > fileSize) || (_header->namesSize > fileSize - _header->namesOffset)) {
+        return false;
+    }
+
+    _entries = (const PakEntry*)(_file->data() + _header->indexOffset);
+    _names = _file->data() + _header->namesOffset;
+
+    //index only, no directory records to walk
+    for (uint32_t i = 0; i < _header->numEntries; i++) {
+        const PakEntry& entry = _entries[i];
+        if ((entry.offset > fileSize) || (entry.storedSize > fileSize - entry.offset) ||
+            ((uint64_t)entry.nameOffset + entry.nameLength > _header->namesSize)) {
+            return false;
+        }
+        _lookup[entry.hash] = i;
+        addToDirectory(string(_names + entry.nameOffset, entry.nameLength));
+    }
+    return true;
+}
+
+void PakArchive::addToDirectory(const string& path) {
+    string::size_type slash = path.rfind('/');
+    string dirName = (slash == string::npos) ? "" : path.substr(0, slash);
+    string baseName = (slash == string::npos) ? path : path.substr(slash + 1);
+
+    bool newDirectory = (_directories.find(dirName) == _directories.end());
+    vector<string>& children = _directories[dirName];
+    if (std::find(children.begin(), children.end(), baseName) == children.end()) {
+        children.push_back(baseName);
+    }
+    if (newDirectory && !dirName.empty()) {
+        addToDirectory(dirName);
+    }
+}
+
+const PakEntry* PakArchive::find(const string& name) const {
+    hash_map<uint64_t, uint32_t>::const_iterator i = _lookup.find(pakHash(name.data(), name.length()));
+    if (i == _lookup.end()) {
+        return 0;
+    }
+    const PakEntry& entry = _entries[i->second];
+    if ((entry.nameLength != name.length()) || (memcmp(_names + entry.nameOffset, name.data(), name.length()) != 0)) {
+        return 0;
+    }
+    return &entry;
+}
+
+bool PakArchive::isDirectory(const string& name) const {
+    return _directories.find(name) != _directories.end();
+}
+
+const vector<string>* PakArchive::getChildren(const string& dirName) const {
+    hash_map<string, vector<string>, hash<string>>::const_iterator i = _directories.find(dirName);
+    if (i == _directories.end()) {
+        return 0;
+    }
+    return &i->second;
+}
+
+ResourceView* PakArchive::getView(const string& name) const {
+    const PakEntry* entry = find(name);
+    if (!entry) {
+        return 0;
+    }
+    return getView(*entry, name);
+}
+
+ResourceView* PakArchive::getView(const PakEntry& entry, const string& name) const {
+    const char* stored = getStored(entry);
+    ResourceView* view = new ResourceView(name);
+
+    if (entry.flags & PAK_ENTRY_COMPRESSED) {
+        view->_buffer.resize((size_t)entry.size);
+        uLongf inflatedSize = (uLongf)entry.size;
+        int result = uncompress((Bytef*)view->_buffer.data(), &inflatedSize, (const Bytef*)stored,
+                                (uLong)entry.storedSize);
+        if ((result != Z_OK) || (inflatedSize != entry.size)) {
+            LOG_ERROR << "Unable to inflate " << name << " from " << _fileName << endl;
+            delete view;
+            return 0;
+        }
+        view->borrow(view->_buffer.data(), view->_buffer.size());
+    } else {
+        view->borrow(stored, (size_t)entry.size);
+    }
+    return view;
+}
+
+bool PakArchive::verify(void) const {
+    bool ok = true;
+    for (uint32_t i = 0; i < _header->numEntries; i++) {
+        const PakEntry& entry = _entries[i];
+        string name(_names + entry.nameOffset, entry.nameLength);
+        ResourceView* view = getView(entry, name);
+        if (!view) {
+            ok = false;
+            continue;
+        }
+        if (crc32(0, (const Bytef*)view->data(), (uInt)view->size()) != entry.crc) {
+            LOG_ERROR << "Checksum mismatch for " << name << " in " << _fileName << endl;
+            ok = false;
+        }
+        delete view;
+    }
+    return ok;
+}
+
+//--------------------------------------------------------------------------
+//PhysFS archiver
+
+//Streams read straight from the pak. Stored entries are copied out of the
+//mapping, deflated ones are inflated as they are read, so a streamed
+//soundtrack starts playing without inflating the whole file first.
+struct PakFile {
+    PakArchive* pak;
+    const PakEntry* entry;
+    string name;
+    const char* stored;
+    PHYSFS_uint64 pos;
+    bool compressed;
+    z_stream stream;
+};
+
+//zlib counts in uInt
+const PHYSFS_uint64 MAX_INFLATE_CHUNK = 1 << 30;
+const size_t SKIP_BUFFER_SIZE = 16 * 1024;
+
+static PHYSFS_Io* createPakIo(PakArchive* pak, const PakEntry* entry, const char* name);
+
+static bool startInflate(PakFile* file) {
+    memset(&file->stream, 0, sizeof(file->stream));
+    file->stream.next_in = (Bytef*)file->stored;
+    file->stream.avail_in = (uInt)file->entry->storedSize;
+    return inflateInit(&file->stream) == Z_OK;
+}
+
+static bool inflateBytes(PakFile* file, char* buf, PHYSFS_uint64 len) {
+    z_stream& stream = file->stream;
+    while (len > 0) {
+        PHYSFS_uint64 chunk = (len < MAX_INFLATE_CHUNK) ? len : MAX_INFLATE_CHUNK;
+        stream.next_out = (Bytef*)buf;
+        stream.avail_out = (uInt)chunk;
+        while (stream.avail_out > 0) {
+            int result = inflate(&stream, Z_NO_FLUSH);
+            if ((result != Z_OK) && ((result != Z_STREAM_END) || (stream.avail_out > 0))) {
+                LOG_ERROR << "Unable to inflate " << file->name << " from " << file->pak->getFileName() << endl;
+                return false;
+            }
+        }
+        buf += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+static PHYSFS_sint64 pakIo_read(PHYSFS_Io* io, void* buf, PHYSFS_uint64 len) {
+    PakFile* file = (PakFile*)io->opaque;
+    PHYSFS_uint64 remaining = file->entry->size - file->pos;
+    if (len > remaining) {
+        len = remaining;
+    }
+    if (!file->compressed) {
+        memcpy(buf, file->stored + file->pos, (size_t)len);
+    } else if (!inflateBytes(file, (char*)buf, len)) {
+        PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+        return -1;
+    }
+    file->pos += len;
+    return (PHYSFS_sint64)len;
+}
+
+static PHYSFS_sint64 pakIo_write(PHYSFS_Io*, const void*, PHYSFS_uint64) {
+    PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+    return -1;
+}
+
+static int pakIo_seek(PHYSFS_Io* io, PHYSFS_uint64 offset) {
+    PakFile* file = (PakFile*)io->opaque;
+    if (offset > file->entry->size) {
+        PHYSFS_setErrorCode(PHYSFS_ERR_PAST_EOF);
+        return 0;
+    }
+    if (!file->compressed) {
+        file->pos = offset;
+        return 1;
+    }
+
+    //deflate streams only go forward, start over for seeks back
+    if (offset < file->pos) {
+        if (inflateReset(&file->stream) != Z_OK) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+            return 0;
+        }
+        file->stream.next_in = (Bytef*)file->stored;
+        file->stream.avail_in = (uInt)file->entry->storedSize;
+        file->pos = 0;
+    }
+    char skipped[SKIP_BUFFER_SIZE];
+    while (file->pos < offset) {
+        PHYSFS_uint64 len = offset - file->pos;
+        if (len > sizeof(skipped)) {
+            len = sizeof(skipped);
+        }
+        if (pakIo_read(io, skipped, len) != (PHYSFS_sint64)len) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static PHYSFS_sint64 pakIo_tell(PHYSFS_Io* io) {
+    return (PHYSFS_sint64)((PakFile*)io->opaque)->pos;
+}
+
+static PHYSFS_sint64 pakIo_length(PHYSFS_Io* io) {
+    return (PHYSFS_sint64)((PakFile*)io->opaque)->entry->size;
+}
+
+static PHYSFS_Io* pakIo_duplicate(PHYSFS_Io* io) {
+    PakFile* file = (PakFile*)io->opaque;
+    return createPakIo(file->pak, file->entry, file->name.c_str());
+}
+
+static int pakIo_flush(PHYSFS_Io*) {
+    return 1;
+}
+
+static void pakIo_destroy(PHYSFS_Io* io) {
+    PakFile* file = (PakFile*)io->opaque;
+    if (file->compressed) {
+        inflateEnd(&file->stream);
+    }
+    delete file;
+    delete io;
+}
+
+static PHYSFS_Io* createPakIo(PakArchive* pak, const PakEntry* entry, const char* name) {
+    PakFile* file = new PakFile;
+    file->pak = pak;
+    file->entry = entry;
+    file->name = name;
+    file->stored = pak->getStored(*entry);
+    file->pos = 0;
+    file->compressed = (entry->flags & PAK_ENTRY_COMPRESSED) != 0;
+    if (file->compressed && !startInflate(file)) {
+        LOG_ERROR << "Unable to inflate " << name << " from " << pak->getFileName() << endl;
+        delete file;
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        return 0;
+    }
+
+    PHYSFS_Io* io = new PHYSFS_Io;
+    io->version = 0;
+    io->opaque = file;
+    io->read = pakIo_read;
+    io->write = pakIo_write;
+    io->seek = pakIo_seek;
+    io->tell = pakIo_tell;
+    io->length = pakIo_length;
+    io->duplicate = pakIo_duplicate;
+    io->flush = pakIo_flush;
+    io->destroy = pakIo_destroy;
+    return io;
+}
+
+static void* pak_openArchive(PHYSFS_Io* io, const char* name, int forWrite, int* claimed) {
+    char magic[sizeof(PAK_MAGIC)];
+    if ((io->read(io, magic, sizeof(magic)) != (PHYSFS_sint64)sizeof(magic)) ||
+        (memcmp(magic, PAK_MAGIC, sizeof(magic)) != 0)) {
+        PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+        return 0;
+    }
+    *claimed = 1;
+
+    if (forWrite) {
+        PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+        return 0;
+    }
+
+    //the archive is mapped by file name, so only native files can be mounted
+    PakArchive* pak = PakArchive::acquire(name);
+    if (!pak) {
+        PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+        return 0;
+    }
+    io->destroy(io);
+    return pak;
+}
+
+static PHYSFS_EnumerateCallbackResult pak_enumerate(void* opaque, const char* dirname, PHYSFS_EnumerateCallback cb,
+                                                    const char* origdir, void* callbackdata) {
+    const vector<string>* children = ((PakArchive*)opaque)->getChildren(dirname);
+    if (!children) {
+        return PHYSFS_ENUM_OK;
+    }
+    for (size_t i = 0; i < children->size(); i++) {
+        PHYSFS_EnumerateCallbackResult result = cb(callbackdata, origdir, (*children)[i].c_str());
+        if (result == PHYSFS_ENUM_ERROR) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_APP_CALLBACK);
+            return PHYSFS_ENUM_ERROR;
+        }
+        if (result == PHYSFS_ENUM_STOP) {
+            return PHYSFS_ENUM_STOP;
+        }
+    }
+    return PHYSFS_ENUM_OK;
+}
+
+static PHYSFS_Io* pak_openRead(void* opaque, const char* fileName) {
+    PakArchive* pak = (PakArchive*)opaque;
+    const PakEntry* entry = pak->find(fileName);
+    if (!entry) {
+        PHYSFS_setErrorCode(pak->isDirectory(fileName) ? PHYSFS_ERR_NOT_A_FILE : PHYSFS_ERR_NOT_FOUND);
+        return 0;
+    }
+    return createPakIo(pak, entry, fileName);
+}
+
+static PHYSFS_Io* pak_openWrite(void*, const char*) {
+    PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+    return 0;
+}
+
+static int pak_remove(void*, const char*) {
+    PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+    return 0;
+}
+
+static int pak_stat(void* opaque, const char* fileName, PHYSFS_Stat* stat) {
+    PakArchive* pak = (PakArchive*)opaque;
+    stat->modtime = -1;
+    stat->createtime = -1;
+    stat->accesstime = -1;
+    stat->readonly = 1;
+
+    const PakEntry* entry = pak->find(fileName);
+    if (entry) {
+        stat->filesize = (PHYSFS_sint64)entry->size;
+        stat->filetype = PHYSFS_FILETYPE_REGULAR;
+        return 1;
+    }
+    if (pak->isDirectory(fileName)) {
+        stat->filesize = 0;
+        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+        return 1;
+    }
+    PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+    return 0;
+}
+
+static void pak_closeArchive(void* opaque) {
+    ((PakArchive*)opaque)->release();
+}
+
+bool PakArchive::registerArchiver(void) {
+    static PHYSFS_Archiver archiver;
+    archiver.version = 0;
+    archiver.info.extension = "DAT";
+    archiver.info.description = "Shaaft packed resources";
+    archiver.info.author = "Frank Becker";
+    archiver.info.url = "https://mooflu.com";
+    archiver.info.supportsSymlinks = 0;
+    archiver.openArchive = pak_openArchive;
+    archiver.enumerate = pak_enumerate;
+    archiver.openRead = pak_openRead;
+    archiver.openWrite = pak_openWrite;
+    archiver.openAppend = pak_openWrite;
+    archiver.remove = pak_remove;
+    archiver.mkdir = pak_remove;
+    archiver.stat = pak_stat;
+    archiver.closeArchive = pak_closeArchive;
+
+    if (!PHYSFS_registerArchiver(&archiver)) {
+        LOG_ERROR << "Unable to register pak archiver: " << PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()) << endl;
+        return false;
+    }
+    return true;
+}
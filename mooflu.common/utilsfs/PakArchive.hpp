@@ -0,0 +1,66 @@
+#pragma once
+// Description:
+//   Reader for packed resource files (see PakFormat.hpp). The file is mapped
+//   once and entries are found through a hash of their path.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include <string>
+#include <list>
+#include <vector>
+
+#include "hashMap.hpp"
+#include "PakFormat.hpp"
+#include "ResourceView.hpp"
+
+class PakArchive {
+public:
+    //Open (or share an already open) pak file. Returns 0 if fileName is not a pak.
+    static PakArchive* acquire(const std::string& fileName);
+    void release(void);
+
+    //Let PhysFS mount pak files so streams and directory listings work as well.
+    static bool registerArchiver(void);
+
+    //name relative to the pak root, without leading slash
+    const PakEntry* find(const std::string& name) const;
+    bool isDirectory(const std::string& name) const;
+
+    //Entry data, inflated if needed. Returns 0 on error. Checksums are not
+    //checked here, that would touch every byte of mapped entries.
+    ResourceView* getView(const std::string& name) const;
+    ResourceView* getView(const PakEntry& entry, const std::string& name) const;
+
+    //entry data as stored in the pak
+    const char* getStored(const PakEntry& entry) const { return _file->data() + entry.offset; }
+
+    //Check the crc of every entry, e.g. right after packing. Logs mismatches.
+    bool verify(void) const;
+
+    //files and directories directly below dirName
+    const std::vector<std::string>* getChildren(const std::string& dirName) const;
+
+    const std::string& getFileName(void) const { return _fileName; }
+
+    uint32_t getNumEntries(void) const { return _header->numEntries; }
+
+private:
+    PakArchive(const std::string& fileName, ResourceView* file);
+    ~PakArchive();
+    PakArchive(const PakArchive&);
+    PakArchive& operator=(const PakArchive&);
+
+    bool readIndex(void);
+    void addToDirectory(const std::string& path);
+
+    std::string _fileName;
+    int _refCount;
+
+    ResourceView* _file;
+    const PakHeader* _header;
+    const PakEntry* _entries;
+    const char* _names;
+
+    hash_map<uint64_t, uint32_t> _lookup;
+    hash_map<std::string, std::vector<std::string>, hash<std::string>> _directories;
+};
@@ -0,0 +1,57 @@
+#pragma once
+// Description:
+//   On-disk layout of packed resource files (resource.dat).
+//
+//   [PakHeader][entry data, each aligned][PakEntry index sorted by hash][names]
+//
+//   All values are little endian. Entries are located through the index,
+//   there are no directory records.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include <stdint.h>
+#include <string.h>
+
+const char PAK_MAGIC[4] = {'M', 'P', 'A', 'K'};
+const uint32_t PAK_VERSION = 1;
+const uint32_t PAK_DEFAULT_ALIGNMENT = 64;
+
+//entry data is zlib compressed, size is the inflated size
+const uint32_t PAK_ENTRY_COMPRESSED = 1;
+
+#pragma pack(push, 1)
+struct PakHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t alignment;
+    uint32_t numEntries;
+    uint64_t indexOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+};
+
+struct PakEntry {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t flags;
+    uint32_t crc;  //crc32 of the uncompressed data
+};
+#pragma pack(pop)
+
+//FNV-1a, paths are stored without a leading slash
+inline uint64_t pakHash(const char* path, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline bool isPakHeader(const void* data, size_t size) {
+    return (size >= sizeof(PakHeader)) && (memcmp(data, PAK_MAGIC, sizeof(PAK_MAGIC)) == 0);
+}
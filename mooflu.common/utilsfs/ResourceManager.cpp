@@ -4,18 +4,27 @@
 // Copyright (C) 2011 Frank Becker
 //
 #include "ResourceManager.hpp"
+#include "PakArchive.hpp"
 #include "GetDataPath.hpp"
 #include "Trace.hpp"
+#include "Profiler.hpp"
 
 #include <physfs.h>
 
+#include <atomic>
+
 #ifndef _MSC_VER
 #include <unistd.h>
 #else
 #include <direct.h>
 #endif
+#ifdef WIN32
+#include <windows.h>
+#endif
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <stdio.h>
+#include <string.h>
 
 using namespace std;
 
@@ -23,21 +32,20 @@ static void output_archivers(void) {
     const PHYSFS_ArchiveInfo** rc = PHYSFS_supportedArchiveTypes();
     const PHYSFS_ArchiveInfo** i;
 
-    printf("Supported archive types:\n");
+    //debug only, a screenful of console output on every start
+    LOG_DEBUG << "Supported archive types:" << endl;
     if (*rc == NULL) {
-        printf(" * Apparently, NONE!\n");
+        LOG_DEBUG << " * Apparently, NONE!" << endl;
     } else {
         for (i = rc; *i != NULL; i++) {
-            printf(" * %s: %s\n    Written by %s.\n    %s\n", (*i)->extension, (*i)->description, (*i)->author,
-                   (*i)->url);
-            printf("    %s symbolic links.\n", (*i)->supportsSymlinks ? "Supports" : "Does not support");
+            LOG_DEBUG << " * " << (*i)->extension << ": " << (*i)->description << " (" << (*i)->author << ", "
+                      << (*i)->url << ")" << (((*i)->supportsSymlinks) ? ", supports symbolic links" : "") << endl;
         } /* for */
     }     /* else */
-
-    printf("\n");
 } /* output_archivers */
 
-ResourceManager::ResourceManager(void) {
+ResourceManager::ResourceManager(void) :
+    _paks() {
     const char* argv0 = 0;
 #if defined(EMSCRIPTEN)
     argv0 = "/dummy";
@@ -45,12 +53,16 @@ ResourceManager::ResourceManager(void) {
     if (PHYSFS_init(argv0) == 0) {
         LOG_ERROR << "Failed in initialize PHYSFS\n";
     } else {
+        PakArchive::registerArchiver();
         output_archivers();
     }
 }
 
 ResourceManager::~ResourceManager() {
     dump();
+    for (list<PakMount>::iterator i = _paks.begin(); i != _paks.end(); i++) {
+        i->pak->release();
+    }
     PHYSFS_deinit();
 }
 
@@ -65,7 +77,55 @@ void ResourceManager::dump(void) {
 }
 
 bool ResourceManager::addResourceBundle(const string& bundle, const string& mountPoint) {
-    return PHYSFS_mount(bundle.c_str(), mountPoint.c_str(), 1) != 0;
+    if (PHYSFS_mount(bundle.c_str(), mountPoint.c_str(), 1) == 0) {
+        return false;
+    }
+
+    //shares the archive PhysFS just opened
+    PakArchive* pak = PakArchive::acquire(bundle);
+    if (pak) {
+        PakMount mount;
+        mount.pak = pak;
+        mount.mountPoint = mountPoint;
+        while (!mount.mountPoint.empty() && (mount.mountPoint[0] == '/')) {
+            mount.mountPoint.erase(0, 1);
+        }
+        if (!mount.mountPoint.empty() && (mount.mountPoint[mount.mountPoint.length() - 1] != '/')) {
+            mount.mountPoint += "/";
+        }
+        _paks.push_back(mount);
+    }
+    return true;
+}
+
+const PakEntry* ResourceManager::findPacked(const string& name, PakArchive*& pak) {
+    if (_paks.empty()) {
+        return 0;
+    }
+
+    string::size_type start = name.find_first_not_of('/');
+    if (start == string::npos) {
+        return 0;
+    }
+    for (list<PakMount>::iterator i = _paks.begin(); i != _paks.end(); i++) {
+        const string& mountPoint = i->mountPoint;
+        if (name.compare(start, mountPoint.length(), mountPoint) != 0) {
+            continue;
+        }
+        const PakEntry* entry = i->pak->find(name.substr(start + mountPoint.length()));
+        if (!entry) {
+            continue;
+        }
+        //use the index only if PhysFS would read this pak too, files in the
+        //write dir or in directories mounted earlier override it
+        const char* realDir = PHYSFS_getRealDir(name.c_str());
+        if (!realDir || (i->pak->getFileName() != realDir)) {
+            return 0;
+        }
+        pak = i->pak;
+        return entry;
+    }
+    return 0;
 }
 
 void ResourceManager::setWriteDirectory(const string& writeDir) {
@@ -87,7 +147,53 @@ void ResourceManager::setWriteDirectory(const string& writeDir) {
     dump();
 }
 
+bool ResourceManager::makeDirectory(const string& dirName) {
+    if (PHYSFS_mkdir(dirName.c_str()) == 0) {
+        LOG_ERROR << "Unable to create directory " << dirName << ": "
+                  << PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()) << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool ResourceManager::replaceFile(const string& name, const string& data) {
+    //own temp file per call, several threads may replace the same file
+    static atomic<unsigned int> tempCount(0);
+    string tempName = name + "." + to_string(tempCount++) + ".tmp";
+    PHYSFS_File* outfile = PHYSFS_openWrite(tempName.c_str());
+    if (!outfile) {
+        LOG_ERROR << "Unable to write " << tempName << "\n";
+        return false;
+    }
+    bool ok = (PHYSFS_writeBytes(outfile, data.data(), data.size()) == (PHYSFS_sint64)data.size());
+    ok = PHYSFS_close(outfile) && ok;
+    if (!ok) {
+        LOG_ERROR << "Unable to write " << tempName << "\n";
+        PHYSFS_delete(tempName.c_str());
+        return false;
+    }
+
+    //PhysFS can't rename, that needs the real paths
+    string dir = string(PHYSFS_getWriteDir()) + PHYSFS_getDirSeparator();
+    string from = dir + tempName;
+    string to = dir + name;
+#ifdef WIN32
+    ok = (MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+    ok = (rename(from.c_str(), to.c_str()) == 0);
+#endif
+    if (!ok) {
+        LOG_ERROR << "Unable to replace " << name << "\n";
+        PHYSFS_delete(tempName.c_str());
+    }
+    return ok;
+}
+
 bool ResourceManager::hasResource(const string& name) {
+    PakArchive* pak;
+    if (findPacked(name, pak)) {
+        return true;
+    }
     return PHYSFS_exists(name.c_str());
 }
 
@@ -103,14 +209,17 @@ void ResourceManager::getFiles(const string& dirName, list<string>& results) {
 }
 
 int ResourceManager::getResourceSize(const string& name) {
-    PHYSFS_File* physFile = PHYSFS_openRead(name.c_str());
-    if (!physFile) {
-        return -1;
+    PakArchive* pak;
+    const PakEntry* entry = findPacked(name, pak);
+    if (entry) {
+        return (int)entry->size;
     }
 
-    int size = (int)PHYSFS_fileLength(physFile);
-    PHYSFS_close(physFile);
-    return size;
+    PHYSFS_Stat statInfo;
+    if (!PHYSFS_stat(name.c_str(), &statInfo) || (statInfo.filetype != PHYSFS_FILETYPE_REGULAR)) {
+        return -1;
+    }
+    return (int)statInfo.filesize;
 }
 
 ziStream* ResourceManager::getInputStream(const string& name) {
@@ -119,3 +228,49 @@ ziStream* ResourceManager::getInputStream(const string& name) {
     }
     return new ziStream(name);
 }
+
+ResourceView* ResourceManager::getResourceView(const string& name) {
+    PROFILE_ZONE_DETAIL("ResourceManager::getResourceView", name);
+    PakArchive* pak;
+    ResourceView* view = 0;
+    const PakEntry* entry = findPacked(name, pak);
+    if (entry) {
+        view = pak->getView(*entry, name);
+    } else if (PHYSFS_exists(name.c_str())) {
+        view = new ResourceView(name);
+        if (!readView(view)) {
+            delete view;
+            view = 0;
+        }
+    }
+
+    //files written by zoStream with compress, ziStream inflates them too
+    if (view && !view->inflateGzip()) {
+        delete view;
+        view = 0;
+    }
+    return view;
+}
+
+bool ResourceManager::readView(ResourceView* view) {
+    const string& name = view->getName();
+
+    //files in a mounted directory can be mapped directly, archives need PhysFS
+    const char* realDir = PHYSFS_getRealDir(name.c_str());
+    struct stat statInfo;
+    if (realDir && (stat(realDir, &statInfo) == 0) && (statInfo.st_mode & S_IFDIR)) {
+        string path = name;
+        const char* mountPoint = PHYSFS_getMountPoint(realDir);
+        if (mountPoint && (path.compare(0, strlen(mountPoint), mountPoint) == 0)) {
+            path = path.substr(strlen(mountPoint));
+        }
+        if (!path.empty() && (path[0] == '/')) {
+            path = path.substr(1);
+        }
+        if (view->map(string(realDir) + "/" + path)) {
+            return true;
+        }
+    }
+
+    return view->read();
+}
@@ -9,18 +9,38 @@
 
 #include "Singleton.hpp"
 #include "zStream.hpp"
+#include "ResourceView.hpp"
+
+class PakArchive;
+struct PakEntry;
 
 class ResourceManager {
     friend class Singleton<ResourceManager>;
 
 public:
+    //Packed (.dat) bundles are also indexed directly. Names still resolve in
+    //PhysFS search order, the index is only used if the pak provides the file.
     bool addResourceBundle(const std::string& bundle, const std::string& mountPoint);
     void setWriteDirectory(const std::string& writeDir);
 
+    //create directory (and parents) inside the write directory
+    bool makeDirectory(const std::string& dirName);
+
+    //Replace a file in the write directory: data goes to a temp file that
+    //is renamed over the old one, so a crash leaves one or the other intact
+    //(and maybe a stray NAME.N.tmp). Concurrent replaces: the last one wins.
+    //The file must not be open (or mapped) on Windows.
+    bool replaceFile(const std::string& name, const std::string& data);
+
     bool hasResource(const std::string& name);
     int getResourceSize(const std::string& name);
     ziStream* getInputStream(const std::string& name);
 
+    //Whole resource in memory without stream copies. Mapped if the file
+    //lives in a plain directory, gzip files are inflated. Returns 0 if the
+    //resource doesn't exist or can't be read.
+    ResourceView* getResourceView(const std::string& name);
+
     void getFiles(const std::string& dirName, std::list<std::string>& results);
 
     void dump(void);
@@ -31,6 +51,17 @@ private:
 
     ResourceManager(void);
     ~ResourceManager();
+
+    struct PakMount {
+        PakArchive* pak;
+        std::string mountPoint;
+    };
+
+    const PakEntry* findPacked(const std::string& name, PakArchive*& pak);
+    //map or read an unpacked file
+    bool readView(ResourceView* view);
+
+    std::list<PakMount> _paks;
 };
 
 typedef Singleton<ResourceManager> ResourceManagerS;
@@ -0,0 +1,261 @@
+// Description:
+//   Read-only view of a whole resource. Files in plain directories are
+//   memory mapped, everything else is read into an owned buffer in one go.
+//   Gzip files (zoStream with compress) are inflated into the buffer.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "ResourceView.hpp"
+#include "Trace.hpp"
+
+#include <physfs.h>
+#include <zlib.h>
+
+#if !defined(_MSC_VER) && !defined(EMSCRIPTEN)
+#define HAVE_MMAP
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <stdio.h>
+
+using namespace std;
+
+ResourceView::ResourceView(const string& name) :
+    _name(name),
+    _data(0),
+    _size(0),
+    _mapAddress(0),
+    _mapLength(0),
+    _buffer() {}
+
+ResourceView::~ResourceView() {
+#ifdef HAVE_MMAP
+    if (_mapAddress) {
+        munmap(_mapAddress, _mapLength);
+    }
+#endif
+}
+
+bool ResourceView::map(const string& path) {
+#ifdef HAVE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat statInfo;
+    if ((fstat(fd, &statInfo) != 0) || (statInfo.st_size <= 0)) {
+        //empty files can't be mapped
+        close(fd);
+        return false;
+    }
+
+    void* address = mmap(0, (size_t)statInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    //the mapping stays valid after the descriptor is closed
+    close(fd);
+    if (address == MAP_FAILED) {
+        LOG_WARNING << "Unable to map " << path << ", reading instead\n";
+        return false;
+    }
+
+    _mapAddress = address;
+    _mapLength = (size_t)statInfo.st_size;
+    _data = (const char*)address;
+    _size = _mapLength;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ResourceView::read(void) {
+    PHYSFS_File* physFile = PHYSFS_openRead(_name.c_str());
+    if (!physFile) {
+        LOG_ERROR << "Unable to open file:" << _name << "\n";
+        return false;
+    }
+
+    PHYSFS_sint64 length = PHYSFS_fileLength(physFile);
+    if (length < 0) {
+        LOG_ERROR << "Unable to get size of " << _name << "\n";
+        PHYSFS_close(physFile);
+        return false;
+    }
+
+    _buffer.resize((size_t)length);
+    PHYSFS_sint64 bytesRead = 0;
+    if (length > 0) {
+        bytesRead = PHYSFS_readBytes(physFile, _buffer.data(), (PHYSFS_uint64)length);
+    }
+    PHYSFS_close(physFile);
+
+    if (bytesRead != length) {
+        LOG_ERROR << "Short read on " << _name << ": " << bytesRead << " of " << length << "\n";
+        _buffer.clear();
+        return false;
+    }
+
+    _data = _buffer.data();
+    _size = _buffer.size();
+    return true;
+}
+
+bool ResourceView::readFile(const string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    bool ok = (fseek(file, 0, SEEK_END) == 0);
+    long length = ok ? ftell(file) : -1;
+    if ((length < 0) || (fseek(file, 0, SEEK_SET) != 0)) {
+        fclose(file);
+        return false;
+    }
+
+    _buffer.resize((size_t)length);
+    size_t bytesRead = length ? fread(_buffer.data(), 1, (size_t)length, file) : 0;
+    fclose(file);
+
+    if (bytesRead != (size_t)length) {
+        LOG_ERROR << "Short read on " << path << ": " << bytesRead << " of " << length << "\n";
+        _buffer.clear();
+        return false;
+    }
+
+    _data = _buffer.data();
+    _size = _buffer.size();
+    return true;
+}
+
+void ResourceView::borrow(const char* data, size_t size) {
+    _data = data;
+    _size = size;
+}
+
+void ResourceView::skip(size_t bytes) {
+    if (bytes > _size) {
+        bytes = _size;
+    }
+    _data += bytes;
+    _size -= bytes;
+}
+
+bool ResourceView::inflateGzip(void) {
+    const unsigned char* in = (const unsigned char*)_data;
+    if ((_size < 2) || (in[0] != 0x1f) || (in[1] != 0x8b)) {
+        return true;
+    }
+
+    //the gzip trailer holds the uncompressed size (mod 4GB), a first guess
+    size_t guess = _size * 4;
+    if (_size >= 18) {
+        const unsigned char* trailer = in + _size - 4;
+        guess = (size_t)trailer[0] | ((size_t)trailer[1] << 8) | ((size_t)trailer[2] << 16) |
+                ((size_t)trailer[3] << 24);
+        //deflate can't do better than ~1:1032, don't trust a damaged trailer
+        if ((guess == 0) || (guess > _size * 1032)) {
+            guess = _size * 4;
+        }
+    }
+    vector<char> out(guess);
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = (Bytef*)in;
+    stream.avail_in = (uInt)_size;
+    //32K window with gzip header, same as zStreamBuffer
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        LOG_ERROR << "Unable to initialize inflate for " << _name << "\n";
+        return false;
+    }
+
+    int rc = Z_OK;
+    size_t produced = 0;
+    while (rc == Z_OK) {
+        if (produced == out.size()) {
+            out.resize(out.size() * 2);
+        }
+        stream.next_out = (Bytef*)out.data() + produced;
+        stream.avail_out = (uInt)(out.size() - produced);
+        rc = inflate(&stream, Z_NO_FLUSH);
+        produced = out.size() - stream.avail_out;
+        if ((rc == Z_BUF_ERROR) && (stream.avail_in > 0)) {
+            //only out of output space, grow and go on
+            rc = Z_OK;
+        }
+    }
+    inflateEnd(&stream);
+    if (rc != Z_STREAM_END) {
+        LOG_ERROR << "Unable to inflate " << _name << ": " << rc << "\n";
+        return false;
+    }
+    out.resize(produced);
+
+#ifdef HAVE_MMAP
+    if (_mapAddress) {
+        munmap(_mapAddress, _mapLength);
+        _mapAddress = 0;
+        _mapLength = 0;
+    }
+#endif
+    _buffer.swap(out);
+    _data = _buffer.data();
+    _size = _buffer.size();
+    return true;
+}
+
+ResourceView* ResourceView::fromFile(const string& path) {
+    ResourceView* view = new ResourceView(path);
+    if (!view->map(path) && !view->readFile(path)) {
+        delete view;
+        return 0;
+    }
+    return view;
+}
+
+ResourceViewStream::ViewBuffer::ViewBuffer(const char* data, size_t size) {
+    //the get area is never written to
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+}
+
+ResourceViewStream::ViewBuffer::pos_type ResourceViewStream::ViewBuffer::seekoff(off_type off,
+                                                                                 std::ios_base::seekdir dir,
+                                                                                 std::ios_base::openmode mode) {
+    off_type pos = off;
+    switch (dir) {
+        case std::ios_base::beg:
+            break;
+        case std::ios_base::cur:
+            pos += gptr() - eback();
+            break;
+        case std::ios_base::end:
+            pos += egptr() - eback();
+            break;
+        default:
+            return pos_type(off_type(-1));
+    }
+    return seekpos(pos_type(pos), mode);
+}
+
+ResourceViewStream::ViewBuffer::pos_type ResourceViewStream::ViewBuffer::seekpos(pos_type pos,
+                                                                                 std::ios_base::openmode) {
+    off_type offset = off_type(pos);
+    if ((offset < 0) || (offset > (egptr() - eback()))) {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + offset, egptr());
+    return pos;
+}
+
+ResourceViewStream::ResourceViewStream(const ResourceView& view) :
+    std::istream(0),
+    _viewBuffer(view.data(), view.size()) {
+    rdbuf(&_viewBuffer);
+}
@@ -0,0 +1,77 @@
+#pragma once
+// Description:
+//   Read-only view of a whole resource. Files in plain directories are
+//   memory mapped, everything else is read into an owned buffer in one go.
+//   Gzip files (zoStream with compress) are inflated into the buffer.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include <string>
+#include <vector>
+#include <istream>
+#include <streambuf>
+
+class ResourceView {
+    friend class ResourceManager;
+    friend class PakArchive;
+    friend class AssetCache;
+
+public:
+    ~ResourceView();
+
+    //View of a file outside of PhysFS, e.g. a pak file. Returns 0 on error.
+    static ResourceView* fromFile(const std::string& path);
+
+    const char* data(void) const { return _data; }
+
+    size_t size(void) const { return _size; }
+
+    bool isMapped(void) const { return _mapAddress != 0; }
+
+    const std::string& getName(void) const { return _name; }
+
+private:
+    ResourceView(const std::string& name);
+    ResourceView(const ResourceView&);
+    ResourceView& operator=(const ResourceView&);
+
+    bool map(const std::string& path);
+    bool read(void);
+    bool readFile(const std::string& path);
+
+    //points into memory owned by someone else (e.g. a mapped pak file)
+    void borrow(const char* data, size_t size);
+    //drop leading bytes, e.g. a file header
+    void skip(size_t bytes);
+    //replace gzip data (1f 8b header) with its inflated bytes, like ziStream
+    bool inflateGzip(void);
+
+    std::string _name;
+    const char* _data;
+    size_t _size;
+
+    void* _mapAddress;
+    size_t _mapLength;
+    std::vector<char> _buffer;
+};
+
+//istream reading straight from a ResourceView, for the text parsers
+class ResourceViewStream : public std::istream {
+public:
+    ResourceViewStream(const ResourceView& view);
+
+private:
+    ResourceViewStream(const ResourceViewStream&);
+    ResourceViewStream& operator=(const ResourceViewStream&);
+
+    class ViewBuffer : public std::streambuf {
+    public:
+        ViewBuffer(const char* data, size_t size);
+
+    protected:
+        virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode mode);
+        virtual pos_type seekpos(pos_type pos, std::ios_base::openmode mode);
+    };
+
+    ViewBuffer _viewBuffer;
+};
@@ -8,9 +8,9 @@
 
 #include <string>
 
-ziStream::ziStream(const std::string& fileName) :
+ziStream::ziStream(const std::string& fileName, int bufferSize) :
     std::istream(0),
-    _streambuf(new ziStreamBuffer(fileName)) {
+    _streambuf(new ziStreamBuffer(fileName, bufferSize)) {
     rdbuf(_streambuf);
 }
 
@@ -22,13 +22,17 @@ bool ziStream::isOK(void) {
     return _streambuf->isOK();
 }
 
+bool ziStream::isCompressed(void) {
+    return _streambuf->isCompressed();
+}
+
 int ziStream::fileSize(void) {
     return _streambuf->fileSize();
 }
 
-zoStream::zoStream(const std::string& fileName) :
+zoStream::zoStream(const std::string& fileName, bool compress, int bufferSize) :
     std::ostream(0),
-    _streambuf(new zoStreamBuffer(fileName)) {
+    _streambuf(new zoStreamBuffer(fileName, compress, bufferSize)) {
     rdbuf(_streambuf);
 }
 
@@ -39,3 +43,11 @@ zoStream::~zoStream() {
 bool zoStream::isOK(void) {
     return _streambuf->isOK();
 }
+
+bool zoStream::close(void) {
+    bool ok = good() && _streambuf->close();
+    if (!ok) {
+        setstate(std::ios_base::badbit);
+    }
+    return ok;
+}
@@ -7,15 +7,18 @@
 #include <iostream>
 #include <sstream>
 
+#include "zStreamBuffer.hpp"
+
 class ziStreamBuffer;
 class zoStreamBuffer;
 
 class ziStream : public std::istream {
 public:
-    ziStream(const std::string& fileName);
+    ziStream(const std::string& fileName, int bufferSize = kDefaultStreamBufferSize);
     ~ziStream();
 
     bool isOK(void);
+    bool isCompressed(void);
     int fileSize(void);
 
     std::string readAll() {
@@ -35,11 +38,16 @@ private:
 
 class zoStream : public std::ostream {
 public:
-    zoStream(const std::string& fileName);
+    //compress writes gzip, ziStream detects and inflates it on load
+    zoStream(const std::string& fileName, bool compress = false, int bufferSize = kDefaultStreamBufferSize);
     ~zoStream();
 
     bool isOK(void);
 
+    //Write everything out and close the file. The destructor does the same
+    //but can't report errors. Returns false (and sets badbit) on failure.
+    bool close(void);
+
 private:
     zoStream(void);
     zoStream(const zoStream&);
@@ -2,17 +2,30 @@
 #include "Trace.hpp"
 
 #include <physfs.h>
+#include <zlib.h>
 
-zoStreamBuffer::zoStreamBuffer(const std::string& fileName) :
+//windowBits for deflateInit2/inflateInit2: 32K window with gzip header
+const int GZIP_WINDOW_BITS = 15 + 16;
+
+zoStreamBuffer::zoStreamBuffer(const std::string& fileName, bool compress, int bufferSize) :
     _physFile(),
-    _isOK(_init(fileName)) {}
+    _buf(bufferSize),
+    _zstream(0),
+    _zbuf(),
+    _isOK(_init(fileName, compress)) {}
 
 zoStreamBuffer::~zoStreamBuffer() {
-    sync();
-    PHYSFS_close(_physFile);
+    if (_physFile) {
+        _flush(true);
+        PHYSFS_close(_physFile);
+    }
+    if (_zstream) {
+        deflateEnd(_zstream);
+        delete _zstream;
+    }
 }
 
-bool zoStreamBuffer::_init(const std::string& fileName) {
+bool zoStreamBuffer::_init(const std::string& fileName, bool compress) {
     _physFile = PHYSFS_openWrite(fileName.c_str());
     if (!_physFile) {
         LOG_ERROR << "File not found:" << fileName << "\n";
@@ -20,45 +33,112 @@ bool zoStreamBuffer::_init(const std::string& fileName) {
         return false;
     }
 
-    setp(_buf, _buf + kWriteBufferSize);
+    if (compress) {
+        _zstream = new z_stream;
+        _zstream->zalloc = Z_NULL;
+        _zstream->zfree = Z_NULL;
+        _zstream->opaque = Z_NULL;
+        if (deflateInit2(_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) !=
+            Z_OK) {
+            LOG_ERROR << "Unable to initialize deflate for " << fileName << "\n";
+            delete _zstream;
+            _zstream = 0;
+            return false;
+        }
+        _zbuf.resize(_buf.size());
+    }
+
+    setp(_buf.data(), _buf.data() + _buf.size());
     return true;
 }
 
-int zoStreamBuffer::overflow(int i) {
-    char c = (char)i;
+bool zoStreamBuffer::_deflate(int flush) {
+    //run until deflate has consumed all input and (when finishing) written the trailer
+    for (;;) {
+        _zstream->next_out = (Bytef*)_zbuf.data();
+        _zstream->avail_out = (uInt)_zbuf.size();
+        int result = deflate(_zstream, flush);
+        if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR)) {
+            LOG_ERROR << "deflate failed: " << result << "\n";
+            return false;
+        }
+
+        size_t produced = _zbuf.size() - _zstream->avail_out;
+        if (produced && (PHYSFS_writeBytes(_physFile, _zbuf.data(), produced) != (PHYSFS_sint64)produced)) {
+            return false;
+        }
 
-    if (pbase() == pptr()) {
-        return 0;
+        if (flush == Z_FINISH) {
+            if (result == Z_STREAM_END) {
+                return true;
+            }
+        } else if ((_zstream->avail_in == 0) && (_zstream->avail_out != 0)) {
+            return true;
+        }
     }
+}
 
+bool zoStreamBuffer::_flush(bool finish) {
     size_t size = pptr() - pbase();
-    PHYSFS_sint64 bytesWritten = PHYSFS_writeBytes(_physFile, pbase(), size);
-    if (bytesWritten <= 0) {
+    bool ok = true;
+    if (_zstream) {
+        _zstream->next_in = (Bytef*)pbase();
+        _zstream->avail_in = (uInt)size;
+        ok = _deflate(finish ? Z_FINISH : Z_NO_FLUSH);
+    } else if (size) {
+        ok = (PHYSFS_writeBytes(_physFile, pbase(), size) == (PHYSFS_sint64)size);
+    }
+    setp(_buf.data(), _buf.data() + _buf.size());
+    return ok;
+}
+
+bool zoStreamBuffer::close(void) {
+    if (!_physFile) {
+        return false;
+    }
+    bool ok = _flush(true);
+    ok = (PHYSFS_close(_physFile) != 0) && ok;
+    _physFile = 0;
+    return ok;
+}
+
+int zoStreamBuffer::overflow(int c) {
+    if (!_physFile || !_flush(false)) {
         return traits_type::eof();
     }
 
     if (c != traits_type::eof()) {
-        PHYSFS_sint64 bytesWritten = PHYSFS_writeBytes(_physFile, &c, 1);
-        if (bytesWritten <= 0) {
-            return traits_type::eof();
-        }
+        *pptr() = (char)c;
+        pbump(1);
     }
-
-    setp(_buf, _buf + bytesWritten);
-    return 0;
+    return traits_type::not_eof(c);
 }
 
 int zoStreamBuffer::sync(void) {
-    return overflow(traits_type::eof());
+    //compressed data is only finished on close, sync just hands input to deflate
+    if (!_physFile || !_flush(false)) {
+        return -1;
+    }
+    return 0;
 }
 
 //--------------------------------------------------------------------------
 
-ziStreamBuffer::ziStreamBuffer(const std::string& fileName) :
+ziStreamBuffer::ziStreamBuffer(const std::string& fileName, int bufferSize) :
     _physFile(),
+    _buf(bufferSize),
+    _zstream(0),
+    _zbuf(),
+    _zend(false),
+    _zpos(0),
+    _zsize(-1),
     _isOK(_init(fileName)) {}
 
 ziStreamBuffer::~ziStreamBuffer() {
+    if (_zstream) {
+        inflateEnd(_zstream);
+        delete _zstream;
+    }
     PHYSFS_close(_physFile);
 }
 
@@ -69,39 +149,196 @@ bool ziStreamBuffer::_init(const std::string& fileName) {
         LOG_ERROR << "PhysFS:" << PHYSFS_getLastErrorCode() << "\n";
         return false;
     }
+
+    //gzip files start with 1f 8b, anything else is read as is
+    unsigned char magic[2] = {0, 0};
+    PHYSFS_sint64 bytesRead = PHYSFS_readBytes(_physFile, magic, sizeof(magic));
+    PHYSFS_seek(_physFile, 0);
+    if ((bytesRead == sizeof(magic)) && (magic[0] == 0x1f) && (magic[1] == 0x8b)) {
+        if (!_initInflate()) {
+            LOG_ERROR << "Unable to initialize inflate for " << fileName << "\n";
+            return false;
+        }
+    }
+
+    setg(_buf.data(), _buf.data(), _buf.data());
+    return true;
+}
+
+bool ziStreamBuffer::_initInflate(void) {
+    //the gzip trailer holds the uncompressed size (mod 4GB)
+    PHYSFS_sint64 length = PHYSFS_fileLength(_physFile);
+    unsigned char trailer[4];
+    if ((length >= 18) && PHYSFS_seek(_physFile, (PHYSFS_uint64)length - 4) &&
+        (PHYSFS_readBytes(_physFile, trailer, sizeof(trailer)) == sizeof(trailer))) {
+        _zsize = (int64_t)trailer[0] | ((int64_t)trailer[1] << 8) | ((int64_t)trailer[2] << 16) |
+                 ((int64_t)trailer[3] << 24);
+    }
+    PHYSFS_seek(_physFile, 0);
+
+    _zstream = new z_stream;
+    _zstream->zalloc = Z_NULL;
+    _zstream->zfree = Z_NULL;
+    _zstream->opaque = Z_NULL;
+    _zstream->next_in = Z_NULL;
+    _zstream->avail_in = 0;
+    if (inflateInit2(_zstream, GZIP_WINDOW_BITS) != Z_OK) {
+        delete _zstream;
+        _zstream = 0;
+        return false;
+    }
+    _zbuf.resize(_buf.size());
     return true;
 }
 
 int ziStreamBuffer::fileSize(void) {
+    if (_zstream) {
+        return (int)_zsize;
+    }
     return (int)PHYSFS_fileLength(_physFile);
 }
 
+ziStreamBuffer::int_type ziStreamBuffer::_inflate(void) {
+    size_t produced = 0;
+    while (!_zend && (produced == 0)) {
+        if (_zstream->avail_in == 0) {
+            PHYSFS_sint64 bytesRead = PHYSFS_readBytes(_physFile, _zbuf.data(), _zbuf.size());
+            if (bytesRead <= 0) {
+                LOG_ERROR << "Unexpected end of compressed stream\n";
+                _zend = true;
+                break;
+            }
+            _zstream->next_in = (Bytef*)_zbuf.data();
+            _zstream->avail_in = (uInt)bytesRead;
+        }
+
+        _zstream->next_out = (Bytef*)_buf.data();
+        _zstream->avail_out = (uInt)_buf.size();
+        int result = inflate(_zstream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            _zend = true;
+        } else if ((result != Z_OK) && (result != Z_BUF_ERROR)) {
+            LOG_ERROR << "inflate failed: " << result << "\n";
+            _zend = true;
+        }
+        produced = _buf.size() - _zstream->avail_out;
+    }
+
+    if (produced == 0) {
+        return traits_type::eof();
+    }
+    setg(_buf.data(), _buf.data(), _buf.data() + produced);
+    _zpos += produced;
+
+    return traits_type::to_int_type(*gptr());
+}
+
+bool ziStreamBuffer::_rewind(void) {
+    if (!PHYSFS_seek(_physFile, 0) || (inflateReset(_zstream) != Z_OK)) {
+        return false;
+    }
+    _zstream->next_in = Z_NULL;
+    _zstream->avail_in = 0;
+    _zend = false;
+    _zpos = 0;
+    setg(_buf.data(), _buf.data(), _buf.data());
+    return true;
+}
+
 ziStreamBuffer::int_type ziStreamBuffer::underflow(void) {
     if (gptr() < egptr()) {
         return traits_type::to_int_type(*gptr());
     }
 
-    PHYSFS_sint64 bytesRead = PHYSFS_readBytes(_physFile, _buf, sizeof(_buf));
+    if (_zstream) {
+        return _inflate();
+    }
+
+    PHYSFS_sint64 bytesRead = PHYSFS_readBytes(_physFile, _buf.data(), _buf.size());
     if (bytesRead <= 0) {
         return traits_type::eof();
     }
-    setg(_buf, _buf, _buf + bytesRead);
+    setg(_buf.data(), _buf.data(), _buf.data() + bytesRead);
 
     return traits_type::to_int_type(*gptr());
 }
 
+std::streamsize ziStreamBuffer::xsgetn(char* s, std::streamsize n) {
+    if (_zstream) {
+        //goes through underflow
+        return std::streambuf::xsgetn(s, n);
+    }
+
+    //drain what's buffered, then read the rest straight into the caller's memory
+    std::streamsize buffered = egptr() - gptr();
+    if (buffered > n) {
+        buffered = n;
+    }
+    if (buffered > 0) {
+        traits_type::copy(s, gptr(), (size_t)buffered);
+        gbump((int)buffered);
+    }
+    if (buffered == n) {
+        return n;
+    }
+
+    PHYSFS_sint64 bytesRead = PHYSFS_readBytes(_physFile, s + buffered, (PHYSFS_uint64)(n - buffered));
+    if (bytesRead <= 0) {
+        return buffered;
+    }
+    return buffered + bytesRead;
+}
+
 ziStreamBuffer::pos_type ziStreamBuffer::seekpos(pos_type pos, std::ios_base::openmode) {
+    if (_zstream) {
+        //inflate can only go forward, seeking back starts over
+        int64_t target = static_cast<int64_t>(pos);
+        int64_t bufferStart = _zpos - (egptr() - eback());
+        if ((target < bufferStart) && !_rewind()) {
+            return pos_type(off_type(-1));
+        }
+        while (target > _zpos) {
+            setg(eback(), egptr(), egptr());
+            if (_inflate() == traits_type::eof()) {
+                return pos_type(off_type(-1));
+            }
+        }
+        bufferStart = _zpos - (egptr() - eback());
+        setg(eback(), eback() + (target - bufferStart), egptr());
+        return pos;
+    }
+
     if (PHYSFS_seek(_physFile, static_cast<PHYSFS_uint64>(pos)) == 0) {
         return pos_type(off_type(-1));
     }
 
-    setg(_buf, _buf, _buf);
+    setg(_buf.data(), _buf.data(), _buf.data());
     return pos;
 }
 
 ziStreamBuffer::pos_type ziStreamBuffer::seekoff(off_type off, std::ios_base::seekdir dir,
                                                  std::ios_base::openmode mode) {
     off_type pos = off;
+    if (_zstream) {
+        switch (dir) {
+            case std::ios_base::beg:
+                break;
+            case std::ios_base::cur:
+                pos += static_cast<off_type>(_zpos - (egptr() - gptr()));
+                if (off == 0) {
+                    return static_cast<pos_type>(pos);
+                }
+                break;
+            case std::ios_base::end:
+                pos += static_cast<off_type>(_zsize);
+                break;
+            default:
+                LOG_ERROR << "seekoff: unknown direction" << dir << "\n";
+                return pos_type(off_type(-1));
+        }
+        return seekpos(static_cast<pos_type>(pos), mode);
+    }
+
     PHYSFS_sint64 ptell = PHYSFS_tell(_physFile);
 
     switch (dir) {
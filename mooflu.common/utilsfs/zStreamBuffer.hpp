@@ -6,35 +6,55 @@
 //
 #include <string>
 #include <streambuf>
+#include <vector>
+#include <stdint.h>
 
 extern "C" {
 struct PHYSFS_File;
+struct z_stream_s;
 }
 
+const int kDefaultStreamBufferSize = 64 * 1024;
+
+//Reads plain files as is and inflates gzip files, detected by their header.
 class ziStreamBuffer : public std::streambuf {
     typedef int int_type;
 
 public:
-    ziStreamBuffer(const std::string& fileName);
+    ziStreamBuffer(const std::string& fileName, int bufferSize = kDefaultStreamBufferSize);
     ~ziStreamBuffer();
 
     bool isOK(void) { return _isOK; }
 
+    bool isCompressed(void) { return _zstream != 0; }
+
+    //uncompressed size
     int fileSize(void);
 
     void* getHandle(void) { return _physFile; }
 
 protected:
     virtual int_type underflow(void);
+    virtual std::streamsize xsgetn(char* s, std::streamsize n);
     virtual pos_type seekoff(off_type pos, std::ios_base::seekdir, std::ios_base::openmode);
     virtual pos_type seekpos(pos_type pos, std::ios_base::openmode);
 
 private:
-    static const int kReadBufferSize = 1024;
     PHYSFS_File* _physFile;
-    char _buf[kReadBufferSize];
+    std::vector<char> _buf;
+
+    //gzip input
+    z_stream_s* _zstream;
+    std::vector<char> _zbuf;
+    bool _zend;
+    //uncompressed offset of egptr()
+    int64_t _zpos;
+    int64_t _zsize;
 
     bool _init(const std::string& fileName);
+    bool _initInflate(void);
+    int_type _inflate(void);
+    bool _rewind(void);
     bool _isOK;
 
 private:
@@ -43,13 +63,17 @@ private:
     ziStreamBuffer& operator=(const ziStreamBuffer&);
 };
 
+//Writes plain files or, if compress is set, gzip files.
 class zoStreamBuffer : public std::streambuf {
 public:
-    zoStreamBuffer(const std::string& filename);
+    zoStreamBuffer(const std::string& filename, bool compress = false, int bufferSize = kDefaultStreamBufferSize);
     ~zoStreamBuffer();
 
     bool isOK(void) { return _isOK; }
 
+    //finish (gzip trailer) and close the file, false if anything failed
+    bool close(void);
+
     void* getHandle(void) { return _physFile; }
 
 protected:
@@ -57,11 +81,15 @@ protected:
     virtual int sync(void);
 
 private:
-    static const int kWriteBufferSize = 1024;
     PHYSFS_File* _physFile;
-    char _buf[kWriteBufferSize];
+    std::vector<char> _buf;
 
-    bool _init(const std::string& fileName);
+    z_stream_s* _zstream;
+    std::vector<char> _zbuf;
+
+    bool _init(const std::string& fileName, bool compress);
+    bool _flush(bool finish);
+    bool _deflate(int flush);
     bool _isOK;
 
 private:
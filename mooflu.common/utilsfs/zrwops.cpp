@@ -9,6 +9,11 @@
 #include "zStreamBuffer.hpp"
 
 #include <physfs.h>
+#include <string.h>
+
+#include <vector>
+
+#include "SDL_thread.h"
 
 Sint64 ziStream_seek(struct SDL_RWops* context, Sint64 offset, int whence) {
     PHYSFS_file* physFile = (PHYSFS_file*)context->hidden.unknown.data1;
@@ -55,6 +60,11 @@ int ziStream_close(struct SDL_RWops* context) {
 }
 
 SDL_RWops* RWops_from_ziStream(ziStream& zi) {
+    //the RWops reads the raw file handle, bypassing inflate
+    if (zi.isCompressed()) {
+        LOG_ERROR << "RWops_from_ziStream: compressed streams not supported\n";
+        return 0;
+    }
     PHYSFS_file* physFile = (PHYSFS_file*)((ziStreamBuffer*)zi.rdbuf())->getHandle();
     SDL_RWops* rwops;
 
@@ -68,3 +78,246 @@ SDL_RWops* RWops_from_ziStream(ziStream& zi) {
     }
     return (rwops);
 }
+
+//--------------------------------------------------------------------------
+
+//Read-ahead state for RWops_stream_from_PhysFS. Only the fill thread touches
+//the PhysFS file; the reader consumes from the ring buffer.
+struct PhysFSStream {
+    PHYSFS_File* physFile;
+    Sint64 fileLength;
+
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* cond;
+
+    std::vector<char> ring;
+    size_t head;       //ring index of the next byte for the reader
+    size_t count;      //bytes buffered
+    Sint64 position;   //file offset of the next byte for the reader
+    Sint64 seekTo;     //pending seek for the fill thread or -1
+    unsigned int generation;  //bumped on seek to drop in-flight reads
+    bool eof;
+    bool quit;
+};
+
+static const size_t kStreamChunkSize = 16 * 1024;
+
+//Read one chunk into the ring. Called with the lock held, returns with it held.
+static void PhysFSStream_fill(PhysFSStream* stream, std::vector<char>& chunk) {
+    if (stream->seekTo >= 0) {
+        PHYSFS_seek(stream->physFile, stream->seekTo);
+        stream->seekTo = -1;
+        stream->eof = false;
+    }
+
+    size_t space = stream->ring.size() - stream->count;
+    size_t toRead = space < kStreamChunkSize ? space : kStreamChunkSize;
+    unsigned int generation = stream->generation;
+
+    SDL_UnlockMutex(stream->lock);
+    PHYSFS_sint64 bytesRead = PHYSFS_readBytes(stream->physFile, chunk.data(), toRead);
+    SDL_LockMutex(stream->lock);
+
+    if (generation != stream->generation) {
+        //reader seeked while we were reading, data is stale
+        return;
+    }
+    if (bytesRead <= 0) {
+        stream->eof = true;
+        return;
+    }
+
+    size_t tail = (stream->head + stream->count) % stream->ring.size();
+    for (PHYSFS_sint64 i = 0; i < bytesRead; i++) {
+        stream->ring[tail] = chunk[i];
+        tail = (tail + 1) % stream->ring.size();
+    }
+    stream->count += (size_t)bytesRead;
+}
+
+static int PhysFSStream_thread(void* data) {
+    PhysFSStream* stream = (PhysFSStream*)data;
+    std::vector<char> chunk(kStreamChunkSize);
+
+    SDL_LockMutex(stream->lock);
+    while (!stream->quit) {
+        bool full = (stream->count == stream->ring.size());
+        if ((full || stream->eof) && (stream->seekTo < 0)) {
+            SDL_CondWait(stream->cond, stream->lock);
+            continue;
+        }
+        PhysFSStream_fill(stream, chunk);
+        SDL_CondBroadcast(stream->cond);
+    }
+    SDL_UnlockMutex(stream->lock);
+
+    return 0;
+}
+
+static Sint64 PhysFSStream_size(struct SDL_RWops* context) {
+    PhysFSStream* stream = (PhysFSStream*)context->hidden.unknown.data1;
+    return stream->fileLength;
+}
+
+static Sint64 PhysFSStream_seek(struct SDL_RWops* context, Sint64 offset, int whence) {
+    PhysFSStream* stream = (PhysFSStream*)context->hidden.unknown.data1;
+
+    SDL_LockMutex(stream->lock);
+    Sint64 target;
+    switch (whence) {
+        case RW_SEEK_SET:
+            target = offset;
+            break;
+        case RW_SEEK_CUR:
+            target = stream->position + offset;
+            break;
+        case RW_SEEK_END:
+            target = stream->fileLength + offset;
+            break;
+        default:
+            SDL_UnlockMutex(stream->lock);
+            return -1;
+    }
+    if ((target < 0) || (target > stream->fileLength)) {
+        SDL_UnlockMutex(stream->lock);
+        return -1;
+    }
+
+    Sint64 skip = target - stream->position;
+    if ((skip >= 0) && (skip <= (Sint64)stream->count)) {
+        //still buffered, just skip ahead
+        stream->head = (stream->head + (size_t)skip) % stream->ring.size();
+        stream->count -= (size_t)skip;
+    } else if (skip != 0) {
+        stream->head = 0;
+        stream->count = 0;
+        stream->seekTo = target;
+        stream->eof = false;
+        stream->generation++;
+    }
+    stream->position = target;
+
+    SDL_CondBroadcast(stream->cond);
+    SDL_UnlockMutex(stream->lock);
+
+    return target;
+}
+
+static size_t PhysFSStream_read(struct SDL_RWops* context, void* ptr, size_t size, size_t maxnum) {
+    PhysFSStream* stream = (PhysFSStream*)context->hidden.unknown.data1;
+    if (size == 0) {
+        return 0;
+    }
+
+    char* out = (char*)ptr;
+    size_t wanted = size * maxnum;
+    size_t copied = 0;
+
+    SDL_LockMutex(stream->lock);
+    while (copied < wanted) {
+        if (stream->count == 0) {
+            if (stream->eof && (stream->seekTo < 0)) {
+                break;
+            }
+            if (stream->thread) {
+                SDL_CondBroadcast(stream->cond);
+                SDL_CondWait(stream->cond, stream->lock);
+            } else {
+                //no fill thread (e.g. single threaded web build), read in place
+                std::vector<char> chunk(kStreamChunkSize);
+                PhysFSStream_fill(stream, chunk);
+            }
+            continue;
+        }
+
+        size_t n = wanted - copied;
+        if (n > stream->count) {
+            n = stream->count;
+        }
+        size_t untilWrap = stream->ring.size() - stream->head;
+        if (n > untilWrap) {
+            n = untilWrap;
+        }
+        memcpy(out + copied, &stream->ring[stream->head], n);
+        stream->head = (stream->head + n) % stream->ring.size();
+        stream->count -= n;
+        stream->position += n;
+        copied += n;
+    }
+    //wake the fill thread, there is space now
+    SDL_CondBroadcast(stream->cond);
+    SDL_UnlockMutex(stream->lock);
+
+    //partial items are dropped; SDL_mixer only reads bytes
+    return copied / size;
+}
+
+static size_t PhysFSStream_write(struct SDL_RWops*, const void*, size_t, size_t) {
+    LOG_ERROR << "Writing PhysFS stream not supported...\n";
+    return 0;
+}
+
+static int PhysFSStream_close(struct SDL_RWops* context) {
+    PhysFSStream* stream = (PhysFSStream*)context->hidden.unknown.data1;
+
+    if (stream->thread) {
+        SDL_LockMutex(stream->lock);
+        stream->quit = true;
+        SDL_CondBroadcast(stream->cond);
+        SDL_UnlockMutex(stream->lock);
+        SDL_WaitThread(stream->thread, 0);
+    }
+
+    PHYSFS_close(stream->physFile);
+    SDL_DestroyCond(stream->cond);
+    SDL_DestroyMutex(stream->lock);
+    delete stream;
+    SDL_FreeRW(context);
+
+    return 0;
+}
+
+SDL_RWops* RWops_stream_from_PhysFS(const std::string& fileName, int readAheadSize) {
+    PHYSFS_File* physFile = PHYSFS_openRead(fileName.c_str());
+    if (!physFile) {
+        LOG_ERROR << "Unable to open file:" << fileName << "\n";
+        LOG_ERROR << "PhysFS:" << PHYSFS_getLastErrorCode() << "\n";
+        return 0;
+    }
+
+    SDL_RWops* rwops = SDL_AllocRW();
+    if (!rwops) {
+        PHYSFS_close(physFile);
+        return 0;
+    }
+
+    PhysFSStream* stream = new PhysFSStream;
+    stream->physFile = physFile;
+    stream->fileLength = PHYSFS_fileLength(physFile);
+    stream->thread = 0;
+    stream->lock = SDL_CreateMutex();
+    stream->cond = SDL_CreateCond();
+    stream->ring.resize(readAheadSize > (int)kStreamChunkSize ? readAheadSize : kStreamChunkSize);
+    stream->head = 0;
+    stream->count = 0;
+    stream->position = 0;
+    stream->seekTo = -1;
+    stream->generation = 0;
+    stream->eof = false;
+    stream->quit = false;
+
+    rwops->size = PhysFSStream_size;
+    rwops->seek = PhysFSStream_seek;
+    rwops->read = PhysFSStream_read;
+    rwops->write = PhysFSStream_write;
+    rwops->close = PhysFSStream_close;
+    rwops->hidden.unknown.data1 = stream;
+
+    stream->thread = SDL_CreateThread(PhysFSStream_thread, "physfs-stream", stream);
+    if (!stream->thread) {
+        LOG_WARNING << "Streaming " << fileName << " without read-ahead thread: " << SDL_GetError() << "\n";
+    }
+
+    return rwops;
+}
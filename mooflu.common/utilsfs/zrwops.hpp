@@ -17,3 +17,7 @@
 #include "SDL_rwops.h"
 
 extern SDL_RWops* RWops_from_ziStream(ziStream& zi);
+
+//Open fileName via PhysFS for streaming. A background thread keeps up to
+//readAheadSize bytes buffered ahead of the reader. Closing the RWops closes the file.
+extern SDL_RWops* RWops_stream_from_PhysFS(const std::string& fileName, int readAheadSize = 256 * 1024);
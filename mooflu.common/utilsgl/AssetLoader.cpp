@@ -0,0 +1,254 @@
+// Description:
+//   Preloads bitmaps, fonts and models listed in a manifest. Files are read
+//   and decoded on worker threads, GL uploads happen on the calling thread.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include "AssetLoader.hpp"
+
+#include <memory>
+#include <sstream>
+
+#include "SDL.h"
+
+#include "Trace.hpp"
+#include "Profiler.hpp"
+#include "ResourceManager.hpp"
+#include "AssetCache.hpp"
+#include "BitmapManager.hpp"
+#include "FontManager.hpp"
+#include "ModelManager.hpp"
+
+using namespace std;
+
+const int MAX_LOADER_THREADS = 4;
+
+AssetLoader::AssetLoader(void) :
+    _jobs(),
+    _threads(),
+    _started(false),
+    _lock(SDL_CreateMutex()),
+    _decodedCond(SDL_CreateCond()),
+    _nextJob(0),
+    _decoded() {
+    XTRACE();
+}
+
+AssetLoader::~AssetLoader() {
+    XTRACE();
+    //started but never finished, let the workers run out
+    for (size_t i = 0; i < _threads.size(); i++) {
+        SDL_WaitThread(_threads[i], 0);
+    }
+    SDL_DestroyCond(_decodedCond);
+    SDL_DestroyMutex(_lock);
+}
+
+bool AssetLoader::loadManifest(const string& manifestName) {
+    XTRACE();
+    if (!ResourceManagerS::instance()->hasResource(manifestName)) {
+        LOG_WARNING << "Preload manifest [" << manifestName << "] not found." << endl;
+        return false;
+    }
+    std::shared_ptr<ziStream> infilePtr(ResourceManagerS::instance()->getInputStream(manifestName));
+    ziStream& infile = *infilePtr;
+
+    string line;
+    int linecount = 0;
+    while (!getline(infile, line).eof()) {
+        linecount++;
+        if (line.empty() || (line[0] == '#')) {
+            continue;
+        }
+
+        istringstream tokens(line);
+        string type;
+        string name;
+        tokens >> type >> name;
+        if (type.empty()) {
+            continue;
+        }
+
+        if (type == "bitmap") {
+            add(eBitmap, name);
+        } else if (type == "font") {
+            add(eFont, name);
+        } else if (type == "model") {
+            add(eModel, name);
+        } else if (type == "sample") {
+            //decoded by SampleManager
+        } else {
+            LOG_WARNING << manifestName << ":" << linecount << ": unknown asset type [" << type << "]" << endl;
+        }
+    }
+
+    LOG_INFO << "Preload manifest " << manifestName << ": " << _jobs.size() << " assets" << endl;
+    return true;
+}
+
+void AssetLoader::add(AssetType type, const string& name) {
+    Job job;
+    job.type = type;
+    job.name = name;
+    job.bitmap = 0;
+    job.font = 0;
+    job.model = 0;
+    _jobs.push_back(job);
+}
+
+int AssetLoader::workerThread(void* data) {
+    AssetLoader* loader = (AssetLoader*)data;
+    Profiler::SetThreadName("asset-loader");
+    loader->decodeJobs();
+    return 0;
+}
+
+void AssetLoader::decodeJobs(void) {
+    for (;;) {
+        SDL_LockMutex(_lock);
+        size_t jobIndex = _nextJob++;
+        SDL_UnlockMutex(_lock);
+
+        if (jobIndex >= _jobs.size()) {
+            break;
+        }
+
+        //each job is only touched by one worker until it is queued as decoded
+        Job& job = _jobs[jobIndex];
+        PROFILE_ZONE_DETAIL("AssetLoader::decode", job.name);
+        switch (job.type) {
+            case eBitmap:
+                job.bitmap = BitmapManagerS::instance()->decode(job.name);
+                break;
+            case eFont:
+                job.font = FontManagerS::instance()->decode(job.name);
+                break;
+            case eModel:
+                job.model = ModelManagerS::instance()->decode(job.name);
+                break;
+        }
+
+        SDL_LockMutex(_lock);
+        _decoded.push_back(jobIndex);
+        SDL_CondSignal(_decodedCond);
+        SDL_UnlockMutex(_lock);
+    }
+}
+
+bool AssetLoader::uploadJob(Job& job) {
+    PROFILE_ZONE_DETAIL("AssetLoader::upload", job.name);
+    switch (job.type) {
+        case eBitmap:
+            return job.bitmap && BitmapManagerS::instance()->addDecoded(job.name, job.bitmap);
+        case eFont:
+            return job.font && FontManagerS::instance()->addDecoded(job.name, job.font);
+        case eModel:
+            return ModelManagerS::instance()->addDecoded(job.name, job.model);
+    }
+    return false;
+}
+
+bool AssetLoader::run(AssetLoadObserverI* observer) {
+    XTRACE();
+    start();
+    return finish(observer);
+}
+
+void AssetLoader::start(void) {
+    XTRACE();
+    if (_started || _jobs.empty()) {
+        return;
+    }
+    _started = true;
+
+    //create singletons up front, Singleton<T>::instance is not thread safe
+    ResourceManagerS::instance();
+    AssetCacheS::instance();
+    BitmapManagerS::instance();
+    FontManagerS::instance();
+    ModelManagerS::instance();
+
+#ifndef IPHONE
+    //keep one core for the GL thread
+    int numThreads = SDL_GetCPUCount() - 1;
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    if (numThreads > MAX_LOADER_THREADS) {
+        numThreads = MAX_LOADER_THREADS;
+    }
+    if (numThreads > (int)_jobs.size()) {
+        numThreads = (int)_jobs.size();
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        SDL_Thread* thread = SDL_CreateThread(workerThread, "asset-loader", this);
+        if (!thread) {
+            LOG_WARNING << "Unable to create asset loader thread: " << SDL_GetError() << endl;
+            break;
+        }
+        _threads.push_back(thread);
+    }
+#endif
+    LOG_INFO << "Preloading " << _jobs.size() << " assets using " << _threads.size() << " threads" << endl;
+}
+
+bool AssetLoader::finish(AssetLoadObserverI* observer) {
+    XTRACE();
+    PROFILE_ZONE("AssetLoader::finish");
+    if (_jobs.empty()) {
+        return true;
+    }
+
+    start();
+    if (_threads.empty()) {
+        //no threads available (e.g. single threaded web build), decode in place
+        decodeJobs();
+    }
+
+    bool result = true;
+    int loaded = 0;
+    int total = (int)_jobs.size();
+    while (loaded < total) {
+        SDL_LockMutex(_lock);
+        while (_decoded.empty()) {
+            SDL_CondWait(_decodedCond, _lock);
+        }
+        deque<size_t> decoded;
+        decoded.swap(_decoded);
+        SDL_UnlockMutex(_lock);
+
+        for (size_t i = 0; i < decoded.size(); i++) {
+            Job& job = _jobs[decoded[i]];
+            if (!uploadJob(job)) {
+                LOG_ERROR << "Unable to preload " << job.name << endl;
+                result = false;
+            }
+            loaded++;
+
+            if (observer) {
+                observer->assetLoaded(job.name, loaded, total);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < _threads.size(); i++) {
+        SDL_WaitThread(_threads[i], 0);
+    }
+    _threads.clear();
+
+    _jobs.clear();
+    _nextJob = 0;
+    _started = false;
+
+    return result;
+}
@@ -0,0 +1,86 @@
+#pragma once
+// Description:
+//   Preloads bitmaps, fonts and models listed in a manifest. Files are read
+//   and decoded on worker threads, GL uploads happen on the calling thread.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include <string>
+#include <vector>
+#include <deque>
+
+#include "SDL_thread.h"
+
+class GLBitmapCollection;
+class GLBitmapFont;
+class Model;
+
+class AssetLoadObserverI {
+public:
+    //called on the GL thread after each asset has been uploaded
+    virtual void assetLoaded(const std::string& assetName, int loaded, int total) = 0;
+    virtual ~AssetLoadObserverI() {}
+};
+
+class AssetLoader {
+public:
+    enum AssetType {
+        eBitmap,
+        eFont,
+        eModel,
+    };
+
+    AssetLoader(void);
+    ~AssetLoader();
+
+    //Manifest lines: "bitmap|font|model <name>", '#' starts a comment.
+    //"sample" lines are left to SampleManager.
+    bool loadManifest(const std::string& manifestName);
+    void add(AssetType type, const std::string& name);
+
+    //Decode everything on a worker pool and upload as results arrive.
+    //Blocks until all assets are cached. Must be called on the GL thread.
+    bool run(AssetLoadObserverI* observer = 0);
+
+    //run split in two: start decoding (any thread, no GL needed, e.g.
+    //before the window exists), then upload on the GL thread
+    void start(void);
+    bool finish(AssetLoadObserverI* observer = 0);
+
+    int getTotal(void) { return (int)_jobs.size(); }
+
+private:
+    AssetLoader(const AssetLoader&);
+    AssetLoader& operator=(const AssetLoader&);
+
+    struct Job {
+        AssetType type;
+        std::string name;
+        GLBitmapCollection* bitmap;
+        GLBitmapFont* font;
+        Model* model;
+    };
+
+    static int workerThread(void* data);
+    void decodeJobs(void);
+    bool uploadJob(Job& job);
+
+    std::vector<Job> _jobs;
+    std::vector<SDL_Thread*> _threads;
+    bool _started;
+
+    //guards _nextJob and _decoded
+    SDL_mutex* _lock;
+    SDL_cond* _decodedCond;
+    size_t _nextJob;
+    std::deque<size_t> _decoded;
+};
@@ -43,13 +43,13 @@ void BitmapManager::reload(void) {
     }
 }
 
-GLBitmapCollection* BitmapManager::load(const string& bitmapName) {
+GLBitmapCollection* BitmapManager::decode(const string& bitmapName) {
     XTRACE();
     GLBitmapCollection* bitmap = new GLBitmapCollection();
 
     string bitmapData = bitmapName + ".data";
 
-    if (!bitmap->Load(bitmapName.c_str(), bitmapData.c_str())) {
+    if (!bitmap->decode(bitmapName.c_str(), bitmapData.c_str())) {
         LOG_ERROR << "Unable to load bitmap collection: " << bitmapName << endl;
         delete bitmap;
         bitmap = 0;
@@ -57,3 +57,8 @@ GLBitmapCollection* BitmapManager::load(const string& bitmapName) {
 
     return bitmap;
 }
+
+bool BitmapManager::upload(GLBitmapCollection* bitmap) {
+    XTRACE();
+    return bitmap->upload();
+}
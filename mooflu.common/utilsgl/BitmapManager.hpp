@@ -34,8 +34,10 @@ public:
     virtual void reload(void);
     virtual void reset(void);
 
+    virtual GLBitmapCollection* decode(const std::string& bitmapName);
+
 protected:
-    virtual GLBitmapCollection* load(const std::string& bitmap);
+    virtual bool upload(GLBitmapCollection* bitmap);
 
 private:
     BitmapManager(void);
@@ -43,14 +43,14 @@ void FontManager::reload(void) {
     }
 }
 
-GLBitmapFont* FontManager::load(const string& fontName) {
+GLBitmapFont* FontManager::decode(const string& fontName) {
     XTRACE();
     GLBitmapFont* font = new GLBitmapFont();
 
     string fontPNG = fontName + ".font";
     string fontData = fontName + ".data";
 
-    if (!font->Load(fontPNG.c_str(), fontData.c_str())) {
+    if (!font->decode(fontPNG.c_str(), fontData.c_str())) {
         LOG_ERROR << "Unable to load font: " << fontName << endl;
         delete font;
         return 0;
@@ -58,3 +58,8 @@ GLBitmapFont* FontManager::load(const string& fontName) {
 
     return font;
 }
+
+bool FontManager::upload(GLBitmapFont* font) {
+    XTRACE();
+    return font->upload();
+}
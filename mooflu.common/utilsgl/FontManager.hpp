@@ -27,8 +27,10 @@ public:
     virtual void reload(void);
     virtual void reset(void);
 
+    virtual GLBitmapFont* decode(const std::string& fontName);
+
 protected:
-    virtual GLBitmapFont* load(const std::string& font);
+    virtual bool upload(GLBitmapFont* font);
 
 private:
     FontManager(void);
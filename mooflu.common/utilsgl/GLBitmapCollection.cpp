@@ -17,11 +17,11 @@
 #include "GLBitmapCollection.hpp"
 
 #include "SDL_image.h"
-#include <zrwops.hpp>
 
 #include "Trace.hpp"
 #include "FindHash.hpp"
 #include "ResourceManager.hpp"
+#include "AssetCache.hpp"
 
 #include "gl3/ProgramManager.hpp"
 #include "gl3/Program.hpp"
@@ -31,7 +31,12 @@
 #include <memory>
 using namespace std;
 
+//Cached data file (kind "atlas"): BitmapInfo[], the count follows from the size
+static const uint32_t ATLAS_CACHE_VERSION = 1;
+
 GLBitmapCollection::GLBitmapCollection(void) :
+    _pendingImage(0),
+    _pendingSource(),
     _bitmapCollection(0),
     _bcNeedsCleanup(true),
     _bitmapCount(0),
@@ -45,6 +50,9 @@ GLBitmapCollection::GLBitmapCollection(void) :
 
 GLBitmapCollection::~GLBitmapCollection() {
     //Note: A bit of a hack for iphone where all bitmap collections are merged into a single collection
+    if (_pendingImage) {
+        SDL_FreeSurface(_pendingImage);
+    }
     if (_bcNeedsCleanup) {
         delete _bitmapCollection;
     }
@@ -60,7 +68,7 @@ void GLBitmapCollection::setColor(float r, float g, float b, float a) {
 }
 
 //Load bitmap
-bool GLBitmapCollection::LoadBitmapFile(const char* bitmapFile) {
+bool GLBitmapCollection::decodeBitmapFile(const char* bitmapFile) {
     XTRACE();
     SDL_Surface* img;
 
@@ -72,22 +80,23 @@ bool GLBitmapCollection::LoadBitmapFile(const char* bitmapFile) {
     }
 
     if (bmName != "") {
-        std::shared_ptr<ziStream> bminfilePtr(ResourceManagerS::instance()->getInputStream(bmName));
-        ziStream& bminfile = *bminfilePtr;
-
-        SDL_RWops* src = RWops_from_ziStream(bminfile);
-        img = IMG_LoadPNG_RW(src);
+        img = GLTexture::loadImage(bmName);
         if (!img) {
             LOG_ERROR << "Failed to load PNG image: [" << bmName << "]" << endl;
             return false;
         }
-        SDL_FreeRW(src);
+        _pendingSource = bmName;
     }
 #ifdef IPHONE
     else if (ResourceManagerS::instance()->hasResource(string(bitmapFile) + ".pvr")) {
         // pvr generated from png:
         // /Developer/Platforms/iPhoneOS.platform/usr/bin/texturetool -e PVRTC --bits-per-pixel-4 -p test.png -o a.pvr atlas.png
-        int compressedSize = ResourceManagerS::instance()->getResourceSize(string(bitmapFile) + ".pvr");
+        std::unique_ptr<ResourceView> pvrView(ResourceManagerS::instance()->getResourceView(string(bitmapFile) + ".pvr"));
+        if (!pvrView) {
+            LOG_ERROR << "Failed to load PVR image: [" << bitmapFile << "]" << endl;
+            return false;
+        }
+        int compressedSize = (int)pvrView->size();
 
         img = (SDL_Surface*)malloc(sizeof(SDL_Surface));
 
@@ -98,14 +107,7 @@ bool GLBitmapCollection::LoadBitmapFile(const char* bitmapFile) {
         img->pitch = 0;
         img->compressedSize = compressedSize;
         img->pixels = (char*)malloc(compressedSize);
-
-        int r = ResourceManagerS::instance()->readResource(img->pixels, compressedSize);
-        if (r != compressedSize) {
-            LOG_ERROR << "Failed to load PVR image: [" << bitmapFile << "]" << endl;
-            free(img->pixels);
-            free(img);
-            return false;
-        }
+        memcpy(img->pixels, pvrView->data(), compressedSize);
     }
 #endif
     else {
@@ -116,8 +118,20 @@ bool GLBitmapCollection::LoadBitmapFile(const char* bitmapFile) {
 
     //assuming texture is square
     _textureSize = (float)img->w;
+    _pendingImage = img;
 
-    _bitmapCollection = new GLTexture(GL_TEXTURE_2D, img, false);
+    return true;
+}
+
+bool GLBitmapCollection::upload(void) {
+    XTRACE();
+    if (_pendingImage) {
+        _bitmapCollection = new GLTexture(GL_TEXTURE_2D, _pendingImage, _pendingSource, false);
+        _pendingImage = 0;
+    }
+    if (!_bitmapCollection) {
+        return false;
+    }
 
     initVAO();
 
@@ -168,12 +182,12 @@ void GLBitmapCollection::initVAO() {
 
 //Load single bitmap
 bool GLBitmapCollection::Load(const char* bitmapFile) {
-    if (!LoadBitmapFile(bitmapFile)) {
+    if (!decodeBitmapFile(bitmapFile)) {
         return false;
     }
     BitmapInfo bInfo;
-    bInfo.width = _bitmapCollection->width();
-    bInfo.height = _bitmapCollection->height();
+    bInfo.width = _pendingImage->w;
+    bInfo.height = _pendingImage->h;
     bInfo.xoff = 0;
     bInfo.yoff = 0;
     bInfo.xpos = 0;
@@ -186,24 +200,46 @@ bool GLBitmapCollection::Load(const char* bitmapFile) {
     _bitmapInfoMap[tmpName] = &_bitmapInfo[_bitmapCount];
     _bitmapCount++;
 
-    return true;
+    return upload();
 }
 
 //Load bitmap and data file
 bool GLBitmapCollection::Load(const char* bitmapFile, const char* dataFile) {
-    if (!LoadBitmapFile(bitmapFile)) {
+    return decode(bitmapFile, dataFile) && upload();
+}
+
+bool GLBitmapCollection::decode(const char* bitmapFile, const char* dataFile) {
+    if (!decodeBitmapFile(bitmapFile)) {
         return false;
     }
 
     if (!ResourceManagerS::instance()->hasResource(string(dataFile))) {
         LOG_WARNING << "Bitmap data file [" << dataFile << "] not found." << endl;
-        if (_bcNeedsCleanup) {
-            delete _bitmapCollection;
-        }
+        SDL_FreeSurface(_pendingImage);
+        _pendingImage = 0;
         return false;
     }
-    std::shared_ptr<ziStream> datainfilePtr(ResourceManagerS::instance()->getInputStream(string(dataFile)));
-    ziStream& datainfile = *datainfilePtr;
+    std::unique_ptr<ResourceView> dataView(ResourceManagerS::instance()->getResourceView(string(dataFile)));
+    if (!dataView) {
+        SDL_FreeSurface(_pendingImage);
+        _pendingImage = 0;
+        return false;
+    }
+
+    AssetCacheKey key("atlas", ATLAS_CACHE_VERSION);
+    key.add(*dataView);
+    std::unique_ptr<ResourceView> cached(AssetCacheS::instance()->load(key));
+    if (cached && ((cached->size() % sizeof(BitmapInfo)) == 0) &&
+        ((cached->size() / sizeof(BitmapInfo)) <= MAX_BITMAPS)) {
+        _bitmapCount = (unsigned int)(cached->size() / sizeof(BitmapInfo));
+        memcpy(_bitmapInfo, cached->data(), cached->size());
+        for (unsigned int i = 0; i < _bitmapCount; i++) {
+            _bitmapInfoMap[string(_bitmapInfo[i].name)] = &_bitmapInfo[i];
+        }
+        return true;
+    }
+
+    ResourceViewStream datainfile(*dataView);
 
     LOG_DEBUG << "Reading: [" << dataFile << "]." << endl;
     _bitmapCount = 0;
@@ -250,6 +286,7 @@ bool GLBitmapCollection::Load(const char* bitmapFile, const char* dataFile) {
     }
 
     LOG_DEBUG << "Bitmap read OK." << endl;
+    AssetCacheS::instance()->store(key, _bitmapInfo, _bitmapCount * sizeof(BitmapInfo));
 
     return true;
 }
@@ -49,6 +49,12 @@ public:
     //Load single bitmap
     bool Load(const char* bitmapFile);
 
+    //Read and decode bitmap and data file without touching GL (safe on a worker thread)
+    virtual bool decode(const char* bitmapFile, const char* dataFile);
+
+    //Create texture and buffers from decoded data (GL thread)
+    bool upload(void);
+
     //Get index of bitmap with the given name
     int getIndex(const std::string& name);
 
@@ -113,7 +119,11 @@ protected:
     void initVAO();
     void resetVAO();
 
-    bool LoadBitmapFile(const char* bitmapFile);
+    bool decodeBitmapFile(const char* bitmapFile);
+
+    //decoded image waiting for upload, source is empty if it can't be reloaded
+    SDL_Surface* _pendingImage;
+    std::string _pendingSource;
 
     GLTexture* _bitmapCollection;
     bool _bcNeedsCleanup;
@@ -125,8 +125,8 @@ float GLBitmapFont::GetHeight(float scaley) {
     return (float)_totalHeight * scaley;
 }
 
-//Load bitmap and data files for font
-bool GLBitmapFont::Load(const char* bitmapFile, const char* dataFile) {
+//Read bitmap and data files for font
+bool GLBitmapFont::decode(const char* bitmapFile, const char* dataFile) {
     XTRACE();
 #ifdef IPHONE
     GLBitmapCollection* bitmaps = BitmapManagerS::instance()->getBitmap("bitmaps/atlas");
@@ -148,7 +148,7 @@ bool GLBitmapFont::Load(const char* bitmapFile, const char* dataFile) {
         baseName = bitmapFileName.substr(spos + 1, epos - (spos + 1));
     }
 #else
-    bool result = GLBitmapCollection::Load(bitmapFile, dataFile);
+    bool result = GLBitmapCollection::decode(bitmapFile, dataFile);
 #endif
     if (!result) {
         LOG_ERROR << "Unable to load font...\n";
@@ -36,8 +36,8 @@ public:
 
     float GetHeight(float scaley);
 
-    //Load bitmap and data files for font
-    virtual bool Load(const char* bitmapFile, const char* dataFile);
+    //Read bitmap and data files for font and build the character map
+    virtual bool decode(const char* bitmapFile, const char* dataFile);
 
 private:
     GLBitmapFont(const GLBitmapFont&);
@@ -14,26 +14,140 @@
 //
 #include "GLTexture.hpp"
 
+#include <memory>
+#include <string.h>
+#include <vector>
+
 #include "Trace.hpp"
 #include "TextureManager.hpp"
+#include "ResourceManager.hpp"
+#include "AssetCache.hpp"
+
+using namespace std;
+
+//Cached decoded image (kind "texture"):
+//  TextureCacheHeader
+//  unsigned char[pitch * height] pixels
+static const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+struct TextureCacheHeader {
+    uint32_t format;  //SDL_PixelFormatEnum
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;
+};
+
+static SDL_Surface* loadCachedImage(AssetCacheKey& key) {
+    std::unique_ptr<ResourceView> cached(AssetCacheS::instance()->load(key));
+    if (!cached || (cached->size() < sizeof(TextureCacheHeader))) {
+        return 0;
+    }
+
+    TextureCacheHeader header;
+    memcpy(&header, cached->data(), sizeof(header));
+    size_t pixelSize = (size_t)header.pitch * header.height;
+    if (cached->size() != sizeof(header) + pixelSize) {
+        return 0;
+    }
+
+    SDL_Surface* img = SDL_CreateRGBSurfaceWithFormat(0, (int)header.width, (int)header.height,
+                                                      SDL_BITSPERPIXEL(header.format), header.format);
+    if (!img) {
+        return 0;
+    }
+    if ((uint32_t)img->pitch != header.pitch) {
+        SDL_FreeSurface(img);
+        return 0;
+    }
+    memcpy(img->pixels, cached->data() + sizeof(header), pixelSize);
+
+    return img;
+}
+
+static void storeCachedImage(AssetCacheKey& key, SDL_Surface* img) {
+    //palettes aren't stored, those images are simply decoded every time
+    if (SDL_ISPIXELFORMAT_INDEXED(img->format->format) || SDL_MUSTLOCK(img)) {
+        return;
+    }
+
+    TextureCacheHeader header;
+    header.format = img->format->format;
+    header.width = (uint32_t)img->w;
+    header.height = (uint32_t)img->h;
+    header.pitch = (uint32_t)img->pitch;
+    size_t pixelSize = (size_t)header.pitch * header.height;
+
+    vector<char> payload(sizeof(header) + pixelSize);
+    memcpy(payload.data(), &header, sizeof(header));
+    memcpy(payload.data() + sizeof(header), img->pixels, pixelSize);
+    AssetCacheS::instance()->store(key, payload.data(), payload.size());
+}
+
+SDL_Surface* GLTexture::loadImage(const string& name) {
+    std::unique_ptr<ResourceView> view(ResourceManagerS::instance()->getResourceView(name));
+    if (!view) {
+        LOG_ERROR << "Unable to read image: [" << name << "]" << endl;
+        return 0;
+    }
+
+    AssetCacheKey key("texture", TEXTURE_CACHE_VERSION);
+    key.add(*view);
+    SDL_Surface* img = loadCachedImage(key);
+    if (!img) {
+        //decode straight from the mapped file
+        SDL_RWops* src = SDL_RWFromConstMem(view->data(), (int)view->size());
+        img = IMG_Load_RW(src, 0);
+        SDL_FreeRW(src);
+        if (!img) {
+            LOG_ERROR << "Failed to decode image: [" << name << "]: " << SDL_GetError() << endl;
+            return 0;
+        }
+        storeCachedImage(key, img);
+    }
+
+    return img;
+}
 
-//Construct texture given filename
+//Construct texture given resource name
 GLTexture::GLTexture(GLenum target, const char* fileName, bool mipmap) :
-    _target(target) {
+    _textureID(0),
+    _target(target),
+    _image(0),
+    _sourceName(fileName),
+    _mipmap(mipmap),
+    _width(0),
+    _height(0),
+    _gpuBytes(0) {
     XTRACE();
-    SDL_Surface* image;
-    if ((image = IMG_Load(fileName)) == 0) {
-        LOG_ERROR << "Couldn't load " << fileName << ": " << SDL_GetError() << "\n";
-        _textureID = 0;
-        _image = 0;
-    } else {
+    SDL_Surface* image = loadImage(_sourceName);
+    if (image) {
         init(image, mipmap);
     }
 }
 
 //Construct texture given SDL surface
 GLTexture::GLTexture(GLenum target, SDL_Surface* img, bool mipmap) :
-    _target(target) {
+    _textureID(0),
+    _target(target),
+    _image(0),
+    _sourceName(),
+    _mipmap(mipmap),
+    _width(0),
+    _height(0),
+    _gpuBytes(0) {
+    XTRACE();
+    init(img, mipmap);
+}
+
+GLTexture::GLTexture(GLenum target, SDL_Surface* img, const string& sourceName, bool mipmap) :
+    _textureID(0),
+    _target(target),
+    _image(0),
+    _sourceName(sourceName),
+    _mipmap(mipmap),
+    _width(0),
+    _height(0),
+    _gpuBytes(0) {
     XTRACE();
     init(img, mipmap);
 }
@@ -51,15 +165,60 @@ void GLTexture::reset(void) {
 }
 
 void GLTexture::reload(void) {
-    init(_image, _mipmap);
+    SDL_Surface* img = _image;
+    if (!img) {
+        img = loadImage(_sourceName);
+        if (!img) {
+            LOG_ERROR << "Unable to reload texture: [" << _sourceName << "]" << endl;
+            return;
+        }
+    }
+    init(img, _mipmap);
+}
+
+size_t GLTexture::getCPUBytes(void) {
+    return _image ? (size_t)_image->pitch * _image->h : 0;
+}
+
+size_t GLTexture::getGPUBytes(void) {
+    return _gpuBytes;
+}
+
+void GLTexture::releaseImage(void) {
+    //without a source there is nothing to reload from
+    if (!_image || _sourceName.empty()) {
+        return;
+    }
+    if (TextureManagerS::instance()->getImagePolicy() == TextureManager::eKeepImages) {
+        return;
+    }
+    SDL_FreeSurface(_image);
+    _image = 0;
 }
 
 //Init texture with SDL surface
 void GLTexture::init(SDL_Surface* img, bool mipmap) {
     _image = img;
     _mipmap = mipmap;
+    _width = img->w;
+    _height = img->h;
     _textureID = TextureManagerS::instance()->addTexture(this);
 
+    //what the driver most likely allocates for the RGBA upload
+#ifdef USE_16BIT_TEXTURE
+    _gpuBytes = (size_t)_width * _height * 2;
+#else
+    _gpuBytes = (size_t)_width * _height * 4;
+#endif
+#ifdef IPHONE
+    if (_image->compressedSize > 0) {
+        _gpuBytes = _image->compressedSize;
+    }
+#endif
+    if (mipmap) {
+        _gpuBytes += _gpuBytes / 3;
+    }
+
     bind();
     glTexParameteri(_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
@@ -121,6 +280,8 @@ void GLTexture::init(SDL_Surface* img, bool mipmap) {
 #endif
         }
     }
+
+    releaseImage();
 }
 
 //get texture format
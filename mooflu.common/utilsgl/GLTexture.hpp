@@ -21,6 +21,8 @@
 #include <GL/glew.h>
 #endif
 
+#include <string>
+
 #include "Trace.hpp"
 
 class GLTextureI {
@@ -29,17 +31,29 @@ public:
     virtual void unbind(void) = 0;
     virtual void reload(void) = 0;
 
+    //bytes held in system memory and (estimated) in texture memory
+    virtual size_t getCPUBytes(void) = 0;
+    virtual size_t getGPUBytes(void) = 0;
+
     virtual ~GLTextureI() {}
 };
 
 class GLTexture : public GLTextureI {
 public:
     //target: GL_TEXTURE_1D, GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP_ARB, etc.
+    //Takes ownership of img. Without a source the image is kept for reload.
     GLTexture(GLenum target, SDL_Surface* img, bool mipmap = false);
+    //Image decoded from resource sourceName. Depending on the TextureManager
+    //image policy it is freed after upload and decoded again on reload.
+    GLTexture(GLenum target, SDL_Surface* img, const std::string& sourceName, bool mipmap = false);
+    //Load image from resource fileName
     GLTexture(GLenum target, const char* fileName, bool mipmap = false);
 
     ~GLTexture();
 
+    //Decode image resource via the asset cache. Returns 0 on error.
+    static SDL_Surface* loadImage(const std::string& name);
+
     void bind(void) { glBindTexture(_target, _textureID); }
 
     void unbind(void) { glBindTexture(_target, 0); }
@@ -47,9 +61,12 @@ public:
     void reset(void);
     void reload(void);
 
-    int width() { return _image ? _image->w : 0; }
+    size_t getCPUBytes(void);
+    size_t getGPUBytes(void);
 
-    int height() { return _image ? _image->h : 0; }
+    int width() { return _width; }
+
+    int height() { return _height; }
 
 private:
     GLTexture(const GLTexture&);
@@ -58,8 +75,14 @@ private:
     GLuint _textureID;
     GLenum _target;
     SDL_Surface* _image;
+    std::string _sourceName;
     bool _mipmap;
 
+    int _width;
+    int _height;
+    size_t _gpuBytes;
+
     GLenum getGLTextureFormat(void);
     void init(SDL_Surface* img, bool mipmap);
+    void releaseImage(void);
 };
@@ -98,3 +98,19 @@ void GLTextureCubeMap::reload(void) {
     TextureManagerS::instance()->removeTexture(this);
     init();
 }
+
+size_t GLTextureCubeMap::getCPUBytes(void) {
+    size_t bytes = 0;
+    for (int i = 0; i < 6; i++) {
+        bytes += (size_t)_image[i]->pitch * _image[i]->h;
+    }
+    return bytes;
+}
+
+size_t GLTextureCubeMap::getGPUBytes(void) {
+    size_t bytes = 0;
+    for (int i = 0; i < 6; i++) {
+        bytes += (size_t)_image[i]->w * _image[i]->h * 4;
+    }
+    return bytes;
+}
@@ -45,6 +45,10 @@ public:
 
     void reload(void);
 
+    //faces have no source, they are always kept for reload
+    size_t getCPUBytes(void);
+    size_t getGPUBytes(void);
+
 private:
     GLuint _textureID;
     SDL_Surface* _image[6];
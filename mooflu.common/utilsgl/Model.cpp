@@ -6,8 +6,9 @@
 #include "Model.hpp"
 
 #include "Trace.hpp"
-#include "Tokenizer.hpp"
 #include "ResourceManager.hpp"
+#include "ModelCompiler.hpp"
+#include "AssetCache.hpp"
 
 #include "gl3/ProgramManager.hpp"
 #include "gl3/Program.hpp"
@@ -18,6 +19,8 @@
 #include "glm/ext.hpp"
 
 #include <memory>
+#include <stddef.h>
+#include <string.h>
 #include <vector>
 using namespace std;
 
@@ -28,21 +31,14 @@ float Model::MODEL_SCALE = 1.0f;
 #endif
 
 Model::Model(void) :
-    _numVerts(0),
-    _numColors(0),
-    _numFaces(0),
-    _verts(0),
-    _norms(0),
-    _colors(0),
-    _faces(0),
+    _name(),
+    _data(),
     _offset(0, 0, 0),
-    _fixNormals(false),
     _vao(0),
     _vIndexBuf(0),
     _vertBuf(0),
-    _normBuf(0),
-    _colorBuf(0),
-    _numTriangles(0),
+    _indexType(GL_UNSIGNED_INT),
+    _numIndices(0),
     _color(-1, -1, -1, 1) {
     XTRACE();
 }
@@ -50,7 +46,6 @@ Model::Model(void) :
 Model::~Model() {
     XTRACE();
     reset();
-    delete[] _faces;
 }
 
 void Model::setColor(const vec4f& color) {
@@ -63,266 +58,141 @@ void Model::setColor(float r, float g, float b, float a) {
 
 //Load model from file
 bool Model::load(const char* filename) {
+    XTRACE();
+    if (!decode(filename)) {
+        return false;
+    }
+
+    upload();
+
+    return true;
+}
+
+bool Model::decode(const char* filename) {
     XTRACE();
     //HACK to fixup models with bad normals or models that require
     //GL_LIGHT_MODEL_TWO_SIDE, but doesn't work on IPHONE
     string fileName = filename;
     size_t len = fileName.length();
+    bool fixNormals = false;
+
+    //Precompiled by modelc into the pak (see tools/). Only plain names are
+    //compiled, X names have no binary and fix their normals from the text.
+    string binFileName = fileName.substr(0, len - 6) + ".bmodel";
+
     if (fileName[len - 7] == 'X') {
-        _fixNormals = true;
+        fixNormals = true;
         fileName.replace(fileName.end() - 7, fileName.end(), ".model");
     }
 
-    if (!ResourceManagerS::instance()->hasResource(fileName)) {
-        LOG_ERROR << "Unable to open: [" << fileName << "]" << endl;
+    if (!loadBinary(binFileName) && !loadText(fileName, fixNormals)) {
         return false;
     }
-    std::shared_ptr<ziStream> infilePtr(ResourceManagerS::instance()->getInputStream(fileName));
-    ziStream& infile = *infilePtr;
-
-    LOG_INFO << "  Model " << fileName << endl;
-
-    vec3f scale;
-    scale.x() = scale.y() = scale.z() = 1.0;
-
-    string line;
-    int linecount = 0;
-    while (!getline(infile, line).eof()) {
-        linecount++;
-
-        //explicitly skip comments
-        if (line[0] == '#') {
-            continue;
-        }
-        Tokenizer t(line);
-        string token = t.next();
-        if (token == "Name") {
-            _name = t.next();
-            //            LOG_INFO << "Name = [" << _name << "]" << endl;
-        } else if (token == "Scale") {
-            scale.x() = (float)atof(t.next().c_str()) * MODEL_SCALE;
-            scale.y() = (float)atof(t.next().c_str()) * MODEL_SCALE;
-            scale.z() = (float)atof(t.next().c_str()) * MODEL_SCALE;
-#if 0
-            LOG_INFO << "Scale = ["
-                << scale.x() << ","
-                << scale.y() << ","
-                << scale.z()
-                << "]" << endl;
-#endif
-        } else if (token == "Colors") {
-            _numColors = atoi(t.next().c_str());
-            if (!readColors(infile, linecount)) {
-                LOG_ERROR << "Error reading colors:"
-                          << " line:" << linecount << endl;
-                return false;
-            }
-        } else if (token == "Vertices") {
-            int numVerts = atoi(t.next().c_str());
-            verifyAndAssign(numVerts, _numVerts);
-            if (!readVertices(infile, scale, linecount)) {
-                LOG_ERROR << "Error reading vertices:"
-                          << " line:" << linecount << endl;
-                return false;
-            }
-        } else if (token == "Normals") {
-            int numNorms = atoi(t.next().c_str());
-            verifyAndAssign(numNorms, _numVerts);
-            if (!readNormals(infile, linecount)) {
-                LOG_ERROR << "Error reading normals:"
-                          << " line:" << linecount << endl;
-                return false;
-            }
-        } else if (token == "Faces") {
-            _numFaces = atoi(t.next().c_str());
-            _faces = new FaceInfo[_numFaces];
-            if (!readFaces(infile, linecount)) {
-                LOG_ERROR << "Error reading faces:"
-                          << " line:" << linecount << endl;
-                return false;
-            }
-        } else if (token == "Offset") {
-            _offset.x() = (float)atof(t.next().c_str()) * MODEL_SCALE;
-            _offset.y() = (float)atof(t.next().c_str()) * MODEL_SCALE;
-            _offset.z() = (float)atof(t.next().c_str()) * MODEL_SCALE;
-#if 0
-            LOG_INFO << "Offset = ["
-                << _offset.x() << ","
-                << _offset.y() << ","
-                << _offset.z()
-                << "]" << endl;
-#endif
-        } else {
-            LOG_ERROR << "Syntax error: [" << token << "] line:" << linecount << endl;
-            return false;
-        }
-    }
 
-    prepareModel();
+    applyHeader();
 
     return true;
 }
 
-//read vertices section
-bool Model::readVertices(ziStream& infile, const vec3f& scale, int& linecount) {
-    XTRACE();
-    string line;
-    for (int i = 0; i < _numVerts; i++) {
-        if (getline(infile, line).eof()) {
-            return false;
-        }
-        linecount++;
-
-        Tokenizer t(line);
-
-        float x = (float)atof(t.next().c_str());
-        float y = (float)atof(t.next().c_str());
-        float z = (float)atof(t.next().c_str());
-
-        _verts.push_back(vec3f(x * scale.x(), y * scale.y(), z * scale.z()));
-
-        if (t.tokensReturned() != 3) {
-            return false;
-        }
-
-        if (i == 0) {
-            _min = _verts[i];
-            _max = _verts[i];
-        } else {
-            if (_verts[i].x() < _min.x()) {
-                _min.x() = _verts[i].x();
-            }
-            if (_verts[i].y() < _min.y()) {
-                _min.y() = _verts[i].y();
-            }
-            if (_verts[i].z() < _min.z()) {
-                _min.z() = _verts[i].z();
-            }
-
-            if (_verts[i].x() > _max.x()) {
-                _max.x() = _verts[i].x();
-            }
-            if (_verts[i].y() > _max.y()) {
-                _max.y() = _verts[i].y();
-            }
-            if (_verts[i].z() > _max.z()) {
-                _max.z() = _verts[i].z();
-            }
-        }
-    }
-
-    return true;
+void Model::upload(void) {
+    prepareModel();
 }
 
-//read normals section
-bool Model::readNormals(ziStream& infile, int& linecount) {
+bool Model::loadBinary(const string& fileName) {
     XTRACE();
-    string line;
-    for (int i = 0; i < _numVerts; i++) {
-        if (getline(infile, line).eof()) {
-            return false;
-        }
-        linecount++;
-
-        Tokenizer t(line);
-
-        float x = (float)atof(t.next().c_str());
-        float y = (float)atof(t.next().c_str());
-        float z = (float)atof(t.next().c_str());
-
-        vec3f norm(x, y, z);
-        //norm.normalize();
+    if (!ResourceManagerS::instance()->hasResource(fileName)) {
+        return false;
+    }
+    std::unique_ptr<ResourceView> view(ResourceManagerS::instance()->getResourceView(fileName));
+    if (!view || (view->size() == 0)) {
+        return false;
+    }
+    //one copy out of the mapped file, the data gets scaled in place below
+    const unsigned char* begin = (const unsigned char*)view->data();
+    _data.assign(begin, begin + view->size());
+    if (!ModelCompiler::verify(_data)) {
+        LOG_WARNING << "Ignoring bad compiled model: [" << fileName << "]" << endl;
+        _data.clear();
+        return false;
+    }
 
-        _norms.push_back(norm);
+    LOG_INFO << "  Model " << fileName << endl;
 
-        if (_fixNormals && (_norms[i].z() < 0)) {
-            _norms[i].x() = -_norms[i].x();
-            _norms[i].y() = -_norms[i].y();
-            _norms[i].z() = -_norms[i].z();
+    if (MODEL_SCALE != 1.0f) {
+        ModelFileHeader* header = (ModelFileHeader*)_data.data();
+        ModelVertex* verts = (ModelVertex*)(_data.data() + sizeof(ModelFileHeader));
+        for (uint32_t i = 0; i < header->numVertices; i++) {
+            for (int j = 0; j < 3; j++) {
+                verts[i].pos[j] *= MODEL_SCALE;
+            }
         }
-
-        if (t.tokensReturned() != 3) {
-            return false;
+        for (int j = 0; j < 3; j++) {
+            header->min[j] *= MODEL_SCALE;
+            header->max[j] *= MODEL_SCALE;
+            header->offset[j] *= MODEL_SCALE;
         }
     }
 
     return true;
 }
 
-//read faces section
-bool Model::readFaces(ziStream& infile, int& linecount) {
+bool Model::loadText(const string& fileName, bool fixNormals) {
     XTRACE();
-    string line;
-    for (int i = 0; i < _numFaces; i++) {
-        if (getline(infile, line).eof()) {
-            return false;
-        }
-        linecount++;
-
-        Tokenizer t(line);
-
-        _faces[i].v1 = atoi(t.next().c_str());
-        _faces[i].v2 = atoi(t.next().c_str());
-        _faces[i].v3 = atoi(t.next().c_str());
-        _faces[i].v4 = atoi(t.next().c_str());
-        _faces[i].smooth = (atoi(t.next().c_str()) == 1);
-        _faces[i].color = atoi(t.next().c_str());
-
-        if (t.tokensReturned() != 6) {
-            return false;
-        }
+    if (!ResourceManagerS::instance()->hasResource(fileName)) {
+        LOG_ERROR << "Unable to open: [" << fileName << "]" << endl;
+        return false;
+    }
+    std::unique_ptr<ResourceView> view(ResourceManagerS::instance()->getResourceView(fileName));
+    if (!view) {
+        LOG_ERROR << "Unable to read: [" << fileName << "]" << endl;
+        return false;
     }
 
-    return true;
-}
-
-//read colors section
-bool Model::readColors(ziStream& infile, int& linecount) {
-    XTRACE();
-    string line;
-    for (int i = 0; i < _numColors; i++) {
-        if (getline(infile, line).eof()) {
-            return false;
+    //compiled result depends on the source and both load settings
+    AssetCacheKey key("model", MODEL_FILE_VERSION);
+    key.add(*view);
+    key.add(&fixNormals, sizeof(fixNormals));
+    key.add(&MODEL_SCALE, sizeof(MODEL_SCALE));
+
+    std::unique_ptr<ResourceView> cached(AssetCacheS::instance()->load(key));
+    if (cached) {
+        const unsigned char* begin = (const unsigned char*)cached->data();
+        _data.assign(begin, begin + cached->size());
+        if (ModelCompiler::verify(_data)) {
+            LOG_INFO << "  Model " << fileName << " (cached)" << endl;
+            return true;
         }
-        linecount++;
+        _data.clear();
+    }
 
-        Tokenizer t(line);
-        float r = (float)atof(t.next().c_str());
-        float g = (float)atof(t.next().c_str());
-        float b = (float)atof(t.next().c_str());
+    ResourceViewStream infile(*view);
 
-        _colors.push_back(vec4f(r, g, b, 1.0f));
+    LOG_INFO << "  Model " << fileName << endl;
 
-        if (t.tokensReturned() != 3) {
-            return false;
-        }
+    if (!ModelCompiler::compile(infile, fileName, fixNormals, MODEL_SCALE, _data)) {
+        return false;
     }
+    AssetCacheS::instance()->store(key, _data.data(), _data.size());
 
     return true;
 }
 
-//hum
-void Model::verifyAndAssign(const int newVert, int& currVertVal) {
-    XTRACE();
-    if ((currVertVal != 0) && (newVert != currVertVal)) {
-        LOG_ERROR << "Vertex count inconsistency!" << endl;
-    } else {
-        currVertVal = newVert;
-    }
+void Model::applyHeader(void) {
+    const ModelFileHeader* header = (const ModelFileHeader*)_data.data();
+    _name = string(header->name, strnlen(header->name, sizeof(header->name)));
+    _min = vec3f(header->min[0], header->min[1], header->min[2]);
+    _max = vec3f(header->max[0], header->max[1], header->max[2]);
+    _offset = vec3f(header->offset[0], header->offset[1], header->offset[2]);
 }
 
 void Model::reset(void) {
-    _numTriangles = 0;
+    _numIndices = 0;
     delete _vao;
     _vao = 0;
     delete _vIndexBuf;
     _vIndexBuf = 0;
     delete _vertBuf;
     _vertBuf = 0;
-    delete _normBuf;
-    _normBuf = 0;
-    delete _colorBuf;
-    _colorBuf = 0;
 }
 
 //re-load model
@@ -331,31 +201,6 @@ void Model::reload(void) {
     prepareModel();
 }
 
-void Model::addTriangle(const vec4f& color, const vec4f& avgNormal, bool hasColor, int v1, int v2, int v3, bool smooth,
-                        std::vector<vec3f>& verts, std::vector<vec3f>& norms, std::vector<vec4f>& colors) {
-    int f[3];
-    f[0] = v1;
-    f[1] = v2;
-    f[2] = v3;
-
-    for (int i = 0; i < 3; i++) {
-        if (hasColor) {
-            colors.push_back(color);
-        } else {
-            colors.push_back(vec4f(1.0, 1.0, 1.0, 1.0));
-        }
-
-        if (smooth) {
-            norms.push_back(_norms[f[i]]);
-        } else {
-            norms.push_back(avgNormal);
-        }
-
-        verts.push_back(_verts[f[i]]);
-    }
-    _numTriangles += 1;
-}
-
 void Model::draw() {
     Program* prog = ProgramManagerS::instance()->getProgram("lighting");
     prog->use();
@@ -368,80 +213,46 @@ void Model::draw() {
     glUniform4fv(objectColorLoc, 1, _color.array);
 
     _vao->bind();
-    glDrawElements(GL_TRIANGLES, _numTriangles * 3, GL_UNSIGNED_INT, NULL);
+    glDrawElements(GL_TRIANGLES, _numIndices, _indexType, NULL);
     _vao->unbind();
 }
 
 void Model::prepareModel(void) {
+    if (_data.empty()) {
+        return;
+    }
+
+    const ModelFileHeader* header = (const ModelFileHeader*)_data.data();
+    unsigned char* verts = _data.data() + sizeof(ModelFileHeader);
+    unsigned char* indices = verts + header->numVertices * sizeof(ModelVertex);
+
     _vertBuf = new Buffer();
-    _normBuf = new Buffer();
-    _colorBuf = new Buffer();
     _vIndexBuf = new Buffer();
 
-    Program* prog = ProgramManagerS::instance()->getProgram("lighting");
-    prog->use();
-
     _vao = new VertexArray();
     _vao->bind();
 
+    //single interleaved buffer: float position, normalized short normal, normalized byte color
+    _vertBuf->bind(GL_ARRAY_BUFFER);
+    _vertBuf->setData(GL_ARRAY_BUFFER, header->numVertices * sizeof(ModelVertex), verts, GL_STATIC_DRAW);
+
     GLint vertLoc = 0;
     glEnableVertexAttribArray(vertLoc);
-    _vertBuf->bind(GL_ARRAY_BUFFER);
-    glVertexAttribPointer(vertLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glVertexAttribPointer(vertLoc, 3, GL_FLOAT, GL_FALSE, sizeof(ModelVertex), (void*)offsetof(ModelVertex, pos));
 
     GLint normLoc = 1;
     glEnableVertexAttribArray(normLoc);
-    _normBuf->bind(GL_ARRAY_BUFFER);
-    glVertexAttribPointer(normLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glVertexAttribPointer(normLoc, 3, GL_SHORT, GL_TRUE, sizeof(ModelVertex), (void*)offsetof(ModelVertex, normal));
 
     GLint colorLoc = 2;
     glEnableVertexAttribArray(colorLoc);
-    _colorBuf->bind(GL_ARRAY_BUFFER);
-    glVertexAttribPointer(colorLoc, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glVertexAttribPointer(colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ModelVertex),
+                          (void*)offsetof(ModelVertex, color));
 
+    _indexType = (header->indexSize == sizeof(uint16_t)) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    _numIndices = header->numIndices;
     _vIndexBuf->bind(GL_ELEMENT_ARRAY_BUFFER);
-
-    std::vector<vec3f> verts;
-    std::vector<vec3f> norms;
-    std::vector<vec2f> texels;
-    std::vector<vec4f> colors;
-
-    vec3f color(1.0, 0.0, 0.0);
-    for (int i = 0; i < _numFaces; i++) {
-        if (_numColors) {
-            color = _colors[_faces[i].color];
-        }
-
-        vec3f avgNormal = _norms[_faces[i].v1] + _norms[_faces[i].v2] + _norms[_faces[i].v3];
-        if (_faces[i].v4 != 0) {
-            avgNormal += _norms[_faces[i].v4];
-        }
-        avgNormal.normalize();
-
-        addTriangle(color, avgNormal, _numColors > 0, _faces[i].v1, _faces[i].v2, _faces[i].v3, _faces[i].smooth, verts,
-                    norms, colors);
-        if (_faces[i].v4 != 0)  //quad
-        {
-            addTriangle(color, avgNormal, _numColors > 0, _faces[i].v3, _faces[i].v4, _faces[i].v1, _faces[i].smooth,
-                        verts, norms, colors);
-        }
-    }
-    GLuint* vi = new GLuint[verts.size()];
-    for (GLuint i = 0; i < verts.size(); i++) {
-        vi[i] = i;
-    }
-    _vIndexBuf->bind(GL_ELEMENT_ARRAY_BUFFER);
-    _vIndexBuf->setData(GL_ELEMENT_ARRAY_BUFFER, verts.size() * sizeof(GLuint), vi, GL_STATIC_DRAW);
-
-    _vertBuf->bind(GL_ARRAY_BUFFER);
-    _vertBuf->setData(GL_ARRAY_BUFFER, verts.size() * sizeof(vec3f), verts.data(), GL_STATIC_DRAW);
-
-    _normBuf->bind(GL_ARRAY_BUFFER);
-    _normBuf->setData(GL_ARRAY_BUFFER, norms.size() * sizeof(vec3f), norms.data(), GL_STATIC_DRAW);
-
-    _colorBuf->bind(GL_ARRAY_BUFFER);
-    _colorBuf->setData(GL_ARRAY_BUFFER, colors.size() * sizeof(vec4f), colors.data(), GL_STATIC_DRAW);
+    _vIndexBuf->setData(GL_ELEMENT_ARRAY_BUFFER, header->numIndices * header->indexSize, indices, GL_STATIC_DRAW);
 
     _vao->unbind();
-    delete[] vi;
 }
@@ -14,6 +14,7 @@
 // FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
 //
 #include <string>
+#include <vector>
 
 #include "zStream.hpp"
 #include <GL/glew.h>
@@ -26,15 +27,6 @@ using namespace vmml;
 class Buffer;
 class VertexArray;
 
-struct FaceInfo {
-    int v1;
-    int v2;
-    int v3;
-    int v4;
-    int color;
-    bool smooth;
-};
-
 class Model {
 public:
     Model(void);
@@ -42,8 +34,12 @@ public:
 
     static float MODEL_SCALE;  //global scale factor (mostly for iPhone)
 
-    //Load model from file
+    //Load model from file. Prefers a precompiled .bmodel next to the .model
     bool load(const char* filename);
+    //Read model without touching GL (safe on a worker thread)
+    bool decode(const char* filename);
+    //Create buffers from decoded data (GL thread)
+    void upload(void);
     //go draw
     void draw();
     //re-load model (e.g. after toggling fullscreen).
@@ -78,41 +74,25 @@ private:
     Model(const Model&);
     Model& operator=(const Model&);
 
+    bool loadBinary(const std::string& fileName);
+    bool loadText(const std::string& fileName, bool fixNormals);
+    void applyHeader(void);
     void prepareModel(void);
 
-    void addTriangle(const vec4f& color, const vec4f& avgNormal, bool hasColor, int v1, int v2, int v3, bool smooth,
-                     std::vector<vec3f>& verts, std::vector<vec3f>& norms, std::vector<vec4f>& colors);
-
-    void verifyAndAssign(const int newVert, int& currVertVal);
-
-    bool readColors(ziStream& infile, int& linecount);
-    bool readFaces(ziStream& infile, int& linecount);
-    bool readNormals(ziStream& infile, int& linecount);
-    bool readVertices(ziStream& infile, const vec3f& scale, int& linecount);
-
     std::string _name;
 
-    int _numVerts;
-    int _numColors;
-    int _numFaces;
-
-    std::vector<vec3f> _verts;
-    std::vector<vec3f> _norms;
-    std::vector<vec4f> _colors;
-    FaceInfo* _faces;
+    //compiled model (see ModelCompiler.hpp), kept for reload
+    std::vector<unsigned char> _data;
 
     vec3f _min;
     vec3f _max;
     vec3f _offset;
 
-    bool _fixNormals;
-
     VertexArray* _vao;
     Buffer* _vIndexBuf;
     Buffer* _vertBuf;
-    Buffer* _normBuf;
-    Buffer* _colorBuf;
-    int _numTriangles;
+    GLenum _indexType;
+    int _numIndices;
 
     vec4f _color;
 };
@@ -0,0 +1,393 @@
+// Description:
+//   Compiles text .model files into an indexed, interleaved binary mesh.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include "ModelCompiler.hpp"
+
+#include "Trace.hpp"
+#include "Tokenizer.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+using namespace std;
+
+static inline int16_t packNormal(float n) {
+    if (n > 1.0f) {
+        n = 1.0f;
+    } else if (n < -1.0f) {
+        n = -1.0f;
+    }
+    return (int16_t)floorf(n * 32767.0f + 0.5f);
+}
+
+static inline uint8_t packColor(float c) {
+    if (c > 1.0f) {
+        c = 1.0f;
+    } else if (c < 0.0f) {
+        c = 0.0f;
+    }
+    return (uint8_t)floorf(c * 255.0f + 0.5f);
+}
+
+bool ModelCompiler::compile(istream& infile, const string& fileName, bool fixNormals, float modelScale,
+                            vector<unsigned char>& blob) {
+    XTRACE();
+    ModelCompiler compiler(fixNormals, modelScale);
+    if (!compiler.parse(infile, fileName)) {
+        return false;
+    }
+    compiler.build(blob);
+    return true;
+}
+
+bool ModelCompiler::verify(const vector<unsigned char>& blob) {
+    XTRACE();
+    if (blob.size() < sizeof(ModelFileHeader)) {
+        return false;
+    }
+
+    const ModelFileHeader* header = (const ModelFileHeader*)blob.data();
+    if ((memcmp(header->magic, MODEL_FILE_MAGIC, sizeof(header->magic)) != 0) ||
+        (header->version != MODEL_FILE_VERSION) || (header->byteOrder != MODEL_FILE_BYTE_ORDER)) {
+        return false;
+    }
+    if ((header->indexSize != sizeof(uint16_t)) && (header->indexSize != sizeof(uint32_t))) {
+        return false;
+    }
+
+    size_t expected = sizeof(ModelFileHeader) + (size_t)header->numVertices * sizeof(ModelVertex) +
+                      (size_t)header->numIndices * header->indexSize;
+    return blob.size() == expected;
+}
+
+ModelCompiler::ModelCompiler(bool fixNormals, float modelScale) :
+    _fixNormals(fixNormals),
+    _modelScale(modelScale),
+    _name(),
+    _numVerts(0),
+    _numColors(0),
+    _numFaces(0),
+    _verts(),
+    _norms(),
+    _colors(),
+    _faces(),
+    _packedVerts(),
+    _indices(),
+    _vertexLookup() {
+    for (int i = 0; i < 3; i++) {
+        _min[i] = _max[i] = _offset[i] = 0.0f;
+    }
+}
+
+bool ModelCompiler::parse(istream& infile, const string& fileName) {
+    XTRACE();
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+
+    string line;
+    int linecount = 0;
+    while (!getline(infile, line).eof()) {
+        linecount++;
+
+        //explicitly skip comments
+        if (line[0] == '#') {
+            continue;
+        }
+        Tokenizer t(line);
+        string token = t.next();
+        if (token == "Name") {
+            _name = t.next();
+        } else if (token == "Scale") {
+            for (int i = 0; i < 3; i++) {
+                scale[i] = (float)atof(t.next().c_str()) * _modelScale;
+            }
+        } else if (token == "Colors") {
+            _numColors = atoi(t.next().c_str());
+            if (!readColors(infile, linecount)) {
+                LOG_ERROR << fileName << ": error reading colors: line:" << linecount << endl;
+                return false;
+            }
+        } else if (token == "Vertices") {
+            int numVerts = atoi(t.next().c_str());
+            if ((_numVerts != 0) && (numVerts != _numVerts)) {
+                LOG_ERROR << fileName << ": vertex count inconsistency!" << endl;
+                return false;
+            }
+            _numVerts = numVerts;
+            if (!readVertices(infile, scale, linecount)) {
+                LOG_ERROR << fileName << ": error reading vertices: line:" << linecount << endl;
+                return false;
+            }
+        } else if (token == "Normals") {
+            int numNorms = atoi(t.next().c_str());
+            if ((_numVerts != 0) && (numNorms != _numVerts)) {
+                LOG_ERROR << fileName << ": vertex count inconsistency!" << endl;
+                return false;
+            }
+            _numVerts = numNorms;
+            if (!readNormals(infile, linecount)) {
+                LOG_ERROR << fileName << ": error reading normals: line:" << linecount << endl;
+                return false;
+            }
+        } else if (token == "Faces") {
+            _numFaces = atoi(t.next().c_str());
+            if (!readFaces(infile, linecount)) {
+                LOG_ERROR << fileName << ": error reading faces: line:" << linecount << endl;
+                return false;
+            }
+        } else if (token == "Offset") {
+            for (int i = 0; i < 3; i++) {
+                _offset[i] = (float)atof(t.next().c_str()) * _modelScale;
+            }
+        } else {
+            LOG_ERROR << fileName << ": syntax error: [" << token << "] line:" << linecount << endl;
+            return false;
+        }
+    }
+
+    if (((int)_verts.size() != _numVerts * 3) || ((int)_norms.size() != _numVerts * 3)) {
+        LOG_ERROR << fileName << ": vertices and normals don't match up" << endl;
+        return false;
+    }
+
+    for (int i = 0; i < _numFaces; i++) {
+        const FaceInfo& f = _faces[i];
+        if ((f.v1 < 0) || (f.v1 >= _numVerts) || (f.v2 < 0) || (f.v2 >= _numVerts) || (f.v3 < 0) ||
+            (f.v3 >= _numVerts) || (f.v4 < 0) || (f.v4 >= _numVerts) || (_numColors && (f.color >= _numColors))) {
+            LOG_ERROR << fileName << ": face " << i << " out of range" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//read vertices section
+bool ModelCompiler::readVertices(istream& infile, const float* scale, int& linecount) {
+    XTRACE();
+    string line;
+    for (int i = 0; i < _numVerts; i++) {
+        if (getline(infile, line).eof()) {
+            return false;
+        }
+        linecount++;
+
+        Tokenizer t(line);
+        for (int j = 0; j < 3; j++) {
+            float v = (float)atof(t.next().c_str()) * scale[j];
+            _verts.push_back(v);
+
+            if ((i == 0) || (v < _min[j])) {
+                _min[j] = v;
+            }
+            if ((i == 0) || (v > _max[j])) {
+                _max[j] = v;
+            }
+        }
+
+        if (t.tokensReturned() != 3) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//read normals section
+bool ModelCompiler::readNormals(istream& infile, int& linecount) {
+    XTRACE();
+    string line;
+    for (int i = 0; i < _numVerts; i++) {
+        if (getline(infile, line).eof()) {
+            return false;
+        }
+        linecount++;
+
+        Tokenizer t(line);
+
+        float n[3];
+        for (int j = 0; j < 3; j++) {
+            n[j] = (float)atof(t.next().c_str());
+        }
+
+        //HACK to fixup models with bad normals
+        bool flip = _fixNormals && (n[2] < 0);
+        for (int j = 0; j < 3; j++) {
+            _norms.push_back(flip ? -n[j] : n[j]);
+        }
+
+        if (t.tokensReturned() != 3) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//read faces section
+bool ModelCompiler::readFaces(istream& infile, int& linecount) {
+    XTRACE();
+    string line;
+    for (int i = 0; i < _numFaces; i++) {
+        if (getline(infile, line).eof()) {
+            return false;
+        }
+        linecount++;
+
+        Tokenizer t(line);
+
+        FaceInfo face;
+        face.v1 = atoi(t.next().c_str());
+        face.v2 = atoi(t.next().c_str());
+        face.v3 = atoi(t.next().c_str());
+        face.v4 = atoi(t.next().c_str());
+        face.smooth = (atoi(t.next().c_str()) == 1);
+        face.color = atoi(t.next().c_str());
+        _faces.push_back(face);
+
+        if (t.tokensReturned() != 6) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//read colors section
+bool ModelCompiler::readColors(istream& infile, int& linecount) {
+    XTRACE();
+    string line;
+    for (int i = 0; i < _numColors; i++) {
+        if (getline(infile, line).eof()) {
+            return false;
+        }
+        linecount++;
+
+        Tokenizer t(line);
+        for (int j = 0; j < 3; j++) {
+            _colors.push_back((float)atof(t.next().c_str()));
+        }
+        _colors.push_back(1.0f);
+
+        if (t.tokensReturned() != 3) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t ModelCompiler::addVertex(const ModelVertex& v) {
+    string key((const char*)&v, sizeof(ModelVertex));
+    hash_map<string, uint32_t>::const_iterator ci = _vertexLookup.find(key);
+    if (ci != _vertexLookup.end()) {
+        return ci->second;
+    }
+
+    uint32_t index = (uint32_t)_packedVerts.size();
+    _packedVerts.push_back(v);
+    _vertexLookup[key] = index;
+    return index;
+}
+
+void ModelCompiler::addTriangle(const float* color, const float* avgNormal, int v1, int v2, int v3, bool smooth) {
+    int f[3];
+    f[0] = v1;
+    f[1] = v2;
+    f[2] = v3;
+
+    for (int i = 0; i < 3; i++) {
+        const float* n = smooth ? &_norms[f[i] * 3] : avgNormal;
+
+        ModelVertex v;
+        memset(&v, 0, sizeof(ModelVertex));
+        for (int j = 0; j < 3; j++) {
+            v.pos[j] = _verts[f[i] * 3 + j];
+            v.normal[j] = packNormal(n[j]);
+        }
+        for (int j = 0; j < 4; j++) {
+            v.color[j] = packColor(color[j]);
+        }
+
+        _indices.push_back(addVertex(v));
+    }
+}
+
+void ModelCompiler::build(vector<unsigned char>& blob) {
+    XTRACE();
+    static const float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    for (int i = 0; i < _numFaces; i++) {
+        const FaceInfo& face = _faces[i];
+        const float* color = _numColors ? &_colors[face.color * 4] : white;
+
+        float avgNormal[3];
+        for (int j = 0; j < 3; j++) {
+            avgNormal[j] = _norms[face.v1 * 3 + j] + _norms[face.v2 * 3 + j] + _norms[face.v3 * 3 + j];
+            if (face.v4 != 0) {
+                avgNormal[j] += _norms[face.v4 * 3 + j];
+            }
+        }
+        float len = sqrtf(avgNormal[0] * avgNormal[0] + avgNormal[1] * avgNormal[1] + avgNormal[2] * avgNormal[2]);
+        if (len > 0.0f) {
+            for (int j = 0; j < 3; j++) {
+                avgNormal[j] /= len;
+            }
+        }
+
+        addTriangle(color, avgNormal, face.v1, face.v2, face.v3, face.smooth);
+        if (face.v4 != 0)  //quad
+        {
+            addTriangle(color, avgNormal, face.v3, face.v4, face.v1, face.smooth);
+        }
+    }
+
+    ModelFileHeader header;
+    memset(&header, 0, sizeof(ModelFileHeader));
+    memcpy(header.magic, MODEL_FILE_MAGIC, sizeof(header.magic));
+    header.version = MODEL_FILE_VERSION;
+    header.byteOrder = MODEL_FILE_BYTE_ORDER;
+    header.numVertices = (uint32_t)_packedVerts.size();
+    header.numIndices = (uint32_t)_indices.size();
+    header.indexSize = (_packedVerts.size() <= 0xffff) ? sizeof(uint16_t) : sizeof(uint32_t);
+    for (int j = 0; j < 3; j++) {
+        header.min[j] = _min[j];
+        header.max[j] = _max[j];
+        header.offset[j] = _offset[j];
+    }
+    strncpy(header.name, _name.c_str(), sizeof(header.name) - 1);
+
+    size_t vertBytes = _packedVerts.size() * sizeof(ModelVertex);
+    size_t indexBytes = _indices.size() * header.indexSize;
+    blob.resize(sizeof(ModelFileHeader) + vertBytes + indexBytes);
+
+    unsigned char* p = blob.data();
+    memcpy(p, &header, sizeof(ModelFileHeader));
+    p += sizeof(ModelFileHeader);
+    if (vertBytes) {
+        memcpy(p, _packedVerts.data(), vertBytes);
+        p += vertBytes;
+    }
+
+    if (header.indexSize == sizeof(uint16_t)) {
+        uint16_t* idx = (uint16_t*)p;
+        for (size_t i = 0; i < _indices.size(); i++) {
+            idx[i] = (uint16_t)_indices[i];
+        }
+    } else if (indexBytes) {
+        memcpy(p, _indices.data(), indexBytes);
+    }
+
+    LOG_INFO << "  Model " << _name << ": " << _indices.size() << " indices, " << _packedVerts.size()
+             << " unique vertices" << endl;
+}
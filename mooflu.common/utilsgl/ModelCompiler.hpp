@@ -0,0 +1,106 @@
+#pragma once
+// Description:
+//   Compiles text .model files into an indexed, interleaved binary mesh.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include <stdint.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "hashMap.hpp"
+
+//Binary model file (.bmodel) layout, in the byte order of the compiling
+//host (see byteOrder):
+//  ModelFileHeader
+//  ModelVertex[numVertices]
+//  uint16_t or uint32_t[numIndices] (see indexSize)
+static const char MODEL_FILE_MAGIC[4] = {'S', 'M', 'D', 'L'};
+static const uint32_t MODEL_FILE_VERSION = 2;
+//reads back differently on a host with the other byte order
+static const uint32_t MODEL_FILE_BYTE_ORDER = 0x01020304;
+
+struct ModelFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t numVertices;
+    uint32_t numIndices;
+    uint32_t indexSize;  //2 or 4 bytes
+    float min[3];
+    float max[3];
+    float offset[3];
+    char name[32];
+};
+
+//24 bytes per vertex; normal and color are normalized on the GPU
+struct ModelVertex {
+    float pos[3];
+    int16_t normal[4];  //xyz, w unused
+    uint8_t color[4];
+};
+
+class ModelCompiler {
+public:
+    //Parse text model and build binary blob (header, vertices, indices)
+    static bool compile(std::istream& infile, const std::string& fileName, bool fixNormals, float modelScale,
+                        std::vector<unsigned char>& blob);
+
+    //Check magic, version, byte order and sizes
+    static bool verify(const std::vector<unsigned char>& blob);
+
+private:
+    struct FaceInfo {
+        int v1;
+        int v2;
+        int v3;
+        int v4;
+        int color;
+        bool smooth;
+    };
+
+    ModelCompiler(bool fixNormals, float modelScale);
+
+    bool parse(std::istream& infile, const std::string& fileName);
+    void build(std::vector<unsigned char>& blob);
+
+    void addTriangle(const float* color, const float* avgNormal, int v1, int v2, int v3, bool smooth);
+    uint32_t addVertex(const ModelVertex& v);
+
+    bool readColors(std::istream& infile, int& linecount);
+    bool readFaces(std::istream& infile, int& linecount);
+    bool readNormals(std::istream& infile, int& linecount);
+    bool readVertices(std::istream& infile, const float* scale, int& linecount);
+
+    bool _fixNormals;
+    float _modelScale;
+
+    std::string _name;
+    int _numVerts;
+    int _numColors;
+    int _numFaces;
+
+    std::vector<float> _verts;
+    std::vector<float> _norms;
+    std::vector<float> _colors;
+    std::vector<FaceInfo> _faces;
+
+    float _min[3];
+    float _max[3];
+    float _offset[3];
+
+    std::vector<ModelVertex> _packedVerts;
+    std::vector<uint32_t> _indices;
+    hash_map<std::string, uint32_t> _vertexLookup;
+};
@@ -53,14 +53,35 @@ void ModelManager::reload(void) {
 }
 
 Model* ModelManager::load(const string& modelName) {
+    XTRACE();
+    Model* model = decode(modelName);
+    model->upload();
+
+    return model;
+}
+
+Model* ModelManager::decode(const string& modelName) {
     XTRACE();
     Model* model = new Model;
 
     string modelFile = modelName + ".model";
 
-    if (!model->load(modelFile.c_str())) {
+    if (!model->decode(modelFile.c_str())) {
         LOG_ERROR << "Unable to load: " << modelFile << endl;
     }
 
     return model;
 }
+
+bool ModelManager::addDecoded(const string& modelName, Model* model) {
+    XTRACE();
+    if (_modelMap.find(modelName) != _modelMap.end()) {
+        delete model;
+        return true;
+    }
+
+    model->upload();
+    _modelMap[modelName] = model;
+
+    return true;
+}
@@ -44,6 +44,11 @@ public:
     void reset(void);
     void reload(void);
 
+    //Read model without touching GL (safe on a worker thread)
+    Model* decode(const std::string& modelName);
+    //Finish a decoded model on the GL thread and cache it. Takes ownership.
+    bool addDecoded(const std::string& modelName, Model* model);
+
 private:
     ~ModelManager();
     ModelManager(void);
@@ -17,6 +17,8 @@
 #include "stdio.h"
 #include "Trace.hpp"
 
+TextureManager::ImagePolicy TextureManager::_imagePolicy = TextureManager::eReleaseImages;
+
 TextureManager::TextureManager(void) :
     _textureCount(0) {
     XTRACE();
@@ -64,3 +66,23 @@ int TextureManager::findTexture(GLTextureI* tex) {
     }
     return -1;
 }
+
+void TextureManager::getMemoryStats(TextureMemoryStats& stats) {
+    stats.textures = 0;
+    stats.cpuBytes = 0;
+    stats.gpuBytes = 0;
+    for (int i = 1; i < MAX_TEXTURES; i++) {
+        if (texArray[i]) {
+            stats.textures++;
+            stats.cpuBytes += texArray[i]->getCPUBytes();
+            stats.gpuBytes += texArray[i]->getGPUBytes();
+        }
+    }
+}
+
+void TextureManager::dumpMemoryStats(void) {
+    TextureMemoryStats stats;
+    getMemoryStats(stats);
+    LOG_INFO << "Textures: " << stats.textures << " cpu " << stats.cpuBytes / 1024 << "KB gpu "
+             << stats.gpuBytes / 1024 << "KB\n";
+}
@@ -19,13 +19,33 @@
 
 #define MAX_TEXTURES 1024
 
+struct TextureMemoryStats {
+    int textures;
+    size_t cpuBytes;  //images kept in system memory
+    size_t gpuBytes;  //estimated texture memory
+};
+
 class TextureManager {
     friend class Singleton<TextureManager>;
 
 public:
+    //What happens to a texture's image after upload. Released images are
+    //decoded from their source resource again on reload.
+    enum ImagePolicy {
+        eKeepImages,
+        eReleaseImages,
+    };
+
     int addTexture(GLTextureI* tex);
     void removeTexture(GLTextureI* tex);
 
+    //The policy outlives the manager, which goes away with its last texture
+    static void setImagePolicy(ImagePolicy policy) { _imagePolicy = policy; }
+    static ImagePolicy getImagePolicy(void) { return _imagePolicy; }
+
+    void getMemoryStats(TextureMemoryStats& stats);
+    void dumpMemoryStats(void);
+
 protected:
     TextureManager(void);
     ~TextureManager();
@@ -36,6 +56,7 @@ protected:
 
 private:
     int _textureCount;
+    static ImagePolicy _imagePolicy;
 };
 
 typedef Singleton<TextureManager> TextureManagerS;
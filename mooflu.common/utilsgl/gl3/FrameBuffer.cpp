@@ -0,0 +1,98 @@
+#include "FrameBuffer.hpp"
+
+#include "Trace.hpp"
+
+FrameBuffer::FrameBuffer(bool withDepth) :
+    _withDepth(withDepth),
+    _complete(false),
+    _id(0),
+    _texture(0),
+    _depth(0),
+    _width(0),
+    _height(0) {
+    glGenFramebuffers(1, &_id);
+    glGenTextures(1, &_texture);
+    if (_withDepth) {
+        glGenRenderbuffers(1, &_depth);
+    }
+}
+
+FrameBuffer::~FrameBuffer() {
+    if (_depth) {
+        glDeleteRenderbuffers(1, &_depth);
+    }
+    glDeleteTextures(1, &_texture);
+    glDeleteFramebuffers(1, &_id);
+}
+
+GLuint FrameBuffer::id() const {
+    return _id;
+}
+
+GLuint FrameBuffer::textureId() const {
+    return _texture;
+}
+
+int FrameBuffer::width() const {
+    return _width;
+}
+
+int FrameBuffer::height() const {
+    return _height;
+}
+
+bool FrameBuffer::resize(int width, int height) {
+    if ((width == _width) && (height == _height)) {
+        return _complete;
+    }
+    _width = width;
+    _height = height;
+
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texture, 0);
+
+    if (_withDepth) {
+        glBindRenderbuffer(GL_RENDERBUFFER, _depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _width, _height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    _complete = (status == GL_FRAMEBUFFER_COMPLETE);
+    if (!_complete) {
+        LOG_ERROR << "FrameBuffer " << _width << "x" << _height << " incomplete: " << std::hex << status << std::dec
+                  << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return _complete;
+}
+
+void FrameBuffer::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, _id);
+}
+
+void FrameBuffer::unbind() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void FrameBuffer::bindTexture() const {
+    glBindTexture(GL_TEXTURE_2D, _texture);
+}
+
+void FrameBuffer::blit() const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _id);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <GL/glew.h>
+
+//Offscreen render target with a color texture and an optional depth buffer
+class FrameBuffer {
+public:
+    FrameBuffer(bool withDepth = false);
+    virtual ~FrameBuffer();
+
+    GLuint id() const;
+    GLuint textureId() const;
+
+    int width() const;
+    int height() const;
+
+    //(Re)allocate attachments if the size changed; false if incomplete
+    bool resize(int width, int height);
+
+    void bind() const;
+    static void unbind();
+
+    void bindTexture() const;
+
+    //Copy the color attachment 1:1 onto the default framebuffer
+    void blit() const;
+
+private:
+    FrameBuffer(const FrameBuffer&);
+    FrameBuffer& operator=(const FrameBuffer&);
+
+    bool _withDepth;
+    bool _complete;
+
+    GLuint _id;
+    GLuint _texture;
+    GLuint _depth;
+
+    int _width;
+    int _height;
+};
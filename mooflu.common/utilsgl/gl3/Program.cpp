@@ -99,6 +99,29 @@ bool Program::isLinked() const {
     return _linked;
 }
 
+bool Program::loadBinary(GLenum format, const void* binary, GLsizei length) {
+    glProgramBinary(id(), format, binary, length);
+
+    _linked = get(GL_LINK_STATUS) == GL_TRUE;
+    _dirty = !_linked;
+
+    return _linked;
+}
+
+bool Program::getBinary(GLenum& format, std::vector<unsigned char>& binary) const {
+    GLint length = get(GL_PROGRAM_BINARY_LENGTH);
+    if (!_linked || (length <= 0)) {
+        return false;
+    }
+
+    binary.resize(length);
+    GLsizei written = 0;
+    glGetProgramBinary(id(), length, &written, &format, binary.data());
+    binary.resize(written);
+
+    return written > 0;
+}
+
 bool Program::compileAttachedShaders() const {
     for (Shader* shader : _shaders) {
         if (shader->isCompiled()) {
@@ -2,6 +2,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <GL/glew.h>
 
@@ -26,6 +27,11 @@ public:
     bool isLinked() const;
     bool compileAttachedShaders() const;
 
+    //Use a binary from getBinary() instead of compiling and linking.
+    //Returns false if the driver rejects it (different GPU/driver).
+    bool loadBinary(GLenum format, const void* binary, GLsizei length);
+    bool getBinary(GLenum& format, std::vector<unsigned char>& binary) const;
+
     GLint get(GLenum pname) const;
 
     void validate();
@@ -1,16 +1,43 @@
 #include "ProgramManager.hpp"
 
 #include <memory>
+#include <stdint.h>
+#include <string.h>
 
 #include "Trace.hpp"
 #include "ResourceManager.hpp"
+#include "sha2.h"
 
 #include "gl3/Program.hpp"
 #include "gl3/Shader.hpp"
 
 using namespace std;
 
-ProgramManager::ProgramManager() {}
+//Program binary cache file (shadercache/NAME.bin) layout:
+//  ProgramBinaryHeader
+//  unsigned char[length] driver specific binary
+static const char PROGRAM_BINARY_MAGIC[4] = {'S', 'P', 'R', 'G'};
+static const uint32_t PROGRAM_BINARY_VERSION = 1;
+static const string PROGRAM_BINARY_DIR = "shadercache";
+
+struct ProgramBinaryHeader {
+    char magic[4];
+    uint32_t version;
+    unsigned char key[SHA256_DIGEST_SIZE];
+    uint32_t format;
+    uint32_t length;
+};
+
+ProgramManager::ProgramManager() :
+    _binaryCacheSupported(false) {
+#if !defined(EMSCRIPTEN)
+    //WebGL has no program binaries, desktop drivers report zero formats if unsupported
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    _binaryCacheSupported = (numFormats > 0);
+#endif
+    LOG_INFO << "Shader program binary cache " << (_binaryCacheSupported ? "enabled" : "not supported") << "\n";
+}
 
 ProgramManager::~ProgramManager() {}
 
@@ -34,21 +61,39 @@ Program* ProgramManager::createProgram(const string& name) {
     }
 
     const string vFileName = "shaders/" + name + ".vert.glsl";
-    Shader* vs = new Shader(GL_VERTEX_SHADER, loadShaderSource(vFileName));
-    vs->compile();
+    const string vSource = loadShaderSource(vFileName);
 
     const string fFileName = "shaders/" + name + ".frag.glsl";
-    Shader* fs = new Shader(GL_FRAGMENT_SHADER, loadShaderSource(fFileName));
-    fs->compile();
+    const string fSource = loadShaderSource(fFileName);
 
     Program* prog = new Program();
 
-    prog->attach(vs);
-    prog->attach(fs);
+    unsigned char key[SHA256_DIGEST_SIZE];
+    makeProgramKey(vSource, fSource, key);
+
+    if (_binaryCacheSupported && loadProgramBinary(name, key, prog)) {
+        LOG_INFO << "Shader program loaded from cache: " << name << "\n";
+    } else {
+        Shader* vs = new Shader(GL_VERTEX_SHADER, vSource);
+        vs->compile();
+
+        Shader* fs = new Shader(GL_FRAGMENT_SHADER, fSource);
+        fs->compile();
 
-    prog->link();
+        prog->attach(vs);
+        prog->attach(fs);
 
-    LOG_INFO << "Shader program created: " << name << "\n";
+        if (_binaryCacheSupported) {
+            prog->setParameter(GL_PROGRAM_BINARY_RETRIEVABLE_HINT, (GLint)GL_TRUE);
+        }
+        prog->link();
+
+        LOG_INFO << "Shader program created: " << name << "\n";
+
+        if (_binaryCacheSupported && prog->isLinked()) {
+            saveProgramBinary(name, key, prog);
+        }
+    }
 
     _programs[name] = prog;
 
@@ -63,6 +108,90 @@ Program* ProgramManager::getProgram(const string& name) {
     return program;
 }
 
+void ProgramManager::makeProgramKey(const string& vSource, const string& fSource, unsigned char* key) {
+    sha256_ctx ctx;
+    sha256_init(&ctx);
+
+    //a driver update invalidates the binary, so the driver is part of the key
+    const GLenum driverInfo[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (size_t i = 0; i < sizeof(driverInfo) / sizeof(driverInfo[0]); i++) {
+        const char* info = (const char*)glGetString(driverInfo[i]);
+        if (info) {
+            sha256_update(&ctx, (const unsigned char*)info, (unsigned int)strlen(info) + 1);
+        }
+    }
+
+    sha256_update(&ctx, (const unsigned char*)vSource.c_str(), (unsigned int)vSource.size() + 1);
+    sha256_update(&ctx, (const unsigned char*)fSource.c_str(), (unsigned int)fSource.size() + 1);
+
+    sha256_final(&ctx, key);
+}
+
+bool ProgramManager::loadProgramBinary(const string& name, const unsigned char* key, Program* prog) {
+    const string fileName = PROGRAM_BINARY_DIR + "/" + name + ".bin";
+    std::unique_ptr<ziStream> infilePtr(ResourceManagerS::instance()->getInputStream(fileName));
+    if (!infilePtr) {
+        return false;
+    }
+
+    const string data = infilePtr->readAll();
+    if (data.size() < sizeof(ProgramBinaryHeader)) {
+        LOG_WARNING << "Shader cache " << fileName << " truncated\n";
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if ((memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic)) != 0) ||
+        (header.version != PROGRAM_BINARY_VERSION) ||
+        (header.length != data.size() - sizeof(header))) {
+        LOG_WARNING << "Shader cache " << fileName << " invalid\n";
+        return false;
+    }
+
+    if (memcmp(header.key, key, SHA256_DIGEST_SIZE) != 0) {
+        LOG_INFO << "Shader cache " << fileName << " out of date\n";
+        return false;
+    }
+
+    if (!prog->loadBinary(header.format, data.data() + sizeof(header), header.length)) {
+        LOG_WARNING << "Shader cache " << fileName << " rejected by driver\n";
+        return false;
+    }
+
+    return true;
+}
+
+void ProgramManager::saveProgramBinary(const string& name, const unsigned char* key, Program* prog) {
+    GLenum format = 0;
+    vector<unsigned char> binary;
+    if (!prog->getBinary(format, binary)) {
+        LOG_WARNING << "Unable to get binary for shader program " << name << "\n";
+        return;
+    }
+
+    if (!ResourceManagerS::instance()->hasResource(PROGRAM_BINARY_DIR)) {
+        if (!ResourceManagerS::instance()->makeDirectory(PROGRAM_BINARY_DIR)) {
+            return;
+        }
+    }
+
+    ProgramBinaryHeader header;
+    memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic));
+    header.version = PROGRAM_BINARY_VERSION;
+    memcpy(header.key, key, SHA256_DIGEST_SIZE);
+    header.format = format;
+    header.length = (uint32_t)binary.size();
+
+    const string fileName = PROGRAM_BINARY_DIR + "/" + name + ".bin";
+    zoStream outfile(fileName);
+    if (!outfile.isOK()) {
+        return;
+    }
+    outfile.write((const char*)&header, sizeof(header));
+    outfile.write((const char*)binary.data(), binary.size());
+}
+
 string ProgramManager::loadShaderSource(const string& shaderSrcFile) {
     if (!ResourceManagerS::instance()->hasResource(shaderSrcFile)) {
         LOG_ERROR << shaderSrcFile << " not found!" << endl;
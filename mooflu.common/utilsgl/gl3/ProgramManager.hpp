@@ -19,6 +19,12 @@ public:
 protected:
     static std::string loadShaderSource(const std::string& shaderSrcFile);
 
+    //Linked program binaries are cached in the write directory, keyed by a
+    //hash of the shader sources and the GL vendor/renderer/version.
+    bool loadProgramBinary(const std::string& name, const unsigned char* key, Program* prog);
+    void saveProgramBinary(const std::string& name, const unsigned char* key, Program* prog);
+    void makeProgramKey(const std::string& vSource, const std::string& fSource, unsigned char* key);
+
 private:
     virtual ~ProgramManager();
     ProgramManager(void);
@@ -26,6 +32,7 @@ private:
     ProgramManager& operator=(const ProgramManager&);
 
     std::unordered_map<std::string, Program*> _programs;
+    bool _binaryCacheSupported;
 };
 
 typedef Singleton<ProgramManager> ProgramManagerS;
@@ -0,0 +1,91 @@
+#include "RenderQueue.hpp"
+
+#include <string.h>
+
+//Key layout, most significant bits first:
+//  opaque:      pass:2 program:8 texture:16 depth:24 unused:14
+//  transparent: pass:2 ~depth:24 program:8 texture:16 unused:14
+static const int PASS_SHIFT = 62;
+static const uint64_t DEPTH_MASK = 0xffffff;
+static const uint64_t PROGRAM_MASK = 0xff;
+static const uint64_t TEXTURE_MASK = 0xffff;
+
+RenderQueue::RenderQueue() {}
+
+RenderQueue::~RenderQueue() {}
+
+uint64_t RenderQueue::makeKey(Pass pass, unsigned int program, unsigned int texture, float depth) {
+    if (depth < 0.0f) {
+        depth = 0.0f;
+    } else if (depth > 1.0f) {
+        depth = 1.0f;
+    }
+    uint64_t d = (uint64_t)(depth * (float)DEPTH_MASK);
+    uint64_t p = program & PROGRAM_MASK;
+    uint64_t t = texture & TEXTURE_MASK;
+
+    uint64_t key = (uint64_t)pass << PASS_SHIFT;
+    if (pass == eOpaque) {
+        key |= (p << 54) | (t << 38) | (d << 14);
+    } else {
+        key |= ((DEPTH_MASK - d) << 38) | (p << 30) | (t << 14);
+    }
+    return key;
+}
+
+RenderQueue::Pass RenderQueue::getPass(uint64_t key) {
+    return (Pass)(key >> PASS_SHIFT);
+}
+
+void RenderQueue::clear() {
+    _entries.clear();
+}
+
+void RenderQueue::add(uint64_t key, unsigned int item) {
+    Entry e;
+    e.key = key;
+    e.item = item;
+    _entries.push_back(e);
+}
+
+void RenderQueue::sort() {
+    size_t n = _entries.size();
+    if (n < 2) {
+        return;
+    }
+    _scratch.resize(n);
+
+    Entry* src = _entries.data();
+    Entry* dst = _scratch.data();
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256];
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < n; i++) {
+            counts[(src[i].key >> shift) & 0xff]++;
+        }
+
+        //all keys share this byte (e.g. the unused low bits) - nothing to do
+        if (counts[(src[0].key >> shift) & 0xff] == n) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = counts[b];
+            counts[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            dst[counts[(src[i].key >> shift) & 0xff]++] = src[i];
+        }
+
+        Entry* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != _entries.data()) {
+        memcpy(_entries.data(), src, n * sizeof(Entry));
+    }
+}
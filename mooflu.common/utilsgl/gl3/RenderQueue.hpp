@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+//Collects draws as packed 64 bit sort keys and hands them back in
+//execution order. Opaque draws are grouped by program and texture and then
+//go front-to-back; transparent draws go strictly back-to-front.
+class RenderQueue {
+public:
+    enum Pass {
+        eOpaque = 0,
+        eTransparent = 1,
+    };
+
+    RenderQueue();
+    virtual ~RenderQueue();
+
+    //depth is the normalized view distance, 0 = near plane, 1 = far plane
+    static uint64_t makeKey(Pass pass, unsigned int program, unsigned int texture, float depth);
+    static Pass getPass(uint64_t key);
+
+    void clear();
+    void add(uint64_t key, unsigned int item);
+
+    //stable LSD radix sort of the keys
+    void sort();
+
+    size_t size() const { return _entries.size(); }
+
+    uint64_t key(size_t i) const { return _entries[i].key; }
+
+    unsigned int item(size_t i) const { return _entries[i].item; }
+
+private:
+    struct Entry {
+        uint64_t key;
+        unsigned int item;
+    };
+
+    std::vector<Entry> _entries;
+    std::vector<Entry> _scratch;
+};
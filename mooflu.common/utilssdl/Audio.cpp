@@ -16,14 +16,12 @@
 
 #include "Trace.hpp"
 #include "Config.hpp"
-#include "Value.hpp"
 #include "ResourceManager.hpp"
 #ifdef IPHONE
 #else
 #include "zrwops.hpp"
 #endif
 #include "SampleManager.hpp"
-#include "Timer.hpp"
 #include "GetDataPath.hpp"
 
 #include <sys/types.h>
@@ -37,27 +35,28 @@ using namespace std;
 
 Audio::Audio() :
     _sampleManager(0),
+    _voiceManager(0),
     _soundTrack(0),
-    _soundTrackData(0),
+    _playlist(),
+    _playlistPos(0),
     _defaultSoundtrack(""),
-    _playDefaultSoundtrack(true),
-    _playMusic(true),
+    _playDefaultSoundtrack("playDefaultSoundtrack", true),
+    _playMusic("playMusic", true),
+    _restartMusic(false),
     _isPlaying(false),
     _unloadMusic(false),
-    _musicVolume(0.8f),
-    _effectsVolume(0.8f),
+    _musicVolume("musicVolume", 0.8f),
+    _effectsVolume("effectsVolume", 0.8f),
     _audioEnabled(true) {
     XTRACE();
 
     bool dummy;
     //if config variables don't exist (upgrade, etc) update
     if (!ConfigS::instance()->getBoolean("playMusic", dummy)) {
-        Value* v = new Value(_playMusic);
-        ConfigS::instance()->updateKeyword("playMusic", v);
+        _playMusic.set(_playMusic);
     }
     if (!ConfigS::instance()->getBoolean("playDefaultSoundtrack", dummy)) {
-        Value* v = new Value(_playDefaultSoundtrack);
-        ConfigS::instance()->updateKeyword("playDefaultSoundtrack", v);
+        _playDefaultSoundtrack.set(_playDefaultSoundtrack);
     }
 }
 
@@ -71,6 +70,7 @@ Audio::~Audio() {
 #endif
     unloadMusic();
 
+    delete _voiceManager;
     Mix_CloseAudio();
     delete _sampleManager;
 
@@ -100,13 +100,11 @@ void Audio::loadMusic(const string& mod) {
         return;
     }
 
-    std::shared_ptr<ziStream> infilePtr(ResourceManagerS::instance()->getInputStream(mod));
-    ziStream& infile = *infilePtr;
-
-    int fileSize = infile.fileSize();
-    _soundTrackData = new char[fileSize];
-    infile.read(_soundTrackData, fileSize);
-    SDL_RWops* src = SDL_RWFromMem(_soundTrackData, fileSize);
+    //stream from PhysFS, SDL_mixer closes src when the music is freed
+    SDL_RWops* src = RWops_stream_from_PhysFS(mod);
+    if (!src) {
+        return;
+    }
 
     _soundTrack = Mix_LoadMUS_RW(src, true);
 
@@ -114,8 +112,10 @@ void Audio::loadMusic(const string& mod) {
         LOG_ERROR << "Failed to load soundtrack: [" << mod << "]\n";
         LOG_ERROR << SDL_GetError() << "\n";
     } else {
+        //with a playlist play each track once, otherwise loop
+        int loops = (_playlist.size() > 1) ? 1 : -1;
         //loop soundtrack
-        Mix_FadeInMusic(_soundTrack, -1, 500);
+        Mix_FadeInMusic(_soundTrack, loops, 500);
         Mix_HookMusicFinished(::musicFinished);
         _isPlaying = true;
     }
@@ -135,31 +135,57 @@ bool Audio::init(void) {
             _audioEnabled = false;
             return false;
         }
+    }
+
+    return true;
+}
+
+bool Audio::open(void) {
+    XTRACE();
 
+    if (_audioEnabled) {
         //Note: set rate to 48000 (ogg playback on VM didn't work with DEFAULT (22050))
-        if (Mix_OpenAudio(48000, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, 1024) < 0) {
+        //smaller buffers lower the latency but underrun sooner (see voice stats)
+        int bufferSize = 1024;
+        ConfigS::instance()->getInteger("audioBufferSize", bufferSize);
+        int numChannels = 16;
+        ConfigS::instance()->getInteger("audioChannels", numChannels);
+
+        if (Mix_OpenAudio(48000, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, bufferSize) < 0) {
             LOG_WARNING << "Open Audio failed: " << SDL_GetError() << "\n";
             _audioEnabled = false;
             return false;
         }
 
+        int frequency = 48000;
+        Uint16 format;
+        int outputChannels;
+        Mix_QuerySpec(&frequency, &format, &outputChannels);
+
+        _voiceManager = new VoiceManager();
+        _voiceManager->init(numChannels, frequency, bufferSize);
+
         _sampleManager = new SampleManager();
+        _sampleManager->startPreload("system/preload.txt");
 
         //make sure we have default volumes
         float dummy;
         if (!ConfigS::instance()->getFloat("musicVolume", dummy)) {
-            Value* v = new Value(0.8f);
-            ConfigS::instance()->updateKeyword("musicVolume", v);
+            _musicVolume.set(_musicVolume);
         }
         if (!ConfigS::instance()->getFloat("effectsVolume", dummy)) {
-            Value* v = new Value(0.8f);
-            ConfigS::instance()->updateKeyword("effectsVolume", v);
+            _effectsVolume.set(_effectsVolume);
         }
 
-        ConfigS::instance()->getBoolean("playMusic", _playMusic);
-        ConfigS::instance()->getBoolean("playDefaultSoundtrack", _playDefaultSoundtrack);
         startMusic();
-        updateVolume();
+
+        _musicVolume.subscribe([](const float& volume) { Mix_VolumeMusic((int)(MIX_MAX_VOLUME * volume)); });
+        _effectsVolume.subscribe([](const float& volume) { Mix_Volume(-1, (int)(MIX_MAX_VOLUME * volume)); });
+
+        ConfigValue<bool>::Callback musicChanged = [this](const bool&) { _restartMusic = true; };
+        _playMusic.subscribe(musicChanged);
+        _playDefaultSoundtrack.subscribe(musicChanged);
+        _restartMusic = false;
     }
 
     if (_audioEnabled) {
@@ -176,19 +202,48 @@ void Audio::playSample(const string& sampleName) {
         return;
     }
 
+    playSample(getSampleId(sampleName));
+}
+
+SampleId Audio::getSampleId(const string& sampleName) {
+    if (!_sampleManager) {
+        return INVALID_SAMPLE;
+    }
+
 #ifdef IPHONE
     string fullName = sampleName + ".caf";
-    Mix_Chunk* sample = _sampleManager->getSample(fullName);
 #else
     string fullName = sampleName;
-    Mix_Chunk* sample = _sampleManager->getSample(fullName);
 #endif
+    return _sampleManager->getSampleId(fullName);
+}
+
+void Audio::finishPreload(void) {
+    if (_sampleManager) {
+        _sampleManager->finishPreload();
+    }
+}
+
+void Audio::playSample(SampleId id) {
+    if (!_sampleManager || !_audioEnabled) {
+        return;
+    }
+
+    Mix_Chunk* sample = _sampleManager->getSample(id);
     if (sample) {
-        //any channel, no loop
-        Mix_PlayChannel(-1, sample, 0);
+        _voiceManager->play(id, sample, _sampleManager->getProperties(id));
     }
 }
 
+bool Audio::getVoiceStats(VoiceStats& stats) {
+    if (!_voiceManager || !_audioEnabled) {
+        return false;
+    }
+
+    _voiceManager->getStats(stats);
+    return true;
+}
+
 void Audio::turnMusicOff(void) {
     if (_isPlaying) {
         Mix_FadeOutMusic(500);
@@ -196,6 +251,43 @@ void Audio::turnMusicOff(void) {
     }
 }
 
+void Audio::loadPlaylist(const string& playlistName) {
+    _playlist.clear();
+    _playlistPos = 0;
+
+    if (playlistName == "") {
+        return;
+    }
+    if (!ResourceManagerS::instance()->hasResource(playlistName)) {
+        LOG_WARNING << "Playlist [" << playlistName << "] not found.\n";
+        return;
+    }
+
+    std::shared_ptr<ziStream> infilePtr(ResourceManagerS::instance()->getInputStream(playlistName));
+    ziStream& infile = *infilePtr;
+
+    //one track per line, '#' starts a comment
+    string line;
+    while (!getline(infile, line).eof()) {
+        if (!line.empty() && (line[line.length() - 1] == '\r')) {
+            line.erase(line.length() - 1);
+        }
+        if (line.empty() || (line[0] == '#')) {
+            continue;
+        }
+        _playlist.push_back(line);
+    }
+    LOG_INFO << "Playlist " << playlistName << ": " << _playlist.size() << " tracks\n";
+}
+
+void Audio::nextTrack(void) {
+    if (_playlist.size() < 2) {
+        return;
+    }
+    _playlistPos = (_playlistPos + 1) % _playlist.size();
+    loadMusic(_playlist[_playlistPos]);
+}
+
 void Audio::setDefaultSoundtrack(const string& fileName) {
     _defaultSoundtrack = fileName;
 }
@@ -204,10 +296,18 @@ void Audio::startMusic(void) {
     if (_playMusic) {
         string soundtrack = "";
 
+        _playlist.clear();
         if (_playDefaultSoundtrack) {
             soundtrack = _defaultSoundtrack;
         } else {
-            ConfigS::instance()->getString("soundtrack", soundtrack);
+            string playlist = "";
+            ConfigS::instance()->getString("playlist", playlist);
+            loadPlaylist(playlist);
+            if (!_playlist.empty()) {
+                soundtrack = _playlist[_playlistPos];
+            } else {
+                ConfigS::instance()->getString("soundtrack", soundtrack);
+            }
         }
 
         turnMusicOff();
@@ -217,52 +317,10 @@ void Audio::startMusic(void) {
     }
 }
 
-void Audio::updateSettings(void) {
-    if (Mix_FadingMusic() != MIX_NO_FADING) {
-        return;
-    }
-
-    bool oldPlayMusic = _playMusic;
-    bool oldPlayDefaultSoundtrack = _playDefaultSoundtrack;
-
-    ConfigS::instance()->getBoolean("playMusic", _playMusic);
-    ConfigS::instance()->getBoolean("playDefaultSoundtrack", _playDefaultSoundtrack);
-
-    if ((oldPlayMusic == _playMusic) && (oldPlayDefaultSoundtrack == _playDefaultSoundtrack)) {
-        //no changes...
-        return;
-    }
-
-    startMusic();
-}
-
-void Audio::updateVolume(void) {
-    int newVolume;
-
-    float musicVolume = 0.8f;
-    ConfigS::instance()->getFloat("musicVolume", musicVolume);
-    newVolume = (int)(MIX_MAX_VOLUME * musicVolume);
-    if (_musicVolume != musicVolume) {
-        _musicVolume = musicVolume;
-        Mix_VolumeMusic(newVolume);
-    }
-
-    float effectsVolume = 0.8f;
-    ConfigS::instance()->getFloat("effectsVolume", effectsVolume);
-    newVolume = (int)(MIX_MAX_VOLUME * effectsVolume);
-    if (_effectsVolume != effectsVolume) {
-        _effectsVolume = effectsVolume;
-        Mix_Volume(-1, newVolume);
-        //playSample( "sounds/beep");
-    }
-}
-
 void Audio::unloadMusic(void) {
     if (_soundTrack) {
         Mix_FreeMusic(_soundTrack);
         _soundTrack = 0;
-        delete[] _soundTrackData;
-        _soundTrackData = 0;
     }
 }
 
@@ -274,15 +332,16 @@ bool Audio::update(void) {
     if (_unloadMusic) {
         unloadMusic();
         _unloadMusic = false;
-    }
 
-    updateVolume();
+        //track ended by itself (not faded out), continue with the playlist
+        if (_isPlaying) {
+            nextTrack();
+        }
+    }
 
-    static double nextTime = Timer::getTime() + 0.5;
-    double thisTime = Timer::getTime();
-    if (thisTime > nextTime) {
-        updateSettings();
-        nextTime = thisTime + 0.5;
+    if (_restartMusic && (Mix_FadingMusic() == MIX_NO_FADING)) {
+        _restartMusic = false;
+        startMusic();
     }
 
     return true;
@@ -15,22 +15,36 @@
 //
 
 #include <string>
+#include <vector>
 
 #define USE_RWOPS
 #include "SDL2/SDL_mixer.h"
 #include "Singleton.hpp"
+#include "Config.hpp"
+#include "SampleManager.hpp"
+#include "VoiceManager.hpp"
 
 using std::string;
 
-class SampleManager;
-
 class Audio {
     friend class Singleton<Audio>;
 
 public:
+    //SDL audio subsystem, call on the main thread
     bool init(void);
+    //Opens the device, starts sample decoding and the music. Can run on
+    //another thread (e.g. while the window is created), after init.
+    bool open(void);
     bool update(void);
     void playSample(const string& sampleName);
+    //Resolve sample name once, then play by id without string lookups
+    SampleId getSampleId(const string& sampleName);
+    void playSample(SampleId id);
+    //Wait for samples decoded in the background since open
+    void finishPreload(void);
+
+    //Voice usage since open; false if audio is off
+    bool getVoiceStats(VoiceStats& stats);
     void setDefaultSoundtrack(const string& fileName);
 
     void toggleAudioEnabled() { _audioEnabled = !_audioEnabled; }
@@ -46,24 +60,30 @@ private:
     Audio& operator=(const Audio&);
 
     void loadMusic(const string& mod);
+    void loadPlaylist(const string& playlistName);
+    void nextTrack(void);
     void unloadMusic(void);
     void turnMusicOff(void);
     void startMusic(void);
-    void updateSettings(void);
-    void updateVolume(void);
 
     SampleManager* _sampleManager;
+    VoiceManager* _voiceManager;
 
     Mix_Music* _soundTrack;
-    char* _soundTrackData;
+
+    //tracks streamed in order when a playlist is configured
+    std::vector<string> _playlist;
+    size_t _playlistPos;
 
     string _defaultSoundtrack;
-    bool _playDefaultSoundtrack;
-    bool _playMusic;
+    ConfigValue<bool> _playDefaultSoundtrack;
+    ConfigValue<bool> _playMusic;
+    //music settings changed, restart once no fade is in progress
+    bool _restartMusic;
     bool _isPlaying;
     bool _unloadMusic;
-    float _musicVolume;
-    float _effectsVolume;
+    ConfigValue<float> _musicVolume;
+    ConfigValue<float> _effectsVolume;
 
     bool _audioEnabled;
 };
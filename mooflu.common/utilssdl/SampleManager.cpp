@@ -20,14 +20,26 @@
 
 #include "SDL2/SDL_mixer.h"
 
+#include <algorithm>
 #include <memory>
+#include <sstream>
 using namespace std;
 
-SampleManager::SampleManager(void) {
+SampleManager::SampleManager(void) :
+    _preloadNames(),
+    _preloadSamples(),
+    _preloadThread(0),
+    _preloading(false),
+    _samples(),
+    _properties(),
+    _sampleIds(),
+    _manifestProperties() {
     XTRACE();
 }
 
 SampleManager::~SampleManager() {
+    finishPreload();
+
     //need to override base destructor behaviour, since we need
     //to Mix_FreeChunk not delete.
 
@@ -39,7 +51,7 @@ SampleManager::~SampleManager() {
     _resourceMap.clear();
 }
 
-Mix_Chunk* SampleManager::load(const string& wav) {
+Mix_Chunk* SampleManager::decode(const string& wav) {
     XTRACE();
 #ifdef IPHONE
     Mix_Chunk* mix = Mix_Load(wav);
@@ -67,3 +79,146 @@ Mix_Chunk* SampleManager::load(const string& wav) {
 #endif
     return mix;
 }
+
+Mix_Chunk* SampleManager::getSample(const string& sampleName) {
+    //anything else loads right away, the preload thread never touches the cache
+    if (isPreloading(sampleName)) {
+        finishPreload();
+    }
+    return getResource(sampleName);
+}
+
+bool SampleManager::isPreloading(const string& sampleName) {
+    return _preloading && (find(_preloadNames.begin(), _preloadNames.end(), sampleName) != _preloadNames.end());
+}
+
+SampleId SampleManager::getSampleId(const string& sampleName) {
+    hash_map<string, SampleId>::const_iterator ci = _sampleIds.find(sampleName);
+    if (ci != _sampleIds.end()) {
+        return ci->second;
+    }
+
+    //missing samples get an id too, so we only try to load them once
+    SampleId id = (SampleId)_samples.size();
+    if (isPreloading(sampleName)) {
+        //don't wait for the preload thread, finishPreload fills this in
+        _samples.push_back(0);
+    } else {
+        _samples.push_back(getSample(sampleName));
+    }
+    _sampleIds[sampleName] = id;
+
+    SampleProperties properties;
+    hash_map<string, SampleProperties>::const_iterator pi = _manifestProperties.find(sampleName);
+    if (pi != _manifestProperties.end()) {
+        properties = pi->second;
+    }
+    _properties.push_back(properties);
+
+    return id;
+}
+
+bool SampleManager::startPreload(const string& manifestName) {
+    XTRACE();
+    if (_preloading) {
+        return false;
+    }
+    if (!ResourceManagerS::instance()->hasResource(manifestName)) {
+        LOG_WARNING << "Preload manifest [" << manifestName << "] not found." << endl;
+        return false;
+    }
+
+    std::shared_ptr<ziStream> infilePtr(ResourceManagerS::instance()->getInputStream(manifestName));
+    ziStream& infile = *infilePtr;
+
+    _preloadNames.clear();
+    string line;
+    while (!getline(infile, line).eof()) {
+        istringstream tokens(line);
+        string type;
+        string name;
+        tokens >> type >> name;
+        if ((type != "sample") || name.empty()) {
+            continue;
+        }
+
+        SampleProperties properties;
+        int value;
+        if (tokens >> value) {
+            properties.priority = value;
+        }
+        if (tokens >> value) {
+            properties.maxInstances = value;
+        }
+        if (tokens >> value) {
+            properties.cooldown = (Uint32)value;
+        }
+        _manifestProperties[name] = properties;
+
+        if (!isCached(name)) {
+            _preloadNames.push_back(name);
+        }
+    }
+    if (_preloadNames.empty()) {
+        return true;
+    }
+
+    _preloadSamples.assign(_preloadNames.size(), (Mix_Chunk*)0);
+    _preloading = true;
+
+    _preloadThread = SDL_CreateThread(preloadThread, "sample-loader", this);
+    if (!_preloadThread) {
+        LOG_WARNING << "Unable to create sample loader thread: " << SDL_GetError() << endl;
+        decodePreload();
+    }
+
+    LOG_INFO << "Preloading " << _preloadNames.size() << " samples" << endl;
+    return true;
+}
+
+int SampleManager::preloadThread(void* data) {
+    SampleManager* sampleManager = (SampleManager*)data;
+    sampleManager->decodePreload();
+    return 0;
+}
+
+void SampleManager::decodePreload(void) {
+    for (size_t i = 0; i < _preloadNames.size(); i++) {
+        _preloadSamples[i] = decode(_preloadNames[i]);
+    }
+}
+
+void SampleManager::finishPreload(void) {
+    if (!_preloading) {
+        return;
+    }
+    _preloading = false;
+
+    if (_preloadThread) {
+        SDL_WaitThread(_preloadThread, 0);
+        _preloadThread = 0;
+    }
+
+    for (size_t i = 0; i < _preloadNames.size(); i++) {
+        Mix_Chunk* sample = _preloadSamples[i];
+        if (!sample) {
+            continue;
+        }
+        if (isCached(_preloadNames[i])) {
+            Mix_FreeChunk(sample);
+            continue;
+        }
+        addDecoded(_preloadNames[i], sample);
+    }
+
+    //ids handed out while the preload was running
+    hash_map<string, SampleId>::const_iterator ci;
+    for (ci = _sampleIds.begin(); ci != _sampleIds.end(); ci++) {
+        if (!_samples[ci->second]) {
+            _samples[ci->second] = findHash<const string>(ci->first, _resourceMap);
+        }
+    }
+
+    _preloadNames.clear();
+    _preloadSamples.clear();
+}
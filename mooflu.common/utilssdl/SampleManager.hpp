@@ -14,21 +14,79 @@
 // FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
 //
 #include <string>
+#include <vector>
 
 #include "ResourceCache.hpp"
 #include "SDL2/SDL_mixer.h"
+#include "SDL_thread.h"
+
+//Handle for a sample resolved once by name
+typedef int SampleId;
+const SampleId INVALID_SAMPLE = -1;
+
+//Playback rules used by the VoiceManager
+struct SampleProperties {
+    SampleProperties(void) :
+        priority(1),
+        maxInstances(4),
+        cooldown(0) {}
+
+    int priority;      //higher priority sounds steal voices from lower ones
+    int maxInstances;  //simultaneous voices of this sample, 0 = unlimited
+    Uint32 cooldown;   //minimum ms between two starts
+};
 
 class SampleManager : public ResourceCache<Mix_Chunk> {
 public:
     SampleManager(void);
     virtual ~SampleManager();
 
-    Mix_Chunk* getSample(const std::string& sampleName) { return getResource(sampleName); }
+    //Only waits for the preload thread if it is decoding sampleName
+    Mix_Chunk* getSample(const std::string& sampleName);
+
+    //Resolve (and load) sample once; play with the returned id afterwards
+    SampleId getSampleId(const std::string& sampleName);
+
+    Mix_Chunk* getSample(SampleId id) {
+        if ((id < 0) || (id >= (int)_samples.size())) {
+            return 0;
+        }
+        return _samples[id];
+    }
+
+    const SampleProperties& getProperties(SampleId id) { return _properties[id]; }
+    void setProperties(SampleId id, const SampleProperties& properties) { _properties[id] = properties; }
+
+    //Decode samples listed in the manifest on a worker thread.
+    //Lines: "sample <name> [priority] [maxInstances] [cooldownMs]"
+    bool startPreload(const std::string& manifestName);
+    //Wait for the preload thread and cache its samples
+    void finishPreload(void);
+
+    virtual Mix_Chunk* decode(const std::string& wav);
 
 protected:
-    virtual Mix_Chunk* load(const std::string& wav);
+    //samples need no GL upload
+    virtual bool upload(Mix_Chunk*) { return true; }
 
 private:
     SampleManager(const SampleManager&);
     SampleManager& operator=(const SampleManager&);
+
+    static int preloadThread(void* data);
+    bool isPreloading(const std::string& sampleName);
+    void decodePreload(void);
+
+    //only touched by the preload thread until finishPreload joins it
+    std::vector<std::string> _preloadNames;
+    std::vector<Mix_Chunk*> _preloadSamples;
+    SDL_Thread* _preloadThread;
+    bool _preloading;
+
+    std::vector<Mix_Chunk*> _samples;
+    std::vector<SampleProperties> _properties;
+    hash_map<std::string, SampleId> _sampleIds;
+
+    //properties from the manifest, applied when the id is created
+    hash_map<std::string, SampleProperties> _manifestProperties;
 };
@@ -0,0 +1,194 @@
+// Description:
+//   Voice Manager. Assigns mixer channels to samples based on priority,
+//   instance limits and cooldown, and tracks voice usage.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include "VoiceManager.hpp"
+
+#include "Trace.hpp"
+
+#include "SDL.h"
+#include "SDL2/SDL_mixer.h"
+
+using namespace std;
+
+VoiceManager::VoiceManager(void) :
+    _voices(),
+    _lastStarted(),
+    _peakActive(0),
+    _played(0),
+    _stolen(0),
+    _dropped(0),
+    _cooldownSkips(0),
+    _bufferMs(0),
+    _lastMix(0),
+    _lateMix(0) {
+    XTRACE();
+    SDL_AtomicSet(&_underruns, 0);
+}
+
+VoiceManager::~VoiceManager() {
+    XTRACE();
+    Mix_SetPostMix(0, 0);
+}
+
+void VoiceManager::init(int numChannels, int frequency, int bufferSize) {
+    XTRACE();
+    int channels = Mix_AllocateChannels(numChannels);
+
+    Voice idle;
+    idle.id = INVALID_SAMPLE;
+    idle.priority = 0;
+    idle.started = 0;
+    _voices.assign(channels, idle);
+
+    //a mix callback arriving more than two buffers late means the device ran dry
+    _bufferMs = 1000.0f * (float)bufferSize / (float)frequency;
+    _lateMix = (Uint64)(2.0 * (double)bufferSize / (double)frequency * (double)SDL_GetPerformanceFrequency());
+    Mix_SetPostMix(postMix, this);
+
+    LOG_INFO << "Voices: " << channels << " channels, " << _bufferMs << "ms buffer\n";
+}
+
+void VoiceManager::postMix(void* udata, Uint8* /*stream*/, int /*len*/) {
+    VoiceManager* voiceManager = (VoiceManager*)udata;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (voiceManager->_lastMix && ((now - voiceManager->_lastMix) > voiceManager->_lateMix)) {
+        SDL_AtomicAdd(&voiceManager->_underruns, 1);
+    }
+    voiceManager->_lastMix = now;
+}
+
+void VoiceManager::updateVoices(void) {
+    for (size_t i = 0; i < _voices.size(); i++) {
+        if ((_voices[i].id != INVALID_SAMPLE) && !Mix_Playing((int)i)) {
+            _voices[i].id = INVALID_SAMPLE;
+        }
+    }
+}
+
+int VoiceManager::findVoice(SampleId id, const SampleProperties& properties) {
+    int instances = 0;
+    int oldestInstance = -1;
+    int freeVoice = -1;
+    int victim = -1;
+
+    for (size_t i = 0; i < _voices.size(); i++) {
+        Voice& voice = _voices[i];
+        if (voice.id == INVALID_SAMPLE) {
+            if (freeVoice < 0) {
+                freeVoice = (int)i;
+            }
+            continue;
+        }
+
+        if (voice.id == id) {
+            instances++;
+            if ((oldestInstance < 0) || (voice.started < _voices[oldestInstance].started)) {
+                oldestInstance = (int)i;
+            }
+        }
+
+        //lowest priority, oldest first
+        if (voice.priority <= properties.priority) {
+            if ((victim < 0) || (voice.priority < _voices[victim].priority) ||
+                ((voice.priority == _voices[victim].priority) && (voice.started < _voices[victim].started))) {
+                victim = (int)i;
+            }
+        }
+    }
+
+    //at the instance limit restart our own oldest voice
+    if ((properties.maxInstances > 0) && (instances >= properties.maxInstances)) {
+        _stolen++;
+        return oldestInstance;
+    }
+
+    if (freeVoice >= 0) {
+        return freeVoice;
+    }
+
+    if (victim >= 0) {
+        _stolen++;
+    }
+    return victim;
+}
+
+int VoiceManager::play(SampleId id, Mix_Chunk* sample, const SampleProperties& properties) {
+    if (!sample || (id < 0)) {
+        return -1;
+    }
+
+    Uint32 now = SDL_GetTicks();
+    if ((size_t)id >= _lastStarted.size()) {
+        _lastStarted.resize(id + 1, 0);
+    }
+    if (properties.cooldown && _lastStarted[id] && ((now - _lastStarted[id]) < properties.cooldown)) {
+        _cooldownSkips++;
+        return -1;
+    }
+
+    updateVoices();
+
+    int channel = findVoice(id, properties);
+    if (channel < 0) {
+        _dropped++;
+        return -1;
+    }
+
+    //playing on a busy channel halts the voice that was there
+    channel = Mix_PlayChannel(channel, sample, 0);
+    if (channel < 0) {
+        _dropped++;
+        return -1;
+    }
+
+    Voice& voice = _voices[channel];
+    voice.id = id;
+    voice.priority = properties.priority;
+    voice.started = now;
+
+    _lastStarted[id] = now;
+    _played++;
+
+    int active = 0;
+    for (size_t i = 0; i < _voices.size(); i++) {
+        if (_voices[i].id != INVALID_SAMPLE) {
+            active++;
+        }
+    }
+    if (active > _peakActive) {
+        _peakActive = active;
+    }
+
+    return channel;
+}
+
+void VoiceManager::getStats(VoiceStats& stats) {
+    updateVoices();
+
+    stats.channels = (int)_voices.size();
+    stats.active = 0;
+    for (size_t i = 0; i < _voices.size(); i++) {
+        if (_voices[i].id != INVALID_SAMPLE) {
+            stats.active++;
+        }
+    }
+    stats.peakActive = _peakActive;
+    stats.played = _played;
+    stats.stolen = _stolen;
+    stats.dropped = _dropped;
+    stats.cooldownSkips = _cooldownSkips;
+    stats.underruns = (unsigned int)SDL_AtomicGet(&_underruns);
+    stats.bufferMs = _bufferMs;
+}
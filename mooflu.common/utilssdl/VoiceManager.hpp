@@ -0,0 +1,77 @@
+#pragma once
+// Description:
+//   Voice Manager. Assigns mixer channels to samples based on priority,
+//   instance limits and cooldown, and tracks voice usage.
+//
+// Copyright (C) 2011 Frank Becker
+//
+// This program is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation;  either version 2 of the License,  or (at your option) any  later
+// version.
+//
+// This program is distributed in the hope that it will be useful,  but  WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details
+//
+#include <vector>
+
+#include "SDL_atomic.h"
+#include "SampleManager.hpp"
+
+struct VoiceStats {
+    int channels;
+    int active;
+    int peakActive;
+    unsigned int played;
+    unsigned int stolen;
+    unsigned int dropped;
+    unsigned int cooldownSkips;
+    unsigned int underruns;  //late mixer callbacks
+    float bufferMs;
+};
+
+class VoiceManager {
+public:
+    VoiceManager(void);
+    ~VoiceManager();
+
+    //Allocate mixer channels and hook the post mix callback. Call after Mix_OpenAudio.
+    void init(int numChannels, int frequency, int bufferSize);
+
+    //Play sample honouring its properties. Returns channel or -1 if not played.
+    int play(SampleId id, Mix_Chunk* sample, const SampleProperties& properties);
+
+    void getStats(VoiceStats& stats);
+
+private:
+    VoiceManager(const VoiceManager&);
+    VoiceManager& operator=(const VoiceManager&);
+
+    struct Voice {
+        SampleId id;
+        int priority;
+        Uint32 started;
+    };
+
+    static void postMix(void* udata, Uint8* stream, int len);
+
+    //release voices whose channel has finished
+    void updateVoices(void);
+    int findVoice(SampleId id, const SampleProperties& properties);
+
+    std::vector<Voice> _voices;
+    std::vector<Uint32> _lastStarted;
+
+    int _peakActive;
+    unsigned int _played;
+    unsigned int _stolen;
+    unsigned int _dropped;
+    unsigned int _cooldownSkips;
+    float _bufferMs;
+
+    //written by the audio thread
+    SDL_atomic_t _underruns;
+    Uint64 _lastMix;
+    Uint64 _lateMix;
+};
@@ -44,7 +44,15 @@ case "$(uname -sr)" in
      ;;
 esac
 
-if [ ! -f resource.dat ]; then
+# The web build preloads resource.dat from here. Pack it with the respack
+# of a native build (scripts/build.sh) so it gets the index, a plain zip
+# still works without it. Always repack, an old one would be stale.
+rm -f resource.dat
+RESPACK=`ls build.oem.*/tools/respack 2>/dev/null | head -n 1`
+if [ -n "${RESPACK}" ]; then
+    ${RESPACK} data resource.dat
+else
+    echo "No native respack found, packing resource.dat as a zip"
     pushd data
     zip -9r ../resource.dat .
     popd
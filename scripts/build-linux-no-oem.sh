@@ -3,13 +3,10 @@
 
 sudo apt install zlib1g-dev libpng-dev libsdl2-dev libsdl2-mixer-dev libsdl2-image-dev libphysfs-dev libglew-dev
 
-pushd data
-zip -9r ../resource.dat .
-popd
-
 mkdir -p build
 pushd build
 cmake -DBUILD_SHARED_LIBS=ON ..
+# also packs data into build/game/resource.dat, next to the executable
 cmake --build . --parallel
 popd
 
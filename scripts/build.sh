@@ -37,12 +37,6 @@ case "$(uname -sr)" in
      ;;
 esac
 
-if [ ! -f resource.dat ]; then
-    pushd data
-    zip -9r ../resource.dat .
-    popd
-fi
-
 echo Proj folder: ${PROJ_FOLDER}
 echo Build type: ${BUILD_TYPE}
 
@@ -263,5 +257,6 @@ pushd ${BUILD_DIR}
         -DCMAKE_PREFIX_PATH:PATH=${INSTALL_DIR} \
         -DBUILD_SHARED_LIBS:BOOL=OFF \
         ..
+    # also packs data into an indexed resource.dat in the build directory
     cmake --build . --config ${BUILD_TYPE} --parallel
 popd
@@ -1,10 +1,15 @@
 #!/usr/bin/env python3
 import http.server
 import socketserver
+import urllib.parse
 
 PORT = 8080
 
 class HttpRequestHandler(http.server.SimpleHTTPRequestHandler):
+    # keep-alive, the game reuses its connection to the score server
+    protocol_version = 'HTTP/1.1'
+    disable_nagle_algorithm = True
+
     extensions_map = {
         '': 'application/octet-stream',
         '.manifest': 'text/cache-manifest',
@@ -19,7 +24,47 @@ class HttpRequestHandler(http.server.SimpleHTTPRequestHandler):
         '.xml': 'application/xml',
     }
 
-httpd = socketserver.TCPServer(("", PORT), HttpRequestHandler)
+    # stand-in for the online score server (DUMMYSCORES builds)
+    # Client=id&Batch=seq:score:hash,...  -> "OK <last seq>", duplicate
+    #                           (client, seq) pairs are ignored
+    # Board=WxHxD:blockset      -> top 10 as "name,score,cubes,seconds,time" lines
+    seenScores = {}
+
+    def do_GET(self):
+        url = urllib.parse.urlparse(self.path)
+        if url.path != '/scores':
+            return super().do_GET()
+
+        query = urllib.parse.parse_qs(url.query)
+        if 'Batch' in query:
+            # every install numbers its scores from 1
+            client = query.get('Client', [''])[0]
+            lastSeq = 0
+            for entry in query['Batch'][0].split(','):
+                seq, score, _hash = entry.split(':')
+                self.seenScores.setdefault((client, int(seq)), int(score))
+                lastSeq = max(lastSeq, int(seq))
+            reply = f"OK {lastSeq}"
+        elif 'Board' in query:
+            top = sorted(self.seenScores.values(), reverse=True)[:10]
+            reply = "".join(f"Anonymous,{score},0,0,0\n" for score in top)
+        else:
+            reply = "Error"
+
+        body = reply.encode()
+        self.send_response(200)
+        self.send_header('Content-Type', 'text/plain')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        if not self.path.startswith('/scores'):
+            super().log_message(format, *args)
+
+socketserver.ThreadingTCPServer.allow_reuse_address = True
+socketserver.ThreadingTCPServer.daemon_threads = True
+httpd = socketserver.ThreadingTCPServer(("", PORT), HttpRequestHandler)
 
 try:
     print(f"serving on port {PORT}")
@@ -0,0 +1,158 @@
+// Description:
+//   InitGraph scheduler checks: dependency order, main thread tasks,
+//   failures, and Game::init's task graph (StartupTasks) run serially and in
+//   parallel with sleeps standing in for the work. Only the scheduler is
+//   tested, not how long the game takes to start; the per-task times of a
+//   real startup are in the game's log ("Startup tasks").
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "InitGraph.hpp"
+#include "StartupTasks.hpp"
+#include "Trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+static int failures = 0;
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+static void sleepMs(int ms) {
+    this_thread::sleep_for(chrono::milliseconds(ms));
+}
+
+static void checkOrder(int workers) {
+    mutex lock;
+    vector<string> order;
+    thread::id mainThread = this_thread::get_id();
+    atomic<bool> mainOnMain(true);
+
+    auto task = [&](const char* name, bool main) {
+        return [&, name, main]() {
+            if (main && (this_thread::get_id() != mainThread)) {
+                mainOnMain.store(false);
+            }
+            sleepMs(5);
+            lock_guard<mutex> guard(lock);
+            order.push_back(name);
+            return true;
+        };
+    };
+
+    InitGraph graph;
+    graph.add("a", InitGraph::eAnyThread, task("a", false));
+    graph.add("b", InitGraph::eAnyThread, task("b", false));
+    graph.add("m1", InitGraph::eMainThread, task("m1", true), {"a"});
+    graph.add("c", InitGraph::eAnyThread, task("c", false), {"a", "b"});
+    graph.add("m2", InitGraph::eMainThread, task("m2", true), {"m1", "c"});
+    check(graph.run(workers), "graph runs");
+
+    auto position = [&](const char* name) {
+        for (size_t i = 0; i < order.size(); i++) {
+            if (order[i] == name) {
+                return (int)i;
+            }
+        }
+        return -1;
+    };
+    check(order.size() == 5, "every task runs once");
+    check(position("a") < position("m1"), "m1 runs after a");
+    check((position("a") < position("c")) && (position("b") < position("c")), "c runs after a and b");
+    check((position("m1") < position("m2")) && (position("c") < position("m2")), "m2 runs after m1 and c");
+    check(mainOnMain.load(), "main thread tasks run on the main thread");
+}
+
+static void checkFailures(void) {
+    atomic<int> ran(0);
+    InitGraph graph;
+    graph.add("ok", InitGraph::eAnyThread, [&]() { ran++; return true; });
+    graph.add("fails", InitGraph::eAnyThread, [&]() { ran++; return false; });
+    graph.add("after", InitGraph::eMainThread, [&]() { ran++; return true; }, {"fails"});
+    graph.add("afterAfter", InitGraph::eAnyThread, [&]() { ran++; return true; }, {"after"});
+    graph.add("independent", InitGraph::eMainThread, [&]() { ran++; return true; }, {"ok"});
+    check(!graph.run(), "a failed task fails the run");
+    check(ran.load() == 3, "dependents of a failed task are skipped, the rest runs");
+
+    InitGraph bad;
+    check(!bad.add("orphan", InitGraph::eAnyThread, []() { return true; }, {"missing"}),
+          "unknown dependency is rejected");
+    check(!bad.run(), "a graph with errors doesn't run");
+}
+
+//Game::init's own task graph with made up costs in ms. Images decode on the
+//asset loader's threads while the window is created, the view waits for them.
+static double startup(int workers) {
+    auto cost = [](int ms) {
+        return [ms]() {
+            sleepMs(ms);
+            return true;
+        };
+    };
+
+    thread decode;
+    if (workers) {
+        decode = thread(sleepMs, 150);
+    }
+
+    StartupTasks tasks;
+    tasks.scores = cost(20);
+    tasks.audio = cost(120);
+    tasks.blockset = cost(40);
+    tasks.menuXml = cost(30);
+    tasks.video = cost(150);
+    tasks.view = [&]() {
+        if (decode.joinable()) {
+            decode.join();
+        } else {
+            sleepMs(150);
+        }
+        sleepMs(60);
+        return true;
+    };
+    tasks.input = cost(10);
+    tasks.controller = cost(1);
+    tasks.menu = cost(30);
+    tasks.particles = cost(10);
+
+    InitGraph graph;
+    check(addStartupTasks(graph, tasks), "startup tasks are added");
+    if (!graph.run(workers)) {
+        check(false, "startup runs");
+    }
+    graph.log(workers ? "parallel startup" : "serial startup");
+    return (double)graph.getElapsed() / 1e6;
+}
+
+int main(int, char*[]) {
+    Trace::SetLevel("info");
+
+    checkOrder(0);
+    checkOrder(4);
+    checkFailures();
+
+    double serial = startup(0);
+    double parallel = startup(4);
+    cout << "startup: serial " << serial << "ms, parallel " << parallel << "ms (" << (int)(100 * parallel / serial)
+         << "%)" << endl;
+    //the stand-ins add up to 621ms, 261ms of it on the main thread once
+    //images decode in the background: the rest has to overlap
+    check(parallel <= 0.55 * serial, "the scheduler overlaps independent startup tasks");
+
+    Trace::Flush();
+    if (failures) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All init graph checks passed" << endl;
+    return 0;
+}
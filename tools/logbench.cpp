@@ -0,0 +1,107 @@
+// Description:
+//   Logging benchmark. Logs from several threads to a file, with and
+//   without the log thread, and checks that every line made it out.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "Trace.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+using namespace std;
+
+static void logLines(int thread, int lines, double* callerTime) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < lines; i++) {
+        LOG_INFO << "thread " << thread << " line " << i << " score " << (i * 37) << " "
+                 << "................................" << endl;
+        LOG_DEBUG << "filtered " << i << endl;
+    }
+    *callerTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / lines;
+}
+
+//returns the number of lines from the run, including the rotated file
+static int countLines(const string& fileName) {
+    int count = 0;
+    string names[2] = {fileName + ".1", fileName};
+    for (int f = 0; f < 2; f++) {
+        ifstream in(names[f].c_str());
+        string line;
+        while (getline(in, line)) {
+            if (line.find(" INFO: thread ") != string::npos) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+static bool run(const string& fileName, int threads, int lines, bool async) {
+    remove(fileName.c_str());
+    remove((fileName + ".1").c_str());
+    Trace::SetLogFile(fileName, 64 * 1024 * 1024);
+    if (async && !Trace::StartLogThread()) {
+        cerr << "Unable to start log thread" << endl;
+        return false;
+    }
+
+    vector<thread> workers;
+    vector<double> callerTimes(threads);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread(logLines, t, lines, &callerTimes[t]));
+    }
+    for (int t = 0; t < threads; t++) {
+        workers[t].join();
+    }
+    double callerDone = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    Trace::StopLogThread();
+    double allWritten = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    double callerTime = 0;
+    for (int t = 0; t < threads; t++) {
+        callerTime += callerTimes[t] / threads;
+    }
+
+    int written = countLines(fileName);
+    cout << (async ? "async: " : "sync:  ") << threads * lines << " lines, " << written << " written, "
+         << callerTime << "us per line in the caller, callers done " << callerDone << "ms, all written "
+         << allWritten << "ms" << endl;
+
+    return (written == threads * lines);
+}
+
+int main(int argc, char* argv[]) {
+    int threads = (argc > 1) ? atoi(argv[1]) : 4;
+    int lines = (argc > 2) ? atoi(argv[2]) : 20000;
+    if ((argc > 3) || (threads < 1) || (lines < 1)) {
+        cerr << "Usage: " << argv[0] << " [threads] [lines per thread]" << endl;
+        return 1;
+    }
+
+    string fileName = "logbench.txt";
+    Trace::SetConsole(false);
+    Trace::SetLevel("info");
+
+    if (!run(fileName, threads, lines, false) || !run(fileName, threads, lines, true)) {
+        return 1;
+    }
+
+    //a small rotation limit keeps the last two files
+    Trace::SetLogFile(fileName, 4096);
+    for (int i = 0; i < 1000; i++) {
+        LOG_INFO << "thread 0 rotation " << i << endl;
+    }
+    Trace::Flush();
+    int rotated = countLines(fileName);
+    cout << "rotation: " << rotated << " of 1000 lines in the last two files" << endl;
+
+    remove(fileName.c_str());
+    remove((fileName + ".1").c_str());
+    return ((rotated > 0) && (rotated < 1000)) ? 0 : 1;
+}
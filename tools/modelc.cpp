@@ -0,0 +1,54 @@
+// Description:
+//   Offline model compiler. Turns text .model files into .bmodel files.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "ModelCompiler.hpp"
+
+#include "Trace.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+static int usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-fixnormals] input.model output.bmodel" << endl;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    bool fixNormals = false;
+    int arg = 1;
+    if ((argc > arg) && (string(argv[arg]) == "-fixnormals")) {
+        fixNormals = true;
+        arg++;
+    }
+    if (argc - arg != 2) {
+        return usage(argv[0]);
+    }
+    string inFile = argv[arg];
+    string outFile = argv[arg + 1];
+
+    ifstream infile(inFile.c_str(), ios::in | ios::binary);
+    if (!infile) {
+        LOG_ERROR << "Unable to open: [" << inFile << "]" << endl;
+        return 1;
+    }
+
+    vector<unsigned char> blob;
+    if (!ModelCompiler::compile(infile, inFile, fixNormals, 1.0f, blob)) {
+        LOG_ERROR << "Unable to compile: [" << inFile << "]" << endl;
+        return 1;
+    }
+
+    ofstream outfile(outFile.c_str(), ios::out | ios::binary);
+    outfile.write((const char*)blob.data(), blob.size());
+    if (!outfile) {
+        LOG_ERROR << "Unable to write: [" << outFile << "]" << endl;
+        return 1;
+    }
+
+    LOG_INFO << inFile << " -> " << outFile << " (" << blob.size() << " bytes)" << endl;
+    return 0;
+}
@@ -0,0 +1,238 @@
+// Description:
+//   Resource packer. Turns the data directory into an indexed resource.dat
+//   (see PakFormat.hpp).
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "PakFormat.hpp"
+#include "PakArchive.hpp"
+#include "WalkDirectory.hpp"
+#include "Endian.hpp"
+#include "Trace.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+//only keep the compressed data if it saves at least this much
+const double MIN_COMPRESSION_GAIN = 0.1;
+
+struct PackItem {
+    string name;
+    string path;
+    PakEntry entry;
+    vector<char> stored;
+};
+
+static int usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-align bytes] [-store] dataDir... output.dat" << endl;
+    cerr << "  later directories add to the first one, e.g. generated files" << endl;
+    return 1;
+}
+
+static bool itemLess(const PackItem* a, const PackItem* b) {
+    return a->entry.hash < b->entry.hash;
+}
+
+static void collectFiles(const string& dir, const string& prefix, vector<PackItem*>& items) {
+    WalkDirectory walker(dir);
+    DirEntry dirEntry;
+    while (walker.getNext(dirEntry)) {
+        //skips . and .. as well as hidden files
+        if (dirEntry.name.empty() || (dirEntry.name[0] == '.')) {
+            continue;
+        }
+        string path = dir + "/" + dirEntry.name;
+        string name = prefix + dirEntry.name;
+        if (dirEntry.type == DirEntry::eDirectory) {
+            collectFiles(path, name + "/", items);
+        } else if (dirEntry.type == DirEntry::eFile) {
+            PackItem* item = new PackItem;
+            item->name = name;
+            item->path = path;
+            items.push_back(item);
+        }
+    }
+}
+
+static bool readFile(const string& path, vector<char>& data) {
+    ifstream infile(path.c_str(), ios::in | ios::binary);
+    if (!infile) {
+        return false;
+    }
+    infile.seekg(0, ios::end);
+    data.resize((size_t)infile.tellg());
+    infile.seekg(0, ios::beg);
+    infile.read(data.data(), data.size());
+    return !infile.fail();
+}
+
+static bool packItem(PackItem& item, bool allowCompression) {
+    vector<char> data;
+    if (!readFile(item.path, data)) {
+        LOG_ERROR << "Unable to read: [" << item.path << "]" << endl;
+        return false;
+    }
+
+    memset(&item.entry, 0, sizeof(item.entry));
+    item.entry.hash = pakHash(item.name.data(), item.name.length());
+    item.entry.size = data.size();
+    item.entry.crc = crc32(0, (const Bytef*)data.data(), (uInt)data.size());
+
+    if (allowCompression && !data.empty()) {
+        uLongf compressedSize = compressBound((uLong)data.size());
+        item.stored.resize(compressedSize);
+        int result = compress2((Bytef*)item.stored.data(), &compressedSize, (const Bytef*)data.data(),
+                               (uLong)data.size(), Z_BEST_COMPRESSION);
+        //png, ogg etc. are compressed already and are kept as is
+        if ((result == Z_OK) && (compressedSize < data.size() * (1.0 - MIN_COMPRESSION_GAIN))) {
+            item.stored.resize(compressedSize);
+            item.entry.flags |= PAK_ENTRY_COMPRESSED;
+        } else {
+            item.stored.swap(data);
+        }
+    } else {
+        item.stored.swap(data);
+    }
+    item.entry.storedSize = item.stored.size();
+    return true;
+}
+
+static uint64_t alignUp(uint64_t offset, uint32_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+static void pad(ofstream& outfile, uint64_t& offset, uint64_t target) {
+    while (offset < target) {
+        outfile.put(0);
+        offset++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t alignment = PAK_DEFAULT_ALIGNMENT;
+    bool allowCompression = true;
+    int arg = 1;
+    while ((argc > arg) && (argv[arg][0] == '-')) {
+        string option = argv[arg];
+        if ((option == "-align") && (argc > arg + 1)) {
+            alignment = (uint32_t)atoi(argv[arg + 1]);
+            arg += 2;
+        } else if (option == "-store") {
+            allowCompression = false;
+            arg++;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if ((argc - arg < 2) || (alignment == 0) || (alignment & (alignment - 1))) {
+        return usage(argv[0]);
+    }
+    if (!isLittleEndian()) {
+        LOG_ERROR << "Pak files are little endian, packing on this host is not supported." << endl;
+        return 1;
+    }
+    string dataDir = argv[arg];
+    string outFile = argv[argc - 1];
+
+    vector<PackItem*> items;
+    for (int i = arg; i < argc - 1; i++) {
+        collectFiles(argv[i], "", items);
+    }
+    if (items.empty()) {
+        LOG_ERROR << "No files found in: [" << dataDir << "]" << endl;
+        return 1;
+    }
+
+    for (size_t i = 0; i < items.size(); i++) {
+        if (!packItem(*items[i], allowCompression)) {
+            return 1;
+        }
+    }
+
+    //sorted index; the loader relies on hashes being unique
+    sort(items.begin(), items.end(), itemLess);
+    for (size_t i = 1; i < items.size(); i++) {
+        if (items[i]->entry.hash == items[i - 1]->entry.hash) {
+            const char* what = (items[i]->name == items[i - 1]->name) ? "Duplicate file" : "Hash collision";
+            LOG_ERROR << what << ": [" << items[i - 1]->path << "] [" << items[i]->path << "]" << endl;
+            return 1;
+        }
+    }
+
+    ofstream outfile(outFile.c_str(), ios::out | ios::binary);
+    if (!outfile) {
+        LOG_ERROR << "Unable to open: [" << outFile << "]" << endl;
+        return 1;
+    }
+
+    PakHeader header;
+    memcpy(header.magic, PAK_MAGIC, sizeof(header.magic));
+    header.version = PAK_VERSION;
+    header.alignment = alignment;
+    header.numEntries = (uint32_t)items.size();
+    header.indexOffset = 0;
+    header.namesOffset = 0;
+    header.namesSize = 0;
+    outfile.write((const char*)&header, sizeof(header));
+
+    uint64_t offset = sizeof(header);
+    uint64_t storedTotal = 0;
+    uint64_t sizeTotal = 0;
+    string names;
+    for (size_t i = 0; i < items.size(); i++) {
+        PackItem& item = *items[i];
+        pad(outfile, offset, alignUp(offset, alignment));
+        item.entry.offset = offset;
+        item.entry.nameOffset = (uint32_t)names.length();
+        item.entry.nameLength = (uint32_t)item.name.length();
+        names += item.name;
+
+        outfile.write(item.stored.data(), item.stored.size());
+        offset += item.stored.size();
+        storedTotal += item.entry.storedSize;
+        sizeTotal += item.entry.size;
+    }
+
+    pad(outfile, offset, alignUp(offset, alignment));
+    header.indexOffset = offset;
+    for (size_t i = 0; i < items.size(); i++) {
+        outfile.write((const char*)&items[i]->entry, sizeof(PakEntry));
+        offset += sizeof(PakEntry);
+    }
+
+    header.namesOffset = offset;
+    header.namesSize = names.length();
+    outfile.write(names.data(), names.length());
+
+    outfile.seekp(0);
+    outfile.write((const char*)&header, sizeof(header));
+    outfile.close();
+    if (!outfile) {
+        LOG_ERROR << "Unable to write: [" << outFile << "]" << endl;
+        return 1;
+    }
+
+    //the game doesn't check entry checksums on every read, so check them once here
+    PakArchive* pak = PakArchive::acquire(outFile);
+    bool verified = pak && pak->verify();
+    if (pak) {
+        pak->release();
+    }
+    if (!verified) {
+        LOG_ERROR << "Verification failed: [" << outFile << "]" << endl;
+        return 1;
+    }
+
+    LOG_INFO << dataDir << " -> " << outFile << ": " << items.size() << " files, " << sizeTotal << " -> "
+             << storedTotal << " bytes" << endl;
+
+    for (size_t i = 0; i < items.size(); i++) {
+        delete items[i];
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Description:
+//   Online score submission benchmark. Sends batches to a score server
+//   (e.g. scripts/server.py) and reports throughput and latency, with and
+//   without connection reuse.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "HttpClient.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+using namespace std;
+
+static int usage(const char* prog) {
+    cerr << "Usage: " << prog << " [-n requests] [-batch scores] [url]" << endl;
+    cerr << "  default url: http://localhost:8080/scores" << endl;
+    return 1;
+}
+
+static bool run(const string& url, int requests, int batch, bool reuse) {
+    HttpClient client("scorebench");
+    vector<double> latencies;
+    unsigned int seq = 1;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < requests; i++) {
+        stringstream request;
+        request << url << "?Batch=";
+        for (int b = 0; b < batch; b++, seq++) {
+            request << (b ? "," : "") << seq << ":" << (seq * 10) << ":0123456789abcdef";
+        }
+
+        if (!reuse) {
+            client.close();
+        }
+
+        HttpResponse response;
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        if (!client.get(request.str(), response)) {
+            cerr << "Request " << i << " failed: " << client.getError() << endl;
+            return false;
+        }
+        latencies.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
+
+        if ((response.status != 200) || (response.body.compare(0, 2, "OK") != 0)) {
+            cerr << "Unexpected reply: " << response.status << " " << response.body << endl;
+            return false;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    sort(latencies.begin(), latencies.end());
+    cout << (reuse ? "keep-alive: " : "new conn:   ");
+    cout << requests << " requests, " << client.getConnectCount() << " connections, ";
+    cout << (int)(requests / seconds) << " req/s, " << (int)(requests * batch / seconds) << " scores/s, ";
+    cout << "latency p50 " << latencies[latencies.size() / 2] << "ms";
+    cout << " p99 " << latencies[(latencies.size() * 99) / 100] << "ms" << endl;
+
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int requests = 1000;
+    int batch = 1;
+    string url = "http://localhost:8080/scores";
+
+    int arg = 1;
+    while ((argc > arg) && (argv[arg][0] == '-')) {
+        string option = argv[arg];
+        if ((option == "-n") && (argc > arg + 1)) {
+            requests = atoi(argv[arg + 1]);
+            arg += 2;
+        } else if ((option == "-batch") && (argc > arg + 1)) {
+            batch = atoi(argv[arg + 1]);
+            arg += 2;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (argc > arg) {
+        url = argv[arg++];
+    }
+    if ((argc != arg) || (requests < 1) || (batch < 1)) {
+        return usage(argv[0]);
+    }
+
+    if (!run(url, requests, batch, false) || !run(url, requests, batch, true)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Description:
+//   Score message encoding benchmark. Round-trips random messages through
+//   Tea and Hex and compares throughput against stringstream hex. Each
+//   variant runs once to warm up, then the fastest of several runs counts.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "Tea.hpp"
+#include "Hex.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+using namespace std;
+
+//what OnlineScore used to do
+static string streamToHex(const string& data) {
+    stringstream ss;
+    for (size_t i = 0; i < data.length(); i++) {
+        ss << setw(2) << setfill('0') << hex << (unsigned int)(unsigned char)data[i];
+    }
+    return ss.str();
+}
+
+static string streamFromHex(const string& strRep) {
+    stringstream ss;
+    string result;
+    for (size_t i = 0; i < strRep.length(); i += 2) {
+        ss.clear();
+        ss << hex << strRep.substr(i, 2);
+        unsigned int c;
+        ss >> c;
+        result += (unsigned char)c;
+    }
+    return result;
+}
+
+//warm up once, then the fastest of runs in seconds
+template <typename F>
+static double fastest(int runs, F body) {
+    body();
+    double best = 0;
+    for (int r = 0; r < runs; r++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        body();
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if ((r == 0) || (elapsed < best)) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int count = (argc > 1) ? atoi(argv[1]) : 100000;
+    int runs = (argc > 2) ? atoi(argv[2]) : 7;
+    if ((count < 1) || (runs < 1)) {
+        cerr << "Usage: " << argv[0] << " [messages [runs]]" << endl;
+        return 1;
+    }
+
+    //score messages are ~80 chars, padded to a multiple of 4
+    const size_t MAX_MESSAGE = 160;
+    vector<string> messages(count);
+    size_t totalBytes = 0;
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        string& msg = messages[i];
+        msg.resize(4 * (2 + rand() % (MAX_MESSAGE / 4 - 1)));
+        for (size_t c = 0; c < msg.size(); c++) {
+            msg[c] = (char)(rand() & 0xff);
+        }
+        totalBytes += msg.size();
+    }
+
+    //round trip, including odd lengths through the padding string API
+    for (int i = 0; i < count; i++) {
+        const string& msg = messages[i];
+        string buffer(msg);
+        Tea::encode((unsigned char*)&buffer[0], buffer.size());
+        if (buffer != Tea::encode(msg)) {
+            cerr << "In place and string encode differ for message " << i << endl;
+            return 1;
+        }
+
+        string hexText = Hex::encode(buffer);
+        if (hexText != streamToHex(buffer)) {
+            cerr << "Hex::encode differs from stringstream for message " << i << endl;
+            return 1;
+        }
+
+        string decoded;
+        if (!Hex::decode(hexText, decoded) || (decoded != buffer)) {
+            cerr << "Hex round trip failed for message " << i << endl;
+            return 1;
+        }
+
+        Tea::decode((unsigned char*)&decoded[0], decoded.size());
+        if (decoded != msg) {
+            cerr << "Tea round trip failed for message " << i << endl;
+            return 1;
+        }
+
+        string odd = msg.substr(0, msg.size() - 1);
+        if (Tea::decode(Tea::encode(odd)).compare(0, odd.size(), odd) != 0) {
+            cerr << "Padded Tea round trip failed for message " << i << endl;
+            return 1;
+        }
+    }
+    string upper;
+    if (!Hex::decode("0aFf", upper) || (upper != "\x0a\xff") || Hex::decode("0g", upper) || Hex::decode("abc", upper)) {
+        cerr << "Hex digit validation failed" << endl;
+        return 1;
+    }
+    cout << "Round trip OK: " << count << " messages, " << totalBytes << " bytes" << endl;
+
+    double mb = totalBytes / (1024.0 * 1024.0);
+    size_t check = 0;
+
+    double streamTime = fastest(runs, [&]() {
+        for (int i = 0; i < count; i++) {
+            string hexText = streamToHex(messages[i]);
+            check += streamFromHex(hexText).size();
+        }
+    });
+
+    vector<char> hexBuffer(MAX_MESSAGE * 2);
+    vector<unsigned char> byteBuffer(MAX_MESSAGE);
+    double tableTime = fastest(runs, [&]() {
+        for (int i = 0; i < count; i++) {
+            const string& msg = messages[i];
+            Hex::encode((const unsigned char*)msg.data(), msg.size(), &hexBuffer[0]);
+            Hex::decode(&hexBuffer[0], msg.size(), &byteBuffer[0]);
+            check += byteBuffer[0];
+        }
+    });
+
+    double teaStringTime = fastest(runs, [&]() {
+        for (int i = 0; i < count; i++) {
+            check += Tea::encode(messages[i]).size();
+        }
+    });
+
+    //encodes the already encoded messages again on every run, same cost
+    double teaInPlaceTime = fastest(runs, [&]() {
+        for (int i = 0; i < count; i++) {
+            string& msg = messages[i];
+            check += Tea::encode((unsigned char*)&msg[0], msg.size());
+        }
+    });
+
+    cout << fixed << setprecision(1);
+    cout << "fastest of " << runs << " runs" << endl;
+    cout << "hex stringstream:  " << mb / streamTime << " MB/s" << endl;
+    cout << "hex table:         " << mb / tableTime << " MB/s" << endl;
+    cout << "tea string:        " << mb / teaStringTime << " MB/s" << endl;
+    cout << "tea in place:      " << mb / teaInPlaceTime << " MB/s" << endl;
+
+    return (check == 0);
+}
@@ -0,0 +1,166 @@
+// Description:
+//   Timer checks. Drives Timer, PausableTimer and WPP from a simulated
+//   clock with jumps, compares fixed step pacing against the old
+//   millisecond wall clock timer and checks the real clock's resolution.
+//
+// Copyright (C) 2011 Frank Becker
+//
+#include "Timer.hpp"
+#include "PausableTimer.hpp"
+#include "FPS.hpp"
+
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+using namespace std;
+
+const uint64_t MS = 1000000;
+const uint64_t SECOND = 1000 * MS;
+
+static uint64_t fakeNow = 100000 * SECOND;
+static uint64_t fakeClock(void) {
+    return fakeNow;
+}
+
+static int failures = 0;
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+static bool near(double a, double b) {
+    return fabs(a - b) < 1e-9;
+}
+
+static void checkJumps(void) {
+    Timer::setClockSource(fakeClock);
+    check(Timer::getTime() == 0.0, "time starts at 0");
+
+    fakeNow += 1500;
+    check(Timer::getNanoseconds() == 1500, "sub millisecond steps are kept");
+
+    //clock stepped back an hour, e.g. a non monotonic source
+    fakeNow -= 3600 * SECOND;
+    check(Timer::getNanoseconds() == 1500, "backward jump doesn't run time backwards");
+    fakeNow += 10 * MS;
+    check(Timer::getNanoseconds() == 1500 + 10 * MS, "time continues after a backward jump");
+
+    PausableTimer stopwatch;
+    fakeNow += 2 * SECOND;
+    check(near(stopwatch.getTime(), 2.0), "stopwatch runs");
+
+    //e.g. suspended while paused
+    stopwatch.pause();
+    fakeNow += 3600 * SECOND;
+    check(near(stopwatch.getTime(), 2.0), "paused stopwatch doesn't see a forward jump");
+    stopwatch.start();
+    fakeNow += 250 * MS;
+    check(near(stopwatch.getTime(), 2.25), "stopwatch resumes where it paused");
+
+    fakeNow -= 60 * SECOND;
+    check(near(stopwatch.getTime(), 2.25), "stopwatch doesn't run backwards");
+
+    WPP fps(1.0);
+    for (int i = 0; i < 240; i++) {
+        fakeNow += SECOND / 60;
+        fps.Update();
+    }
+    check(fabs(fps.GetCountPerPeriod() - 60.0) < 0.5, "fps counts 60 frames per second");
+}
+
+//the old Timer: wall clock truncated to milliseconds
+static double oldTime(uint64_t now, uint64_t start) {
+    uint64_t msecs = (now - start) / MS;
+    return (double)msecs / 1000.0;
+}
+
+struct Pacing {
+    int lateSteps;           //frames whose step count differs from exact time
+    double maxFractionError; //interpolation error, in steps
+};
+
+//Game::updateInGameLogic's fixed step loop at 144 frames per second with a
+//bit of frame time noise, against the same loop on exact time
+static Pacing pacing(bool old) {
+    const double stepSize = 1.0f / 30.0f;
+    uint64_t start = 100000 * SECOND + 123456;
+
+    Timer::setClockSource(fakeClock);
+    fakeNow = start;
+    Timer::getNanoseconds();
+
+    Pacing result = {0, 0.0};
+    double startOfGameStep = 0.0;
+    double exactStartOfGameStep = 0.0;
+    srand(1);
+    for (int frame = 0; frame < 20000; frame++) {
+        fakeNow += SECOND / 144 + (rand() % 200) * 1000;
+        double now = old ? oldTime(fakeNow, start) : Timer::getTime();
+        double exactNow = (double)(fakeNow - start) / 1e9;
+
+        int steps = 0;
+        while ((now - startOfGameStep) > stepSize) {
+            startOfGameStep += stepSize;
+            steps++;
+        }
+        int exactSteps = 0;
+        while ((exactNow - exactStartOfGameStep) > stepSize) {
+            exactStartOfGameStep += stepSize;
+            exactSteps++;
+        }
+        if (steps != exactSteps) {
+            result.lateSteps++;
+        }
+
+        double fraction = (now - startOfGameStep) / stepSize;
+        double exactFraction = (exactNow - exactStartOfGameStep) / stepSize;
+        if ((steps == exactSteps) && (fabs(fraction - exactFraction) > result.maxFractionError)) {
+            result.maxFractionError = fabs(fraction - exactFraction);
+        }
+    }
+    return result;
+}
+
+static void checkRealClock(void) {
+    Timer::setClockSource(0);
+
+    uint64_t last = Timer::getNanoseconds();
+    uint64_t smallestStep = SECOND;
+    bool monotonic = true;
+    for (int i = 0; i < 1000000; i++) {
+        uint64_t now = Timer::getNanoseconds();
+        if (now < last) {
+            monotonic = false;
+        } else if ((now > last) && (now - last < smallestStep)) {
+            smallestStep = now - last;
+        }
+        last = now;
+    }
+    check(monotonic, "real clock is monotonic");
+    check(smallestStep < MS, "real clock resolves below a millisecond");
+    cout << "real clock: smallest step " << smallestStep << "ns" << endl;
+}
+
+int main(int, char*[]) {
+    checkJumps();
+
+    Pacing oldPacing = pacing(true);
+    Pacing newPacing = pacing(false);
+    cout << "144fps with 30Hz steps, 20000 frames:" << endl;
+    cout << "  ms wall clock: " << oldPacing.lateSteps << " frames with late steps, max interpolation error "
+         << oldPacing.maxFractionError * 100 << "% of a step" << endl;
+    cout << "  ns monotonic:  " << newPacing.lateSteps << " frames with late steps, max interpolation error "
+         << newPacing.maxFractionError * 100 << "% of a step" << endl;
+    check((newPacing.lateSteps == 0) && (newPacing.maxFractionError < 1e-6), "ns timer paces steps on time");
+
+    checkRealClock();
+
+    if (failures) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All timer checks passed" << endl;
+    return 0;
+}